@@ -0,0 +1,131 @@
+// Content blocker benchmark: compile time, cache mapping time and per-request
+// match latency over a URL corpus.
+//
+//   bench_adblock [--filters easylist.txt ...] [--corpus requests.tsv] [--rounds N]
+//
+// The corpus is what FLOW_RECORD_REQUESTS writes while browsing
+// ("type<TAB>page host<TAB>url" per line). Without arguments a synthetic
+// list and corpus of similar shape are generated.
+#include <QCoreApplication>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QElapsedTimer>
+#include <QRandomGenerator>
+#include <QTextStream>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+#include "../cpp/src/ContentFilter.h"
+
+struct CorpusEntry { QByteArray url; QByteArray page; quint32 type; };
+
+static QList<QByteArray> syntheticFilters() {
+    QRandomGenerator rng(42);
+    QList<QByteArray> lines;
+    for (int i = 0; i < 30000; ++i) lines << "||adhost" + QByteArray::number(i) + ".example^";
+    for (int i = 0; i < 5000; ++i) lines << "||tracker" + QByteArray::number(i) + ".net^$third-party";
+    for (int i = 0; i < 8000; ++i) {
+        const QByteArray n = QByteArray::number(rng.bounded(100000));
+        switch (i % 4) {
+        case 0: lines << "/banner" + n + "/*/img^"; break;
+        case 1: lines << "&adslot" + n + "="; break;
+        case 2: lines << "||cdn" + n + ".site.com/ads/$script"; break;
+        default: lines << "@@||cdn" + n + ".site.com/ads/consent^"; break;
+        }
+    }
+    return lines;
+}
+
+static std::vector<CorpusEntry> syntheticCorpus() {
+    QRandomGenerator rng(7);
+    static const char* paths[] = {"/static/app.js", "/img/logo.png", "/api/v1/items?page=2", "/css/site.css", "/fonts/inter.woff2"};
+    static const quint32 types[] = {ContentFilter::Script, ContentFilter::Image, ContentFilter::Xhr, ContentFilter::Stylesheet, ContentFilter::Font};
+    std::vector<CorpusEntry> out;
+    for (int i = 0; i < 50000; ++i) {
+        const int k = rng.bounded(5);
+        QByteArray host;
+        switch (rng.bounded(10)) {
+        case 0: host = "adhost" + QByteArray::number(rng.bounded(60000)) + ".example"; break;
+        case 1: host = "tracker" + QByteArray::number(rng.bounded(10000)) + ".net"; break;
+        default: host = "www.site" + QByteArray::number(rng.bounded(500)) + ".com"; break;
+        }
+        out.push_back({"https://" + host + paths[k], "www.news" + QByteArray::number(rng.bounded(50)) + ".org", types[k]});
+    }
+    return out;
+}
+
+int main(int argc, char** argv) {
+    QCoreApplication app(argc, argv);
+    QStringList filterFiles;
+    QString corpusFile;
+    int rounds = 5;
+    const QStringList args = app.arguments();
+    for (int i = 1; i < args.size(); ++i) {
+        if (args[i] == "--filters" && i + 1 < args.size()) filterFiles << args[++i];
+        else if (args[i] == "--corpus" && i + 1 < args.size()) corpusFile = args[++i];
+        else if (args[i] == "--rounds" && i + 1 < args.size()) rounds = qMax(1, args[++i].toInt());
+    }
+    QTextStream out(stdout);
+
+    QList<QByteArray> lines;
+    for (const QString &path : filterFiles) {
+        QFile f(path);
+        if (!f.open(QIODevice::ReadOnly)) { out << "cannot read " << path << Qt::endl; return 1; }
+        lines += f.readAll().split('\n');
+    }
+    if (filterFiles.isEmpty()) lines = syntheticFilters();
+
+    std::vector<CorpusEntry> corpus;
+    if (!corpusFile.isEmpty()) {
+        QFile f(corpusFile);
+        if (!f.open(QIODevice::ReadOnly)) { out << "cannot read " << corpusFile << Qt::endl; return 1; }
+        while (!f.atEnd()) {
+            const QList<QByteArray> parts = f.readLine().trimmed().split('\t');
+            if (parts.size() != 3) continue;
+            corpus.push_back({parts[2].toLower(), parts[1].toLower(), ContentFilter::typeFromName(parts[0])});
+        }
+    } else {
+        corpus = syntheticCorpus();
+    }
+    if (corpus.empty()) { out << "empty corpus" << Qt::endl; return 1; }
+
+    QElapsedTimer t;
+    t.start();
+    ContentFilter::CompileStats stats;
+    const QByteArray image = ContentFilter::compile(lines, &stats);
+    const qint64 compileMs = t.elapsed();
+
+    QTemporaryDir dir;
+    const QString cache = dir.filePath("compiled.bin");
+    ContentFilter::writeCompiled(cache, image);
+    ContentFilter filter;
+    t.restart();
+    if (!filter.mapFile(cache)) { out << "cannot map compiled cache" << Qt::endl; return 1; }
+    const qint64 mapUs = t.nsecsElapsed() / 1000;
+
+    std::vector<qint64> samples;
+    samples.reserve(corpus.size() * size_t(rounds));
+    qint64 blocked = 0;
+    for (int r = 0; r < rounds; ++r) {
+        for (const CorpusEntry &e : corpus) {
+            const auto a = std::chrono::steady_clock::now();
+            const bool b = filter.shouldBlock(e.url, e.page, e.type);
+            const auto z = std::chrono::steady_clock::now();
+            samples.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(z - a).count());
+            if (r == 0 && b) ++blocked;
+        }
+    }
+    std::sort(samples.begin(), samples.end());
+    double total = 0;
+    for (qint64 s : samples) total += s;
+    auto pct = [&samples](double p) { return samples[std::min(samples.size() - 1, size_t(p * samples.size()))]; };
+
+    out << "rules:       " << filter.ruleCount() << " (" << stats.hostRules << " host, " << stats.patternRules << " pattern, "
+        << stats.untokenized << " untokenized, " << stats.unsupported << " unsupported)" << Qt::endl;
+    out << "compile:     " << compileMs << " ms, image " << image.size() / 1024 << " KiB" << Qt::endl;
+    out << "map cache:   " << mapUs << " us" << Qt::endl;
+    out << "requests:    " << corpus.size() << " x " << rounds << ", " << blocked << " blocked" << Qt::endl;
+    out << "match ns:    mean " << qRound64(total / samples.size()) << ", p50 " << pct(0.5) << ", p99 " << pct(0.99)
+        << ", max " << samples.back() << Qt::endl;
+    return 0;
+}
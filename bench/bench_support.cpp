@@ -0,0 +1,234 @@
+#include "bench_support.h"
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QFile>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QSysInfo>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QXmlStreamReader>
+#include <QtTest>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+const char* const kWords[] = {
+    "flow", "sync", "tab", "note", "page", "search", "quick", "river", "market", "design", "paper", "cloud",
+    "garden", "travel", "recipe", "music", "review", "guide", "daily", "report", "open", "source", "build", "night",
+    "city", "light", "story", "photo", "video", "learn", "money", "health", "sport", "game", "code", "data",
+};
+constexpr int kWordCount = int(sizeof(kWords) / sizeof(kWords[0]));
+constexpr double kNoiseFloorMs = 0.005;
+constexpr double kPi = 3.14159265358979323846;
+
+QString words(QRandomGenerator& rng, int count) {
+    QStringList out;
+    out.reserve(count);
+    for (int i = 0; i < count; ++i) out << QLatin1String(kWords[rng.bounded(kWordCount)]);
+    return out.join(' ');
+}
+
+// a standard normal sample (Box-Muller)
+double normal(QRandomGenerator& rng) {
+    const double u1 = qMax(1e-12, rng.generateDouble());
+    const double u2 = rng.generateDouble();
+    return std::sqrt(-2.0 * std::log(u1)) * std::cos(2.0 * kPi * u2);
+}
+
+// cumulative Zipf weights of ranks 0..n-1
+QVector<double> zipfCdf(int n, double s) {
+    QVector<double> cdf(n);
+    double sum = 0;
+    for (int k = 0; k < n; ++k) { sum += 1.0 / std::pow(k + 1, s); cdf[k] = sum; }
+    for (double &c : cdf) c /= sum;
+    return cdf;
+}
+
+int sampleRank(const QVector<double>& cdf, QRandomGenerator& rng) {
+    const auto it = std::lower_bound(cdf.cbegin(), cdf.cend(), rng.generateDouble());
+    return qMin(int(it - cdf.cbegin()), int(cdf.size()) - 1);
+}
+
+QString siteName(int rank) { return QString("site%1").arg(rank % 997); }
+}
+
+namespace BenchData {
+
+QVector<SyntheticBookmark> bookmarks(int n, int folders, quint32 seed) {
+    QRandomGenerator rng(seed);
+    QVector<SyntheticBookmark> out;
+    out.reserve(n);
+    for (int i = 0; i < n; ++i) {
+        // squaring a uniform sample piles most bookmarks into the first folders
+        const double u = rng.generateDouble();
+        const int folder = qMin(folders - 1, int(folders * u * u));
+        out.append({words(rng, 2 + rng.bounded(5)), QString("https://bm%1.example/%2").arg(i % 1500).arg(i),
+                    folders > 0 ? QString("Folder %1").arg(folder) : QString()});
+    }
+    return out;
+}
+
+QString zipfUrl(int rank) {
+    return QString("https://www.%1.example/articles/%2").arg(siteName(rank)).arg(rank);
+}
+
+QVector<SyntheticVisit> zipfVisits(int visits, int distinctUrls, double s, quint32 seed) {
+    QRandomGenerator rng(seed);
+    const QVector<double> cdf = zipfCdf(distinctUrls, s);
+    QVector<SyntheticVisit> out;
+    out.reserve(visits);
+    for (int i = 0; i < visits; ++i) {
+        const int rank = sampleRank(cdf, rng);
+        QRandomGenerator titleRng(quint32(rank));
+        out.append({zipfUrl(rank), words(titleRng, 3 + rank % 6)});
+    }
+    return out;
+}
+
+QVector<SyntheticNote> notes(int n, quint32 seed) {
+    QRandomGenerator rng(seed);
+    QVector<SyntheticNote> out;
+    out.reserve(n);
+    for (int i = 0; i < n; ++i) {
+        // median around 400 characters, a few reach tens of kilobytes
+        const int chars = qBound(20, int(std::exp(std::log(400.0) + 1.2 * normal(rng))), 40000);
+        QString body;
+        body.reserve(chars + 16);
+        while (body.size() < chars) body += words(rng, 12) + (rng.bounded(4) == 0 ? ".\n" : ". ");
+        body.truncate(chars);
+        out.append({words(rng, 1 + rng.bounded(6)), body});
+    }
+    return out;
+}
+
+QStringList omniboxQueries(int n, int distinctUrls, quint32 seed) {
+    QRandomGenerator rng(seed);
+    const QVector<double> cdf = zipfCdf(distinctUrls, 1.0);
+    QStringList out;
+    out.reserve(n);
+    for (int i = 0; i < n; ++i) {
+        const int rank = sampleRank(cdf, rng);
+        if (rng.bounded(3) == 0) {
+            out << QLatin1String(kWords[rng.bounded(kWordCount)]);
+        } else {
+            const QString site = siteName(rank);
+            out << site.left(2 + rng.bounded(site.size() - 1));
+        }
+    }
+    return out;
+}
+
+}
+
+namespace BenchRunner {
+
+QVector<Result> parseQtTestXml(const QByteArray& xml) {
+    QVector<Result> results;
+    QXmlStreamReader r(xml);
+    QString function;
+    while (!r.atEnd()) {
+        if (r.readNext() != QXmlStreamReader::StartElement) continue;
+        const auto attrs = r.attributes();
+        if (r.name() == QLatin1String("TestFunction")) {
+            function = attrs.value("name").toString();
+        } else if (r.name() == QLatin1String("BenchmarkResult")) {
+            Result res;
+            const QString tag = attrs.value("tag").toString();
+            res.name = tag.isEmpty() ? function : function + ":" + tag;
+            res.metric = attrs.value("metric").toString();
+            res.value = attrs.value("value").toDouble();
+            res.iterations = attrs.value("iterations").toInt();
+            results.append(res);
+        }
+    }
+    return results;
+}
+
+QJsonObject toJson(const QString& benchName, const QVector<Result>& results) {
+    QJsonArray arr;
+    for (const Result &r : results)
+        arr.append(QJsonObject{{"name", r.name}, {"metric", r.metric}, {"value", r.value}, {"iterations", r.iterations}});
+    return QJsonObject{{"bench", benchName},
+                       {"host", QSysInfo::machineHostName()},
+                       {"qt", QString::fromLatin1(qVersion())},
+                       {"timestamp", QDateTime::currentDateTimeUtc().toString(Qt::ISODate)},
+                       {"results", arr}};
+}
+
+QVector<QPair<QString, QString>> compare(const QVector<Result>& results, const QJsonObject& baseline, double tolerance) {
+    QHash<QString, QJsonObject> base;
+    for (const QJsonValue &v : baseline.value("results").toArray()) base.insert(v.toObject().value("name").toString(), v.toObject());
+    QVector<QPair<QString, QString>> regressions;
+    for (const Result &r : results) {
+        const QJsonObject b = base.value(r.name);
+        if (b.isEmpty() || b.value("metric").toString() != r.metric) continue;
+        const double was = b.value("value").toDouble();
+        // the noise floor only applies to wall time, whose unit it is in
+        const bool aboveNoise = r.metric != QLatin1String("WalltimeMilliseconds") || r.value - was > kNoiseFloorMs;
+        if (was > 0 && r.value > was * (1.0 + tolerance) && aboveNoise)
+            regressions.append({r.name, QString("%1 -> %2 %3 (+%4%)").arg(was).arg(r.value).arg(r.metric)
+                                            .arg(qRound((r.value / was - 1.0) * 100))});
+    }
+    return regressions;
+}
+
+int run(QObject* suite, const QString& benchName, int argc, char** argv) {
+    QStringList qtestArgs{QString::fromLocal8Bit(argv[0])};
+    QString outPath, baselinePath, writeBaselinePath;
+    double tolerance = 0.15;
+    bool json = false;
+    for (int i = 1; i < argc; ++i) {
+        const QString a = QString::fromLocal8Bit(argv[i]);
+        const QString v = i + 1 < argc ? QString::fromLocal8Bit(argv[i + 1]) : QString();
+        if (a == "--json") { json = true; continue; }
+        if (a == "--out") outPath = v;
+        else if (a == "--baseline") baselinePath = v;
+        else if (a == "--write-baseline") writeBaselinePath = v;
+        else if (a == "--tolerance") tolerance = v.toDouble();
+        else { qtestArgs << a; continue; }
+        ++i;
+    }
+
+    QTemporaryDir tmp;
+    const QString xmlPath = tmp.filePath("results.xml");
+    // the XML log is parsed below; the plain log stays on the console unless JSON goes there
+    qtestArgs << "-o" << xmlPath + ",xml";
+    if (!json) qtestArgs << "-o" << "-,txt";
+    const int rc = QTest::qExec(suite, qtestArgs);
+
+    QFile xml(xmlPath);
+    if (!xml.open(QIODevice::ReadOnly)) return rc ? rc : 1;
+    const QVector<Result> results = parseQtTestXml(xml.readAll());
+    const QJsonObject report = toJson(benchName, results);
+    const QByteArray reportJson = QJsonDocument(report).toJson();
+
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+    if (json) out << reportJson;
+    for (const QString &path : {outPath, writeBaselinePath}) {
+        if (path.isEmpty()) continue;
+        QFile f(path);
+        if (!f.open(QIODevice::WriteOnly | QIODevice::Truncate)) { err << "cannot write " << path << Qt::endl; return 1; }
+        f.write(reportJson);
+    }
+
+    int regressed = 0;
+    if (!baselinePath.isEmpty()) {
+        QFile f(baselinePath);
+        if (!f.open(QIODevice::ReadOnly)) {
+            err << "no baseline at " << baselinePath << "; record one with --write-baseline" << Qt::endl;
+        } else {
+            const auto regressions = compare(results, QJsonDocument::fromJson(f.readAll()).object(), tolerance);
+            for (const auto &r : regressions) err << "REGRESSION " << benchName << " " << r.first << ": " << r.second << Qt::endl;
+            regressed = int(regressions.size());
+            if (!regressed) err << benchName << ": " << results.size() << " results within " << qRound(tolerance * 100)
+                                << "% of the baseline" << Qt::endl;
+        }
+    }
+    if (rc) return rc;
+    return regressed ? 3 : 0;
+}
+
+}
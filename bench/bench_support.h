@@ -0,0 +1,65 @@
+// Shared pieces of the QBENCHMARK-based bench_* targets: synthetic data of a
+// realistic shape, and a runner that turns QtTest's benchmark results into
+// JSON and compares them against a stored baseline.
+//
+//   bench_<name> [--json] [--out results.json] [--baseline baseline.json]
+//                [--tolerance 0.15] [--write-baseline baseline.json] [QtTest args]
+//
+// A result counts as a regression when it is slower than the baseline by more
+// than the tolerance (a fraction) and by more than the noise floor of 0.005 ms
+// per iteration; any regression makes the run exit with 3. Baselines are only
+// meaningful on the machine that recorded them, so each machine keeps its own
+// (bench/baselines/ is the conventional place, see the README).
+#pragma once
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QPair>
+#include <QJsonObject>
+#include <QRandomGenerator>
+
+namespace BenchData {
+
+struct SyntheticBookmark { QString title; QString url; QString folder; };
+struct SyntheticVisit { QString url; QString title; };
+struct SyntheticNote { QString title; QString body; };
+
+// n bookmarks spread over the given number of folders (a few hold most)
+QVector<SyntheticBookmark> bookmarks(int n, int folders, quint32 seed = 1);
+
+// Visits over distinctUrls pages whose popularity follows Zipf's law with
+// exponent s: a handful of sites make up most of the history, as in real use.
+QVector<SyntheticVisit> zipfVisits(int visits, int distinctUrls, double s = 1.0, quint32 seed = 2);
+// url of the page with the given popularity rank in zipfVisits()
+QString zipfUrl(int rank);
+
+// note bodies are log-normally sized around a few hundred characters with a
+// long tail to tens of kilobytes
+QVector<SyntheticNote> notes(int n, quint32 seed = 3);
+
+// query strings the way people type into the omnibox: prefixes of hosts and words
+QStringList omniboxQueries(int n, int distinctUrls, quint32 seed = 4);
+
+}
+
+namespace BenchRunner {
+
+struct Result {
+    QString name;    // function, plus ":" and the data tag if any
+    QString metric;  // QtTest's metric name, e.g. WalltimeMilliseconds
+    double value = 0;  // per iteration
+    int iterations = 0;
+};
+
+// run suite's benchmarks and report as described above; returns the exit code
+int run(QObject* suite, const QString& benchName, int argc, char** argv);
+
+// exposed for the runner's own use and for tooling
+QVector<Result> parseQtTestXml(const QByteArray& xml);
+QJsonObject toJson(const QString& benchName, const QVector<Result>& results);
+// names of the results that regressed against baseline, with a description each
+QVector<QPair<QString, QString>> compare(const QVector<Result>& results, const QJsonObject& baseline, double tolerance);
+
+}
@@ -0,0 +1,159 @@
+// History benchmarks: recording visits and searching a history whose URL
+// popularity follows Zipf's law, at a few history sizes, and importing a
+// Chrome History file of up to 5M visits.
+//
+//   bench_history [runner options, see bench_support.h] [QtTest args]
+#include <QtTest>
+#include <QSqlQuery>
+#include <QTemporaryDir>
+#include "bench_support.h"
+#include "../cpp/src/StorageExecutor.h"
+#include "../cpp/src/HistoryManager.h"
+#include "../cpp/src/BrowserImporter.h"
+
+class HistoryBench : public QObject {
+    Q_OBJECT
+private slots:
+    void initTestCase();
+    void addVisit();
+    void search_data();
+    void search();
+    void importChromeHistory_data();
+    void importChromeHistory();
+
+private:
+    // replace history.db's visits with n synthetic ones
+    static void seedVisits(int n);
+    static void searchAndWait(HistoryManager& history, const QString& query);
+    // a Chrome History file of n visits over n / 10 pages
+    static void writeChromeHistory(const QString& path, int n);
+};
+
+void HistoryBench::seedVisits(int n) {
+    const QVector<BenchData::SyntheticVisit> visits = BenchData::zipfVisits(n, qMax(100, n / 10));
+    StorageExecutor::instance()->blockingRead<bool>([&visits](Storage& s){
+        QSqlDatabase db = s.history();
+        QSqlQuery q(db);
+        q.exec("DELETE FROM visits");
+        db.transaction();
+        q.prepare("INSERT INTO visits (url, title, visited_at) VALUES (?, ?, ?)");
+        qint64 at = 1700000000;
+        for (const auto &v : visits) {
+            q.addBindValue(v.url);
+            q.addBindValue(v.title);
+            q.addBindValue(at++);
+            q.exec();
+        }
+        return db.commit();
+    });
+}
+
+void HistoryBench::searchAndWait(HistoryManager& history, const QString& query) {
+    bool done = false;
+    history.search(query, 10, &history, [&done](const HistoryManager::Results&){ done = true; });
+    // the search runs on the storage thread; this collects its answer
+    StorageExecutor::instance()->waitForIdle();
+    if (!done) qFatal("history search did not answer");
+}
+
+void HistoryBench::initTestCase() {
+    // opening and migrating flow.db is not part of any benchmark
+    StorageExecutor::instance()->waitForIdle();
+}
+
+void HistoryBench::addVisit() {
+    seedVisits(10000);
+    HistoryManager history;
+    const QVector<BenchData::SyntheticVisit> visits = BenchData::zipfVisits(100, 1000, 1.0, 7);
+    // a burst of 100 visits, until they are on disk
+    QBENCHMARK {
+        for (const auto &v : visits) history.addVisit(v.url, v.title);
+        StorageExecutor::instance()->waitForIdle();
+    }
+}
+
+void HistoryBench::search_data() {
+    QTest::addColumn<int>("visits");
+    QTest::newRow("1k visits") << 1000;
+    QTest::newRow("10k visits") << 10000;
+    QTest::newRow("100k visits") << 100000;
+}
+
+void HistoryBench::search() {
+    QFETCH(int, visits);
+    seedVisits(visits);
+    HistoryManager history;
+    const QStringList queries = BenchData::omniboxQueries(20, qMax(100, visits / 10));
+    QBENCHMARK {
+        for (const QString &q : queries) searchAndWait(history, q);
+    }
+}
+
+void HistoryBench::writeChromeHistory(const QString& path, int n) {
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", "chrome_history");
+        db.setDatabaseName(path);
+        db.open();
+        QSqlQuery q(db);
+        q.exec("PRAGMA journal_mode=OFF");
+        q.exec("CREATE TABLE urls (id INTEGER PRIMARY KEY, url LONGVARCHAR, title LONGVARCHAR)");
+        q.exec("CREATE TABLE visits (id INTEGER PRIMARY KEY, url INTEGER NOT NULL, visit_time INTEGER NOT NULL)");
+        db.transaction();
+        const int pages = qMax(100, n / 10);
+        q.prepare("INSERT INTO urls (id, url, title) VALUES (?, ?, ?)");
+        for (int i = 1; i <= pages; ++i) {
+            q.addBindValue(i);
+            q.addBindValue(BenchData::zipfUrl(i));
+            q.addBindValue(QString("Page %1 of a synthetic history").arg(i));
+            q.exec();
+        }
+        // a visit every ten seconds from 2020 on, pages in a scattered order
+        q.prepare("INSERT INTO visits (url, visit_time) VALUES (?, ?)");
+        for (int i = 0; i < n; ++i) {
+            q.addBindValue(int(qint64(i) * 7919 % pages) + 1);
+            q.addBindValue((1577836800LL + qint64(i) * 10 + 11644473600LL) * 1000000);
+            q.exec();
+        }
+        q.exec("CREATE INDEX visits_time_index ON visits (visit_time)");
+        db.commit();
+    }
+    QSqlDatabase::removeDatabase("chrome_history");
+}
+
+void HistoryBench::importChromeHistory_data() {
+    QTest::addColumn<int>("visits");
+    QTest::newRow("100k visits") << 100000;
+    QTest::newRow("1M visits") << 1000000;
+    QTest::newRow("5M visits") << 5000000;
+}
+
+void HistoryBench::importChromeHistory() {
+    QFETCH(int, visits);
+    QTemporaryDir dir;
+    const QString path = dir.filePath("History");
+    writeChromeHistory(path, visits);
+    StorageExecutor::instance()->blockingRead<bool>([](Storage& s){
+        QSqlQuery q(s.history());
+        return q.exec("DELETE FROM visits");
+    });
+    BrowserImporter importer(nullptr, nullptr);
+    QSignalSpy finished(&importer, &BrowserImporter::finished);
+    // from copying the file until the last batch is committed
+    QBENCHMARK_ONCE {
+        importer.start(path);
+        if (!finished.wait(10 * 60 * 1000)) qFatal("import did not finish");
+    }
+    const qint64 imported = finished.takeFirst().at(0).value<BrowserImporter::Result>().visits;
+    if (imported != visits) qFatal("imported %lld of %d visits", imported, visits);
+}
+
+int main(int argc, char** argv) {
+    // keep the profile away from the real one
+    QTemporaryDir home;
+    qputenv("XDG_DATA_HOME", home.path().toUtf8());
+    QCoreApplication app(argc, argv);
+    HistoryBench bench;
+    return BenchRunner::run(&bench, "bench_history", argc, argv);
+}
+
+#include "history_bench.moc"
@@ -0,0 +1,163 @@
+// Manager-layer benchmarks: loading a synced collection from flow.db, saving
+// edits back, and pulling and merging a remote table through the mock server.
+//
+//   bench_managers [runner options, see bench_support.h] [QtTest args]
+#include <QtTest>
+#include <QSqlQuery>
+#include <QTemporaryDir>
+#include "bench_support.h"
+#include "../cpp/src/StorageExecutor.h"
+#include "../cpp/src/MockSupabaseServer.h"
+#include "../cpp/src/AuthManager.h"
+#include "../cpp/src/BookmarksManager.h"
+#include "../cpp/src/NotesManager.h"
+
+class ManagersBench : public QObject {
+    Q_OBJECT
+private slots:
+    void initTestCase();
+    void loadNotes_data();
+    void loadNotes();
+    void loadBookmarks_data();
+    void loadBookmarks();
+    void saveOneEdit();
+    void saveAllEdited();
+    void pullAndMerge_data();
+    void pullAndMerge();
+
+private:
+    static void clearStorage();
+    static void waitLoaded(SyncEngineBase* manager);
+    static void seedNotes(int n);
+    static void sizes();
+};
+
+void ManagersBench::clearStorage() {
+    StorageExecutor::instance()->blockingRead<bool>([](Storage& s){
+        return s.transaction([&](){
+            QSqlQuery q(s.database());
+            for (const char* sql : {"DELETE FROM bookmarks", "DELETE FROM notes", "DELETE FROM sync_queue", "DELETE FROM sync_state"})
+                if (!q.exec(QLatin1String(sql))) return false;
+            return true;
+        });
+    });
+}
+
+void ManagersBench::waitLoaded(SyncEngineBase* manager) {
+    if (manager->isLoaded()) return;
+    QEventLoop loop;
+    connect(manager, &SyncEngineBase::loaded, &loop, &QEventLoop::quit);
+    loop.exec();
+}
+
+void ManagersBench::seedNotes(int n) {
+    clearStorage();
+    NotesManager notes;
+    waitLoaded(&notes);
+    for (const auto &note : BenchData::notes(n)) notes.addNote(note.title, note.body);
+    notes.flushSave();
+    StorageExecutor::instance()->waitForIdle();
+}
+
+void ManagersBench::sizes() {
+    QTest::addColumn<int>("items");
+    QTest::newRow("1k") << 1000;
+    QTest::newRow("10k") << 10000;
+}
+
+void ManagersBench::initTestCase() {
+    StorageExecutor::instance()->waitForIdle();
+    // nothing leaves the machine unless a benchmark signs in to its mock server
+    QFile::remove(QDir(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation)).filePath("auth.json"));
+}
+
+void ManagersBench::loadNotes_data() { sizes(); }
+
+void ManagersBench::loadNotes() {
+    QFETCH(int, items);
+    seedNotes(items);
+    QBENCHMARK {
+        NotesManager notes;
+        waitLoaded(&notes);
+        if (notes.count() != items) qFatal("loaded %d notes of %d", int(notes.count()), items);
+    }
+}
+
+void ManagersBench::loadBookmarks_data() { sizes(); }
+
+void ManagersBench::loadBookmarks() {
+    QFETCH(int, items);
+    clearStorage();
+    {
+        BookmarksManager seed;
+        waitLoaded(&seed);
+        for (const auto &b : BenchData::bookmarks(items, 40)) seed.addBookmark(b.title, b.url, b.folder);
+        seed.flushSave();
+        StorageExecutor::instance()->waitForIdle();
+    }
+    QBENCHMARK {
+        BookmarksManager bookmarks;
+        waitLoaded(&bookmarks);
+    }
+}
+
+void ManagersBench::saveOneEdit() {
+    seedNotes(10000);
+    NotesManager notes;
+    waitLoaded(&notes);
+    int i = 0;
+    // one row and the op queue, until committed
+    QBENCHMARK {
+        notes.editNote(i % notes.count(), QString("Edited %1").arg(i), "edited body");
+        ++i;
+        notes.flushSave();
+        StorageExecutor::instance()->waitForIdle();
+    }
+}
+
+void ManagersBench::saveAllEdited() {
+    seedNotes(10000);
+    NotesManager notes;
+    waitLoaded(&notes);
+    int round = 0;
+    QBENCHMARK {
+        ++round;
+        for (int i = 0; i < notes.count(); ++i) notes.editNote(i, QString("Round %1").arg(round), "edited body");
+        notes.flushSave();
+        StorageExecutor::instance()->waitForIdle();
+    }
+}
+
+void ManagersBench::pullAndMerge_data() { sizes(); }
+
+void ManagersBench::pullAndMerge() {
+    QFETCH(int, items);
+    clearStorage();
+    MockSupabaseServer server;
+    QVERIFY(server.listen());
+    server.seedRows("notes", items);
+    // local notes written while signed out, merged with the remote table
+    const int local = items / 10;
+    AuthManager auth;
+    auth.setSupabaseConfig(server.url(), server.anonKey());
+    NotesManager notes;
+    notes.setSupabaseConfig(server.url(), server.anonKey());
+    notes.setAuthManager(&auth);
+    waitLoaded(&notes);
+    for (const auto &note : BenchData::notes(local)) notes.addNote(note.title, note.body);
+    QBENCHMARK_ONCE {
+        auth.signIn("bench@test.local", "password");
+        QVERIFY(QTest::qWaitFor([&](){ return notes.count() >= local + items; }, 120000));
+    }
+}
+
+int main(int argc, char** argv) {
+    // keep the profile away from the real one
+    QTemporaryDir home;
+    qputenv("XDG_DATA_HOME", home.path().toUtf8());
+    QCoreApplication app(argc, argv);
+    ManagersBench bench;
+    return BenchRunner::run(&bench, "bench_managers", argc, argv);
+}
+
+#include "managers_bench.moc"
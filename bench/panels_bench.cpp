@@ -0,0 +1,184 @@
+// UI-path benchmarks: rebuilding the bookmarks panel, a sync burst reaching the
+// notes and todos panels, and the omnibox suggestion round trip (history
+// search plus completer model).
+// Runs on the offscreen platform unless QT_QPA_PLATFORM says otherwise.
+//
+//   bench_panels [runner options, see bench_support.h] [QtTest args]
+#include <QtTest>
+#include <QApplication>
+#include <QCompleter>
+#include <QSqlQuery>
+#include <QStringListModel>
+#include <QTemporaryDir>
+#include "bench_support.h"
+#include "../cpp/src/StorageExecutor.h"
+#include "../cpp/src/BookmarksManager.h"
+#include "../cpp/src/BookmarksPanel.h"
+#include "../cpp/src/NotesManager.h"
+#include "../cpp/src/NotesPanel.h"
+#include "../cpp/src/TodosManager.h"
+#include "../cpp/src/TodosPanel.h"
+#include "../cpp/src/HistoryManager.h"
+
+class PanelsBench : public QObject {
+    Q_OBJECT
+private slots:
+    void initTestCase();
+    void bookmarksRefresh_data();
+    void bookmarksRefresh();
+    void notesSyncBurst_data();
+    void notesSyncBurst();
+    void todosSyncBurst_data();
+    void todosSyncBurst();
+    void omniboxQuery();
+
+private:
+    static void clearStorage();
+    static void waitLoaded(SyncEngineBase* manager);
+};
+
+// rows left by the previous data row would be loaded too
+void PanelsBench::clearStorage() {
+    StorageExecutor::instance()->blockingRead<bool>([](Storage& s){
+        QSqlQuery q(s.database());
+        return q.exec("DELETE FROM bookmarks") && q.exec("DELETE FROM notes") && q.exec("DELETE FROM todos")
+            && q.exec("DELETE FROM sync_queue");
+    });
+}
+
+void PanelsBench::waitLoaded(SyncEngineBase* manager) {
+    if (manager->isLoaded()) return;
+    QEventLoop loop;
+    connect(manager, &SyncEngineBase::loaded, &loop, &QEventLoop::quit);
+    loop.exec();
+}
+
+void PanelsBench::initTestCase() {
+    StorageExecutor::instance()->waitForIdle();
+}
+
+void PanelsBench::bookmarksRefresh_data() {
+    QTest::addColumn<int>("items");
+    QTest::addColumn<int>("folders");
+    QTest::newRow("1k in 20 folders") << 1000 << 20;
+    QTest::newRow("10k in 200 folders") << 10000 << 200;
+}
+
+void PanelsBench::bookmarksRefresh() {
+    QFETCH(int, items);
+    QFETCH(int, folders);
+    clearStorage();
+    BookmarksManager bookmarks;
+    waitLoaded(&bookmarks);
+    for (const auto &b : BenchData::bookmarks(items, folders)) bookmarks.addBookmark(b.title, b.url, b.folder);
+    // created afterwards so seeding does not refresh it once per bookmark
+    BookmarksPanel panel(&bookmarks);
+    panel.show();
+    QBENCHMARK {
+        panel.refresh();
+    }
+}
+
+void PanelsBench::notesSyncBurst_data() {
+    QTest::addColumn<int>("items");
+    QTest::newRow("1k") << 1000;
+    QTest::newRow("10k") << 10000;
+}
+
+// what a pulled page does to the panel: 100 scattered notes change and the
+// next frame shows them, painting included
+void PanelsBench::notesSyncBurst() {
+    QFETCH(int, items);
+    clearStorage();
+    NotesManager notes;
+    waitLoaded(&notes);
+    for (const auto &n : BenchData::notes(items)) notes.addNote(n.title, n.body);
+    NotesPanel panel(&notes);
+    panel.show();
+    int round = 0;
+    QBENCHMARK {
+        ++round;
+        for (int i = 0; i < 100; ++i) {
+            const int index = (i * (items / 100) + round) % items;
+            notes.editNote(index, notes.notes().at(index).title, QString("edited in round %1").arg(round));
+        }
+        panel.refresh();
+        QCoreApplication::processEvents();
+    }
+}
+
+void PanelsBench::todosSyncBurst_data() {
+    QTest::addColumn<int>("items");
+    QTest::newRow("10k") << 10000;
+    QTest::newRow("50k") << 50000;
+}
+
+// the same for todos; at 50k an iteration has to stay well inside a 16 ms frame
+void PanelsBench::todosSyncBurst() {
+    QFETCH(int, items);
+    clearStorage();
+    TodosManager todos;
+    waitLoaded(&todos);
+    QVector<TodoItem> seed;
+    for (int i = 0; i < items; ++i) seed.append({QString(), QString("Todo %1").arg(i), false, i % 4 ? "Work" : "Home"});
+    todos.appendMany(seed);
+    TodosPanel panel(&todos);
+    panel.show();
+    int round = 0;
+    QBENCHMARK {
+        ++round;
+        for (int i = 0; i < 100; ++i) {
+            const int index = (i * (items / 100) + round) % items;
+            todos.setCompleted(index, !todos.todos().at(index).completed);
+        }
+        panel.refresh();
+        QCoreApplication::processEvents();
+    }
+}
+
+void PanelsBench::omniboxQuery() {
+    const int visits = 100000;
+    const QVector<BenchData::SyntheticVisit> seed = BenchData::zipfVisits(visits, visits / 10);
+    StorageExecutor::instance()->blockingRead<bool>([&seed](Storage& s){
+        QSqlDatabase db = s.history();
+        QSqlQuery q(db);
+        db.transaction();
+        q.prepare("INSERT INTO visits (url, title, visited_at) VALUES (?, ?, ?)");
+        qint64 at = 1700000000;
+        for (const auto &v : seed) {
+            q.addBindValue(v.url);
+            q.addBindValue(v.title);
+            q.addBindValue(at++);
+            q.exec();
+        }
+        return db.commit();
+    });
+    HistoryManager history;
+    QCompleter completer;
+    const QStringList queries = BenchData::omniboxQueries(20, visits / 10);
+    // what MainWindow does per debounced keystroke, answer included
+    QBENCHMARK {
+        for (const QString &query : queries) {
+            history.search(query, 10, &completer, [&completer](const HistoryManager::Results& results){
+                QStringList sl;
+                for (const auto &r : results) sl << (r.second.isEmpty() ? r.first : QString("%1 — %2").arg(r.first, r.second));
+                QAbstractItemModel* old = completer.model();
+                completer.setModel(new QStringListModel(sl, &completer));
+                delete old;
+            });
+            StorageExecutor::instance()->waitForIdle();
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    // keep the profile away from the real one
+    QTemporaryDir home;
+    qputenv("XDG_DATA_HOME", home.path().toUtf8());
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) qputenv("QT_QPA_PLATFORM", "offscreen");
+    QApplication app(argc, argv);
+    PanelsBench bench;
+    return BenchRunner::run(&bench, "bench_panels", argc, argv);
+}
+
+#include "panels_bench.moc"
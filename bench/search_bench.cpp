@@ -0,0 +1,103 @@
+// Unified search benchmarks: querying an index over history, bookmarks, notes
+// and todos at up to a million documents, and keeping it up to date.
+//
+//   bench_search [runner options, see bench_support.h] [QtTest args]
+#include <QtTest>
+#include "bench_support.h"
+#include "../cpp/src/SearchIndex.h"
+
+class SearchBench : public QObject {
+    Q_OBJECT
+private slots:
+    void search_data();
+    void search();
+    void build();
+    void todoBurst();
+
+private:
+    // n documents shaped like a profile: mostly history, then bookmarks,
+    // notes and todos
+    static void fill(SearchIndex& index, int n);
+    static QVector<SearchDocument> todos(int n, int version);
+};
+
+void SearchBench::fill(SearchIndex& index, int n) {
+    const int notes = n / 50, todos = n / 50, bookmarks = n / 20;
+    const int history = n - notes - todos - bookmarks;
+    const QVector<BenchData::SyntheticBookmark> titles = BenchData::bookmarks(history + bookmarks, 40);
+    for (int i = 0; i < history; ++i) {
+        SearchDocument d;
+        d.key = BenchData::zipfUrl(i);
+        d.title = titles[i].title;
+        d.text = d.key;
+        d.subtitle = d.key;
+        // Zipf: the first ranks hold most visits
+        d.popularity = qMax(1, 1000 / (i + 1));
+        index.upsert(d);
+    }
+    for (int i = 0; i < bookmarks; ++i) {
+        const BenchData::SyntheticBookmark &b = titles[history + i];
+        index.upsert(SearchDocument{SearchSource::Bookmark, QString::number(i), b.title, b.url, b.url, 1.0, 0});
+    }
+    const QVector<BenchData::SyntheticNote> bodies = BenchData::notes(notes);
+    for (int i = 0; i < notes; ++i)
+        index.upsert(SearchDocument{SearchSource::Note, QString::number(i), bodies[i].title, bodies[i].body, QString(), 1.0, 0});
+    index.replaceSource(SearchSource::Todo, SearchBench::todos(todos, 0));
+}
+
+QVector<SearchDocument> SearchBench::todos(int n, int version) {
+    const QVector<BenchData::SyntheticBookmark> titles = BenchData::bookmarks(n, 0, 9);
+    QVector<SearchDocument> out;
+    out.reserve(n);
+    for (int i = 0; i < n; ++i) {
+        // one in a hundred is edited per version
+        const QString title = i % 100 == 0 ? QString("%1 rev%2").arg(titles[i].title).arg(version) : titles[i].title;
+        out.append(SearchDocument{SearchSource::Todo, QString::number(i), title, QString(), QString(), 1.0, 0});
+    }
+    return out;
+}
+
+void SearchBench::search_data() {
+    QTest::addColumn<int>("documents");
+    QTest::newRow("10k documents") << 10000;
+    QTest::newRow("100k documents") << 100000;
+    QTest::newRow("1M documents") << 1000000;
+}
+
+void SearchBench::search() {
+    QFETCH(int, documents);
+    SearchIndex index;
+    fill(index, documents);
+    const QStringList queries = BenchData::omniboxQueries(20, qMax(100, documents / 10));
+    // 20 palette queries, each returning the top 20 over every store
+    QBENCHMARK {
+        for (const QString &q : queries) index.search(q, 20);
+    }
+}
+
+void SearchBench::build() {
+    QBENCHMARK {
+        SearchIndex index;
+        fill(index, 100000);
+    }
+}
+
+void SearchBench::todoBurst() {
+    // a sync burst: the 50k-todo snapshot comes back with 500 edited items
+    const QVector<SearchDocument> versions[2] = {todos(50000, 0), todos(50000, 1)};
+    SearchIndex index;
+    index.replaceSource(SearchSource::Todo, versions[0]);
+    int next = 1;
+    QBENCHMARK {
+        index.replaceSource(SearchSource::Todo, versions[next]);
+        next ^= 1;
+    }
+}
+
+int main(int argc, char** argv) {
+    QCoreApplication app(argc, argv);
+    SearchBench bench;
+    return BenchRunner::run(&bench, "bench_search", argc, argv);
+}
+
+#include "search_bench.moc"
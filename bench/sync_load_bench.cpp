@@ -0,0 +1,241 @@
+// Sync load test: seeds N unsynced local items, signs in against a local
+// MockSupabaseServer (running on its own thread) and lets the manager push
+// everything, then reports requests, bytes, wall time and local saves per item.
+//
+//   bench_sync [--kind bookmarks|notes|todos] [--items N] [--latency ms] [--jitter ms]
+//              [--error-rate p] [--remote-rows N] [--idle-ms ms] [--timeout s] [--json]
+//
+// The run ends when nothing is pending anymore, when the server has been idle
+// for --idle-ms, or after --timeout; items still pending are reported.
+#include <QCoreApplication>
+#include <QTemporaryDir>
+#include <QThread>
+#include <QTimer>
+#include <QEventLoop>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QDir>
+#include <QStandardPaths>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTextStream>
+#include <functional>
+#include "../cpp/src/MockSupabaseServer.h"
+#include "../cpp/src/AuthManager.h"
+#include "../cpp/src/NetworkClient.h"
+#include "../cpp/src/BookmarksManager.h"
+#include "../cpp/src/NotesManager.h"
+#include "../cpp/src/TodosManager.h"
+
+struct Options {
+    QString kind = "bookmarks";
+    int items = 10000;
+    int latencyMs = 0;
+    int jitterMs = 0;
+    double errorRate = 0.0;
+    int remoteRows = 0;
+    int idleMs = 2000;
+    int timeoutSec = 600;
+    bool json = false;
+};
+
+static Options parseArgs(const QStringList& args) {
+    Options o;
+    for (int i = 1; i < args.size(); ++i) {
+        const QString a = args[i];
+        const QString v = i + 1 < args.size() ? args[i + 1] : QString();
+        if (a == "--json") { o.json = true; continue; }
+        if (a == "--kind") o.kind = v;
+        else if (a == "--items") o.items = v.toInt();
+        else if (a == "--latency") o.latencyMs = v.toInt();
+        else if (a == "--jitter") o.jitterMs = v.toInt();
+        else if (a == "--error-rate") o.errorRate = v.toDouble();
+        else if (a == "--remote-rows") o.remoteRows = v.toInt();
+        else if (a == "--idle-ms") o.idleMs = v.toInt();
+        else if (a == "--timeout") o.timeoutSec = v.toInt();
+        else continue;
+        ++i;
+    }
+    return o;
+}
+
+// a pre-flow.db JSON file, imported when the manager opens storage; every item Unsynced
+static void seedLocal(const QString& path, const QString& kind, int count) {
+    QJsonArray arr;
+    for (int i = 0; i < count; ++i) {
+        QJsonObject o;
+        o["id"] = QString();
+        o["title"] = QString("Load %1 #%2").arg(kind).arg(i);
+        o["status"] = 2;
+        if (kind == "bookmarks") { o["url"] = QString("https://load.example/%1").arg(i); o["folder"] = QString(); }
+        else if (kind == "notes") { o["content"] = QString("Body of load note %1").arg(i); o["workspace"] = QString(); }
+        else { o["completed"] = (i % 2) == 0; o["workspace"] = QString(); }
+        arr.append(o);
+    }
+    QFile f(path);
+    if (f.open(QIODevice::WriteOnly | QIODevice::Truncate)) f.write(QJsonDocument(arr).toJson());
+}
+
+// status counts over the manager's items: [synced, syncing, unsynced, conflict]
+template <class Items>
+static QVector<int> countStatuses(const Items& items) {
+    QVector<int> c(4, 0);
+    for (const auto &it : items) c[qBound(0, int(it.status), 3)]++;
+    return c;
+}
+
+int main(int argc, char** argv) {
+    // keep the managers' AppDataLocation away from the real profile
+    QTemporaryDir home;
+    qputenv("XDG_DATA_HOME", home.path().toUtf8());
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("flow_sync_bench");
+    const Options opt = parseArgs(app.arguments());
+    QTextStream out(stdout);
+    if (opt.kind != "bookmarks" && opt.kind != "notes" && opt.kind != "todos") {
+        out << "unknown --kind " << opt.kind << Qt::endl;
+        return 1;
+    }
+
+    const QString dataDir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    QDir().mkpath(dataDir);
+    seedLocal(QDir(dataDir).filePath(opt.kind + ".json"), opt.kind, opt.items);
+
+    auto *server = new MockSupabaseServer;
+    server->setLatency(opt.latencyMs, opt.jitterMs);
+    server->setErrorRate(opt.errorRate);
+    server->seedRows(opt.kind, opt.remoteRows);
+    QThread serverThread;
+    server->moveToThread(&serverThread);
+    serverThread.start();
+    bool listening = false;
+    QMetaObject::invokeMethod(server, [server, &listening](){ listening = server->listen(); }, Qt::BlockingQueuedConnection);
+    if (!listening) { out << "mock server failed to listen" << Qt::endl; return 1; }
+
+    AuthManager auth;
+    auth.setSupabaseConfig(server->url(), server->anonKey());
+    std::function<void()> syncPending;
+    std::function<QVector<int>()> statuses;
+    std::function<int()> saves;
+    SyncEngineBase* manager = nullptr;
+    if (opt.kind == "bookmarks") {
+        auto *m = new BookmarksManager(&app);
+        m->setSupabaseConfig(server->url(), server->anonKey());
+        m->setAuthManager(&auth);
+        syncPending = [m](){ m->syncPending(); };
+        statuses = [m](){ return countStatuses(m->bookmarks()); };
+        saves = [m](){ return m->saveCount(); };
+        manager = m;
+    } else if (opt.kind == "notes") {
+        auto *m = new NotesManager(&app);
+        m->setSupabaseConfig(server->url(), server->anonKey());
+        m->setAuthManager(&auth);
+        syncPending = [m](){ m->syncPending(); };
+        statuses = [m](){ return countStatuses(m->notes()); };
+        saves = [m](){ return m->saveCount(); };
+        manager = m;
+    } else {
+        auto *m = new TodosManager(&app);
+        m->setSupabaseConfig(server->url(), server->anonKey());
+        m->setAuthManager(&auth);
+        syncPending = [m](){ m->syncPending(); };
+        statuses = [m](){ return countStatuses(m->todos()); };
+        saves = [m](){ return m->saveCount(); };
+        manager = m;
+    }
+    // the stored items arrive from the storage thread
+    if (!manager->isLoaded()) {
+        QEventLoop loaded;
+        QObject::connect(manager, &SyncEngineBase::loaded, &loaded, &QEventLoop::quit);
+        loaded.exec();
+    }
+    const int savesBefore = saves(); // loading does not save, but be explicit
+
+    QEventLoop loop;
+    QElapsedTimer wall;
+    QElapsedTimer idle;
+    qint64 lastRequests = -1;
+    QString endReason = "timeout";
+    QObject::connect(&auth, &AuthManager::signedIn, &loop, [&](){ syncPending(); });
+    QObject::connect(&auth, &AuthManager::authFailed, &loop, [&](const QString &e){ endReason = "auth failed: " + e; loop.quit(); });
+    QTimer poll;
+    poll.setInterval(50);
+    QObject::connect(&poll, &QTimer::timeout, &loop, [&](){
+        const qint64 requests = server->stats().requests;
+        if (requests != lastRequests) { lastRequests = requests; idle.restart(); }
+        const QVector<int> s = statuses();
+        if (requests > 1 && s[1] + s[2] == 0) { endReason = "all items settled"; loop.quit(); return; }
+        if (idle.elapsed() >= opt.idleMs) { endReason = "server idle"; loop.quit(); return; }
+        if (wall.elapsed() >= qint64(opt.timeoutSec) * 1000) { endReason = "timeout"; loop.quit(); }
+    });
+    wall.start();
+    idle.start();
+    poll.start();
+    auth.signIn("load@test.local", "password");
+    loop.exec();
+    const qint64 wallMs = wall.elapsed();
+    poll.stop();
+
+    const MockServerStats st = server->stats();
+    const QVector<int> s = statuses();
+    const int localSaves = saves() - savesBefore;
+    const double n = qMax(1, opt.items);
+
+    QJsonObject report;
+    report["kind"] = opt.kind;
+    report["items"] = opt.items;
+    report["remote_rows"] = opt.remoteRows;
+    report["latency_ms"] = opt.latencyMs;
+    report["error_rate"] = opt.errorRate;
+    report["end_reason"] = endReason;
+    report["wall_ms"] = wallMs;
+    report["requests"] = st.requests;
+    report["bytes_sent"] = st.bytesIn;
+    report["bytes_received"] = st.bytesOut;
+    report["requests_per_item"] = st.requests / n;
+    report["bytes_per_item"] = (st.bytesIn + st.bytesOut) / n;
+    report["local_saves"] = localSaves;
+    report["local_saves_per_item"] = localSaves / n;
+    report["synced"] = s[0];
+    report["syncing"] = s[1];
+    report["unsynced"] = s[2];
+    report["conflict"] = s[3];
+    report["server"] = server->statsJson();
+    report["client"] = NetworkClient::instance()->toJson();
+    const SyncWireStats ws = manager->wireStats();
+    QJsonObject upload;
+    upload["uploads"] = ws.uploads;
+    upload["full_row_bytes"] = ws.fullRowBytes;
+    upload["payload_bytes"] = ws.payloadBytes;
+    upload["wire_bytes"] = ws.wireBytes;
+    upload["gzip_uploads"] = ws.compressed;
+    upload["saved_bytes"] = ws.savedBytes();
+    report["upload"] = upload;
+
+    if (opt.json) {
+        out << QJsonDocument(report).toJson();
+    } else {
+        out << "kind:            " << opt.kind << " x " << opt.items << " (" << opt.remoteRows << " remote rows, "
+            << opt.latencyMs << " ms latency, " << opt.errorRate * 100 << "% errors)" << Qt::endl;
+        out << "ended:           " << endReason << " after " << wallMs << " ms" << Qt::endl;
+        out << "requests:        " << st.requests << " (" << st.requests / n << " per item)" << Qt::endl;
+        out << "bytes:           " << st.bytesIn << " sent, " << st.bytesOut << " received ("
+            << qRound64((st.bytesIn + st.bytesOut) / n) << " per item)" << Qt::endl;
+        out << "local saves:     " << localSaves << " (" << localSaves / n << " per item)" << Qt::endl;
+        out << "final state:     " << s[0] << " synced, " << s[1] << " syncing, " << s[2] << " unsynced, "
+            << s[3] << " conflict" << Qt::endl;
+        out << "upload bodies:   " << ws.wireBytes << " bytes on the wire for " << ws.fullRowBytes << " bytes of rows ("
+            << ws.compressed << " of " << ws.uploads << " gzip-encoded)" << Qt::endl;
+        const NetworkStats ns = NetworkClient::instance()->stats();
+        out << "client queue:    " << ns.meanQueueMs(NetworkClient::Interactive) << " ms interactive, "
+            << ns.meanQueueMs(NetworkClient::Background) << " ms background (mean), peak " << ns.peakInFlight
+            << " in flight" << Qt::endl;
+    }
+
+    delete manager;
+    QMetaObject::invokeMethod(server, [server](){ delete server; }, Qt::BlockingQueuedConnection);
+    serverThread.quit();
+    serverThread.wait();
+    return 0;
+}
@@ -1,4 +1,5 @@
 #include "AuthManager.h"
+#include "NetworkClient.h"
 #include <QNetworkRequest>
 #include <QNetworkReply>
 #include <QJsonDocument>
@@ -7,15 +8,29 @@
 #include <QFile>
 #include <QDir>
 #include <QDateTime>
+#include <QTimer>
+#include <QCoreApplication>
+#include <QPointer>
+#include <utility>
 
 AuthManager::AuthManager(QObject* parent) : QObject(parent) {
-    connect(&m_net, &QNetworkAccessManager::finished, this, &AuthManager::onNetworkReplyFinished);
+    m_refreshTimer = new QTimer(this);
+    m_refreshTimer->setSingleShot(true);
+    connect(m_refreshTimer, &QTimer::timeout, this, &AuthManager::refresh);
     loadTokens();
 }
 
+AuthManager* AuthManager::instance() {
+    static QPointer<AuthManager> s_instance;
+    if (!s_instance) s_instance = new AuthManager(QCoreApplication::instance());
+    return s_instance;
+}
+
 void AuthManager::setSupabaseConfig(const QString& url, const QString& anonKey) {
     m_supabaseUrl = url;
     m_anonKey = anonKey;
+    // a session restored from auth.json may be close to or past expiry
+    scheduleRefresh();
 }
 
 void AuthManager::signIn(const QString& email, const QString& password) {
@@ -23,17 +38,10 @@ void AuthManager::signIn(const QString& email, const QString& password) {
         emit authFailed("Supabase config not set");
         return;
     }
-    QUrl u(m_supabaseUrl + "/auth/v1/token?grant_type=password");
-    QNetworkRequest req(u);
-    req.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
-    req.setRawHeader("apikey", m_anonKey.toUtf8());
-
     QJsonObject body;
     body["email"] = email;
     body["password"] = password;
-    QByteArray data = QJsonDocument(body).toJson();
-
-    m_net.post(req, data);
+    post(QUrl(m_supabaseUrl + "/auth/v1/token?grant_type=password"), body, [this](QNetworkReply* reply){ onNetworkReplyFinished(reply); });
 }
 
 void AuthManager::signUp(const QString& email, const QString& password) {
@@ -41,29 +49,117 @@ void AuthManager::signUp(const QString& email, const QString& password) {
         emit authFailed("Supabase config not set");
         return;
     }
-    QUrl u(m_supabaseUrl + "/auth/v1/signup");
-    QNetworkRequest req(u);
-    req.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
-    req.setRawHeader("apikey", m_anonKey.toUtf8());
-
     QJsonObject body;
     body["email"] = email;
     body["password"] = password;
-    QByteArray data = QJsonDocument(body).toJson();
+    post(QUrl(m_supabaseUrl + "/auth/v1/signup"), body, [this](QNetworkReply* reply){ onNetworkReplyFinished(reply); });
+}
 
-    m_net.post(req, data);
+void AuthManager::post(const QUrl& url, const QJsonObject& body, std::function<void(QNetworkReply*)> onFinished) {
+    QNetworkRequest req(url);
+    req.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
+    req.setRawHeader("apikey", m_anonKey.toUtf8());
+    // either the user is waiting on the sign-in dialog or requests wait on the refresh
+    NetworkClient::instance()->send(req, "POST", QJsonDocument(body).toJson(), NetworkClient::Interactive, this,
+                                    std::move(onFinished));
 }
 
 void AuthManager::signOut() {
+    m_refreshTimer->stop();
+    m_refreshing = false;
+    m_refreshFailures = 0;
     m_accessToken.clear();
     m_refreshToken.clear();
     m_userId.clear();
     m_expiresAt = 0;
     saveTokens();
     emit signedOut();
+    releaseWaiters();
 }
 
-bool AuthManager::isSignedIn() const { return !m_accessToken.isEmpty() && m_expiresAt > QDateTime::currentSecsSinceEpoch(); }
+bool AuthManager::isSignedIn() const {
+    if (m_accessToken.isEmpty()) return false;
+    return m_expiresAt > QDateTime::currentSecsSinceEpoch() || !m_refreshToken.isEmpty();
+}
+
+bool AuthManager::tokenUsable() const {
+    return !m_refreshing && m_expiresAt > QDateTime::currentSecsSinceEpoch();
+}
+
+void AuthManager::whenTokenReady(QObject* context, std::function<void()> fn) {
+    if (tokenUsable() || m_refreshToken.isEmpty() || m_supabaseUrl.isEmpty()) { fn(); return; }
+    m_waiters.append({context, std::move(fn)});
+    refresh();
+}
+
+void AuthManager::tokenRejected(const QString& rejectedToken, QObject* context, std::function<void()> fn) {
+    // someone else's 401 already got a new token
+    if (m_refreshToken.isEmpty() || (rejectedToken != m_accessToken && !m_refreshing)) { fn(); return; }
+    m_waiters.append({context, std::move(fn)});
+    refresh();
+}
+
+void AuthManager::refresh() {
+    if (m_refreshing || m_refreshToken.isEmpty() || m_supabaseUrl.isEmpty()) return;
+    // another process may have renewed the session already, using up our token
+    if (adoptSavedSession() && m_expiresAt - refreshMargin() > QDateTime::currentSecsSinceEpoch()) {
+        emit tokenRefreshed();
+        releaseWaiters();
+        return;
+    }
+    m_refreshing = true;
+    m_refreshTimer->stop();
+    const QString token = m_refreshToken;
+    QJsonObject body;
+    body["refresh_token"] = token;
+    post(QUrl(m_supabaseUrl + "/auth/v1/token?grant_type=refresh_token"), body,
+         [this, token](QNetworkReply* reply){ onRefreshFinished(reply, token); });
+}
+
+void AuthManager::onRefreshFinished(QNetworkReply* reply, const QString& sentToken) {
+    // signed out while the refresh was on the wire
+    if (!m_refreshing) return;
+    m_refreshing = false;
+    const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    const QJsonObject obj = QJsonDocument::fromJson(reply->readAll()).object();
+    if (reply->error() == QNetworkReply::NoError && obj.contains("access_token")) {
+        m_refreshFailures = 0;
+        ++m_refreshCount;
+        handleAuthResponse(obj);
+        emit tokenRefreshed();
+        releaseWaiters();
+        return;
+    }
+    if (status == 400 || status == 401 || status == 403) {
+        // used up by another process that renewed at the same time: go on
+        // with its session instead of wiping the saved one
+        if (m_refreshToken == sentToken && adoptSavedSession()) {
+            emit tokenRefreshed();
+            releaseWaiters();
+            return;
+        }
+        // the refresh token is unknown or used up: only a new sign-in helps
+        signOut();
+        return;
+    }
+    // offline or server trouble: the session is still good, try again soon
+    ++m_refreshFailures;
+    m_refreshTimer->start(qMin(60, 1 << qMin(m_refreshFailures, 6)) * 1000);
+    releaseWaiters();
+}
+
+void AuthManager::scheduleRefresh() {
+    m_refreshTimer->stop();
+    if (m_refreshToken.isEmpty() || m_supabaseUrl.isEmpty() || m_refreshing) return;
+    // a minute ahead of expiry, or halfway through very short-lived tokens
+    const qint64 dueMs = (m_expiresAt - refreshMargin()) * 1000 - QDateTime::currentMSecsSinceEpoch();
+    m_refreshTimer->start(int(qBound<qint64>(0, dueMs, 24LL * 3600 * 1000)));
+}
+
+void AuthManager::releaseWaiters() {
+    const QVector<Waiter> waiters = std::exchange(m_waiters, QVector<Waiter>());
+    for (const Waiter &w : waiters) if (w.context) w.fn();
+}
 QString AuthManager::accessToken() const { return m_accessToken; }
 QString AuthManager::userId() const { return m_userId; }
 
@@ -73,14 +169,12 @@ void AuthManager::onNetworkReplyFinished(QNetworkReply* reply) {
 
     if (reply->error() != QNetworkReply::NoError) {
         emit authFailed(reply->errorString());
-        reply->deleteLater();
         return;
     }
 
     QJsonDocument doc = QJsonDocument::fromJson(resp);
     if (!doc.isObject()) {
         emit authFailed("Invalid auth response");
-        reply->deleteLater();
         return;
     }
     QJsonObject obj = doc.object();
@@ -99,8 +193,6 @@ void AuthManager::onNetworkReplyFinished(QNetworkReply* reply) {
     } else {
         emit authFailed("Unexpected auth response");
     }
-
-    reply->deleteLater();
 }
 
 void AuthManager::handleAuthResponse(const QJsonObject& obj) {
@@ -108,10 +200,12 @@ void AuthManager::handleAuthResponse(const QJsonObject& obj) {
     m_refreshToken = obj["refresh_token"].toString();
     int expiresIn = obj["expires_in"].toInt();
     m_expiresAt = QDateTime::currentSecsSinceEpoch() + expiresIn;
+    if (expiresIn > 0) m_lifetime = expiresIn;
     if (obj.contains("user") && obj["user"].isObject()) {
         m_userId = obj["user"].toObject()["id"].toString();
     }
     saveTokens();
+    scheduleRefresh();
 }
 
 void AuthManager::saveTokens() {
@@ -130,18 +224,35 @@ void AuthManager::saveTokens() {
     }
 }
 
-void AuthManager::loadTokens() {
+QJsonObject AuthManager::readSavedTokens() {
     QString dataDir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
     QString path = QDir(dataDir).filePath("auth.json");
     QFile f(path);
-    if (!f.open(QIODevice::ReadOnly)) return;
-    QByteArray data = f.readAll();
-    f.close();
-    QJsonDocument doc = QJsonDocument::fromJson(data);
-    if (!doc.isObject()) return;
-    QJsonObject o = doc.object();
+    if (!f.open(QIODevice::ReadOnly)) return QJsonObject();
+    return QJsonDocument::fromJson(f.readAll()).object();
+}
+
+void AuthManager::loadTokens() {
+    const QJsonObject o = readSavedTokens();
+    if (o.isEmpty()) return;
     m_accessToken = o["access_token"].toString();
     m_refreshToken = o["refresh_token"].toString();
     m_expiresAt = o["expires_at"].toString().toLongLong();
     m_userId = o["user_id"].toString();
-}
\ No newline at end of file
+}
+
+bool AuthManager::adoptSavedSession() {
+    const QJsonObject o = readSavedTokens();
+    const QString refreshToken = o["refresh_token"].toString();
+    const qint64 expiresAt = o["expires_at"].toString().toLongLong();
+    // signed out elsewhere, still ours, or an older session
+    if (refreshToken.isEmpty() || refreshToken == m_refreshToken || expiresAt < m_expiresAt) return false;
+    // another account is a sign-in, not a renewal
+    if (o["user_id"].toString() != m_userId) return false;
+    m_accessToken = o["access_token"].toString();
+    m_refreshToken = refreshToken;
+    m_expiresAt = expiresAt;
+    m_refreshFailures = 0;
+    scheduleRefresh();
+    return true;
+}
@@ -2,32 +2,83 @@
 
 #include <QObject>
 #include <QString>
-#include <QNetworkAccessManager>
+#include <QPointer>
+#include <QVector>
+#include <functional>
 
+class QNetworkReply;
+class QJsonObject;
+class QTimer;
+
+// Supabase GoTrue session. The access token is renewed with the refresh_token
+// grant shortly before it expires; requests made while a renewal is running
+// wait for it instead of going out with a dead token.
+// Refresh tokens are single use, so the windows of the app share instance().
+// Other processes of the profile (flow_cli) share auth.json: it is read again
+// before each renewal, and a refused refresh token only ends the session when
+// the saved one is no newer.
 class AuthManager : public QObject {
     Q_OBJECT
 public:
     explicit AuthManager(QObject* parent = nullptr);
+    // the session of the app, shared by all its windows
+    static AuthManager* instance();
 
     void setSupabaseConfig(const QString& url, const QString& anonKey);
     void signIn(const QString& email, const QString& password);
     void signUp(const QString& email, const QString& password);
     void signOut();
 
+    // a session exists; its access token may be expired but can be refreshed
     bool isSignedIn() const;
     QString accessToken() const;
     QString userId() const;
+    bool isRefreshing() const { return m_refreshing; }
+    int refreshCount() const { return m_refreshCount; }
+
+    // Run fn once the access token is usable: right away, or after the refresh
+    // that is running or due. fn also runs when the refresh fails, so callers
+    // are never left waiting; their request then fails like any other.
+    void whenTokenReady(QObject* context, std::function<void()> fn);
+    // The server refused rejectedToken (HTTP 401). Refreshes once for all
+    // callers holding that token, then runs fn; runs fn right away if the
+    // token has been replaced already.
+    void tokenRejected(const QString& rejectedToken, QObject* context, std::function<void()> fn);
 
 signals:
     void signedIn();
     void signedOut();
     void authFailed(const QString& error);
+    // the access token was renewed; the session and user are unchanged
+    void tokenRefreshed();
+
+private:
+    struct Waiter {
+        QPointer<QObject> context;
+        std::function<void()> fn;
+    };
 
-private slots:
+    // the reply is owned (and deleted) by NetworkClient
     void onNetworkReplyFinished(QNetworkReply* reply);
+    void onRefreshFinished(QNetworkReply* reply, const QString& sentToken);
+    void post(const QUrl& url, const QJsonObject& body, std::function<void(QNetworkReply*)> onFinished);
+    void refresh();
+    void scheduleRefresh();
+    void releaseWaiters();
+    bool tokenUsable() const;
+    // seconds before expiry at which the token is renewed
+    qint64 refreshMargin() const { return qMin<qint64>(60, m_lifetime / 2); }
+    // take over a session that another process saved since; false when the
+    // saved one is not newer than this one
+    bool adoptSavedSession();
+
+    QTimer* m_refreshTimer;
+    bool m_refreshing = false;
+    int m_refreshFailures = 0;
+    int m_refreshCount = 0;
+    qint64 m_lifetime = 3600; // seconds, from the last expires_in
+    QVector<Waiter> m_waiters;
 
-private:
-    QNetworkAccessManager m_net;
     QString m_supabaseUrl;
     QString m_anonKey;
 
@@ -38,5 +89,6 @@ private:
 
     void saveTokens();
     void loadTokens();
+    static QJsonObject readSavedTokens();
     void handleAuthResponse(const QJsonObject& obj);
 };
\ No newline at end of file
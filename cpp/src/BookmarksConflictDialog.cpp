@@ -36,7 +36,10 @@ void BookmarksConflictDialog::refreshList() {
     for (int idx : cs) {
         if (idx >=0 && idx < items.size()) {
             const auto &b = items[idx];
-            m_list->addItem(QString("%1: %2 (%3)").arg(QString::number(idx)).arg(b.title).arg(b.url));
+            QString text = QString("%1: %2 (%3)").arg(QString::number(idx)).arg(b.title).arg(b.url);
+            const Bookmark remote = m_mgr->remoteVersion(idx);
+            if (!remote.id.isEmpty()) text += QString("  |  remote: %1 (%2)").arg(remote.title).arg(remote.url);
+            m_list->addItem(text);
         }
     }
 }
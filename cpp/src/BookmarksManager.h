@@ -1,11 +1,7 @@
 #pragma once
 
-#include <QObject>
-#include <QVector>
-
-class AuthManager;
-
-enum class SyncStatus { Synced=0, Syncing=1, Unsynced=2, Conflict=3 };
+#include "SyncedCollection.h"
+#include <QString>
 
 struct Bookmark {
     QString id; // Supabase id if synced
@@ -15,55 +11,29 @@ struct Bookmark {
     SyncStatus status = SyncStatus::Synced;
 };
 
-class BookmarksManager : public QObject {
+struct BookmarkTraits {
+    using Item = Bookmark;
+    static constexpr const char* table = "bookmarks";
+    // one bookmark per URL, even when it was created on two devices
+    static QString identityKey(const Bookmark& b) { return b.url; }
+    static QJsonObject toRemote(const Bookmark& b);
+    static Bookmark fromRemote(const QJsonObject& o);
+    static QJsonObject toLocal(const Bookmark& b);
+    static Bookmark fromLocal(const QJsonObject& o);
+};
+
+class BookmarksManager : public SyncedCollection<BookmarkTraits> {
     Q_OBJECT
 public:
     explicit BookmarksManager(QObject* parent = nullptr);
-    QVector<Bookmark> bookmarks() const;
+    QVector<Bookmark> bookmarks() const { return items(); }
     void addBookmark(const QString& title, const QString& url, const QString& folder = QString(), const QString& id = QString());
+    // add in one change, skipping URLs already bookmarked; returns how many were added
+    int addBookmarks(const QVector<Bookmark>& bookmarks);
     void editBookmark(int index, const QString& title, const QString& url, const QString& folder = QString());
-    void removeBookmark(int index);
-
-    void setSupabaseConfig(const QString& supabaseUrl, const QString& anonKey);
-    void setAuthManager(AuthManager* auth);
-
-public slots:
-    void syncFromSupabase();
-    void syncPending();
-
-    QList<int> conflictIndices() const;
-    void retrySync(int index);
-    void keepLocal(int index);
-    void keepRemote(int index);
-
-    // Undo / delete with undo
-    void removeBookmarkWithUndo(int index);
-    void undoLastRemove();
-    bool hasPendingUndo() const;
+    void removeBookmark(int index) { remove(index); }
+    void removeBookmarkWithUndo(int index) { removeWithUndo(index); }
 
 signals:
     void bookmarksUpdated();
-    void bookmarkSyncStatusChanged(int index);
-    void syncPendingCountChanged(int count);
-    void lastRemoveAvailable(bool available);
-
-private:
-    void load();
-    void save();
-
-    QVector<Bookmark> m_bookmarks;
-    QString m_filePath;
-
-    QString m_supabaseUrl;
-    QString m_anonKey;
-    AuthManager* m_auth;
-    QNetworkAccessManager* m_net;
-
-    int pendingCount() const;
-
-    // Undo buffer
-    Bookmark m_lastRemoved;
-    int m_lastRemovedIndex = -1;
-    QTimer* m_undoTimer = nullptr;
-    bool m_hasPendingUndo = false;
-};
\ No newline at end of file
+};
@@ -1,5 +1,6 @@
 #include "BookmarksPanel.h"
 #include "BookmarksManager.h"
+#include "Trace.h"
 #include <QVBoxLayout>
 #include <QTreeWidget>
 #include <QPushButton>
@@ -53,6 +54,13 @@ BookmarksPanel::BookmarksPanel(BookmarksManager* manager, QWidget* parent): QWid
         }
     });
 
+    m_list->setMouseTracking(true);
+    connect(m_list, &QTreeWidget::itemEntered, this, [this](QTreeWidgetItem* item, int){
+        // folder rows carry no index
+        if (!item || !item->data(0, Qt::UserRole).isValid()) return;
+        emit itemHovered(item->data(0, Qt::UserRole).toInt());
+    });
+
     connect(m_list, &QTreeWidget::itemActivated, this, [this](QTreeWidgetItem* item, int){
         if (!item) return;
         int idx = item->data(0, Qt::UserRole).toInt();
@@ -60,10 +68,6 @@ BookmarksPanel::BookmarksPanel(BookmarksManager* manager, QWidget* parent): QWid
         emit itemActivated(idx, newTab);
     });
 
-    connect(m_manager, &BookmarksManager::bookmarkSyncStatusChanged, this, [this](int idx){
-        Q_UNUSED(idx)
-        refresh();
-    });
     connect(m_manager, &BookmarksManager::syncPendingCountChanged, this, [this](int cnt){
         Q_UNUSED(cnt)
         // maybe show a small indicator in panel header later
@@ -73,6 +77,7 @@ BookmarksPanel::BookmarksPanel(BookmarksManager* manager, QWidget* parent): QWid
 }
 
 void BookmarksPanel::refresh() {
+    FLOW_TRACE_SCOPE("BookmarksPanel::refresh");
     m_list->clear();
     auto items = m_manager->bookmarks();
     // group by folder
@@ -11,6 +11,8 @@ public:
 
 signals:
     void itemActivated(int index, bool newTab);
+    // pointer rests on a bookmark; used to warm up its connection
+    void itemHovered(int index);
     void editRequested(int index);
     void deleteRequested(int index);
 
@@ -0,0 +1,310 @@
+#include "BrowserImporter.h"
+#include "HistoryManager.h"
+#include "StorageExecutor.h"
+#include "Trace.h"
+#include <QCryptographicHash>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QRegularExpression>
+#include <QSemaphore>
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QTemporaryDir>
+#include <QThread>
+#include <QVariant>
+#include <memory>
+
+namespace {
+constexpr qint64 kChromeEpochOffsetSecs = 11644473600LL;
+// visit batches handed to the storage thread and not written yet
+constexpr int kBatchesInFlight = 2;
+
+// Chrome also records chrome://, extension and data: pages
+bool importable(const QString& url) {
+    return url.startsWith("http://") || url.startsWith("https://") || url.startsWith("ftp://") || url.startsWith("file://");
+}
+
+QString decodeEntities(const QString& s) {
+    if (!s.contains('&')) return s;
+    static const QRegularExpression entity("&(#[xX][0-9a-fA-F]+|#[0-9]+|amp|lt|gt|quot|apos);");
+    QString out;
+    int last = 0;
+    for (auto it = entity.globalMatch(s); it.hasNext();) {
+        const QRegularExpressionMatch m = it.next();
+        out += s.mid(last, m.capturedStart() - last);
+        last = m.capturedEnd();
+        const QString e = m.captured(1);
+        if (e == "amp") out += '&';
+        else if (e == "lt") out += '<';
+        else if (e == "gt") out += '>';
+        else if (e == "quot") out += '"';
+        else if (e == "apos") out += '\'';
+        else {
+            bool ok = false;
+            const char32_t c = e.size() > 1 && (e[1] == 'x' || e[1] == 'X') ? e.mid(2).toUInt(&ok, 16) : e.mid(1).toUInt(&ok);
+            if (ok) out += QString::fromUcs4(&c, 1);
+        }
+    }
+    return out + s.mid(last);
+}
+
+// where the newest imported visit of a file is kept
+QString markerKey(const QString& path) {
+    const QByteArray hash = QCryptographicHash::hash(QFileInfo(path).absoluteFilePath().toUtf8(), QCryptographicHash::Md5);
+    return "import_" + QString::fromLatin1(hash.toHex().left(16));
+}
+}
+
+BrowserImporter::BrowserImporter(HistoryManager* history, BookmarksManager* bookmarks, QObject* parent)
+    : QObject(parent), m_history(history), m_bookmarks(bookmarks) {
+    qRegisterMetaType<BrowserImporter::Result>();
+}
+
+BrowserImporter::~BrowserImporter() {
+    if (!m_thread) return;
+    m_cancel = true;
+    m_thread->wait();
+    delete m_thread;
+}
+
+bool BrowserImporter::start(const QString& path) {
+    if (m_thread) return false;
+    m_cancel = false;
+    m_added = 0;
+    m_known = 0;
+    m_thread = QThread::create([this, path](){ run(path); });
+    m_thread->setObjectName("import");
+    m_thread->start();
+    return true;
+}
+
+qint64 BrowserImporter::chromeTimeToSecs(qint64 chromeMicros) {
+    return chromeMicros / 1000000 - kChromeEpochOffsetSecs;
+}
+
+void BrowserImporter::readBookmarksHtml(QIODevice& in, const std::function<bool(const Bookmark&)>& found) {
+    // exports put each tag on its own line, so lines are read one at a time
+    static const QRegularExpression anchor(R"(<A\s[^>]*HREF="([^"]*)"[^>]*>(.*?)</A>)", QRegularExpression::CaseInsensitiveOption);
+    static const QRegularExpression heading(R"(<H3([^>]*)>(.*?)</H3>)", QRegularExpression::CaseInsensitiveOption);
+    QStringList folders;  // one per open <DL>
+    QString next;         // named by the last <H3>, opened by the next <DL>
+    while (!in.atEnd()) {
+        const QString line = QString::fromUtf8(in.readLine());
+        if (const QRegularExpressionMatch m = heading.match(line); m.hasMatch()) {
+            // the toolbar is where bookmarks live, not a folder of the user's
+            next = m.captured(1).contains("PERSONAL_TOOLBAR_FOLDER", Qt::CaseInsensitive) ? QString() : decodeEntities(m.captured(2).trimmed());
+        }
+        if (line.contains("<DL", Qt::CaseInsensitive)) {
+            folders.append(next);
+            next.clear();
+        }
+        if (const QRegularExpressionMatch m = anchor.match(line); m.hasMatch()) {
+            Bookmark b;
+            b.url = decodeEntities(m.captured(1));
+            b.title = decodeEntities(m.captured(2).trimmed());
+            if (b.title.isEmpty()) b.title = b.url;
+            b.folder = folders.isEmpty() ? QString() : folders.last();
+            if (importable(b.url) && !found(b)) return;
+        }
+        if (line.contains("</DL", Qt::CaseInsensitive) && !folders.isEmpty()) folders.removeLast();
+    }
+}
+
+void BrowserImporter::run(const QString& path) {
+    FLOW_TRACE_SCOPE("BrowserImporter::run");
+    QElapsedTimer timer;
+    timer.start();
+    Result r;
+    QFile f(path);
+    if (!f.open(QIODevice::ReadOnly)) {
+        r.error = QString("Cannot open %1: %2").arg(path, f.errorString());
+    } else {
+        const QByteArray head = f.read(1024);
+        f.close();
+        if (head.startsWith("SQLite format 3")) importSqlite(path, r);
+        else if (head.contains("NETSCAPE-Bookmark-file")) importHtml(path, r);
+        else r.error = "Not a Chrome or Firefox profile database, or a bookmarks HTML export";
+    }
+    r.cancelled = m_cancel;
+    r.ms = timer.nsecsElapsed() / 1e6;
+    // after the last bookmark batch, which was queued before
+    QMetaObject::invokeMethod(this, [this, r](){ finish(r); }, Qt::QueuedConnection);
+}
+
+void BrowserImporter::importSqlite(const QString& path, Result& r) {
+    QTemporaryDir tmp;
+    const QString copy = tmp.filePath("source.sqlite");
+    if (!tmp.isValid() || !QFile::copy(path, copy)) {
+        r.error = QString("Cannot copy %1").arg(path);
+        return;
+    }
+    // what the browser has not checkpointed yet is in its WAL
+    if (QFile::exists(path + "-wal")) QFile::copy(path + "-wal", copy + "-wal");
+
+    const QString connection = QString("flow_import_%1").arg(quintptr(this));
+    {
+        QSqlDatabase src = QSqlDatabase::addDatabase("QSQLITE", connection);
+        src.setDatabaseName(copy);
+        if (!src.open()) {
+            r.error = QString("Cannot read %1: %2").arg(path, src.lastError().text());
+        } else {
+            const QStringList tables = src.tables();
+            if (tables.contains("urls") && tables.contains("visits")) r.format = Format::ChromeHistory;
+            else if (tables.contains("moz_places") && tables.contains("moz_historyvisits")) r.format = Format::FirefoxPlaces;
+            if (r.format == Format::Unknown) r.error = "Not a Chrome History or Firefox places.sqlite file";
+            else importVisits(src, markerKey(path), r);
+            if (r.format == Format::FirefoxPlaces && !m_cancel && r.error.isEmpty()) importPlacesBookmarks(src);
+        }
+        src.close();
+    }
+    QSqlDatabase::removeDatabase(connection);
+}
+
+void BrowserImporter::importVisits(QSqlDatabase src, const QString& key, Result& r) {
+    FLOW_TRACE_SCOPE("BrowserImporter::importVisits");
+    const bool chrome = r.format == Format::ChromeHistory;
+    // in the source's own time unit
+    const qint64 since = StorageExecutor::instance()->blockingRead<qint64>([key](Storage& s){
+        return s.value(key, "0").toLongLong();
+    });
+    QSqlQuery count(src);
+    count.prepare(chrome ? "SELECT COUNT(*) FROM visits WHERE visit_time > ?" : "SELECT COUNT(*) FROM moz_historyvisits WHERE visit_date > ?");
+    count.addBindValue(since);
+    const qint64 total = count.exec() && count.next() ? count.value(0).toLongLong() : 0;
+
+    // oldest first along the time index, so the marker is right wherever it stops
+    QSqlQuery q(src);
+    q.setForwardOnly(true);
+    q.prepare(chrome ? "SELECT u.url, u.title, v.visit_time FROM visits v JOIN urls u ON u.id = v.url "
+                       "WHERE v.visit_time > ? ORDER BY v.visit_time"
+                     : "SELECT p.url, p.title, v.visit_date FROM moz_historyvisits v JOIN moz_places p ON p.id = v.place_id "
+                       "WHERE v.visit_date > ? ORDER BY v.visit_date");
+    q.addBindValue(since);
+    if (!q.exec()) {
+        r.error = q.lastError().text();
+        return;
+    }
+
+    auto slots = std::make_shared<QSemaphore>(kBatchesInFlight);
+    auto written = std::make_shared<std::atomic<qint64>>(0);
+    // set by the first batch that could not be written; the batches queued
+    // behind it are skipped, so the marker stays at the last one on disk
+    auto failed = std::make_shared<std::atomic<bool>>(false);
+    QVector<HistoryManager::Visit> batch;
+    batch.reserve(kVisitBatch);
+    qint64 rows = 0;
+    qint64 newest = since;
+    const auto flush = [&](){
+        if (batch.isEmpty()) return;
+        // waits while two batches are still being written
+        slots->acquire();
+        const QString marker = QString::number(newest);
+        StorageExecutor::instance()->run([batch = std::move(batch), slots, written, failed, key, marker](Storage& s){
+            if (!*failed) {
+                const bool stored = HistoryManager::writeVisits(s, batch);
+                if (stored) *written += batch.size();
+                // without its marker the batch would be imported again next time
+                if (!stored || !s.setValue(key, marker)) {
+                    *failed = true;
+                    qWarning() << "Import: writing" << batch.size() << "visits failed";
+                }
+            }
+            slots->release();
+        });
+        batch = QVector<HistoryManager::Visit>();
+        batch.reserve(kVisitBatch);
+        report(rows, total);
+    };
+    while (!m_cancel && !*failed && q.next()) {
+        ++rows;
+        newest = q.value(2).toLongLong();
+        const QString url = q.value(0).toString();
+        if (!importable(url)) continue;
+        batch.append(HistoryManager::Visit{url, q.value(1).toString(), chrome ? chromeTimeToSecs(newest) : newest / 1000000});
+        if (batch.size() == kVisitBatch) flush();
+    }
+    if (!*failed) flush();
+    // every batch is on disk once all slots are back
+    slots->acquire(kBatchesInFlight);
+    r.visits = written->load();
+    if (*failed) r.error = QString("Writing visits to history failed after %1 of them; importing again resumes there").arg(r.visits);
+    report(rows, total);
+}
+
+void BrowserImporter::importPlacesBookmarks(QSqlDatabase src) {
+    FLOW_TRACE_SCOPE("BrowserImporter::importPlacesBookmarks");
+    QSqlQuery q(src);
+    q.setForwardOnly(true);
+    // the menu, toolbar, "other" and mobile roots are no folder of the user's
+    if (!q.exec("SELECT p.url, b.title, CASE WHEN f.guid IN ('menu________', 'toolbar_____', 'unfiled_____', 'mobile______') "
+                "THEN '' ELSE f.title END FROM moz_bookmarks b JOIN moz_places p ON p.id = b.fk "
+                "LEFT JOIN moz_bookmarks f ON f.id = b.parent WHERE b.type = 1 ORDER BY b.parent, b.position")) {
+        qWarning() << "Import: reading bookmarks failed:" << q.lastError().text();
+        return;
+    }
+    QVector<Bookmark> batch;
+    while (!m_cancel && q.next()) {
+        Bookmark b;
+        b.url = q.value(0).toString();
+        b.title = q.value(1).toString();
+        if (b.title.isEmpty()) b.title = b.url;
+        b.folder = q.value(2).toString();
+        if (!importable(b.url)) continue;
+        batch.append(b);
+        if (batch.size() == kBookmarkBatch) sendBookmarks(batch);
+    }
+    sendBookmarks(batch);
+}
+
+void BrowserImporter::importHtml(const QString& path, Result& r) {
+    FLOW_TRACE_SCOPE("BrowserImporter::importHtml");
+    r.format = Format::BookmarksHtml;
+    QFile f(path);
+    if (!f.open(QIODevice::ReadOnly)) {
+        r.error = f.errorString();
+        return;
+    }
+    const qint64 total = f.size();
+    QVector<Bookmark> batch;
+    readBookmarksHtml(f, [&](const Bookmark& b){
+        batch.append(b);
+        if (batch.size() == kBookmarkBatch) {
+            sendBookmarks(batch);
+            report(f.pos(), total);
+        }
+        return !m_cancel;
+    });
+    sendBookmarks(batch);
+    report(total, total);
+}
+
+void BrowserImporter::sendBookmarks(QVector<Bookmark>& batch) {
+    if (batch.isEmpty()) return;
+    QMetaObject::invokeMethod(this, [this, batch](){
+        if (!m_bookmarks) return;
+        const int added = m_bookmarks->addBookmarks(batch);
+        m_added += added;
+        m_known += batch.size() - added;
+    }, Qt::QueuedConnection);
+    batch.clear();
+}
+
+void BrowserImporter::report(qint64 done, qint64 total) {
+    QMetaObject::invokeMethod(this, [this, done, total](){ emit progress(done, total); }, Qt::QueuedConnection);
+}
+
+void BrowserImporter::finish(Result r) {
+    m_thread->wait();
+    delete m_thread;
+    m_thread = nullptr;
+    r.bookmarks = m_added;
+    r.knownBookmarks = m_known;
+    if (m_history && r.visits > 0) m_history->reportImported(r.visits);
+    qInfo().noquote() << QString("Import: %1 visits, %2 new bookmarks (%3 known) in %4 ms%5")
+                             .arg(r.visits).arg(r.bookmarks).arg(r.knownBookmarks).arg(r.ms, 0, 'f', 0)
+                             .arg(r.error.isEmpty() ? QString() : " - " + r.error);
+    emit finished(r);
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <QObject>
+#include <QPointer>
+#include <QSqlDatabase>
+#include <QString>
+#include <QVector>
+#include <atomic>
+#include <functional>
+#include "BookmarksManager.h"
+
+class QIODevice;
+class QThread;
+class HistoryManager;
+
+// Imports another browser's data: a Chrome "History" file, a Firefox
+// "places.sqlite" (history and bookmarks) or a bookmarks HTML export in the
+// Netscape format every browser writes.
+//
+// The file is read on a worker thread and streamed. Visits go to history.db
+// in batches of kVisitBatch, each its own transaction on the storage thread;
+// at most three batches are in memory at a time, one filling and two being
+// written. Bookmarks reach BookmarksManager::addBookmarks() a batch at a
+// time, so they are saved and pushed as a few changes rather than one per
+// bookmark. SQLite files are copied first, as the other browser keeps them
+// locked while it runs.
+//
+// Visits are imported oldest first and the newest imported time is kept per
+// source file, so importing the same file again only adds what is new.
+class BrowserImporter : public QObject {
+    Q_OBJECT
+public:
+    enum class Format { Unknown, ChromeHistory, FirefoxPlaces, BookmarksHtml };
+    struct Result {
+        Format format = Format::Unknown;
+        qint64 visits = 0;
+        int bookmarks = 0;          // added
+        int knownBookmarks = 0;     // skipped, the URL was bookmarked already
+        bool cancelled = false;
+        QString error;              // empty on success
+        double ms = 0;
+    };
+
+    BrowserImporter(HistoryManager* history, BookmarksManager* bookmarks, QObject* parent = nullptr);
+    ~BrowserImporter() override;
+
+    // false while another import runs
+    bool start(const QString& path);
+    void cancel() { m_cancel = true; }
+    bool isRunning() const { return m_thread != nullptr; }
+
+    static constexpr int kVisitBatch = 50000;
+    static constexpr int kBookmarkBatch = 1000;
+
+    // exposed for tests
+    // Chrome counts microseconds from 1601-01-01 UTC
+    static qint64 chromeTimeToSecs(qint64 chromeMicros);
+    // Bookmarks of a Netscape bookmark file, in file order, until found
+    // returns false. The folder is the innermost one; the toolbar and the top
+    // level are no folder.
+    static void readBookmarksHtml(QIODevice& in, const std::function<bool(const Bookmark&)>& found);
+
+signals:
+    // done and total are visits, or bytes of an HTML file
+    void progress(qint64 done, qint64 total);
+    void finished(const BrowserImporter::Result& result);
+
+private:
+    // on the worker thread
+    void run(const QString& path);
+    void importSqlite(const QString& path, Result& r);
+    void importVisits(QSqlDatabase src, const QString& markerKey, Result& r);
+    void importPlacesBookmarks(QSqlDatabase src);
+    void importHtml(const QString& path, Result& r);
+    void sendBookmarks(QVector<Bookmark>& batch);
+    void report(qint64 done, qint64 total);
+    // back on ours
+    void finish(Result r);
+
+    QPointer<HistoryManager> m_history;
+    QPointer<BookmarksManager> m_bookmarks;
+    QThread* m_thread = nullptr;
+    std::atomic<bool> m_cancel{false};
+    // bookmark counts, kept on our thread as the batches arrive
+    int m_added = 0;
+    int m_known = 0;
+};
+
+Q_DECLARE_METATYPE(BrowserImporter::Result)
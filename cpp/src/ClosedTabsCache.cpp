@@ -0,0 +1,121 @@
+#include "ClosedTabsCache.h"
+#include <QWebEngineView>
+#include <QWebEnginePage>
+#include <QWebEngineHistory>
+#include <QDataStream>
+#include <QDateTime>
+#include <QTimer>
+
+static qint64 entryBytes(const ClosedTab& t) {
+    return t.history.size() + (t.url.size() + t.title.size()) * qint64(sizeof(QChar));
+}
+
+ClosedTabsCache::ClosedTabsCache(QObject* parent): QObject(parent) {
+    m_graceTimer = new QTimer(this);
+    m_graceTimer->setSingleShot(true);
+    connect(m_graceTimer, &QTimer::timeout, this, &ClosedTabsCache::releaseExpiredViews);
+}
+
+ClosedTabsCache::~ClosedTabsCache() {
+    // live views are unparented while cached, so nobody else will delete them
+    for (auto &t : m_entries) delete t.liveView.data();
+}
+
+void ClosedTabsCache::pushView(QWebEngineView* view, int index) {
+    if (!view) return;
+    ClosedTab t;
+    t.url = view->url().toString();
+    t.title = view->title();
+    t.index = index;
+    QDataStream out(&t.history, QIODevice::WriteOnly);
+    out << *view->history();
+
+    if (m_maxLiveViews > 0 && m_gracePeriodMs > 0) {
+        view->hide();
+        view->setParent(nullptr);
+        // a hidden, frozen page keeps its DOM and JS heap but stops running tasks
+        view->page()->setLifecycleState(QWebEnginePage::LifecycleState::Frozen);
+        t.liveView = view;
+    } else {
+        delete view;
+    }
+    push(t);
+}
+
+void ClosedTabsCache::push(const ClosedTab& tab) {
+    const bool wasEmpty = m_entries.isEmpty();
+    ClosedTab t = tab;
+    if (t.closedAt == 0) t.closedAt = QDateTime::currentMSecsSinceEpoch();
+    m_entries.append(t);
+    m_totalBytes += entryBytes(t);
+    enforceLimits();
+    if (t.liveView && !m_graceTimer->isActive()) m_graceTimer->start(m_gracePeriodMs);
+    if (wasEmpty && !m_entries.isEmpty()) emit availableChanged(true);
+}
+
+ClosedTab ClosedTabsCache::takeLast() {
+    if (m_entries.isEmpty()) return ClosedTab();
+    ClosedTab t = m_entries.takeLast();
+    m_totalBytes -= entryBytes(t);
+    if (t.liveView) t.liveView->page()->setLifecycleState(QWebEnginePage::LifecycleState::Active);
+    if (m_entries.isEmpty()) emit availableChanged(false);
+    return t;
+}
+
+bool ClosedTabsCache::isEmpty() const { return m_entries.isEmpty(); }
+int ClosedTabsCache::count() const { return m_entries.size(); }
+qint64 ClosedTabsCache::totalBytes() const { return m_totalBytes; }
+QVector<ClosedTab> ClosedTabsCache::entries() const { return m_entries; }
+
+int ClosedTabsCache::liveViewCount() const {
+    int c = 0;
+    for (const auto &t : m_entries) if (t.liveView) ++c;
+    return c;
+}
+
+void ClosedTabsCache::setLimits(int maxCount, qint64 maxBytes) {
+    m_maxCount = qMax(0, maxCount);
+    m_maxBytes = qMax<qint64>(0, maxBytes);
+    const bool hadEntries = !m_entries.isEmpty();
+    enforceLimits();
+    if (hadEntries && m_entries.isEmpty()) emit availableChanged(false);
+}
+
+void ClosedTabsCache::setLiveViewPolicy(int maxLiveViews, int gracePeriodMs) {
+    m_maxLiveViews = qMax(0, maxLiveViews);
+    m_gracePeriodMs = qMax(0, gracePeriodMs);
+    enforceLimits();
+}
+
+void ClosedTabsCache::enforceLimits() {
+    // drop oldest entries until both caps hold
+    while (!m_entries.isEmpty() && (m_entries.size() > m_maxCount || m_totalBytes > m_maxBytes)) {
+        ClosedTab t = m_entries.takeFirst();
+        m_totalBytes -= entryBytes(t);
+        releaseView(t);
+    }
+    // keep only the newest live views
+    int live = 0;
+    for (int i = m_entries.size() - 1; i >= 0; --i) {
+        if (!m_entries[i].liveView) continue;
+        if (++live > m_maxLiveViews) releaseView(m_entries[i]);
+    }
+}
+
+void ClosedTabsCache::releaseExpiredViews() {
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    qint64 nextExpiry = -1;
+    for (auto &t : m_entries) {
+        if (!t.liveView) continue;
+        const qint64 expiry = t.closedAt + m_gracePeriodMs;
+        if (expiry <= now) releaseView(t);
+        else if (nextExpiry < 0 || expiry < nextExpiry) nextExpiry = expiry;
+    }
+    if (nextExpiry > 0) m_graceTimer->start(int(nextExpiry - now));
+}
+
+void ClosedTabsCache::releaseView(ClosedTab& tab) {
+    if (!tab.liveView) return;
+    tab.liveView->deleteLater();
+    tab.liveView = nullptr;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <QObject>
+#include <QPointer>
+#include <QVector>
+
+class QWebEngineView;
+class QTimer;
+
+struct ClosedTab {
+    QString url;
+    QString title;
+    QByteArray history; // QWebEngineHistory serialized with QDataStream
+    int index = -1;     // tab position at close time
+    qint64 closedAt = 0;
+    // Held frozen (hidden, lifecycle Frozen) for a short grace period so reopen
+    // is instant; released to history-only afterwards.
+    QPointer<QWebEngineView> liveView;
+};
+
+// Bounded stack of recently closed tabs. Capped by entry count and by the total
+// size of the serialized histories; at most maxLiveViews entries keep their view.
+class ClosedTabsCache : public QObject {
+    Q_OBJECT
+public:
+    explicit ClosedTabsCache(QObject* parent = nullptr);
+    ~ClosedTabsCache();
+
+    // Takes ownership of the view (already removed from the tab widget).
+    void pushView(QWebEngineView* view, int index);
+    void push(const ClosedTab& tab);
+    ClosedTab takeLast();
+
+    bool isEmpty() const;
+    int count() const;
+    qint64 totalBytes() const;
+    int liveViewCount() const;
+    QVector<ClosedTab> entries() const;
+
+    void setLimits(int maxCount, qint64 maxBytes);
+    void setLiveViewPolicy(int maxLiveViews, int gracePeriodMs);
+
+signals:
+    void availableChanged(bool available);
+
+private slots:
+    void releaseExpiredViews();
+
+private:
+    void enforceLimits();
+    static void releaseView(ClosedTab& tab);
+
+    QVector<ClosedTab> m_entries; // oldest first
+    qint64 m_totalBytes = 0;
+    int m_maxCount = 25;
+    qint64 m_maxBytes = 4 * 1024 * 1024;
+    int m_maxLiveViews = 2;
+    int m_gracePeriodMs = 30000;
+    QTimer* m_graceTimer;
+};
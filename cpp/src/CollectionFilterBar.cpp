@@ -0,0 +1,66 @@
+#include "CollectionFilterBar.h"
+#include "CollectionFilterModel.h"
+#include "CollectionModel.h"
+#include <QComboBox>
+#include <QHBoxLayout>
+#include <QLineEdit>
+#include <QSignalBlocker>
+
+CollectionFilterBar::CollectionFilterBar(CollectionModel* model, CollectionFilterModel* filter, bool withDone, QWidget* parent)
+    : QWidget(parent), m_model(model), m_filter(filter) {
+    auto *lay = new QHBoxLayout(this);
+    lay->setContentsMargins(0, 0, 0, 0);
+    m_text = new QLineEdit(this);
+    m_text->setPlaceholderText("Filter");
+    m_text->setClearButtonEnabled(true);
+    lay->addWidget(m_text, 1);
+
+    m_workspace = new QComboBox(this);
+    lay->addWidget(m_workspace);
+
+    using Status = CollectionFilterModel::Status;
+    m_status = new QComboBox(this);
+    m_status->addItem("Any status", int(Status::Any));
+    if (withDone) {
+        m_status->addItem("Open", int(Status::Open));
+        m_status->addItem("Done", int(Status::Done));
+    }
+    m_status->addItem("Not synced", int(Status::Pending));
+    m_status->addItem("Conflicts", int(Status::Conflict));
+    lay->addWidget(m_status);
+
+    using Order = CollectionFilterModel::Order;
+    m_order = new QComboBox(this);
+    m_order->addItem("Manual order", int(Order::Manual));
+    m_order->addItem("Title", int(Order::Title));
+    m_order->addItem("Status", int(Order::Status));
+    lay->addWidget(m_order);
+
+    connect(m_text, &QLineEdit::textChanged, m_filter, &CollectionFilterModel::setText);
+    connect(m_workspace, qOverload<int>(&QComboBox::currentIndexChanged), this, [this](int){
+        m_filter->setWorkspace(m_workspace->currentData().toString());
+    });
+    connect(m_status, qOverload<int>(&QComboBox::currentIndexChanged), this, [this](int){
+        m_filter->setStatus(Status(m_status->currentData().toInt()));
+    });
+    connect(m_order, qOverload<int>(&QComboBox::currentIndexChanged), this, [this](int){
+        m_filter->setOrder(Order(m_order->currentData().toInt()));
+    });
+    connect(m_model, &CollectionModel::workspacesChanged, this, &CollectionFilterBar::updateWorkspaces);
+    updateWorkspaces();
+}
+
+void CollectionFilterBar::updateWorkspaces() {
+    const QString current = m_workspace->currentData().toString();
+    const QStringList names = m_model->workspaces();
+    {
+        const QSignalBlocker block(m_workspace);
+        m_workspace->clear();
+        m_workspace->addItem("All workspaces", QString());
+        for (const QString &name : names) m_workspace->addItem(name, name);
+        m_workspace->setCurrentIndex(qMax(0, m_workspace->findData(current)));
+    }
+    // the chosen workspace has no rows left
+    m_filter->setWorkspace(m_workspace->currentData().toString());
+    m_workspace->setVisible(!names.isEmpty());
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <QWidget>
+class CollectionModel;
+class CollectionFilterModel;
+class QComboBox;
+class QLineEdit;
+
+// The search field and the workspace, status and order pickers above a
+// filtered collection view. The workspace list follows the model's rows.
+class CollectionFilterBar : public QWidget {
+    Q_OBJECT
+public:
+    // withDone offers open and done, which only todos have
+    CollectionFilterBar(CollectionModel* model, CollectionFilterModel* filter, bool withDone, QWidget* parent = nullptr);
+
+private:
+    void updateWorkspaces();
+
+    CollectionModel* m_model;
+    CollectionFilterModel* m_filter;
+    QLineEdit* m_text;
+    QComboBox* m_workspace;
+    QComboBox* m_status;
+    QComboBox* m_order;
+};
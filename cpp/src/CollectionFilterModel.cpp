@@ -0,0 +1,84 @@
+#include "CollectionFilterModel.h"
+#include "CollectionModel.h"
+
+namespace {
+// conflicts first, then what is still to go up
+int statusRank(SyncStatus status) {
+    switch (status) {
+    case SyncStatus::Conflict: return 0;
+    case SyncStatus::Unsynced: return 1;
+    case SyncStatus::Syncing: return 2;
+    case SyncStatus::Synced: break;
+    }
+    return 3;
+}
+}
+
+CollectionFilterModel::CollectionFilterModel(QObject* parent): QSortFilterProxyModel(parent) {
+    setDynamicSortFilter(true);
+}
+
+void CollectionFilterModel::setWorkspace(const QString& workspace) {
+    if (workspace == m_workspace) return;
+    m_workspace = workspace;
+    invalidateFilter();
+}
+
+void CollectionFilterModel::setStatus(Status status) {
+    if (status == m_status) return;
+    m_status = status;
+    invalidateFilter();
+}
+
+void CollectionFilterModel::setText(const QString& text) {
+    const QStringList words = text.split(QLatin1Char(' '), Qt::SkipEmptyParts);
+    if (words == m_words) return;
+    m_words = words;
+    invalidateFilter();
+}
+
+void CollectionFilterModel::setOrder(Order order, Qt::SortOrder direction) {
+    m_order = order;
+    // column -1 is the source order
+    sort(order == Order::Manual ? -1 : 0, direction);
+}
+
+bool CollectionFilterModel::filterAcceptsRow(int sourceRow, const QModelIndex& sourceParent) const {
+    const QModelIndex index = sourceModel()->index(sourceRow, 0, sourceParent);
+    if (!m_workspace.isEmpty() && index.data(CollectionModel::WorkspaceRole).toString() != m_workspace) return false;
+    switch (m_status) {
+    case Status::Any: break;
+    case Status::Open:
+    case Status::Done:
+        if (index.data(CollectionModel::DoneRole).toBool() != (m_status == Status::Done)) return false;
+        break;
+    case Status::Pending: {
+        const auto s = SyncStatus(index.data(CollectionModel::SyncStatusRole).toInt());
+        if (s != SyncStatus::Unsynced && s != SyncStatus::Syncing) return false;
+        break;
+    }
+    case Status::Conflict:
+        if (SyncStatus(index.data(CollectionModel::SyncStatusRole).toInt()) != SyncStatus::Conflict) return false;
+        break;
+    }
+    if (m_words.isEmpty()) return true;
+    const QString text = index.data(CollectionModel::SearchTextRole).toString();
+    for (const QString &word : m_words)
+        if (!text.contains(word, Qt::CaseInsensitive)) return false;
+    return true;
+}
+
+bool CollectionFilterModel::lessThan(const QModelIndex& left, const QModelIndex& right) const {
+    if (m_order == Order::Status) {
+        const bool leftDone = left.data(CollectionModel::DoneRole).toBool();
+        const bool rightDone = right.data(CollectionModel::DoneRole).toBool();
+        if (leftDone != rightDone) return rightDone;
+        const int leftRank = statusRank(SyncStatus(left.data(CollectionModel::SyncStatusRole).toInt()));
+        const int rightRank = statusRank(SyncStatus(right.data(CollectionModel::SyncStatusRole).toInt()));
+        if (leftRank != rightRank) return leftRank < rightRank;
+    }
+    // not locale-aware: QCollator would cost more than the rest of a 50k-row sort
+    const int byTitle = QString::compare(left.data(Qt::DisplayRole).toString(), right.data(Qt::DisplayRole).toString(), Qt::CaseInsensitive);
+    // equal titles keep their collection order
+    return byTitle != 0 ? byTitle < 0 : left.row() < right.row();
+}
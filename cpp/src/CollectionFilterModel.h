@@ -0,0 +1,40 @@
+#pragma once
+
+#include <QSortFilterProxyModel>
+#include <QStringList>
+
+// Narrows a CollectionModel to one workspace, a status and a text, and sorts
+// what is left. With nothing set every row passes, in collection order. The
+// proxy follows the source's row changes itself, so a sync burst re-filters
+// and re-sorts only the rows it touched.
+class CollectionFilterModel : public QSortFilterProxyModel {
+    Q_OBJECT
+public:
+    enum class Status { Any, Open, Done, Pending, Conflict };
+    enum class Order { Manual, Title, Status };
+
+    explicit CollectionFilterModel(QObject* parent = nullptr);
+
+    // empty for every workspace
+    void setWorkspace(const QString& workspace);
+    QString workspace() const { return m_workspace; }
+    // Open and Done go by the done state (todos); Pending is unsynced or syncing
+    void setStatus(Status status);
+    Status status() const { return m_status; }
+    // rows whose text contains every word, ignoring case
+    void setText(const QString& text);
+    QString text() const { return m_words.join(QLatin1Char(' ')); }
+    // Status puts open before done, then conflicts and pending changes first
+    void setOrder(Order order, Qt::SortOrder direction = Qt::AscendingOrder);
+    Order order() const { return m_order; }
+
+protected:
+    bool filterAcceptsRow(int sourceRow, const QModelIndex& sourceParent) const override;
+    bool lessThan(const QModelIndex& left, const QModelIndex& right) const override;
+
+private:
+    QString m_workspace;
+    Status m_status = Status::Any;
+    QStringList m_words;
+    Order m_order = Order::Manual;
+};
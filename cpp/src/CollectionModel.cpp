@@ -0,0 +1,54 @@
+#include "CollectionModel.h"
+#include <QBrush>
+#include <QColor>
+#include <QTimer>
+#include <algorithm>
+
+CollectionModel::CollectionModel(QObject* parent): QAbstractTableModel(parent) {
+    m_frameTimer = new QTimer(this);
+    m_frameTimer->setSingleShot(true);
+    m_frameTimer->setInterval(kFrameMs);
+    connect(m_frameTimer, &QTimer::timeout, this, [this](){ update(); });
+}
+
+QStringList CollectionModel::workspaces() const {
+    QStringList names = m_workspaceCounts.keys();
+    std::sort(names.begin(), names.end(), [](const QString& a, const QString& b){
+        return QString::compare(a, b, Qt::CaseInsensitive) < 0;
+    });
+    return names;
+}
+
+void CollectionModel::scheduleUpdate() {
+    // not restarted: a steady stream of changes still shows once per frame
+    if (!m_frameTimer->isActive()) m_frameTimer->start();
+}
+
+void CollectionModel::finishUpdate(bool reset) {
+    m_frameTimer->stop();
+    ++m_updates;
+    if (reset) ++m_resets;
+    if (m_workspacesChanged) {
+        m_workspacesChanged = false;
+        emit workspacesChanged();
+    }
+}
+
+void CollectionModel::countWorkspace(const QString& workspace, int delta) {
+    if (workspace.isEmpty()) return;
+    const int before = m_workspaceCounts.value(workspace);
+    const int after = before + delta;
+    if (after > 0) m_workspaceCounts.insert(workspace, after);
+    else m_workspaceCounts.remove(workspace);
+    if ((before > 0) != (after > 0)) m_workspacesChanged = true;
+}
+
+QVariant CollectionModel::foregroundFor(SyncStatus status) {
+    switch (status) {
+    case SyncStatus::Unsynced: return QBrush(QColor(0, 102, 204));
+    case SyncStatus::Syncing: return QBrush(QColor(255, 165, 0));
+    case SyncStatus::Conflict: return QBrush(QColor(200, 0, 0));
+    case SyncStatus::Synced: break;
+    }
+    return QVariant();
+}
@@ -0,0 +1,181 @@
+#pragma once
+
+#include <QAbstractTableModel>
+#include <QHash>
+#include <QSet>
+#include <QStringList>
+#include <QVector>
+#include "SyncedCollection.h"
+#include "Trace.h"
+
+class QTimer;
+
+// A synced collection for item views. The rows follow the collection's order
+// and a change there reaches the views as row inserts, removals and
+// dataChanged for the rows that look different, worked out from the local ids;
+// a reset only happens if rows changed places. The itemsChanged bursts of a
+// sync are folded into one update per frame.
+// moc cannot handle class templates: the roles, the workspace list and the
+// frame timer live here, the rows and the diff in SyncedCollectionModel<Traits>.
+class CollectionModel : public QAbstractTableModel {
+    Q_OBJECT
+public:
+    enum Role {
+        LocalIdRole = Qt::UserRole + 1,
+        SyncStatusRole,   // int(SyncStatus)
+        WorkspaceRole,
+        DoneRole,         // todos only
+        SearchTextRole,   // what the text filter looks at
+    };
+    static constexpr int kFrameMs = 16;
+
+    explicit CollectionModel(QObject* parent = nullptr);
+
+    int columnCount(const QModelIndex& parent = QModelIndex()) const override { return parent.isValid() ? 0 : 1; }
+    QString localId(int row) const { return m_localIds.value(row); }
+    // the distinct non-empty workspaces of the rows, sorted
+    QStringList workspaces() const;
+    // updates applied so far, and how many of them fell back to a reset
+    int updateCount() const { return m_updates; }
+    int resetCount() const { return m_resets; }
+
+public slots:
+    // apply what the collection changed since the last update now, instead
+    // of on the next frame
+    virtual void update() = 0;
+
+signals:
+    void workspacesChanged();
+
+protected:
+    // the collection changed: update on the next frame, once however often
+    // this is called until then
+    void scheduleUpdate();
+    // an update is done: stop the frame timer, report a changed workspace list
+    void finishUpdate(bool reset);
+    void countWorkspace(const QString& workspace, int delta);
+    static QVariant foregroundFor(SyncStatus status);
+
+    QVector<QString> m_localIds;
+
+private:
+    QTimer* m_frameTimer;
+    QHash<QString, int> m_workspaceCounts;
+    bool m_workspacesChanged = false;
+    int m_updates = 0;
+    int m_resets = 0;
+};
+
+// The rows of one SyncedCollection<Traits>. Subclasses provide data() and say
+// which changes to an item are visible.
+template <class Traits>
+class SyncedCollectionModel : public CollectionModel {
+public:
+    using Item = typename Traits::Item;
+
+    explicit SyncedCollectionModel(SyncedCollection<Traits>* collection, QObject* parent = nullptr)
+        : CollectionModel(parent), m_collection(collection),
+          m_items(collection->items()) {
+        m_localIds = collection->localIds();
+        for (const Item &item : std::as_const(m_items)) countWorkspace(item.workspace, 1);
+        connect(collection, &SyncEngineBase::itemsChanged, this, [this](){ scheduleUpdate(); });
+    }
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override { return parent.isValid() ? 0 : m_items.size(); }
+    const Item& item(int row) const { return m_items.at(row); }
+
+    void update() override {
+        FLOW_TRACE_SCOPE_DETAIL("CollectionModel::update", Traits::table);
+        const QVector<Item> items = m_collection->items();
+        const QVector<QString> ids = m_collection->localIds();
+        const bool reset = !applyRows(items, ids);
+        if (reset) {
+            beginResetModel();
+            for (const Item &item : std::as_const(m_items)) countWorkspace(item.workspace, -1);
+            m_items = items;
+            m_localIds = ids;
+            for (const Item &item : std::as_const(m_items)) countWorkspace(item.workspace, 1);
+            endResetModel();
+        }
+        finishUpdate(reset);
+    }
+
+protected:
+    // false when the difference between a and b shows in no column or role
+    virtual bool sameRow(const Item& a, const Item& b) const = 0;
+
+    SyncedCollection<Traits>* m_collection;
+
+private:
+    // Walk both lists in step. Where the ids differ, the row here is either
+    // gone from the collection or the collection has rows here that are new;
+    // an id that is in both but elsewhere means the order changed and the
+    // caller resets. The id sets are only built at the first difference, so
+    // edits and appends cost one pass.
+    bool applyRows(const QVector<Item>& items, const QVector<QString>& ids) {
+        QSet<QString> oldIds, newIds;
+        bool haveSets = false;
+        int changedFirst = -1, changedLast = -1;
+        auto flushChanged = [&]() {
+            if (changedFirst < 0) return;
+            emit dataChanged(index(changedFirst, 0), index(changedLast, columnCount() - 1));
+            changedFirst = changedLast = -1;
+        };
+        auto buildSets = [&]() {
+            if (haveSets) return;
+            oldIds = QSet<QString>(m_localIds.cbegin(), m_localIds.cend());
+            newIds = QSet<QString>(ids.cbegin(), ids.cend());
+            haveSets = true;
+        };
+
+        int r = 0;
+        int i = 0;
+        while (i < ids.size() || r < m_items.size()) {
+            if (r < m_items.size() && i < ids.size() && m_localIds[r] == ids[i]) {
+                if (!sameRow(m_items[r], items[i])) {
+                    if (changedLast != r - 1) flushChanged();
+                    if (changedFirst < 0) changedFirst = r;
+                    changedLast = r;
+                    countWorkspace(m_items[r].workspace, -1);
+                    countWorkspace(items[i].workspace, 1);
+                }
+                m_items[r] = items[i];
+                ++r;
+                ++i;
+                continue;
+            }
+            flushChanged();
+            buildSets();
+            if (r < m_items.size() && !newIds.contains(m_localIds[r])) {
+                int last = r;
+                while (last + 1 < m_items.size() && !newIds.contains(m_localIds[last + 1])) ++last;
+                beginRemoveRows(QModelIndex(), r, last);
+                for (int k = r; k <= last; ++k) countWorkspace(m_items[k].workspace, -1);
+                m_items.remove(r, last - r + 1);
+                m_localIds.remove(r, last - r + 1);
+                endRemoveRows();
+            } else if (i < ids.size() && !oldIds.contains(ids[i])) {
+                int last = i;
+                while (last + 1 < ids.size() && !oldIds.contains(ids[last + 1])) ++last;
+                const int n = last - i + 1;
+                beginInsertRows(QModelIndex(), r, r + n - 1);
+                m_items.insert(r, n, Item());
+                m_localIds.insert(r, n, QString());
+                for (int k = 0; k < n; ++k) {
+                    m_items[r + k] = items[i + k];
+                    m_localIds[r + k] = ids[i + k];
+                    countWorkspace(items[i + k].workspace, 1);
+                }
+                endInsertRows();
+                r += n;
+                i += n;
+            } else {
+                return false;
+            }
+        }
+        flushChanged();
+        return true;
+    }
+
+    QVector<Item> m_items;
+};
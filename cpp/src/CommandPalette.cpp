@@ -0,0 +1,108 @@
+#include "CommandPalette.h"
+#include "SearchService.h"
+#include "Trace.h"
+#include <QKeyEvent>
+#include <QLineEdit>
+#include <QListWidget>
+#include <QListWidgetItem>
+#include <QVBoxLayout>
+
+namespace {
+QString sourceLabel(SearchSource source) {
+    switch (source) {
+    case SearchSource::History: return "History";
+    case SearchSource::Bookmark: return "Bookmark";
+    case SearchSource::Note: return "Note";
+    case SearchSource::Todo: return "Todo";
+    }
+    return QString();
+}
+}
+
+CommandPalette::CommandPalette(SearchService* search, QWidget* parent)
+    : QWidget(parent, Qt::Popup | Qt::FramelessWindowHint), m_search(search) {
+    auto *lay = new QVBoxLayout(this);
+    lay->setContentsMargins(6, 6, 6, 6);
+    m_query = new QLineEdit(this);
+    m_query->setPlaceholderText("Search history, bookmarks, notes and todos...");
+    lay->addWidget(m_query);
+    m_results = new QListWidget(this);
+    lay->addWidget(m_results);
+    resize(640, 420);
+
+    // arrows and Enter move through the results while typing goes on
+    m_query->installEventFilter(this);
+    connect(m_query, &QLineEdit::textChanged, this, &CommandPalette::onTextChanged);
+    connect(m_results, &QListWidget::itemActivated, this, &CommandPalette::onItemActivated);
+    hide();
+}
+
+void CommandPalette::popup() {
+    m_query->clear();
+    m_results->clear();
+    m_hits.clear();
+    if (QWidget *w = parentWidget()) {
+        const QRect r = w->window()->geometry();
+        move(r.center().x() - width() / 2, r.top() + r.height() / 6);
+    }
+    show();
+    raise();
+    m_query->setFocus();
+}
+
+void CommandPalette::onTextChanged(const QString& text) {
+    // an answer to an older query is dropped when it arrives after a newer one
+    const int generation = ++m_searchGeneration;
+    if (text.trimmed().isEmpty()) { showHits({}); return; }
+    m_search->search(text, kMaxResults, this, [this, generation](const QVector<SearchHit>& hits){
+        if (generation != m_searchGeneration) return;
+        showHits(hits);
+    });
+}
+
+void CommandPalette::showHits(const QVector<SearchHit>& hits) {
+    FLOW_TRACE_SCOPE("CommandPalette::showHits");
+    m_hits = hits;
+    m_results->clear();
+    for (int i = 0; i < hits.size(); ++i) {
+        const SearchHit &h = hits[i];
+        QString label = QString("%1 — %2").arg(sourceLabel(h.source), h.title);
+        if (!h.subtitle.isEmpty()) label += QString("\n%1").arg(h.subtitle);
+        auto *it = new QListWidgetItem(label);
+        it->setData(Qt::UserRole, i);
+        m_results->addItem(it);
+    }
+    if (m_results->count()) m_results->setCurrentRow(0);
+}
+
+void CommandPalette::onItemActivated(QListWidgetItem* item) {
+    if (!item) return;
+    const int i = item->data(Qt::UserRole).toInt();
+    if (i < 0 || i >= m_hits.size()) return;
+    const SearchHit hit = m_hits[i];
+    hide();
+    emit hitActivated(hit);
+}
+
+bool CommandPalette::eventFilter(QObject* watched, QEvent* event) {
+    if (watched != m_query || event->type() != QEvent::KeyPress) return QWidget::eventFilter(watched, event);
+    auto *key = static_cast<QKeyEvent*>(event);
+    switch (key->key()) {
+    case Qt::Key_Down:
+    case Qt::Key_Up: {
+        const int step = key->key() == Qt::Key_Down ? 1 : -1;
+        const int row = m_results->currentRow() + step;
+        if (row >= 0 && row < m_results->count()) m_results->setCurrentRow(row);
+        return true;
+    }
+    case Qt::Key_Return:
+    case Qt::Key_Enter:
+        onItemActivated(m_results->currentItem());
+        return true;
+    case Qt::Key_Escape:
+        hide();
+        return true;
+    default:
+        return QWidget::eventFilter(watched, event);
+    }
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <QWidget>
+#include "SearchIndex.h"
+
+class SearchService;
+class QLineEdit;
+class QListWidget;
+class QListWidgetItem;
+
+// A popup search box over every store (Ctrl+K): history, bookmarks, notes
+// and todos, ranked together as the user types.
+class CommandPalette : public QWidget {
+    Q_OBJECT
+public:
+    explicit CommandPalette(SearchService* search, QWidget* parent = nullptr);
+    // show centred over the parent window with an empty query
+    void popup();
+
+    static constexpr int kMaxResults = 20;
+
+signals:
+    void hitActivated(const SearchHit& hit);
+
+protected:
+    bool eventFilter(QObject* watched, QEvent* event) override;
+
+private slots:
+    void onTextChanged(const QString& text);
+    void onItemActivated(QListWidgetItem* item);
+
+private:
+    void showHits(const QVector<SearchHit>& hits);
+
+    SearchService* m_search;
+    QLineEdit* m_query;
+    QListWidget* m_results;
+    QVector<SearchHit> m_hits;
+    int m_searchGeneration = 0;
+};
@@ -0,0 +1,72 @@
+#include "ContentBlockInterceptor.h"
+#include "ContentBlocker.h"
+#include "ContentFilter.h"
+#include <QWebEnginePage>
+
+ContentBlockInterceptor::ContentBlockInterceptor(QObject* parent): QWebEngineUrlRequestInterceptor(parent) {
+}
+
+ContentBlockInterceptor* ContentBlockInterceptor::install(QWebEnginePage* page) {
+    auto *interceptor = new ContentBlockInterceptor(page);
+    page->setUrlRequestInterceptor(interceptor);
+    return interceptor;
+}
+
+ContentBlockInterceptor* ContentBlockInterceptor::forPage(QWebEnginePage* page) {
+    return page ? page->findChild<ContentBlockInterceptor*>(QString(), Qt::FindDirectChildrenOnly) : nullptr;
+}
+
+quint32 ContentBlockInterceptor::filterType(QWebEngineUrlRequestInfo::ResourceType type) {
+    switch (type) {
+    case QWebEngineUrlRequestInfo::ResourceTypeMainFrame:
+    case QWebEngineUrlRequestInfo::ResourceTypeNavigationPreloadMainFrame:
+        return ContentFilter::Document;
+    case QWebEngineUrlRequestInfo::ResourceTypeSubFrame:
+    case QWebEngineUrlRequestInfo::ResourceTypeNavigationPreloadSubFrame:
+        return ContentFilter::Subdocument;
+    case QWebEngineUrlRequestInfo::ResourceTypeStylesheet: return ContentFilter::Stylesheet;
+    case QWebEngineUrlRequestInfo::ResourceTypeScript:
+    case QWebEngineUrlRequestInfo::ResourceTypeWorker:
+    case QWebEngineUrlRequestInfo::ResourceTypeSharedWorker:
+    case QWebEngineUrlRequestInfo::ResourceTypeServiceWorker:
+        return ContentFilter::Script;
+    case QWebEngineUrlRequestInfo::ResourceTypeImage:
+    case QWebEngineUrlRequestInfo::ResourceTypeFavicon:
+        return ContentFilter::Image;
+    case QWebEngineUrlRequestInfo::ResourceTypeFontResource: return ContentFilter::Font;
+    case QWebEngineUrlRequestInfo::ResourceTypeMedia: return ContentFilter::Media;
+    case QWebEngineUrlRequestInfo::ResourceTypeObject:
+    case QWebEngineUrlRequestInfo::ResourceTypePluginResource:
+        return ContentFilter::Object;
+    case QWebEngineUrlRequestInfo::ResourceTypeXhr: return ContentFilter::Xhr;
+    case QWebEngineUrlRequestInfo::ResourceTypePing:
+    case QWebEngineUrlRequestInfo::ResourceTypeCspReport:
+        return ContentFilter::Ping;
+    default:
+        return ContentFilter::Other;
+    }
+}
+
+void ContentBlockInterceptor::interceptRequest(QWebEngineUrlRequestInfo& info) {
+    const quint32 type = filterType(info.resourceType());
+    if (type == ContentFilter::Document) {
+        // a new page: restart the per-page counters, never block the navigation itself
+        m_blocked.store(0, std::memory_order_relaxed);
+        m_checked.store(0, std::memory_order_relaxed);
+        return;
+    }
+    const QUrl url = info.requestUrl();
+    if (url.scheme() != QLatin1String("https") && url.scheme() != QLatin1String("http")
+        && url.scheme() != QLatin1String("wss") && url.scheme() != QLatin1String("ws")) return;
+    ContentBlocker* blocker = ContentBlocker::instance();
+    if (blocker->isRecording()) blocker->record(url, info.firstPartyUrl(), type);
+    const ContentFilter* filter = blocker->filter();
+    if (!filter) return;
+    const bool blocked = filter->shouldBlock(url, info.firstPartyUrl(), type);
+    m_checked.fetch_add(1, std::memory_order_relaxed);
+    blocker->countRequest(blocked);
+    if (!blocked) return;
+    info.block(true);
+    m_blocked.fetch_add(1, std::memory_order_relaxed);
+    m_blockedTotal.fetch_add(1, std::memory_order_relaxed);
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <QWebEngineUrlRequestInterceptor>
+#include <QWebEngineUrlRequestInfo>
+#include <atomic>
+
+class QWebEnginePage;
+
+// Per-page request interceptor consulting the shared ContentBlocker filter.
+// Counters are atomic so they can be read from any thread.
+class ContentBlockInterceptor : public QWebEngineUrlRequestInterceptor {
+    Q_OBJECT
+public:
+    explicit ContentBlockInterceptor(QObject* parent = nullptr);
+
+    void interceptRequest(QWebEngineUrlRequestInfo& info) override;
+
+    // since the last main-frame navigation
+    quint64 blockedCount() const { return m_blocked.load(std::memory_order_relaxed); }
+    quint64 checkedCount() const { return m_checked.load(std::memory_order_relaxed); }
+    // over the lifetime of the tab
+    quint64 blockedTotal() const { return m_blockedTotal.load(std::memory_order_relaxed); }
+
+    // Installs an interceptor on page (owned by the page) and returns it.
+    static ContentBlockInterceptor* install(QWebEnginePage* page);
+    static ContentBlockInterceptor* forPage(QWebEnginePage* page);
+    static quint32 filterType(QWebEngineUrlRequestInfo::ResourceType type);
+
+private:
+    std::atomic<quint64> m_blocked{0};
+    std::atomic<quint64> m_checked{0};
+    std::atomic<quint64> m_blockedTotal{0};
+};
@@ -0,0 +1,133 @@
+#include "ContentBlocker.h"
+#include <QCoreApplication>
+#include <QStandardPaths>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QPointer>
+#include <QSaveFile>
+#include <QThread>
+
+ContentBlocker* ContentBlocker::instance() {
+    static QPointer<ContentBlocker> s_instance;
+    if (!s_instance) s_instance = new ContentBlocker(QCoreApplication::instance());
+    return s_instance;
+}
+
+ContentBlocker::ContentBlocker(QObject* parent): QObject(parent), m_filter(new ContentFilter) {
+    QString dataDir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    m_listsDir = QDir(dataDir).filePath("filters");
+    QDir().mkpath(m_listsDir);
+    const QString recordPath = qEnvironmentVariable("FLOW_RECORD_REQUESTS");
+    if (!recordPath.isEmpty()) {
+        auto f = std::make_unique<QFile>(recordPath);
+        if (f->open(QIODevice::WriteOnly | QIODevice::Append)) m_recordFile = std::move(f);
+    }
+    reload();
+}
+
+ContentBlocker::~ContentBlocker() = default;
+
+void ContentBlocker::setListsDir(const QString& dir) {
+    m_listsDir = dir;
+    QDir().mkpath(m_listsDir);
+    m_filter.reset(new ContentFilter);
+    reload();
+}
+
+QString ContentBlocker::cachePath() const { return QDir(m_listsDir).filePath("compiled.bin"); }
+QString ContentBlocker::cacheListsPath() const { return QDir(m_listsDir).filePath("compiled.lists"); }
+
+QByteArray ContentBlocker::listsSignature(const QString& dir) {
+    QByteArray out;
+    for (const QFileInfo &fi : QDir(dir).entryInfoList({"*.txt"}, QDir::Files, QDir::Name))
+        out += fi.fileName().toUtf8() + '\t' + QByteArray::number(fi.size()) + '\t'
+               + QByteArray::number(fi.lastModified().toMSecsSinceEpoch()) + '\n';
+    return out;
+}
+
+bool ContentBlocker::cacheIsFresh() const {
+    if (!QFileInfo::exists(cachePath())) return false;
+    QFile lists(cacheListsPath());
+    return lists.open(QIODevice::ReadOnly) && lists.readAll() == listsSignature(m_listsDir);
+}
+
+void ContentBlocker::reload() {
+    if (m_compiling) { m_reloadPending = true; return; }
+    if (cacheIsFresh()) {
+        auto f = std::make_unique<ContentFilter>();
+        if (f->mapFile(cachePath())) {
+            m_filter = std::move(f);
+            emit filterChanged();
+            return;
+        }
+        // unreadable or from another version: rebuild it
+    }
+    compileInBackground();
+}
+
+void ContentBlocker::compileInBackground() {
+    m_compiling = true;
+    const QString dir = m_listsDir;
+    const QString out = cachePath();
+    const QString listsOut = cacheListsPath();
+    auto result = std::make_shared<std::pair<ContentFilter::CompileStats, qint64>>();
+    QThread* worker = QThread::create([dir, out, listsOut, result]() {
+        QElapsedTimer t;
+        t.start();
+        // taken before reading: a list changed meanwhile makes the cache stale
+        const QByteArray signature = listsSignature(dir);
+        QList<QByteArray> lines;
+        for (const QFileInfo &fi : QDir(dir).entryInfoList({"*.txt"}, QDir::Files, QDir::Name)) {
+            QFile f(fi.filePath());
+            if (f.open(QIODevice::ReadOnly)) lines += f.readAll().split('\n');
+        }
+        if (ContentFilter::writeCompiled(out, ContentFilter::compile(lines, &result->first))) {
+            QSaveFile lists(listsOut);
+            if (lists.open(QIODevice::WriteOnly)) {
+                lists.write(signature);
+                lists.commit();
+            }
+        }
+        result->second = t.elapsed();
+    });
+    connect(worker, &QThread::finished, this, [this, worker, out, result]() {
+        worker->deleteLater();
+        m_compiling = false;
+        m_compileStats = result->first;
+        m_compileMs = result->second;
+        auto f = std::make_unique<ContentFilter>();
+        if (f->mapFile(out)) m_filter = std::move(f);
+        emit filterChanged();
+        if (m_reloadPending) { m_reloadPending = false; reload(); }
+    });
+    worker->start(QThread::LowPriority);
+}
+
+void ContentBlocker::record(const QUrl& url, const QUrl& firstParty, quint32 type) {
+    if (!m_recordFile) return;
+    m_recordFile->write(ContentFilter::typeName(type) + '\t' + firstParty.host(QUrl::FullyEncoded).toLatin1()
+                        + '\t' + url.toEncoded(QUrl::RemoveUserInfo | QUrl::RemoveFragment) + '\n');
+}
+
+QJsonObject ContentBlocker::toJson() const {
+    QJsonObject o;
+    o["enabled"] = m_enabled;
+    o["loaded"] = m_filter->isLoaded();
+    o["rules"] = m_filter->ruleCount();
+    o["checked_requests"] = m_checked;
+    o["blocked_requests"] = m_blocked;
+    if (m_compileMs >= 0) {
+        QJsonObject c;
+        c["ms"] = m_compileMs;
+        c["lines"] = m_compileStats.lines;
+        c["host_rules"] = m_compileStats.hostRules;
+        c["pattern_rules"] = m_compileStats.patternRules;
+        c["untokenized"] = m_compileStats.untokenized;
+        c["unsupported"] = m_compileStats.unsupported;
+        o["last_compile"] = c;
+    }
+    return o;
+}
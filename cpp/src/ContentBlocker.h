@@ -0,0 +1,68 @@
+#pragma once
+
+#include <QObject>
+#include <QString>
+#include <QJsonObject>
+#include <QUrl>
+#include <memory>
+#include "ContentFilter.h"
+
+class QFile;
+
+// Owns the compiled filter shared by every tab. Lists are plain EasyList-format
+// *.txt files in <AppDataLocation>/filters; they are compiled on a worker thread
+// into filters/compiled.bin, which later starts simply map again.
+// filters/compiled.lists names the lists the cache was built from with their
+// size and mtime; the cache is stale once that no longer matches the lists.
+// Modification times of the cache or the directory cannot tell: writing the
+// cache renames it into the directory, which makes the directory newer.
+class ContentBlocker : public QObject {
+    Q_OBJECT
+public:
+    static ContentBlocker* instance();
+    ~ContentBlocker() override;
+
+    // Only swapped on the GUI thread, which is also where Qt 6 runs interceptors.
+    const ContentFilter* filter() const { return m_enabled && m_filter->isLoaded() ? m_filter.get() : nullptr; }
+
+    void setEnabled(bool enabled) { m_enabled = enabled; }
+    bool isEnabled() const { return m_enabled; }
+
+    QString listsDir() const { return m_listsDir; }
+    QString cachePath() const;
+    QString cacheListsPath() const;
+    void setListsDir(const QString& dir); // for tests
+
+    // Maps the cache when it was built from the lists as they are, recompiles
+    // otherwise.
+    void reload();
+    bool isCompiling() const { return m_compiling; }
+
+    void countRequest(bool blocked) { ++m_checked; if (blocked) ++m_blocked; }
+    // With FLOW_RECORD_REQUESTS=<file> every checked request is appended to that
+    // file as "type<TAB>page host<TAB>url", the corpus format of bench_adblock.
+    bool isRecording() const { return m_recordFile != nullptr; }
+    void record(const QUrl& url, const QUrl& firstParty, quint32 type);
+    QJsonObject toJson() const;
+
+signals:
+    void filterChanged();
+
+private:
+    explicit ContentBlocker(QObject* parent = nullptr);
+    bool cacheIsFresh() const;
+    // one line per list: name, size and mtime in ms
+    static QByteArray listsSignature(const QString& dir);
+    void compileInBackground();
+
+    std::unique_ptr<ContentFilter> m_filter;
+    std::unique_ptr<QFile> m_recordFile;
+    QString m_listsDir;
+    bool m_enabled = true;
+    bool m_compiling = false;
+    bool m_reloadPending = false;
+    ContentFilter::CompileStats m_compileStats;
+    qint64 m_compileMs = -1;
+    qint64 m_checked = 0;
+    qint64 m_blocked = 0;
+};
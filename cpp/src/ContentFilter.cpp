@@ -0,0 +1,622 @@
+#include "ContentFilter.h"
+#include <QFile>
+#include <QSaveFile>
+#include <QMap>
+#include <QHash>
+#include <QVarLengthArray>
+#include <algorithm>
+#include <climits>
+#include <cstring>
+
+namespace {
+
+const char kMagic[8] = {'F', 'L', 'O', 'W', 'C', 'F', 'L', 'T'};
+const quint32 kVersion = 1;
+
+enum Section {
+    Bloom,              // quint64 words, power-of-two bit count
+    BlockHosts,         // sorted quint64 host hashes
+    ThirdPartyHosts,    // ... blocked only when loaded from another site
+    AllowHosts,         // @@||host^
+    DocumentAllowHosts, // @@||host^$document: nothing is blocked on these pages
+    BlockTokens,        // TokenEntry sorted by hash
+    AllowTokens,
+    RuleIds,            // quint32, referenced by token entries
+    Rules,
+    Domains,            // quint64 hashes for $domain=, sorted per rule
+    Strings,            // pattern bytes
+    SectionCount
+};
+
+enum RuleFlag : quint16 {
+    Exception = 1 << 0,
+    Important = 1 << 1,
+    HostAnchor = 1 << 2,
+    StartAnchor = 1 << 3,
+    EndAnchor = 1 << 4,
+    ThirdParty = 1 << 5,
+    FirstParty = 1 << 6
+};
+
+inline quint64 fnv1a(const char* s, int n) {
+    quint64 h = 1469598103934665603ULL;
+    for (int i = 0; i < n; ++i) { h ^= uchar(s[i]); h *= 1099511628211ULL; }
+    return h ? h : 1; // 0 is the bucket of untokenized rules
+}
+inline quint64 fnv1a(const QByteArray& s) { return fnv1a(s.constData(), s.size()); }
+
+inline bool isTokenChar(uchar c) { return (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == '%'; }
+
+// '^' in a filter: anything but a letter, digit or one of _ - . %
+inline bool isSeparator(uchar c) {
+    return !((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_' || c == '-' || c == '.' || c == '%');
+}
+
+// Matches one '*'-free piece of a pattern at u[pos]; returns the end position or -1.
+int matchSegment(const char* u, int ulen, int pos, const char* p, int plen) {
+    for (int k = 0; k < plen; ++k) {
+        const char c = p[k];
+        if (c == '^') {
+            if (pos == ulen) continue; // '^' also matches the end of the address
+            if (!isSeparator(uchar(u[pos]))) return -1;
+            ++pos;
+        } else {
+            if (pos >= ulen || u[pos] != c) return -1;
+            ++pos;
+        }
+    }
+    return pos;
+}
+
+// The pieces after the first '*'; taking each at its leftmost position is enough
+// except for the last one, which may have to end exactly at the end of the address.
+bool matchTail(const char* u, int ulen, int pos, const char* p, int plen, bool endAnchor) {
+    for (;;) {
+        const char* star = static_cast<const char*>(memchr(p, '*', plen));
+        const int segLen = star ? int(star - p) : plen;
+        if (!star) {
+            if (segLen == 0) return true;
+            for (int q = pos; q <= ulen; ++q) {
+                const int e = matchSegment(u, ulen, q, p, segLen);
+                if (e >= 0 && (!endAnchor || e == ulen)) return true;
+            }
+            return false;
+        }
+        if (segLen > 0) {
+            int e = -1;
+            for (int q = pos; q <= ulen && e < 0; ++q) e = matchSegment(u, ulen, q, p, segLen);
+            if (e < 0) return false;
+            pos = e;
+        }
+        p = star + 1;
+        plen -= segLen + 1;
+    }
+}
+
+bool matchPattern(const char* p, int plen, quint16 flags, const char* u, int ulen, int hostBegin, int hostEnd) {
+    const char* star = static_cast<const char*>(memchr(p, '*', plen));
+    const int headLen = star ? int(star - p) : plen;
+    const bool endAnchor = flags & EndAnchor;
+    auto tryAt = [&](int start) {
+        const int e = matchSegment(u, ulen, start, p, headLen);
+        if (e < 0) return false;
+        if (!star) return !endAnchor || e == ulen;
+        return matchTail(u, ulen, e, star + 1, plen - headLen - 1, endAnchor);
+    };
+    if (flags & HostAnchor) {
+        // at the start of the host or of any of its labels
+        for (int i = hostBegin; i < hostEnd; ++i)
+            if ((i == hostBegin || u[i - 1] == '.') && tryAt(i)) return true;
+        return false;
+    }
+    if (flags & StartAnchor) return tryAt(0);
+    if (headLen > 0 && p[0] != '^') {
+        for (const char* c = u; (c = static_cast<const char*>(memchr(c, p[0], ulen - (c - u)))); ++c)
+            if (tryAt(int(c - u))) return true;
+        return false;
+    }
+    for (int i = 0; i <= ulen; ++i) if (tryAt(i)) return true;
+    return false;
+}
+
+// hashes of host and every parent domain, longest first
+template <class Out>
+void suffixHashes(const QByteArray& host, Out& out) {
+    const char* s = host.constData();
+    const int n = host.size();
+    for (int i = 0; i < n; ++i) {
+        if (i == 0 || s[i - 1] == '.') out.append(fnv1a(s + i, n - i));
+    }
+}
+
+struct ParsedRule {
+    QByteArray pattern;
+    quint16 flags = 0;
+    quint32 types = ContentFilter::AllTypes;
+    QVector<quint64> include, exclude;
+    QList<QByteArray> tokens;
+};
+
+enum class LineKind { Skip, Unsupported, Host, ThirdPartyHost, AllowHost, DocumentAllowHost, Pattern };
+
+bool isPlainHost(const QByteArray& p) {
+    if (p.size() < 2 || !p.endsWith('^')) return false;
+    for (int i = 0; i < p.size() - 1; ++i) {
+        const char c = p[i];
+        if (!((c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == '.' || c == '-')) return false;
+    }
+    return true;
+}
+
+LineKind parseLine(QByteArray line, ParsedRule* r) {
+    line = line.trimmed();
+    if (line.isEmpty() || line.startsWith('!') || line.startsWith('[')) return LineKind::Skip;
+    // element hiding and scriptlets are for a content script, not the network layer
+    for (const char* c : {"##", "#@#", "#?#", "#$#", "#%#"}) if (line.contains(c)) return LineKind::Unsupported;
+    if (line.startsWith("@@")) { r->flags |= Exception; line = line.mid(2); }
+
+    const bool regex = line.size() > 1 && line.startsWith('/') && line.endsWith('/');
+    const int dollar = regex ? -1 : line.lastIndexOf('$');
+    QByteArray options;
+    if (dollar >= 0) { options = line.mid(dollar + 1).toLower(); line.truncate(dollar); }
+    if (regex || (line.size() > 1 && line.startsWith('/') && line.endsWith('/'))) return LineKind::Unsupported;
+
+    quint32 types = 0, negTypes = 0;
+    if (!options.isEmpty()) {
+        for (QByteArray o : options.split(',')) {
+            o = o.trimmed();
+            const bool neg = o.startsWith('~');
+            if (neg) o = o.mid(1);
+            if (o == "third-party" || o == "3p") { r->flags |= neg ? FirstParty : ThirdParty; continue; }
+            if (o == "first-party" || o == "1p") { r->flags |= neg ? ThirdParty : FirstParty; continue; }
+            if (o == "important") { r->flags |= Important; continue; }
+            if (o == "match-case") continue; // everything is matched lowercase
+            if (o.startsWith("domain=")) {
+                for (const QByteArray &d : o.mid(7).split('|')) {
+                    if (d.startsWith('~')) r->exclude.append(fnv1a(d.mid(1)));
+                    else if (!d.isEmpty()) r->include.append(fnv1a(d));
+                }
+                continue;
+            }
+            const quint32 t = ContentFilter::typeFromName(o);
+            if (!t) return LineKind::Unsupported; // redirect=, csp=, removeparam=, popup, ...
+            if (neg) negTypes |= t; else types |= t;
+        }
+    }
+    r->types = (types ? types : quint32(ContentFilter::AllTypes)) & ~negTypes;
+    if (!r->types) return LineKind::Unsupported;
+    std::sort(r->include.begin(), r->include.end());
+    std::sort(r->exclude.begin(), r->exclude.end());
+
+    line = line.toLower();
+    if (line.startsWith("||")) { r->flags |= HostAnchor; line = line.mid(2); }
+    else if (line.startsWith('|')) { r->flags |= StartAnchor; line = line.mid(1); }
+    if (line.endsWith('|')) { r->flags |= EndAnchor; line.chop(1); }
+    // leading and trailing wildcards are implied
+    while (line.startsWith('*')) { line = line.mid(1); r->flags &= ~(HostAnchor | StartAnchor); }
+    while (line.endsWith('*')) { line.chop(1); r->flags &= ~EndAnchor; }
+    r->pattern = line;
+
+    const bool noOptions = r->include.isEmpty() && r->exclude.isEmpty() && !(r->flags & (Important | FirstParty | EndAnchor));
+    const bool hostOnly = (r->flags & HostAnchor) && noOptions && isPlainHost(line);
+    if (r->types & ContentFilter::Document) {
+        // only whole-page exceptions are supported
+        if (hostOnly && (r->flags & Exception) && !(r->flags & ThirdParty) && r->types == ContentFilter::Document) return LineKind::DocumentAllowHost;
+        return LineKind::Unsupported;
+    }
+    if (hostOnly && r->types == ContentFilter::AllTypes) {
+        if (r->flags & Exception) {
+            if (!(r->flags & ThirdParty)) return LineKind::AllowHost;
+        } else {
+            return (r->flags & ThirdParty) ? LineKind::ThirdPartyHost : LineKind::Host;
+        }
+    }
+    if (r->pattern.size() > 0xffff) return LineKind::Unsupported;
+
+    // index candidates: literal runs that are whole tokens in any matching URL
+    const QByteArray &p = r->pattern;
+    for (int i = 0; i < p.size();) {
+        if (!isTokenChar(uchar(p[i]))) { ++i; continue; }
+        int e = i;
+        while (e < p.size() && isTokenChar(uchar(p[e]))) ++e;
+        const bool leftOk = i > 0 ? p[i - 1] != '*' : bool(r->flags & (HostAnchor | StartAnchor));
+        const bool rightOk = e < p.size() ? p[e] != '*' : bool(r->flags & EndAnchor);
+        if (leftOk && rightOk && e - i >= 2) r->tokens.append(p.mid(i, e - i));
+        i = e;
+    }
+    return LineKind::Pattern;
+}
+
+void align8(QByteArray& out) { while (out.size() % 8) out.append('\0'); }
+
+template <class T>
+void appendPod(QByteArray& out, const T* data, int count) {
+    out.append(reinterpret_cast<const char*>(data), int(sizeof(T)) * count);
+}
+
+} // namespace
+
+struct ContentFilter::Header {
+    char magic[8];
+    quint32 version;
+    quint32 ruleCount;
+    struct { quint32 offset; quint32 count; } sections[SectionCount];
+};
+
+struct ContentFilter::Rule {
+    quint32 patternOffset;
+    quint16 patternLength;
+    quint16 flags;
+    quint32 types;
+    quint32 domainOffset; // include list, then exclude list
+    quint16 includeCount;
+    quint16 excludeCount;
+};
+
+struct ContentFilter::TokenEntry {
+    quint64 hash;
+    quint32 firstId;
+    quint32 count;
+};
+
+struct ContentFilter::Request {
+    const char* url;
+    int length;
+    int hostBegin;
+    int hostEnd;
+    QByteArray host;
+    QByteArray firstPartyHost;
+    quint32 type;
+    bool thirdParty;
+    QVarLengthArray<quint64, 8> hostHashes;
+    QVarLengthArray<quint64, 48> tokens;
+};
+
+ContentFilter::ContentFilter() = default;
+ContentFilter::~ContentFilter() = default;
+
+QByteArray ContentFilter::compile(const QList<QByteArray>& lines, CompileStats* stats) {
+    CompileStats st;
+    QVector<quint64> blockHosts, thirdPartyHosts, allowHosts, documentHosts;
+    QVector<ParsedRule> rules;
+    QHash<QByteArray, int> tokenFrequency;
+    for (const QByteArray &line : lines) {
+        ++st.lines;
+        ParsedRule r;
+        const LineKind kind = parseLine(line, &r);
+        switch (kind) {
+        case LineKind::Skip: break;
+        case LineKind::Unsupported: ++st.unsupported; break;
+        case LineKind::Host: blockHosts.append(fnv1a(r.pattern.left(r.pattern.size() - 1))); ++st.hostRules; break;
+        case LineKind::ThirdPartyHost: thirdPartyHosts.append(fnv1a(r.pattern.left(r.pattern.size() - 1))); ++st.hostRules; break;
+        case LineKind::AllowHost: allowHosts.append(fnv1a(r.pattern.left(r.pattern.size() - 1))); ++st.hostRules; break;
+        case LineKind::DocumentAllowHost: documentHosts.append(fnv1a(r.pattern.left(r.pattern.size() - 1))); ++st.hostRules; break;
+        case LineKind::Pattern:
+            for (const QByteArray &t : r.tokens) ++tokenFrequency[t];
+            rules.append(r);
+            ++st.patternRules;
+            break;
+        }
+    }
+
+    // bucket each rule under its least common token so buckets stay short
+    static const QList<QByteArray> kCommon = {"http", "https", "www", "com"};
+    QMap<quint64, QVector<quint32>> blockBuckets, allowBuckets;
+    for (int i = 0; i < rules.size(); ++i) {
+        const ParsedRule &r = rules[i];
+        QByteArray best;
+        int bestFreq = INT_MAX;
+        for (const QByteArray &t : r.tokens) {
+            const int f = kCommon.contains(t) ? INT_MAX - 1 : tokenFrequency.value(t);
+            if (f < bestFreq || (f == bestFreq && t.size() > best.size())) { best = t; bestFreq = f; }
+        }
+        if (best.isEmpty()) ++st.untokenized;
+        const quint64 h = best.isEmpty() ? 0 : fnv1a(best);
+        ((r.flags & Exception) ? allowBuckets : blockBuckets)[h].append(quint32(i));
+    }
+
+    QVector<Rule> packed;
+    QVector<quint64> domains;
+    QByteArray strings;
+    packed.reserve(rules.size());
+    for (const ParsedRule &r : rules) {
+        Rule pr;
+        pr.patternOffset = quint32(strings.size());
+        pr.patternLength = quint16(r.pattern.size());
+        pr.flags = r.flags;
+        pr.types = r.types;
+        pr.domainOffset = quint32(domains.size());
+        pr.includeCount = quint16(qMin(r.include.size(), 0xffff));
+        pr.excludeCount = quint16(qMin(r.exclude.size(), 0xffff));
+        domains += r.include.mid(0, pr.includeCount);
+        domains += r.exclude.mid(0, pr.excludeCount);
+        strings += r.pattern;
+        packed.append(pr);
+    }
+    QVector<quint32> ruleIds;
+    auto buildTokens = [&ruleIds](const QMap<quint64, QVector<quint32>>& buckets) {
+        QVector<TokenEntry> entries;
+        for (auto it = buckets.constBegin(); it != buckets.constEnd(); ++it) {
+            entries.append({it.key(), quint32(ruleIds.size()), quint32(it.value().size())});
+            ruleIds += it.value();
+        }
+        return entries;
+    };
+    const QVector<TokenEntry> blockTokens = buildTokens(blockBuckets);
+    const QVector<TokenEntry> allowTokens = buildTokens(allowBuckets);
+
+    for (QVector<quint64>* set : {&blockHosts, &thirdPartyHosts, &allowHosts, &documentHosts}) {
+        std::sort(set->begin(), set->end());
+        set->erase(std::unique(set->begin(), set->end()), set->end());
+    }
+    // ~10 bits per host with 3 probes: about 1% false positives
+    const int hostTotal = blockHosts.size() + thirdPartyHosts.size() + allowHosts.size() + documentHosts.size();
+    quint32 bloomBits = 64;
+    while (bloomBits < quint32(hostTotal) * 10 && bloomBits < (1u << 31)) bloomBits <<= 1;
+    QVector<quint64> bloom(int(bloomBits / 64), 0);
+    for (const QVector<quint64>* set : {&blockHosts, &thirdPartyHosts, &allowHosts, &documentHosts}) {
+        for (quint64 h : *set) {
+            const quint64 step = (h >> 32) | 1;
+            for (int k = 0; k < 3; ++k) {
+                const quint32 bit = quint32((h + k * step) & (bloomBits - 1));
+                bloom[int(bit / 64)] |= quint64(1) << (bit % 64);
+            }
+        }
+    }
+
+    Header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.ruleCount = quint32(hostTotal + packed.size());
+    QByteArray out(int(sizeof(Header)), '\0');
+    auto put = [&out, &header](int section, const auto& vec) {
+        align8(out);
+        header.sections[section].offset = quint32(out.size());
+        header.sections[section].count = quint32(vec.size());
+        appendPod(out, vec.constData(), int(vec.size()));
+    };
+    put(Bloom, bloom);
+    put(BlockHosts, blockHosts);
+    put(ThirdPartyHosts, thirdPartyHosts);
+    put(AllowHosts, allowHosts);
+    put(DocumentAllowHosts, documentHosts);
+    put(BlockTokens, blockTokens);
+    put(AllowTokens, allowTokens);
+    put(RuleIds, ruleIds);
+    put(Rules, packed);
+    put(Domains, domains);
+    put(Strings, strings);
+    align8(out);
+    memcpy(out.data(), &header, sizeof(header));
+
+    if (stats) *stats = st;
+    return out;
+}
+
+bool ContentFilter::writeCompiled(const QString& path, const QByteArray& image) {
+    // write aside and rename, so a running instance keeps its mapping of the old file
+    QSaveFile f(path);
+    if (!f.open(QIODevice::WriteOnly)) return false;
+    f.write(image);
+    return f.commit();
+}
+
+bool ContentFilter::load(const QByteArray& image) {
+    // copy into 8-byte aligned storage; the sections hold 64-bit words
+    std::vector<quint64> buf((size_t(image.size()) + 7) / 8);
+    if (!image.isEmpty()) memcpy(buf.data(), image.constData(), size_t(image.size()));
+    if (!attach(reinterpret_cast<const uchar*>(buf.data()), image.size())) return false;
+    m_owned.swap(buf);
+    m_file.reset();
+    return true;
+}
+
+bool ContentFilter::mapFile(const QString& path) {
+    auto file = std::make_unique<QFile>(path);
+    if (!file->open(QIODevice::ReadOnly)) return false;
+    const qint64 size = file->size();
+    uchar* data = size > 0 ? file->map(0, size) : nullptr;
+    if (!data || !attach(data, size)) return false;
+    m_file = std::move(file);
+    m_owned.clear();
+    return true;
+}
+
+bool ContentFilter::attach(const uchar* data, qint64 size) {
+    if (size < qint64(sizeof(Header)) || (quintptr(data) % 8) != 0) return false;
+    const Header* h = reinterpret_cast<const Header*>(data);
+    if (memcmp(h->magic, kMagic, sizeof(kMagic)) != 0 || h->version != kVersion) return false;
+    static const int elementSize[SectionCount] = {
+        8, 8, 8, 8, 8, int(sizeof(TokenEntry)), int(sizeof(TokenEntry)), 4, int(sizeof(Rule)), 8, 1
+    };
+    for (int s = 0; s < SectionCount; ++s) {
+        const auto &sec = h->sections[s];
+        if (elementSize[s] > 1 && sec.offset % 8) return false;
+        if (qint64(sec.offset) + qint64(sec.count) * elementSize[s] > size) return false;
+    }
+    const quint32 bloomWords = h->sections[Bloom].count;
+    if (bloomWords == 0 || (bloomWords & (bloomWords - 1))) return false;
+    // every reference has to stay inside its section, a truncated cache must not crash
+    const quint32 idCount = h->sections[RuleIds].count;
+    const quint32 ruleCount = h->sections[Rules].count;
+    for (int s : {BlockTokens, AllowTokens}) {
+        const TokenEntry* t = reinterpret_cast<const TokenEntry*>(data + h->sections[s].offset);
+        for (quint32 i = 0; i < h->sections[s].count; ++i)
+            if (quint64(t[i].firstId) + t[i].count > idCount) return false;
+    }
+    const quint32* ids = reinterpret_cast<const quint32*>(data + h->sections[RuleIds].offset);
+    for (quint32 i = 0; i < idCount; ++i) if (ids[i] >= ruleCount) return false;
+    const Rule* rules = reinterpret_cast<const Rule*>(data + h->sections[Rules].offset);
+    for (quint32 i = 0; i < ruleCount; ++i) {
+        if (quint64(rules[i].patternOffset) + rules[i].patternLength > h->sections[Strings].count) return false;
+        if (quint64(rules[i].domainOffset) + rules[i].includeCount + rules[i].excludeCount > h->sections[Domains].count) return false;
+    }
+    m_base = data;
+    m_size = size;
+    m_header = h;
+    return true;
+}
+
+int ContentFilter::ruleCount() const { return m_header ? int(m_header->ruleCount) : 0; }
+
+const uchar* ContentFilter::sectionData(int section) const { return m_base + m_header->sections[section].offset; }
+quint32 ContentFilter::sectionCount(int section) const { return m_header->sections[section].count; }
+
+bool ContentFilter::bloomMayContain(quint64 h) const {
+    const quint64* words = reinterpret_cast<const quint64*>(sectionData(Bloom));
+    const quint64 bits = quint64(sectionCount(Bloom)) * 64;
+    const quint64 step = (h >> 32) | 1;
+    for (int k = 0; k < 3; ++k) {
+        const quint64 bit = (h + k * step) & (bits - 1);
+        if (!(words[bit / 64] & (quint64(1) << (bit % 64)))) return false;
+    }
+    return true;
+}
+
+bool ContentFilter::hostSetContains(int section, quint64 h) const {
+    const quint64* begin = reinterpret_cast<const quint64*>(sectionData(section));
+    const quint64* end = begin + sectionCount(section);
+    return std::binary_search(begin, end, h);
+}
+
+bool ContentFilter::hostsMatch(int section, const Request& req) const {
+    if (sectionCount(section) == 0) return false;
+    for (quint64 h : req.hostHashes)
+        if (bloomMayContain(h) && hostSetContains(section, h)) return true;
+    return false;
+}
+
+bool ContentFilter::domainListMatches(quint32 offset, quint32 count, const QByteArray& host) const {
+    if (host.isEmpty()) return false;
+    const quint64* begin = reinterpret_cast<const quint64*>(sectionData(Domains)) + offset;
+    QVarLengthArray<quint64, 8> hashes;
+    suffixHashes(host, hashes);
+    for (quint64 h : hashes) if (std::binary_search(begin, begin + count, h)) return true;
+    return false;
+}
+
+bool ContentFilter::matchRule(const Rule& r, const Request& req) const {
+    if (!(r.types & req.type)) return false;
+    if ((r.flags & ThirdParty) && !req.thirdParty) return false;
+    if ((r.flags & FirstParty) && req.thirdParty) return false;
+    if (r.includeCount && !domainListMatches(r.domainOffset, r.includeCount, req.firstPartyHost)) return false;
+    if (r.excludeCount && domainListMatches(r.domainOffset + r.includeCount, r.excludeCount, req.firstPartyHost)) return false;
+    const char* pattern = reinterpret_cast<const char*>(sectionData(Strings)) + r.patternOffset;
+    return matchPattern(pattern, r.patternLength, r.flags, req.url, req.length, req.hostBegin, req.hostEnd);
+}
+
+const ContentFilter::Rule* ContentFilter::findRule(const Request& req, bool exception) const {
+    const int section = exception ? AllowTokens : BlockTokens;
+    const TokenEntry* begin = reinterpret_cast<const TokenEntry*>(sectionData(section));
+    const TokenEntry* end = begin + sectionCount(section);
+    if (begin == end) return nullptr;
+    const quint32* ids = reinterpret_cast<const quint32*>(sectionData(RuleIds));
+    const Rule* rules = reinterpret_cast<const Rule*>(sectionData(Rules));
+    auto bucket = [&](quint64 h) -> const Rule* {
+        const TokenEntry* t = std::lower_bound(begin, end, h, [](const TokenEntry& e, quint64 v){ return e.hash < v; });
+        if (t == end || t->hash != h) return nullptr;
+        for (quint32 i = 0; i < t->count; ++i) {
+            const Rule &r = rules[ids[t->firstId + i]];
+            if (matchRule(r, req)) return &r;
+        }
+        return nullptr;
+    };
+    if (const Rule* r = bucket(0)) return r;
+    for (quint64 h : req.tokens) if (const Rule* r = bucket(h)) return r;
+    return nullptr;
+}
+
+bool ContentFilter::shouldBlock(const QByteArray& url, const QByteArray& firstPartyHost, quint32 type) const {
+    if (!m_header || url.isEmpty() || (type & Document)) return false;
+
+    Request req;
+    req.url = url.constData();
+    req.length = url.size();
+    const int scheme = url.indexOf("://");
+    req.hostBegin = scheme < 0 ? 0 : scheme + 3;
+    req.hostEnd = req.hostBegin;
+    while (req.hostEnd < req.length && !strchr("/?#:", req.url[req.hostEnd])) ++req.hostEnd;
+    req.host = QByteArray::fromRawData(req.url + req.hostBegin, req.hostEnd - req.hostBegin);
+    req.firstPartyHost = firstPartyHost;
+    req.type = type;
+    req.thirdParty = !firstPartyHost.isEmpty() && registrableDomain(req.host) != registrableDomain(firstPartyHost);
+    suffixHashes(req.host, req.hostHashes);
+    for (int i = 0; i < req.length;) {
+        if (!isTokenChar(uchar(req.url[i]))) { ++i; continue; }
+        int e = i;
+        while (e < req.length && isTokenChar(uchar(req.url[e]))) ++e;
+        if (e - i >= 2) {
+            const quint64 h = fnv1a(req.url + i, e - i);
+            if (!std::count(req.tokens.begin(), req.tokens.end(), h)) req.tokens.append(h);
+        }
+        i = e;
+    }
+
+    const Rule* rule = nullptr;
+    const bool hostBlocked = hostsMatch(BlockHosts, req) || (req.thirdParty && hostsMatch(ThirdPartyHosts, req));
+    if (!hostBlocked && !(rule = findRule(req, false))) return false;
+    if (rule && (rule->flags & Important)) return true;
+
+    if (hostsMatch(AllowHosts, req) || findRule(req, true)) return false;
+    if (!firstPartyHost.isEmpty() && sectionCount(DocumentAllowHosts) > 0) {
+        QVarLengthArray<quint64, 8> pageHashes;
+        suffixHashes(firstPartyHost, pageHashes);
+        for (quint64 h : pageHashes) if (bloomMayContain(h) && hostSetContains(DocumentAllowHosts, h)) return false;
+    }
+    return true;
+}
+
+bool ContentFilter::shouldBlock(const QUrl& url, const QUrl& firstParty, quint32 type) const {
+    if (!m_header) return false;
+    const QByteArray u = url.toEncoded(QUrl::RemoveUserInfo | QUrl::RemoveFragment).toLower();
+    const QByteArray page = firstParty.host(QUrl::FullyEncoded).toLatin1().toLower();
+    return shouldBlock(u, page, type);
+}
+
+quint32 ContentFilter::typeFromName(const QByteArray& o) {
+    if (o == "script") return Script;
+    if (o == "image") return Image;
+    if (o == "stylesheet" || o == "css") return Stylesheet;
+    if (o == "xmlhttprequest" || o == "xhr") return Xhr;
+    if (o == "subdocument" || o == "frame") return Subdocument;
+    if (o == "font") return Font;
+    if (o == "media") return Media;
+    if (o == "object" || o == "object-subrequest") return Object;
+    if (o == "ping" || o == "beacon") return Ping;
+    if (o == "websocket") return WebSocket;
+    if (o == "other") return Other;
+    if (o == "document" || o == "doc") return Document;
+    return 0;
+}
+
+QByteArray ContentFilter::typeName(quint32 type) {
+    switch (type) {
+    case Script: return "script";
+    case Image: return "image";
+    case Stylesheet: return "stylesheet";
+    case Xhr: return "xmlhttprequest";
+    case Subdocument: return "subdocument";
+    case Font: return "font";
+    case Media: return "media";
+    case Object: return "object";
+    case Ping: return "ping";
+    case WebSocket: return "websocket";
+    case Document: return "document";
+    default: return "other";
+    }
+}
+
+QByteArray ContentFilter::registrableDomain(const QByteArray& host) {
+    static const QList<QByteArray> kSecondLevel = {"co", "com", "net", "org", "gov", "edu", "ac", "ne", "or", "go"};
+    const int last = host.lastIndexOf('.');
+    if (last <= 0) return host;
+    const int second = host.lastIndexOf('.', last - 1);
+    if (second < 0) return host;
+    // example.co.uk, example.com.au
+    if (host.size() - last - 1 == 2 && kSecondLevel.contains(host.mid(second + 1, last - second - 1))) {
+        const int third = second > 0 ? host.lastIndexOf('.', second - 1) : -1;
+        return third < 0 ? host : host.mid(third + 1);
+    }
+    return host.mid(second + 1);
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <QByteArray>
+#include <QList>
+#include <QString>
+#include <QUrl>
+#include <memory>
+#include <vector>
+
+class QFile;
+
+// Compiled EasyList-style network filter engine.
+//
+// Filter lists are compiled once into a flat, pointer-free image that can be
+// written to disk and mapped back in without parsing:
+//  - plain host rules (||host^, optionally $third-party) become sorted 64-bit
+//    hash sets behind a Bloom filter, checked for every suffix of the request host;
+//  - every other rule is indexed under its rarest literal token; a request only
+//    evaluates the rules whose token occurs in its URL (plus the few untokenizable ones).
+// Lookups are read-only, so one instance can be shared across threads.
+class ContentFilter {
+public:
+    enum ResourceType : quint32 {
+        Other = 1u << 0,
+        Script = 1u << 1,
+        Image = 1u << 2,
+        Stylesheet = 1u << 3,
+        Xhr = 1u << 4,
+        Subdocument = 1u << 5,
+        Font = 1u << 6,
+        Media = 1u << 7,
+        Object = 1u << 8,
+        Ping = 1u << 9,
+        WebSocket = 1u << 10,
+        Document = 1u << 11,
+        AllTypes = (1u << 11) - 1 // everything except Document, as in EasyList
+    };
+
+    struct CompileStats {
+        int lines = 0;
+        int hostRules = 0;
+        int patternRules = 0;
+        int untokenized = 0;
+        int unsupported = 0; // regex rules, cosmetic filters, unknown options
+    };
+
+    ContentFilter();
+    ~ContentFilter();
+    ContentFilter(const ContentFilter&) = delete;
+    ContentFilter& operator=(const ContentFilter&) = delete;
+
+    static QByteArray compile(const QList<QByteArray>& lines, CompileStats* stats = nullptr);
+    static bool writeCompiled(const QString& path, const QByteArray& image);
+
+    bool load(const QByteArray& image); // copies the image
+    bool mapFile(const QString& path);  // memory-maps a compiled image
+    bool isLoaded() const { return m_base != nullptr; }
+    int ruleCount() const;
+
+    // url must be lowercase and fully encoded; firstPartyHost may be empty.
+    bool shouldBlock(const QByteArray& url, const QByteArray& firstPartyHost, quint32 type) const;
+    bool shouldBlock(const QUrl& url, const QUrl& firstParty, quint32 type) const;
+
+    // EasyList option names ("script", "xmlhttprequest", ...); 0 when unknown
+    static quint32 typeFromName(const QByteArray& name);
+    static QByteArray typeName(quint32 type);
+
+    // Registrable domain approximation (no public suffix list): last two labels,
+    // or three under common second-level labels like co.uk / com.au.
+    static QByteArray registrableDomain(const QByteArray& host);
+
+private:
+    struct Header;
+    struct Rule;
+    struct TokenEntry;
+    struct Request;
+
+    bool attach(const uchar* data, qint64 size);
+    const uchar* sectionData(int section) const;
+    quint32 sectionCount(int section) const;
+    bool bloomMayContain(quint64 h) const;
+    bool hostSetContains(int section, quint64 h) const;
+    bool hostsMatch(int section, const Request& req) const;
+    const Rule* findRule(const Request& req, bool exception) const;
+    bool matchRule(const Rule& r, const Request& req) const;
+    bool domainListMatches(quint32 offset, quint32 count, const QByteArray& host) const;
+
+    std::vector<quint64> m_owned; // image passed to load(), 8-byte aligned
+    std::unique_ptr<QFile> m_file;
+    const uchar* m_base = nullptr;
+    qint64 m_size = 0;
+    const Header* m_header = nullptr;
+};
@@ -0,0 +1,180 @@
+#include "EventLoopMonitor.h"
+#include "Trace.h"
+#include <QAbstractEventDispatcher>
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDebug>
+#include <QEvent>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QMetaEnum>
+#include <QThread>
+
+namespace {
+// set while a monitor is running; checked on every event of every thread
+std::atomic<EventLoopMonitor*> s_running{nullptr};
+
+QString eventName(int type) {
+    const char* key = QMetaEnum::fromType<QEvent::Type>().valueToKey(type);
+    return key ? QString::fromLatin1(key) : QString::number(type);
+}
+
+QJsonObject taskToJson(const LongTask& t) {
+    return QJsonObject{{"at", t.at}, {"ms", t.ms}, {"receiver", t.receiverClass}, {"name", t.receiverName},
+                       {"event", t.event}, {"flagged", t.flagged}};
+}
+}
+
+QString LongTask::label() const {
+    QString s = receiverClass;
+    if (!receiverName.isEmpty()) s += QString(" '%1'").arg(receiverName);
+    return s + QString(" (%1)").arg(event);
+}
+
+EventLoopMonitor* EventLoopMonitor::instance() {
+    static QPointer<EventLoopMonitor> s_instance;
+    if (!s_instance) s_instance = new EventLoopMonitor(QCoreApplication::instance());
+    return s_instance;
+}
+
+EventLoopMonitor::EventLoopMonitor(QObject* parent)
+    : QObject(parent),
+      m_lagMs(MetricsRegistry::histogram("gui.event_loop_lag_ms")),
+      m_taskMs(MetricsRegistry::histogram("gui.task_ms")),
+      m_longTaskCount(MetricsRegistry::counter("gui.long_tasks")) {
+    m_clock.start();
+    m_frames.reserve(16);
+    MetricsRegistry::addSource("long_tasks", this, [this](){
+        QJsonArray out;
+        for (const LongTask &t : m_longTasks) out.append(taskToJson(t));
+        return out;
+    });
+}
+
+EventLoopMonitor::~EventLoopMonitor() {
+    stop();
+}
+
+void EventLoopMonitor::start() {
+    if (m_sampler) return;
+    if (auto *dispatcher = QAbstractEventDispatcher::instance(thread()))
+        connect(dispatcher, &QAbstractEventDispatcher::aboutToBlock, this, &EventLoopMonitor::onAboutToBlock, Qt::UniqueConnection);
+    s_running.store(this);
+    m_stopSampler.store(false);
+    m_sampler = QThread::create([this](){
+        while (!m_stopSampler.load()) {
+            QThread::msleep(ulong(m_intervalMs.load()));
+            sample();
+        }
+    });
+    m_sampler->setObjectName("event-loop-sampler");
+    m_sampler->start();
+}
+
+void EventLoopMonitor::stop() {
+    if (!m_sampler) return;
+    s_running.store(nullptr);
+    m_stopSampler.store(true);
+    m_sampler->wait();
+    delete m_sampler;
+    m_sampler = nullptr;
+    m_taskStartNs.store(0);
+}
+
+EventLoopMonitor::Dispatch::Dispatch(QObject* receiver, QEvent* event) : m_monitor(s_running.load(std::memory_order_relaxed)) {
+    if (m_monitor && QThread::currentThread() != m_monitor->thread()) m_monitor = nullptr;
+    if (m_monitor) m_monitor->enter(receiver, event);
+}
+
+EventLoopMonitor::Dispatch::~Dispatch() {
+    if (m_monitor) m_monitor->leave();
+}
+
+void EventLoopMonitor::enter(QObject* receiver, QEvent* event) {
+    // sent from inside a handler, the event is part of that handler's task
+    const bool task = m_frames.isEmpty() || m_frames.last().hostsLoop;
+    const qint64 now = m_clock.nsecsElapsed();
+    // the receiver may be deleted by its own event, so it is described now
+    m_frames.append(Frame{now, receiver->metaObject()->className(), task ? receiver->objectName() : QString(),
+                          int(event->type()), task, false});
+    if (!task) return;
+    m_taskSeq.fetch_add(1, std::memory_order_relaxed);
+    m_taskClass.store(m_frames.last().receiverClass, std::memory_order_relaxed);
+    m_taskEvent.store(int(event->type()), std::memory_order_relaxed);
+    m_taskStartNs.store(now, std::memory_order_release);
+}
+
+void EventLoopMonitor::leave() {
+    if (m_frames.isEmpty()) return;
+    const Frame f = m_frames.takeLast();
+    if (!f.task || f.hostsLoop) return;
+    m_taskStartNs.store(0, std::memory_order_relaxed);
+    const qint64 durationNs = m_clock.nsecsElapsed() - f.startNs;
+    m_taskMs->record(durationNs / 1e6);
+    if (durationNs < m_thresholdNs.load(std::memory_order_relaxed)) return;
+
+    LongTask t;
+    t.at = QDateTime::currentMSecsSinceEpoch() - durationNs / 1000000;
+    t.ms = durationNs / 1e6;
+    t.receiverClass = QString::fromLatin1(f.receiverClass);
+    t.receiverName = f.receiverName;
+    t.event = eventName(f.eventType);
+    t.flagged = m_flaggedSeq.load() == m_taskSeq.load();
+    m_longTasks.append(t);
+    if (m_longTasks.size() > kKeptLongTasks) m_longTasks.removeFirst();
+    m_longTaskCount->add();
+    qWarning().noquote() << QString("EventLoopMonitor: long task, %1 ms in %2").arg(t.ms, 0, 'f', 1).arg(t.label());
+    if (Trace::enabled()) {
+        // shown around the trace scopes that ran inside it
+        const std::int64_t end = Trace::nowNs();
+        Trace::complete("long task", Trace::intern(t.label().toUtf8()), end - durationNs, end);
+    }
+    emit longTaskDetected(t);
+}
+
+// The loop is about to wait, so whatever dispatched it is not busy: every
+// open frame hosts a nested loop, and the events it runs are tasks of their own.
+void EventLoopMonitor::onAboutToBlock() {
+    for (Frame &f : m_frames) f.hostsLoop = true;
+    m_taskStartNs.store(0, std::memory_order_relaxed);
+}
+
+// sampler thread
+void EventLoopMonitor::sample() {
+    const qint64 now = m_clock.nsecsElapsed();
+    if (!m_pingPending.exchange(true))
+        QMetaObject::invokeMethod(this, [this, now](){ onPing(now); }, Qt::QueuedConnection);
+
+    const quint64 seq = m_taskSeq.load(std::memory_order_relaxed);
+    const qint64 start = m_taskStartNs.load(std::memory_order_acquire);
+    if (!start || now - start < m_thresholdNs.load() || m_flaggedSeq.load() == seq) return;
+    const char* cls = m_taskClass.load(std::memory_order_relaxed);
+    const int type = m_taskEvent.load(std::memory_order_relaxed);
+    // a newer task began meanwhile: this one was not long
+    if (m_taskSeq.load(std::memory_order_relaxed) != seq) return;
+    m_flaggedSeq.store(seq);
+    qWarning().noquote() << QString("EventLoopMonitor: GUI thread busy for %1 ms in %2 (%3), still running")
+                                .arg((now - start) / 1000000).arg(QString::fromLatin1(cls), eventName(type));
+    if (Trace::enabled()) Trace::instant("long task running", cls);
+}
+
+void EventLoopMonitor::onPing(qint64 sentNs) {
+    m_lagMs->record((m_clock.nsecsElapsed() - sentNs) / 1e6);
+    m_pingPending.store(false);
+}
+
+QJsonObject EventLoopMonitor::toJson() const {
+    QJsonArray tasks;
+    for (const LongTask &t : m_longTasks) tasks.append(taskToJson(t));
+    return QJsonObject{{"threshold_ms", thresholdMs()},
+                       {"event_loop_lag_ms", m_lagMs->snapshot().toJson()},
+                       {"task_ms", m_taskMs->snapshot().toJson()},
+                       {"long_tasks", tasks}};
+}
+
+bool EventLoopMonitor::exportJson(const QString& path) const {
+    QFile f(path);
+    if (!f.open(QIODevice::WriteOnly | QIODevice::Truncate)) return false;
+    return f.write(QJsonDocument(toJson()).toJson()) >= 0;
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QJsonObject>
+#include <QPointer>
+#include <QString>
+#include <QVector>
+#include <atomic>
+#include "MetricsRegistry.h"
+
+class QThread;
+class QEvent;
+
+// One event handled on the GUI thread for longer than the threshold.
+struct LongTask {
+    qint64 at = 0;            // epoch ms when it started
+    double ms = 0.0;
+    QString receiverClass;
+    QString receiverName;     // objectName, often empty
+    QString event;            // e.g. "Timer", "MetaCall" for a queued slot
+    bool flagged = false;     // the sampler saw it still running
+    QString label() const;
+};
+
+// Watches the GUI thread's event loop:
+//  - a sampler thread pings the loop every few milliseconds and records how
+//    long the ping waits in gui.event_loop_lag_ms, the delay input would see;
+//  - every event delivered at the loop's own level is timed (gui.task_ms) and
+//    one running past the threshold is logged as a LongTask with its receiver;
+//  - the sampler also flags a task that is still running past the threshold,
+//    so a hang is reported while it happens.
+// An event hosting a nested event loop (a modal dialog, QEventLoop::exec) is
+// not a task; what that loop dispatches is. Events reach the monitor through
+// MonitoredApplication::notify.
+class EventLoopMonitor : public QObject {
+    Q_OBJECT
+public:
+    // created on first use, for the thread that calls it
+    static EventLoopMonitor* instance();
+
+    void start();
+    void stop();
+    bool isRunning() const { return m_sampler != nullptr; }
+
+    void setThresholdMs(int ms) { m_thresholdNs.store(qint64(ms) * 1000000); }
+    int thresholdMs() const { return int(m_thresholdNs.load() / 1000000); }
+    void setSampleIntervalMs(int ms) { m_intervalMs.store(qMax(1, ms)); }
+
+    // the most recent long tasks, oldest first
+    QVector<LongTask> longTasks() const { return m_longTasks; }
+    static constexpr int kKeptLongTasks = 100;
+
+    // histograms and long tasks, for keeping next to a benchmark baseline
+    QJsonObject toJson() const;
+    bool exportJson(const QString& path) const;
+
+    // Times one delivery; MonitoredApplication wraps notify() in it.
+    class Dispatch {
+    public:
+        Dispatch(QObject* receiver, QEvent* event);
+        ~Dispatch();
+        Dispatch(const Dispatch&) = delete;
+        Dispatch& operator=(const Dispatch&) = delete;
+    private:
+        EventLoopMonitor* m_monitor;
+    };
+
+signals:
+    void longTaskDetected(const LongTask& task);
+
+private:
+    explicit EventLoopMonitor(QObject* parent = nullptr);
+    ~EventLoopMonitor() override;
+
+    struct Frame {
+        qint64 startNs;
+        const char* receiverClass;
+        QString receiverName;
+        int eventType;
+        bool task;       // delivered by the loop itself, not by a handler
+        bool hostsLoop;  // a nested event loop ran inside it
+    };
+    void enter(QObject* receiver, QEvent* event);
+    void leave();
+    void onAboutToBlock();
+    void sample();
+    void onPing(qint64 sentNs);
+
+    QElapsedTimer m_clock;
+    QThread* m_sampler = nullptr;
+    std::atomic<bool> m_stopSampler{false};
+    std::atomic<int> m_intervalMs{5};
+    std::atomic<qint64> m_thresholdNs{50 * 1000000};
+    std::atomic<bool> m_pingPending{false};
+
+    // GUI thread only
+    QVector<Frame> m_frames;
+    QVector<LongTask> m_longTasks;
+
+    // the running task, for the sampler; start 0 when there is none
+    std::atomic<qint64> m_taskStartNs{0};
+    std::atomic<const char*> m_taskClass{nullptr};
+    std::atomic<int> m_taskEvent{0};
+    std::atomic<quint64> m_taskSeq{0};
+    std::atomic<quint64> m_flaggedSeq{0};
+
+    MetricsRegistry::Histogram* m_lagMs;
+    MetricsRegistry::Histogram* m_taskMs;
+    MetricsRegistry::Counter* m_longTaskCount;
+};
+
+// The application class with every event delivery on the GUI thread timed
+// by EventLoopMonitor, e.g. MonitoredApplication<QApplication>.
+template <class App>
+class MonitoredApplication : public App {
+public:
+    using App::App;
+    bool notify(QObject* receiver, QEvent* event) override {
+        const EventLoopMonitor::Dispatch dispatch(receiver, event);
+        return App::notify(receiver, event);
+    }
+};
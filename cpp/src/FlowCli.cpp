@@ -0,0 +1,579 @@
+#include "FlowCli.h"
+#include "AuthManager.h"
+#include "BookmarksManager.h"
+#include "HistoryManager.h"
+#include "HistoryRetention.h"
+#include "NotesManager.h"
+#include "StorageExecutor.h"
+#include "StoreTransfer.h"
+#include "SupabaseConfig.h"
+#include "TodosManager.h"
+#include <QBuffer>
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QLocale>
+#include <QPair>
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QStandardPaths>
+#include <QTextStream>
+#include <QTimer>
+#include <QVariant>
+#include <memory>
+#include <vector>
+
+namespace {
+const QStringList kCollections = {"bookmarks", "notes", "todos"};
+const QStringList kKinds = kCollections + QStringList{"history"};
+// options that take no value
+const QSet<QString> kFlags = {"--json", "--new-ids"};
+constexpr int kLoadTimeoutMs = 60 * 1000;
+
+// what a storage-thread job has to say, line by line
+struct Lines {
+    QStringList text;
+    bool ok = true;
+};
+
+bool openFile(QFile& file, const QString& path, QIODevice::OpenMode mode) {
+    if (path == "-") return file.open(mode.testFlag(QIODevice::WriteOnly) ? stdout : stdin, mode);
+    file.setFileName(path);
+    return file.open(mode);
+}
+
+qint64 fileBytes(QSqlDatabase db) {
+    QSqlQuery q(db);
+    const qint64 pages = q.exec("PRAGMA page_count") && q.next() ? q.value(0).toLongLong() : 0;
+    return q.exec("PRAGMA page_size") && q.next() ? pages * q.value(0).toLongLong() : 0;
+}
+
+// Records become local items queued for the next sync. One that is there
+// already is skipped, so importing an export twice adds nothing: a bookmark by
+// its URL, a synced note or todo by its id. Notes and todos get their id from
+// the server, so unsynced ones are matched by content instead, each local copy
+// taking up one record: identical records of one export are all imported the
+// first time. Ids are kept unless newIds: items restored into the account that
+// exported them update the same rows.
+// The collection is looked at once, at the first batch: the rows added by the
+// import itself do not count.
+template <class Traits>
+class RecordAppender {
+public:
+    using Item = typename Traits::Item;
+
+    RecordAppender(SyncedCollection<Traits>* collection, bool newIds): m_collection(collection), m_newIds(newIds) {}
+
+    qint64 operator()(const QVector<QJsonObject>& records) {
+        if (!m_primed) prime();
+        QVector<Item> added;
+        added.reserve(records.size());
+        for (const QJsonObject &o : records) {
+            Item item = Traits::fromLocal(o);
+            const QString key = Traits::identityKey(item);
+            if (!key.isEmpty()) {
+                if (m_known.contains(key)) continue;
+                m_known.insert(key);
+            } else {
+                auto copies = m_copies.find(contentKey(item));
+                if (copies != m_copies.end() && copies.value() > 0) {
+                    --copies.value();
+                    continue;
+                }
+            }
+            if (m_newIds) item.id.clear();
+            added.append(item);
+        }
+        m_collection->appendMany(added);
+        return added.size();
+    }
+
+private:
+    static QString contentKey(const Item& item) {
+        return QString::fromUtf8(QJsonDocument(Traits::toRemote(item)).toJson(QJsonDocument::Compact));
+    }
+
+    void prime() {
+        const QVector<Item> items = m_collection->items();
+        m_known.reserve(items.size());
+        for (const Item &item : items) {
+            const QString key = Traits::identityKey(item);
+            if (!key.isEmpty()) m_known.insert(key);
+            // synced ones too: an unsynced record may have been pushed since the export
+            ++m_copies[contentKey(item)];
+        }
+        m_primed = true;
+    }
+
+    SyncedCollection<Traits>* m_collection;
+    bool m_newIds;
+    bool m_primed = false;
+    QSet<QString> m_known;
+    QHash<QString, int> m_copies;
+};
+}
+
+FlowCli::FlowCli(QTextStream& out, QTextStream& err, QObject* parent): QObject(parent), m_out(out), m_err(err) {
+}
+
+QString FlowCli::usage() {
+    return QStringLiteral(
+        "usage: flow_cli <command> [options]\n"
+        "\n"
+        "  export <kind> [--out file] [--format json|ndjson]\n"
+        "  import <kind> <file> [--format json|ndjson] [--new-ids]\n"
+        "  search <query> [--limit n] [--json]      history, newest first\n"
+        "  compact [--horizon-days n]               roll up old history and return free pages\n"
+        "  vacuum                                   rewrite flow.db and history.db\n"
+        "  check                                    integrity of flow.db and history.db\n"
+        "  sync [kind...] [--url url --anon-key key] [--email address --password secret] [--timeout s]\n"
+        "  bench [--visits n] [--items n] [--json]  synthetic load, on an empty profile only\n"
+        "\n"
+        "kind is bookmarks, notes, todos or history (sync: not history). \"-\" is stdin or stdout.\n");
+}
+
+FlowCli::Args FlowCli::parse(const QStringList& args) {
+    Args a;
+    for (int i = 0; i < args.size(); ++i) {
+        const QString arg = args[i];
+        if (!arg.startsWith("--")) a.positional.append(arg);
+        else if (kFlags.contains(arg)) a.flags.insert(arg);
+        else a.options.insert(arg, i + 1 < args.size() ? args[++i] : QString());
+    }
+    return a;
+}
+
+int FlowCli::usageError(const QString& message) {
+    m_err << message << "\n\n" << usage();
+    m_err.flush();
+    return 2;
+}
+
+bool FlowCli::waitUntil(const std::function<bool()>& done, int timeoutMs) {
+    if (done()) return true;
+    QElapsedTimer timer;
+    timer.start();
+    QEventLoop loop;
+    QTimer poll;
+    poll.setInterval(10);
+    connect(&poll, &QTimer::timeout, &loop, [&](){
+        if (done() || (timeoutMs > 0 && timer.elapsed() >= timeoutMs)) loop.quit();
+    });
+    poll.start();
+    loop.exec();
+    return done();
+}
+
+int FlowCli::run(const QStringList& args) {
+    if (args.isEmpty()) return usageError("no command");
+    const QString command = args.first();
+    const Args a = parse(args.mid(1));
+    if (command == "help" || command == "--help") { m_out << usage(); return 0; }
+    if (command == "export") return exportData(a);
+    if (command == "import") return importData(a);
+    if (command == "search") return search(a);
+    if (command == "compact") return compact(a);
+    if (command == "vacuum") return vacuum();
+    if (command == "check") return check();
+    if (command == "sync") return sync(a);
+    if (command == "bench") return bench(a);
+    return usageError("unknown command " + command);
+}
+
+int FlowCli::exportData(const Args& a) {
+    if (a.positional.size() != 1 || !kKinds.contains(a.positional.first())) return usageError("export needs one of " + kKinds.join(", "));
+    const QString kind = a.positional.first();
+    const QString path = a.value("--out", "-");
+    StoreTransfer::Format format = StoreTransfer::formatForPath(path);
+    if (a.options.contains("--format") && !StoreTransfer::parseFormat(a.value("--format"), format))
+        return usageError("unknown format " + a.value("--format"));
+    QFile file;
+    if (!openFile(file, path, QIODevice::WriteOnly | QIODevice::Truncate)) {
+        m_err << "cannot write " << path << ": " << file.errorString() << Qt::endl;
+        return 1;
+    }
+    QElapsedTimer timer;
+    timer.start();
+    // written on the storage thread as the rows are read, never held whole
+    const qint64 rows = StorageExecutor::instance()->blockingRead<qint64>([&](Storage& s){
+        StoreTransfer::Writer writer(file, format);
+        const qint64 n = kind == "history" ? StoreTransfer::exportHistory(s, writer) : StoreTransfer::exportCollection(s, kind, writer);
+        return n >= 0 && writer.finish() ? n : -1;
+    });
+    file.close();
+    if (rows < 0) {
+        m_err << "export of " << kind << " failed" << Qt::endl;
+        return 1;
+    }
+    // on err, as out may be the export itself
+    m_err << "exported " << rows << ' ' << kind << " in " << timer.elapsed() << " ms" << Qt::endl;
+    return 0;
+}
+
+int FlowCli::importData(const Args& a) {
+    if (a.positional.size() != 2 || !kKinds.contains(a.positional.first()))
+        return usageError("import needs one of " + kKinds.join(", ") + " and a file");
+    const QString kind = a.positional[0];
+    const QString path = a.positional[1];
+    StoreTransfer::Format format = StoreTransfer::formatForPath(path);
+    if (a.options.contains("--format") && !StoreTransfer::parseFormat(a.value("--format"), format))
+        return usageError("unknown format " + a.value("--format"));
+    QFile file;
+    if (!openFile(file, path, QIODevice::ReadOnly)) {
+        m_err << "cannot read " << path << ": " << file.errorString() << Qt::endl;
+        return 1;
+    }
+
+    const bool newIds = a.flags.contains("--new-ids");
+    std::unique_ptr<SyncEngineBase> collection;
+    std::function<qint64(const QVector<QJsonObject>&)> add;
+    if (kind == "history") {
+        add = [](const QVector<QJsonObject>& batch){
+            return StorageExecutor::instance()->blockingRead<qint64>([&batch](Storage& s){ return StoreTransfer::importHistory(s, batch); });
+        };
+    } else {
+        if (kind == "bookmarks") {
+            auto *m = new BookmarksManager;
+            add = RecordAppender<BookmarkTraits>(m, newIds);
+            collection.reset(m);
+        } else if (kind == "notes") {
+            auto *m = new NotesManager;
+            add = RecordAppender<NoteTraits>(m, newIds);
+            collection.reset(m);
+        } else {
+            auto *m = new TodosManager;
+            add = RecordAppender<TodoTraits>(m, newIds);
+            collection.reset(m);
+        }
+        if (!waitUntil([&collection](){ return collection->isLoaded(); }, kLoadTimeoutMs)) {
+            m_err << "timed out loading " << kind << Qt::endl;
+            return 1;
+        }
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    QVector<QJsonObject> batch;
+    batch.reserve(StoreTransfer::kImportBatch);
+    qint64 records = 0;
+    qint64 added = 0;
+    bool writeFailed = false;
+    const auto flush = [&](){
+        const qint64 n = add(batch);
+        batch.clear();
+        if (n < 0) writeFailed = true;
+        else added += n;
+        return !writeFailed;
+    };
+    QString error;
+    const bool parsed = StoreTransfer::read(file, format, [&](const QJsonObject& o){
+        ++records;
+        batch.append(o);
+        return batch.size() < StoreTransfer::kImportBatch || flush();
+    }, &error);
+    if (parsed && !writeFailed && !batch.isEmpty()) flush();
+    if (collection) collection->flushSave();
+    StorageExecutor::instance()->waitForIdle();
+
+    if (!parsed) m_err << path << ": " << error << Qt::endl;
+    if (writeFailed) m_err << "writing " << kind << " failed" << Qt::endl;
+    m_out << "imported " << added << " of " << records << ' ' << kind << " records in " << timer.elapsed() << " ms" << Qt::endl;
+    return parsed && !writeFailed ? 0 : 1;
+}
+
+int FlowCli::search(const Args& a) {
+    if (a.positional.isEmpty()) return usageError("search needs a query");
+    const QString query = a.positional.join(' ');
+    const int limit = qMax(1, a.value("--limit", "20").toInt());
+    HistoryManager history;
+    HistoryManager::Results results;
+    bool done = false;
+    history.search(query, limit, this, [&](const HistoryManager::Results& r){ results = r; done = true; });
+    if (!waitUntil([&done](){ return done; }, kLoadTimeoutMs)) {
+        m_err << "search timed out" << Qt::endl;
+        return 1;
+    }
+    if (a.flags.contains("--json")) {
+        QJsonArray arr;
+        for (const auto &r : std::as_const(results)) arr.append(QJsonObject{{"url", r.first}, {"title", r.second}});
+        m_out << QJsonDocument(arr).toJson();
+    } else {
+        for (const auto &r : std::as_const(results)) m_out << r.second << '\t' << r.first << '\n';
+    }
+    m_out.flush();
+    return 0;
+}
+
+int FlowCli::compact(const Args& a) {
+    HistoryRetention retention;
+    // the horizon kept in the profile arrives from the storage thread first
+    StorageExecutor::instance()->waitForIdle();
+    if (a.options.contains("--horizon-days")) {
+        HistoryRetention::Policy policy = retention.policy();
+        policy.horizonDays = qMax(0, a.value("--horizon-days").toInt());
+        retention.setPolicy(policy);
+    }
+    HistoryRetention::Report report;
+    bool finished = false;
+    connect(&retention, &HistoryRetention::passFinished, this, [&](const HistoryRetention::Report& r){
+        report = r;
+        finished = true;
+    });
+    retention.runPass();
+    waitUntil([&finished](){ return finished; }, 0);
+    m_out << report.summary() << Qt::endl;
+    return 0;
+}
+
+int FlowCli::vacuum() {
+    const Lines result = StorageExecutor::instance()->blockingRead<Lines>([](Storage& s){
+        Lines r;
+        const QLocale locale;
+        const QVector<QPair<QString, QSqlDatabase>> databases = {{"flow.db", s.database()}, {"history.db", s.history()}};
+        for (const auto &db : databases) {
+            const qint64 before = fileBytes(db.second);
+            QSqlQuery q(db.second);
+            // the WAL is folded in first so the rewrite starts from the whole database
+            if (!q.exec("PRAGMA wal_checkpoint(TRUNCATE)") || !q.exec("VACUUM")) {
+                r.text.append(QString("%1: %2").arg(db.first, q.lastError().text()));
+                r.ok = false;
+                continue;
+            }
+            r.text.append(QString("%1: %2 -> %3").arg(db.first, locale.formattedDataSize(before),
+                                                        locale.formattedDataSize(fileBytes(db.second))));
+        }
+        return r;
+    });
+    for (const QString &line : result.text) m_out << line << '\n';
+    m_out.flush();
+    return result.ok ? 0 : 1;
+}
+
+int FlowCli::check() {
+    const Lines result = StorageExecutor::instance()->blockingRead<Lines>([](Storage& s){
+        Lines r;
+        if (!s.isOpen()) return Lines{{"flow.db: cannot be opened"}, false};
+        const int version = s.schemaVersion();
+        if (version != Storage::latestSchemaVersion()) {
+            r.text.append(QString("flow.db: schema version %1, this build knows %2").arg(version).arg(Storage::latestSchemaVersion()));
+            r.ok = false;
+        }
+        const QVector<QPair<QString, QSqlDatabase>> databases = {{"flow.db", s.database()}, {"history.db", s.history()}};
+        for (const auto &db : databases) {
+            QStringList problems;
+            QSqlQuery q(db.second);
+            if (!q.exec("PRAGMA integrity_check")) problems.append(q.lastError().text());
+            while (q.next()) if (q.value(0).toString() != "ok") problems.append(q.value(0).toString());
+            if (q.exec("PRAGMA foreign_key_check"))
+                while (q.next()) problems.append(QString("row %1 of %2 has no parent in %3").arg(q.value(1).toString(), q.value(0).toString(), q.value(2).toString()));
+            if (problems.isEmpty()) r.text.append(db.first + ": ok");
+            for (const QString &p : std::as_const(problems)) r.text.append(db.first + ": " + p);
+            r.ok = r.ok && problems.isEmpty();
+        }
+        return r;
+    });
+    for (const QString &line : result.text) m_out << line << '\n';
+    m_out.flush();
+    return result.ok ? 0 : 1;
+}
+
+int FlowCli::sync(const Args& a) {
+    const QStringList kinds = a.positional.isEmpty() ? kCollections : a.positional;
+    for (const QString &kind : kinds) if (!kCollections.contains(kind)) return usageError("sync takes " + kCollections.join(", "));
+    SupabaseConfig config = SupabaseConfig::load();
+    if (a.options.contains("--url")) config.url = a.value("--url");
+    if (a.options.contains("--anon-key")) config.anonKey = a.value("--anon-key");
+    while (config.url.endsWith('/')) config.url.chop(1);
+    if (!config.isValid()) return usageError("no sync endpoint: pass --url and --anon-key or set FLOW_SUPABASE_URL and FLOW_SUPABASE_ANON_KEY");
+    const int timeoutMs = qMax(1, a.value("--timeout", "300").toInt()) * 1000;
+    QElapsedTimer timer;
+    timer.start();
+
+    AuthManager auth;
+    auth.setSupabaseConfig(config.url, config.anonKey);
+    if (!auth.isSignedIn() || a.options.contains("--email")) {
+        const QString email = a.value("--email");
+        const QString password = a.options.contains("--password") ? a.value("--password") : qEnvironmentVariable("FLOW_SYNC_PASSWORD");
+        if (email.isEmpty() || password.isEmpty()) return usageError("not signed in: pass --email and --password (or FLOW_SYNC_PASSWORD)");
+        bool answered = false;
+        QString failure;
+        connect(&auth, &AuthManager::signedIn, this, [&answered](){ answered = true; });
+        connect(&auth, &AuthManager::authFailed, this, [&](const QString& e){ failure = e; answered = true; });
+        auth.signIn(email, password);
+        if (!waitUntil([&answered](){ return answered; }, timeoutMs) || !failure.isEmpty()) {
+            m_err << "sign-in failed: " << (failure.isEmpty() ? QString("timed out") : failure) << Qt::endl;
+            return 1;
+        }
+    }
+
+    struct Synced {
+        QString kind;
+        std::unique_ptr<SyncEngineBase> engine;
+        std::function<int()> count;
+        std::function<int()> conflicts;
+        bool pulled = false;
+        bool pullOk = false;
+    };
+    std::vector<Synced> synced(kinds.size());
+    for (int i = 0; i < kinds.size(); ++i) {
+        Synced &s = synced[i];
+        s.kind = kinds[i];
+        if (s.kind == "bookmarks") {
+            auto *m = new BookmarksManager;
+            s.count = [m](){ return m->count(); };
+            s.conflicts = [m](){ return int(m->conflictIndices().size()); };
+            s.engine.reset(m);
+        } else if (s.kind == "notes") {
+            auto *m = new NotesManager;
+            s.count = [m](){ return m->count(); };
+            s.conflicts = [m](){ return int(m->conflictIndices().size()); };
+            s.engine.reset(m);
+        } else {
+            auto *m = new TodosManager;
+            s.count = [m](){ return m->count(); };
+            s.conflicts = [m](){ return int(m->conflictIndices().size()); };
+            s.engine.reset(m);
+        }
+        s.engine->setSupabaseConfig(config.url, config.anonKey);
+        s.engine->setAuthManager(&auth);
+        connect(s.engine.get(), &SyncEngineBase::pullFinished, this, [&s](bool ok){
+            s.pulled = true;
+            s.pullOk = ok;
+        });
+        // waits for the stored items; pushes what is queued once merged
+        s.engine->syncFromSupabase();
+    }
+    const bool settled = waitUntil([&synced](){
+        for (const Synced &s : synced) if (!s.pulled || s.engine->queuedOperations() > 0) return false;
+        return true;
+    }, timeoutMs);
+
+    bool ok = settled;
+    for (const Synced &s : synced) {
+        m_out << s.kind << ": " << s.count() << " items, "
+              << (!s.pulled ? "pull unfinished" : s.pullOk ? "pulled" : "pull failed") << ", "
+              << s.engine->queuedOperations() << " changes queued, " << s.conflicts() << " conflicts" << '\n';
+        ok = ok && s.pullOk && s.conflicts() == 0;
+    }
+    m_out << (settled ? "settled" : "timed out") << " after " << timer.elapsed() << " ms" << Qt::endl;
+    return ok ? 0 : 1;
+}
+
+// Synthetic load on the open profile, which must be empty: the rows it
+// writes stay there. flow_cli points it at a temporary profile where
+// AppDataLocation follows XDG_DATA_HOME; anywhere else a real profile is
+// refused here. Each step is timed from the GUI thread's side, so it
+// includes the wait for the storage thread.
+int FlowCli::bench(const Args& a) {
+    const int visits = qMax(1, a.value("--visits", "200000").toInt());
+    const int items = qMax(1, a.value("--items", "20000").toInt());
+    StorageExecutor* storage = StorageExecutor::instance();
+    const qint64 existing = storage->blockingRead<qint64>([](Storage& s){
+        qint64 rows = 0;
+        for (const QString &table : kCollections) {
+            QSqlQuery q(s.database());
+            if (q.exec(QString("SELECT COUNT(*) FROM %1").arg(table)) && q.next()) rows += q.value(0).toLongLong();
+        }
+        for (const char* table : {"visits", "visit_rollups"}) {
+            QSqlQuery q(s.history());
+            if (q.exec(QString("SELECT COUNT(*) FROM %1").arg(QLatin1String(table))) && q.next()) rows += q.value(0).toLongLong();
+        }
+        return rows;
+    });
+    if (existing > 0) {
+        m_err << "bench: the profile at " << QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) << " holds " << existing
+              << " rows; bench only runs on an empty profile" << Qt::endl;
+        return 1;
+    }
+    struct Step {
+        QString name;
+        qint64 rows;
+        double ms;
+    };
+    QVector<Step> steps;
+    const auto measure = [&steps](const QString& name, qint64 rows, const std::function<void()>& fn){
+        QElapsedTimer timer;
+        timer.start();
+        fn();
+        steps.append({name, rows, timer.nsecsElapsed() / 1e6});
+    };
+    storage->waitForIdle();
+
+    // visits in the importer's batch size, a minute apart, ending now
+    measure("history write", visits, [&](){
+        const qint64 now = QDateTime::currentSecsSinceEpoch();
+        QVector<HistoryManager::Visit> batch;
+        for (int i = 0; i < visits; ++i) {
+            batch.append({QString("https://site%1.example/page/%2").arg(i % 1000).arg(i), QString("Page %1").arg(i), now - qint64(visits - i) * 60});
+            if (batch.size() < 50000 && i + 1 < visits) continue;
+            storage->blockingRead<bool>([&batch](Storage& s){ return HistoryManager::writeVisits(s, batch); });
+            batch.clear();
+        }
+    });
+    const int searches = 50;
+    HistoryManager history;
+    measure("history search", searches, [&](){
+        for (int i = 0; i < searches; ++i) {
+            bool done = false;
+            history.search(QString("page/%1").arg(i * 7919 % visits), 20, this, [&done](const HistoryManager::Results&){ done = true; });
+            waitUntil([&done](){ return done; }, 0);
+        }
+    });
+    QBuffer exported;
+    exported.open(QIODevice::ReadWrite);
+    measure("history export", visits, [&](){
+        storage->blockingRead<qint64>([&exported](Storage& s){
+            StoreTransfer::Writer writer(exported, StoreTransfer::Format::Ndjson);
+            return StoreTransfer::exportHistory(s, writer);
+        });
+    });
+    exported.seek(0);
+    measure("history parse", visits, [&](){
+        StoreTransfer::read(exported, StoreTransfer::Format::Ndjson, [](const QJsonObject&){ return true; });
+    });
+    measure("history compact", visits, [&](){
+        HistoryRetention retention;
+        bool finished = false;
+        connect(&retention, &HistoryRetention::passFinished, this, [&finished](){ finished = true; });
+        retention.runPass();
+        waitUntil([&finished](){ return finished; }, 0);
+    });
+
+    TodosManager todos;
+    waitUntil([&todos](){ return todos.isLoaded(); }, kLoadTimeoutMs);
+    measure("todos add", items, [&](){
+        QVector<TodoItem> batch(items);
+        for (int i = 0; i < items; ++i) {
+            batch[i].title = QString("Todo %1").arg(i);
+            batch[i].workspace = QString("Workspace %1").arg(i % 8);
+        }
+        todos.appendMany(batch);
+        todos.flushSave();
+        storage->waitForIdle();
+    });
+    const int edits = qMin(items, 1000);
+    measure("todos complete", edits, [&](){
+        for (int i = 0; i < edits; ++i) todos.setCompleted(i * (items / edits), true);
+        todos.flushSave();
+        storage->waitForIdle();
+    });
+
+    if (a.flags.contains("--json")) {
+        QJsonArray arr;
+        for (const Step &s : std::as_const(steps))
+            arr.append(QJsonObject{{"name", s.name}, {"rows", s.rows}, {"ms", s.ms}, {"rows_per_sec", s.ms > 0 ? s.rows * 1000 / s.ms : 0}});
+        m_out << QJsonDocument(QJsonObject{{"visits", visits}, {"items", items}, {"steps", arr}}).toJson();
+    } else {
+        m_out << QString("%1 %2 %3 %4\n").arg("step", -16).arg("rows", 10).arg("ms", 10).arg("rows/s", 12);
+        for (const Step &s : std::as_const(steps))
+            m_out << QString("%1 %2 %3 %4\n").arg(s.name, -16).arg(s.rows, 10).arg(s.ms, 10, 'f', 1)
+                         .arg(s.ms > 0 ? s.rows * 1000 / s.ms : 0, 12, 'f', 0);
+    }
+    m_out.flush();
+    return 0;
+}
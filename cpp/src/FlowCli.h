@@ -0,0 +1,61 @@
+#pragma once
+
+#include <QHash>
+#include <QObject>
+#include <QSet>
+#include <QStringList>
+#include <functional>
+
+class QTextStream;
+
+// The commands of flow_cli, the browser's store without a window. They open
+// the same profile as the browser (flow.db and history.db in AppDataLocation)
+// through the same managers and storage thread, on a QCoreApplication:
+//
+//   export <kind> [--out file] [--format json|ndjson]
+//   import <kind> <file> [--format json|ndjson]
+//   search <query> [--limit n] [--json]
+//   compact [--horizon-days n]
+//   vacuum
+//   check
+//   sync [kind...] [--url url --anon-key key] [--email address --password secret] [--timeout s]
+//   bench [--visits n] [--items n] [--json]
+//
+// kind is bookmarks, notes, todos or history, and "-" as a file is standard
+// input or output. The format follows the file name (.ndjson, .jsonl) unless
+// --format says otherwise. Results go to out, diagnostics to err.
+class FlowCli : public QObject {
+    Q_OBJECT
+public:
+    FlowCli(QTextStream& out, QTextStream& err, QObject* parent = nullptr);
+
+    // args start with the command; 0 on success, 1 when it failed or found a
+    // problem, 2 for a usage error
+    int run(const QStringList& args);
+    static QString usage();
+
+private:
+    struct Args {
+        QStringList positional;
+        QHash<QString, QString> options;  // --name value
+        QSet<QString> flags;              // --json
+        QString value(const QString& name, const QString& fallback = QString()) const { return options.value(name, fallback); }
+    };
+    static Args parse(const QStringList& args);
+
+    int exportData(const Args& a);
+    int importData(const Args& a);
+    int search(const Args& a);
+    int compact(const Args& a);
+    int vacuum();
+    int check();
+    int sync(const Args& a);
+    int bench(const Args& a);
+    int usageError(const QString& message);
+
+    // run the event loop until done() holds; false after timeoutMs
+    bool waitUntil(const std::function<bool()>& done, int timeoutMs);
+
+    QTextStream& m_out;
+    QTextStream& m_err;
+};
@@ -0,0 +1,145 @@
+#include "FlowSchemeHandler.h"
+#include "MetricsRegistry.h"
+#include <QBuffer>
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QJsonDocument>
+#include <QPointer>
+#include <QWebEngineProfile>
+#include <QWebEngineUrlRequestJob>
+#include <QWebEngineUrlScheme>
+
+namespace {
+
+// Polls metrics.json once a second. Metrics are grouped by the prefix of
+// their name (storage.*, network.*, ...), so new ones show up without
+// touching this page; counters also show their rate since the last poll.
+const char* kPerformanceHtml = R"HTML(<!DOCTYPE html>
+<html><head><meta charset="utf-8"><title>Performance</title>
+<style>
+body { font: 13px system-ui, sans-serif; margin: 24px; color: #222; }
+h1 { font-size: 20px; } h2 { font-size: 15px; margin: 20px 0 6px; text-transform: capitalize; }
+table { border-collapse: collapse; min-width: 560px; }
+th, td { padding: 3px 10px; text-align: right; border-bottom: 1px solid #eee; }
+th:first-child, td:first-child { text-align: left; }
+.bars { display: inline-flex; align-items: flex-end; height: 18px; gap: 1px; }
+.bars span { width: 3px; background: #4a7fd4; }
+#status { color: #888; }
+</style></head>
+<body>
+<h1>Performance</h1>
+<div id="status">loading…</div>
+<h2>Tabs</h2>
+<table id="tabs"><thead><tr><th>Tab</th><th>PID</th><th>Memory</th><th>CPU</th></tr></thead><tbody></tbody></table>
+<h2>Long tasks</h2>
+<table id="long"><thead><tr><th>Handler</th><th>Event</th><th>Duration</th><th>When</th></tr></thead><tbody></tbody></table>
+<div id="groups"></div>
+<script>
+var previous = null, previousAt = 0;
+function esc(s) { return String(s).replace(/[&<>"]/g, function(c) { return {'&':'&amp;','<':'&lt;','>':'&gt;','"':'&quot;'}[c]; }); }
+function ms(v) { return v >= 100 ? v.toFixed(0) + ' ms' : v >= 1 ? v.toFixed(1) + ' ms' : (v * 1000).toFixed(0) + ' µs'; }
+function group(name) { var i = name.indexOf('.'); return i < 0 ? name : name.substring(0, i); }
+function bars(buckets) {
+  var max = 0; buckets.forEach(function(b) { max = Math.max(max, b[1]); });
+  return '<span class="bars">' + buckets.map(function(b) {
+    return '<span title="≤ ' + ms(b[0]) + ': ' + b[1] + '" style="height:' + Math.max(1, 18 * Math.log(1 + b[1]) / Math.log(1 + max)) + 'px"></span>';
+  }).join('') + '</span>';
+}
+function render(m, now) {
+  var tabs = (m.sections.tabs || []).slice().sort(function(a, b) { return b.rss_bytes - a.rss_bytes; });
+  document.querySelector('#tabs tbody').innerHTML = tabs.map(function(t) {
+    return '<tr><td>' + esc(t.title || t.url) + (t.cached ? ' (parked)' : '') + '</td><td>' + t.pid + '</td><td>'
+      + (t.rss_bytes / 1048576).toFixed(1) + ' MB</td><td>' + t.cpu_percent.toFixed(1) + ' %</td></tr>';
+  }).join('');
+  var tasks = (m.sections.long_tasks || []).slice().reverse();
+  document.querySelector('#long tbody').innerHTML = tasks.map(function(t) {
+    return '<tr><td>' + esc(t.receiver + (t.name ? " '" + t.name + "'" : '')) + '</td><td>' + esc(t.event) + '</td><td>'
+      + ms(t.ms) + (t.flagged ? ' (flagged while running)' : '') + '</td><td>' + new Date(t.at).toLocaleTimeString() + '</td></tr>';
+  }).join('');
+  var groups = {};
+  function add(name, row) { (groups[group(name)] = groups[group(name)] || []).push(row); }
+  var seconds = previous ? (now - previousAt) / 1000 : 0;
+  Object.keys(m.counters).sort().forEach(function(k) {
+    var rate = seconds > 0 && k in previous.counters ? (m.counters[k] - previous.counters[k]) / seconds : 0;
+    add(k, '<tr><td>' + esc(k) + '</td><td>' + m.counters[k] + '</td><td>' + rate.toFixed(1) + ' /s</td><td colspan="5"></td></tr>');
+  });
+  Object.keys(m.gauges).sort().forEach(function(k) {
+    add(k, '<tr><td>' + esc(k) + '</td><td>' + m.gauges[k] + '</td><td colspan="6"></td></tr>');
+  });
+  Object.keys(m.histograms).sort().forEach(function(k) {
+    var h = m.histograms[k];
+    add(k, '<tr><td>' + esc(k) + '</td><td>' + h.count + '</td><td>' + ms(h.mean) + ' mean</td><td>' + ms(h.p50)
+      + '</td><td>' + ms(h.p90) + '</td><td>' + ms(h.p99) + '</td><td>' + ms(h.max) + '</td><td>' + bars(h.buckets) + '</td></tr>');
+  });
+  document.getElementById('groups').innerHTML = Object.keys(groups).sort().map(function(g) {
+    return '<h2>' + esc(g) + '</h2><table><thead><tr><th>Metric</th><th>Value</th><th></th><th>p50</th><th>p90</th>'
+      + '<th>p99</th><th>max</th><th>distribution</th></tr></thead><tbody>' + groups[g].join('') + '</tbody></table>';
+  }).join('');
+  previous = m; previousAt = now;
+  document.getElementById('status').textContent = 'updated ' + new Date(now).toLocaleTimeString();
+}
+function poll() {
+  var xhr = new XMLHttpRequest();
+  xhr.open('GET', 'flow://performance/metrics.json');
+  xhr.onload = function() { render(JSON.parse(xhr.responseText), Date.now()); };
+  xhr.onerror = function() { document.getElementById('status').textContent = 'metrics unavailable'; };
+  xhr.send();
+}
+poll();
+setInterval(poll, 1000);
+</script>
+</body></html>
+)HTML";
+
+void reply(QWebEngineUrlRequestJob* job, const QByteArray& contentType, const QByteArray& data) {
+    // the job reads the buffer after we return and deletes it with itself
+    auto *buffer = new QBuffer(job);
+    buffer->setData(data);
+    buffer->open(QIODevice::ReadOnly);
+    job->reply(contentType, buffer);
+}
+
+}
+
+const QByteArray FlowSchemeHandler::kScheme = "flow";
+
+FlowSchemeHandler::FlowSchemeHandler(QObject* parent): QWebEngineUrlSchemeHandler(parent) {
+}
+
+void FlowSchemeHandler::registerScheme() {
+    QWebEngineUrlScheme scheme(kScheme);
+    scheme.setSyntax(QWebEngineUrlScheme::Syntax::Host);
+    // LocalScheme keeps web content from loading flow:// pages; CorsEnabled
+    // lets flow://performance poll its own origin
+    scheme.setFlags(QWebEngineUrlScheme::SecureScheme | QWebEngineUrlScheme::LocalScheme
+                    | QWebEngineUrlScheme::LocalAccessAllowed | QWebEngineUrlScheme::CorsEnabled);
+    QWebEngineUrlScheme::registerScheme(scheme);
+}
+
+void FlowSchemeHandler::install(QWebEngineProfile* profile) {
+    static QPointer<FlowSchemeHandler> s_instance;
+    if (!s_instance) s_instance = new FlowSchemeHandler(QCoreApplication::instance());
+    if (!profile->urlSchemeHandler(kScheme)) profile->installUrlSchemeHandler(kScheme, s_instance);
+}
+
+void FlowSchemeHandler::requestStarted(QWebEngineUrlRequestJob* job) {
+    const QUrl url = job->requestUrl();
+    if (url.host() != QLatin1String("performance")) {
+        job->fail(QWebEngineUrlRequestJob::UrlNotFound);
+        return;
+    }
+    const QString path = url.path();
+    if (path.isEmpty() || path == QLatin1String("/")) reply(job, "text/html", performancePage());
+    else if (path == QLatin1String("/metrics.json")) reply(job, "application/json", metricsJson());
+    else job->fail(QWebEngineUrlRequestJob::UrlNotFound);
+}
+
+QByteArray FlowSchemeHandler::performancePage() {
+    return QByteArray(kPerformanceHtml);
+}
+
+QByteArray FlowSchemeHandler::metricsJson() {
+    QJsonObject o = MetricsRegistry::toJson();
+    o["sampled_at"] = QDateTime::currentMSecsSinceEpoch();
+    return QJsonDocument(o).toJson(QJsonDocument::Compact);
+}
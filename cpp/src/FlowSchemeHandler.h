@@ -0,0 +1,29 @@
+#pragma once
+
+#include <QByteArray>
+#include <QWebEngineUrlSchemeHandler>
+
+class QWebEngineProfile;
+
+// Serves the browser's internal flow:// pages:
+//   flow://performance               live diagnostics from MetricsRegistry
+//   flow://performance/metrics.json  the snapshot that page polls
+// Anything else answers UrlNotFound.
+class FlowSchemeHandler : public QWebEngineUrlSchemeHandler {
+    Q_OBJECT
+public:
+    static const QByteArray kScheme;
+
+    // must run before the QApplication is created
+    static void registerScheme();
+    // one handler, owned by the application, serves every profile
+    static void install(QWebEngineProfile* profile);
+
+    void requestStarted(QWebEngineUrlRequestJob* job) override;
+
+    static QByteArray performancePage();
+    static QByteArray metricsJson();
+
+private:
+    explicit FlowSchemeHandler(QObject* parent = nullptr);
+};
@@ -0,0 +1,36 @@
+#include "Gzip.h"
+#include <zlib.h>
+
+QByteArray Gzip::compress(const QByteArray& data, int level) {
+    z_stream zs = {};
+    // 16 + MAX_WBITS selects the gzip wrapper
+    if (deflateInit2(&zs, level, Z_DEFLATED, 16 + MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK) return QByteArray();
+    QByteArray out(int(deflateBound(&zs, uLong(data.size()))), Qt::Uninitialized);
+    zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.constData()));
+    zs.avail_in = uInt(data.size());
+    zs.next_out = reinterpret_cast<Bytef*>(out.data());
+    zs.avail_out = uInt(out.size());
+    const int rc = deflate(&zs, Z_FINISH);
+    out.resize(int(zs.total_out));
+    deflateEnd(&zs);
+    return rc == Z_STREAM_END ? out : QByteArray();
+}
+
+QByteArray Gzip::decompress(const QByteArray& data) {
+    z_stream zs = {};
+    // 32 + MAX_WBITS detects gzip or zlib from the header
+    if (inflateInit2(&zs, 32 + MAX_WBITS) != Z_OK) return QByteArray();
+    zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.constData()));
+    zs.avail_in = uInt(data.size());
+    QByteArray out;
+    char buf[16384];
+    int rc = Z_OK;
+    while (rc == Z_OK) {
+        zs.next_out = reinterpret_cast<Bytef*>(buf);
+        zs.avail_out = sizeof(buf);
+        rc = inflate(&zs, Z_NO_FLUSH);
+        out.append(buf, int(sizeof(buf) - zs.avail_out));
+    }
+    inflateEnd(&zs);
+    return rc == Z_STREAM_END ? out : QByteArray();
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <QByteArray>
+
+// gzip (RFC 1952) for HTTP bodies. qCompress() writes a zlib stream with a
+// Qt-specific length prefix, which servers do not accept as Content-Encoding.
+class Gzip {
+public:
+    static QByteArray compress(const QByteArray& data, int level = 6);
+    // also accepts zlib streams; empty on corrupt input
+    static QByteArray decompress(const QByteArray& data);
+};
@@ -1,60 +1,98 @@
 #include "HistoryManager.h"
-#include <QStandardPaths>
-#include <QDir>
+#include "StorageExecutor.h"
+#include "MetricsRegistry.h"
+#include "Trace.h"
 #include <QSqlDatabase>
 #include <QSqlQuery>
 #include <QSqlError>
+#include <QDebug>
 #include <QVariant>
 #include <QDateTime>
-#include <QDebug>
+#include <QElapsedTimer>
 
 HistoryManager::HistoryManager(QObject* parent): QObject(parent) {
-    QString dataDir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
-    QDir().mkpath(dataDir);
-    m_dbPath = QDir(dataDir).filePath("history.db");
-    initDb();
 }
 
-void HistoryManager::initDb() {
-    QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", "history_connection");
-    db.setDatabaseName(m_dbPath);
-    if (!db.open()) {
-        qWarning() << "Failed to open history DB:" << db.lastError().text();
-        return;
-    }
-    QSqlQuery q(db);
-    q.exec("CREATE TABLE IF NOT EXISTS visits (id INTEGER PRIMARY KEY AUTOINCREMENT, url TEXT, title TEXT, visited_at INTEGER)");
-    db.close();
+void HistoryManager::addVisit(const QString& url, const QString& title) {
+    const qint64 visitedAt = QDateTime::currentSecsSinceEpoch();
+    StorageExecutor::instance()->run([url, title, visitedAt](Storage& s){
+        QSqlQuery q(s.history());
+        q.prepare("INSERT INTO visits (url, title, visited_at) VALUES (:url, :title, :visited_at)");
+        q.bindValue(":url", url);
+        q.bindValue(":title", title);
+        q.bindValue(":visited_at", visitedAt);
+        q.exec();
+    });
+    emit visitAdded(url, title);
 }
 
-void HistoryManager::addVisit(const QString& url, const QString& title) {
-    QSqlDatabase db = QSqlDatabase::database("history_connection");
-    if (!db.isValid()) db = QSqlDatabase::addDatabase("QSQLITE", "history_connection");
-    db.setDatabaseName(m_dbPath);
-    if (!db.open()) return;
-    QSqlQuery q(db);
-    q.prepare("INSERT INTO visits (url, title, visited_at) VALUES (:url, :title, :visited_at)");
-    q.bindValue(":url", url);
-    q.bindValue(":title", title);
-    q.bindValue(":visited_at", QDateTime::currentSecsSinceEpoch());
-    q.exec();
-    db.close();
+void HistoryManager::search(const QString& query, int maxResults, QObject* context, std::function<void(const Results&)> done) {
+    StorageExecutor::instance()->read<Results>(context, [query, maxResults](Storage& s){
+        FLOW_TRACE_SCOPE("HistoryManager::search query");
+        static MetricsRegistry::Histogram* const searchMs = MetricsRegistry::histogram("history.search_ms");
+        QElapsedTimer timer;
+        timer.start();
+        Results res;
+        QSqlQuery q(s.history());
+        q.prepare("SELECT url, title FROM visits WHERE url LIKE :q OR title LIKE :q ORDER BY visited_at DESC LIMIT :lim");
+        q.bindValue(":q", QString("%") + query + "%");
+        q.bindValue(":lim", maxResults);
+        q.exec();
+        while (q.next()) {
+            res.append(qMakePair(q.value(0).toString(), q.value(1).toString()));
+        }
+        // rolled-up visits are all older than the ones kept, so they only fill up
+        if (res.size() < maxResults) {
+            QSqlQuery older(s.history());
+            older.prepare("SELECT url, title FROM visit_rollups WHERE url LIKE :q OR title LIKE :q "
+                          "ORDER BY period_start DESC LIMIT :lim");
+            older.bindValue(":q", QString("%") + query + "%");
+            older.bindValue(":lim", maxResults - res.size());
+            older.exec();
+            while (older.next()) res.append(qMakePair(older.value(0).toString(), older.value(1).toString()));
+        }
+        searchMs->record(timer.nsecsElapsed() / 1e6);
+        return res;
+    }, [done](Results res){ done(res); });
 }
 
-QVector<QPair<QString, QString>> HistoryManager::search(const QString& query, int maxResults) {
-    QVector<QPair<QString, QString>> res;
-    QSqlDatabase db = QSqlDatabase::database("history_connection");
-    if (!db.isValid()) db = QSqlDatabase::addDatabase("QSQLITE", "history_connection");
-    db.setDatabaseName(m_dbPath);
-    if (!db.open()) return res;
+void HistoryManager::visitedUrls(QObject* context, std::function<void(bool ok, const QVector<VisitedUrl>& urls)> done) {
+    using Read = QPair<bool, QVector<VisitedUrl>>;
+    // history.db is not in WAL mode: a reader thread would wait on, or fail
+    // against, a retention pass or an import writing it
+    StorageExecutor::instance()->read<Read>(context, [](Storage& s){
+        FLOW_TRACE_SCOPE("HistoryManager::visitedUrls query");
+        Read out(false, {});
+        QSqlQuery q(s.history());
+        q.setForwardOnly(true);
+        // with MAX(), SQLite takes the bare title from the latest visit's row
+        if (!q.exec("SELECT url, title, MAX(at), SUM(n) FROM "
+                    "(SELECT url, title, visited_at AS at, 1 AS n FROM visits "
+                    " UNION ALL SELECT url, title, period_start, visits FROM visit_rollups) GROUP BY url")) {
+            qWarning() << "History: reading visited URLs failed:" << q.lastError().text();
+            return out;
+        }
+        while (q.next()) out.second.append(VisitedUrl{q.value(0).toString(), q.value(1).toString(), q.value(3).toInt()});
+        // a step can fail halfway too
+        out.first = !q.lastError().isValid();
+        return out;
+    }, [done](Read r){ done(r.first, r.second); });
+}
+
+bool HistoryManager::writeVisits(Storage& s, const QVector<Visit>& visits) {
+    FLOW_TRACE_SCOPE("HistoryManager::writeVisits");
+    QSqlDatabase db = s.history();
+    if (!db.transaction()) return false;
     QSqlQuery q(db);
-    q.prepare("SELECT url, title FROM visits WHERE url LIKE :q OR title LIKE :q ORDER BY visited_at DESC LIMIT :lim");
-    q.bindValue(":q", QString("%") + query + "%");
-    q.bindValue(":lim", maxResults);
-    q.exec();
-    while (q.next()) {
-        res.append(qMakePair(q.value(0).toString(), q.value(1).toString()));
+    q.prepare("INSERT INTO visits (url, title, visited_at) VALUES (?, ?, ?)");
+    for (const Visit &v : visits) {
+        q.bindValue(0, v.url);
+        q.bindValue(1, v.title);
+        q.bindValue(2, v.visitedAt);
+        if (!q.exec()) {
+            db.rollback();
+            return false;
+        }
     }
-    db.close();
-    return res;
-}
\ No newline at end of file
+    return db.commit();
+}
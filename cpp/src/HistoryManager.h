@@ -3,15 +3,47 @@
 #include <QObject>
 #include <QVector>
 #include <QPair>
+#include <functional>
 
+class Storage;
+
+// Visits in history.db. The database is owned by the storage thread; adding
+// posts a write and searching answers through a callback. Older visits are
+// kept as per-day or per-week counts (see HistoryRetention), which searching
+// and visitedUrls() read too.
 class HistoryManager : public QObject {
     Q_OBJECT
 public:
+    using Results = QVector<QPair<QString, QString>>;  // url, title
+    struct VisitedUrl {
+        QString url;
+        QString title;   // of the latest visit
+        int visits = 0;
+    };
+
+    // a visit as importers hand them over
+    struct Visit {
+        QString url;
+        QString title;
+        qint64 visitedAt = 0;  // epoch secs
+    };
+
     explicit HistoryManager(QObject* parent = nullptr);
     void addVisit(const QString& url, const QString& title);
-    QVector<QPair<QString, QString>> search(const QString& query, int maxResults = 50);
+    // done runs on context's thread, unless context is gone by then
+    void search(const QString& query, int maxResults, QObject* context, std::function<void(const Results&)> done);
+    // Every URL visited, once. Read on the storage thread, which retention and
+    // imports write history.db from, so the read never meets their locks; ok is
+    // false when it failed anyway, and urls then says nothing.
+    void visitedUrls(QObject* context, std::function<void(bool ok, const QVector<VisitedUrl>& urls)> done);
+
+    // Insert visits in one transaction, on the storage thread, without a
+    // visitAdded each. For importers, which call reportImported() when done.
+    static bool writeVisits(Storage& s, const QVector<Visit>& visits);
+    void reportImported(qint64 visits) { emit visitsImported(visits); }
 
-private:
-    void initDb();
-    QString m_dbPath;
-};
\ No newline at end of file
+signals:
+    void visitAdded(const QString& url, const QString& title);
+    // many visits arrived at once; re-read rather than follow them one by one
+    void visitsImported(qint64 visits);
+};
@@ -1,6 +1,11 @@
 #include "HistoryPanel.h"
 #include "HistoryManager.h"
+#include "PageTextIndex.h"
+#include "Trace.h"
 #include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QCheckBox>
+#include <QLabel>
 #include <QLineEdit>
 #include <QListWidget>
 #include <QListWidgetItem>
@@ -20,20 +25,62 @@ HistoryPanel::HistoryPanel(HistoryManager* manager, QWidget* parent): QWidget(pa
     refreshResults();
 }
 
+void HistoryPanel::setPageTextIndex(PageTextIndex* index) {
+    m_pageText = index;
+    auto *row = new QHBoxLayout;
+    m_searchPageText = new QCheckBox("Search page text", this);
+    auto *capture = new QCheckBox("Capture page text", this);
+    capture->setToolTip("Keep the text of pages you visit so you can search what you read");
+    capture->setChecked(index->captureEnabled());
+    row->addWidget(m_searchPageText);
+    row->addWidget(capture);
+    row->addStretch();
+    static_cast<QVBoxLayout*>(layout())->insertLayout(1, row);
+
+    connect(m_searchPageText, &QCheckBox::toggled, this, &HistoryPanel::refreshResults);
+    connect(capture, &QCheckBox::toggled, index, &PageTextIndex::setCaptureEnabled);
+    connect(index, &PageTextIndex::captureEnabledChanged, capture, &QCheckBox::setChecked);
+}
+
 void HistoryPanel::onSearchTextChanged(const QString& txt) {
     refreshResults();
 }
 
 void HistoryPanel::refreshResults() {
-    m_results->clear();
     QString q = m_search->text().trimmed();
-    if (q.isEmpty()) return;
-    auto res = m_manager->search(q, 200);
-    for (const auto &p : res) {
-        auto *it = new QListWidgetItem(QString("%1 — %2").arg(p.second).arg(p.first));
-        it->setData(Qt::UserRole, p.first);
-        m_results->addItem(it);
+    // an answer to an older query is dropped when it arrives after a newer one
+    const int generation = ++m_searchGeneration;
+    if (q.isEmpty()) { m_results->clear(); return; }
+    if (m_searchPageText && m_searchPageText->isChecked()) {
+        // the query is passed whole: a trailing word still being typed is a prefix
+        m_pageText->search(m_search->text(), 50, this, [this, generation](const QVector<PageTextHit>& hits){
+            if (generation != m_searchGeneration) return;
+            FLOW_TRACE_SCOPE("HistoryPanel::showPageTextResults");
+            m_results->clear();
+            for (const auto &h : hits) {
+                auto *it = new QListWidgetItem(m_results);
+                it->setData(Qt::UserRole, h.url);
+                auto *label = new QLabel(QString("<b>%1</b><br>%2").arg(h.title.toHtmlEscaped(), h.snippet), m_results);
+                label->setWordWrap(true);
+                label->setTextFormat(Qt::RichText);
+                // clicks reach the list, which activates the item
+                label->setAttribute(Qt::WA_TransparentForMouseEvents);
+                it->setSizeHint(label->sizeHint());
+                m_results->setItemWidget(it, label);
+            }
+        });
+        return;
     }
+    m_manager->search(q, 200, this, [this, generation](const HistoryManager::Results& res){
+        if (generation != m_searchGeneration) return;
+        FLOW_TRACE_SCOPE("HistoryPanel::showResults");
+        m_results->clear();
+        for (const auto &p : res) {
+            auto *it = new QListWidgetItem(QString("%1 — %2").arg(p.second).arg(p.first));
+            it->setData(Qt::UserRole, p.first);
+            m_results->addItem(it);
+        }
+    });
 }
 
 void HistoryPanel::onItemActivated(QListWidgetItem* it) {
@@ -2,6 +2,8 @@
 
 #include <QWidget>
 class HistoryManager;
+class PageTextIndex;
+class QCheckBox;
 class QLineEdit;
 class QListWidget;
 
@@ -9,6 +11,8 @@ class HistoryPanel : public QWidget {
     Q_OBJECT
 public:
     explicit HistoryPanel(HistoryManager* manager, QWidget* parent = nullptr);
+    // offer searching the text of visited pages, and turning its capture off
+    void setPageTextIndex(PageTextIndex* index);
 
 signals:
     void openUrlRequested(const QString& url, bool newTab);
@@ -22,4 +26,7 @@ private:
     HistoryManager* m_manager;
     QLineEdit* m_search;
     QListWidget* m_results;
+    PageTextIndex* m_pageText = nullptr;
+    QCheckBox* m_searchPageText = nullptr;
+    int m_searchGeneration = 0;
 };
\ No newline at end of file
@@ -0,0 +1,305 @@
+#include "HistoryRetention.h"
+#include "StorageExecutor.h"
+#include "MetricsRegistry.h"
+#include "Trace.h"
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDebug>
+#include <QEvent>
+#include <QLocale>
+#include <QPair>
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QTimer>
+#include <QVariant>
+
+namespace {
+const char* const kHorizonSetting = "history_horizon_days";
+const char* const kLastPassSetting = "history_retention_last";
+// how often idleness is looked at, and the pause between two slices
+constexpr int kCheckMs = 10 * 1000;
+constexpr int kSliceGapMs = 50;
+
+// shown on flow://performance
+struct RetentionMetrics {
+    MetricsRegistry::Counter* rows = MetricsRegistry::counter("history.retention.rows");
+    MetricsRegistry::Counter* reclaimed = MetricsRegistry::counter("history.retention.reclaimed_bytes");
+    MetricsRegistry::Gauge* dbBytes = MetricsRegistry::gauge("history.db_bytes");
+    MetricsRegistry::Histogram* sliceMs = MetricsRegistry::histogram("history.retention.slice_ms");
+};
+
+const RetentionMetrics& metrics() {
+    static const RetentionMetrics m;
+    return m;
+}
+
+qint64 scalar(QSqlDatabase db, const QString& sql) {
+    QSqlQuery q(db);
+    return q.exec(sql) && q.next() ? q.value(0).toLongLong() : 0;
+}
+
+qint64 fileBytes(QSqlDatabase db) {
+    return scalar(db, "PRAGMA page_count") * scalar(db, "PRAGMA page_size");
+}
+
+// rows of the oldest batch before `before` end at the returned value; null
+// when there are none
+QVariant batchEnd(QSqlDatabase db, const QString& sql, qint64 before) {
+    QSqlQuery q(db);
+    q.prepare(sql);
+    q.addBindValue(before);
+    q.addBindValue(HistoryRetention::kBatchRows);
+    return q.exec() && q.next() ? q.value(0) : QVariant();
+}
+
+int deleteBatch(QSqlDatabase db, const QString& sql, qint64 before) {
+    QSqlQuery q(db);
+    q.prepare(sql);
+    q.addBindValue(before);
+    q.addBindValue(HistoryRetention::kBatchRows);
+    return q.exec() ? q.numRowsAffected() : 0;
+}
+
+// Folds rows up to end into coarser ones: the insert adds to a rollup already
+// there, the delete removes what it counted. One transaction, so a visit is
+// never counted twice or lost.
+int rollUp(QSqlDatabase db, const QString& insert, const QString& remove, const QVariant& end) {
+    if (!db.transaction()) return 0;
+    QSqlQuery ins(db);
+    ins.prepare(insert);
+    ins.addBindValue(end);
+    QSqlQuery del(db);
+    del.prepare(remove);
+    del.addBindValue(end);
+    if (!ins.exec() || !del.exec()) {
+        qWarning() << "History retention:" << ins.lastError().text() << del.lastError().text();
+        db.rollback();
+        return 0;
+    }
+    const int n = del.numRowsAffected();
+    db.commit();
+    return n;
+}
+}
+
+QString HistoryRetention::Report::summary() const {
+    const QLocale locale;
+    QString s = QString("rolled up %1 visits and %2 days, deleted %3 rows, reclaimed %4 (history.db is %5) in %6 ms")
+        .arg(visitsRolledUp).arg(daysMerged).arg(rowsDeleted)
+        .arg(locale.formattedDataSize(bytesReclaimed), locale.formattedDataSize(dbBytes))
+        .arg(ms, 0, 'f', 1);
+    if (converted) s += ", including a one-time rewrite of history.db for incremental vacuum";
+    return s;
+}
+
+HistoryRetention* HistoryRetention::instance() {
+    static QPointer<HistoryRetention> s_instance;
+    if (!s_instance) s_instance = new HistoryRetention(QCoreApplication::instance());
+    return s_instance;
+}
+
+HistoryRetention::HistoryRetention(QObject* parent): QObject(parent), m_timer(new QTimer(this)) {
+    qRegisterMetaType<HistoryRetention::Report>();
+    m_sinceInput.start();
+    m_timer->setInterval(kCheckMs);
+    connect(m_timer, &QTimer::timeout, this, &HistoryRetention::check);
+    StorageExecutor::instance()->read<QPair<int, qint64>>(this, [](Storage& s){
+        return qMakePair(s.value(kHorizonSetting, QString::number(Policy().horizonDays)).toInt(),
+                         s.value(kLastPassSetting, "0").toLongLong());
+    }, [this](QPair<int, qint64> v){
+        if (!m_horizonSet) m_policy.horizonDays = v.first;
+        m_lastPass = v.second;
+    });
+}
+
+void HistoryRetention::start() {
+    QCoreApplication::instance()->installEventFilter(this);
+    m_timer->start();
+}
+
+void HistoryRetention::setHorizonDays(int days) {
+    m_horizonSet = true;
+    m_policy.horizonDays = qMax(0, days);
+    const QString v = QString::number(m_policy.horizonDays);
+    StorageExecutor::instance()->write(this, [v](Storage& s){ return s.setValue(kHorizonSetting, v); });
+}
+
+bool HistoryRetention::eventFilter(QObject* watched, QEvent* event) {
+    switch (event->type()) {
+    case QEvent::KeyPress:
+    case QEvent::MouseButtonPress:
+    case QEvent::MouseMove:
+    case QEvent::Wheel:
+    case QEvent::TouchBegin:
+        m_sinceInput.restart();
+        break;
+    default:
+        break;
+    }
+    return QObject::eventFilter(watched, event);
+}
+
+bool HistoryRetention::idle() const {
+    return m_sinceInput.elapsed() >= kIdleSecs * 1000LL && StorageExecutor::instance()->queuedJobs() == 0;
+}
+
+void HistoryRetention::check() {
+    if (m_running) {
+        // a pass paused by input goes on where it stopped
+        if (!m_busy && idle()) nextSlice();
+        return;
+    }
+    if (m_lastPass < 0 || !idle()) return;
+    const qint64 now = QDateTime::currentSecsSinceEpoch();
+    if (now - m_lastPass < kPassIntervalSecs) return;
+    m_now = now;
+    m_report = Report();
+    m_running = true;
+    m_forced = false;
+    m_convertPending = false;
+    nextSlice();
+}
+
+void HistoryRetention::runPass(qint64 nowSecs) {
+    m_forced = true;
+    if (m_running) {
+        if (!m_busy) nextSlice();
+        return;
+    }
+    m_now = nowSecs > 0 ? nowSecs : QDateTime::currentSecsSinceEpoch();
+    m_report = Report();
+    m_running = true;
+    m_convertPending = false;
+    nextSlice();
+}
+
+void HistoryRetention::nextSlice() {
+    if (!m_forced && !idle()) {
+        m_busy = false;
+        return;
+    }
+    m_busy = true;
+    const Policy policy = m_policy;
+    const qint64 now = m_now;
+    const bool convert = m_convertPending;
+    // slices write and vacuum history.db, outside any transaction
+    StorageExecutor::instance()->run<Slice>(this, [policy, now, convert](Storage& s){
+        return convert ? convertFile(s) : runSlice(policy, now, s);
+    }, [this, convert](Slice slice){
+        if (convert) m_report.converted = true;
+        m_convertPending = slice.convert;
+        m_report.visitsRolledUp += slice.rolledUp;
+        m_report.daysMerged += slice.merged;
+        m_report.rowsDeleted += slice.deleted;
+        m_report.bytesReclaimed += slice.reclaimed;
+        m_report.dbBytes = slice.dbBytes;
+        m_report.ms += slice.ms;
+        if (slice.more || m_convertPending) {
+            QTimer::singleShot(kSliceGapMs, this, &HistoryRetention::nextSlice);
+            return;
+        }
+        m_busy = false;
+        m_running = false;
+        m_forced = false;
+        m_lastPass = QDateTime::currentSecsSinceEpoch();
+        const QString last = QString::number(m_lastPass);
+        StorageExecutor::instance()->write(this, [last](Storage& s){ return s.setValue(kLastPassSetting, last); });
+        metrics().dbBytes->set(double(m_report.dbBytes));
+        qInfo().noquote() << "History retention:" << m_report.summary();
+        emit passFinished(m_report);
+    });
+}
+
+// One bounded step of a pass, the first of these with anything to do:
+// deleting past the horizon, rolling visits into days, days into weeks,
+// returning free pages.
+HistoryRetention::Slice HistoryRetention::runSlice(const Policy& policy, qint64 now, Storage& s) {
+    FLOW_TRACE_SCOPE("HistoryRetention::slice");
+    QElapsedTimer timer;
+    timer.start();
+    constexpr qint64 kDay = 24 * 60 * 60;
+    QSqlDatabase db = s.history();
+    Slice slice;
+    const auto done = [&](bool more){
+        slice.more = more;
+        slice.dbBytes = fileBytes(db);
+        slice.ms = timer.nsecsElapsed() / 1e6;
+        metrics().sliceMs->record(slice.ms);
+        metrics().rows->add(slice.rolledUp + slice.merged + slice.deleted);
+        metrics().reclaimed->add(slice.reclaimed);
+        return slice;
+    };
+
+    if (policy.horizonDays > 0) {
+        const qint64 horizon = now - policy.horizonDays * kDay;
+        slice.deleted = deleteBatch(db, "DELETE FROM visits WHERE id IN "
+                                        "(SELECT id FROM visits WHERE visited_at < ? ORDER BY visited_at LIMIT ?)", horizon);
+        if (!slice.deleted)
+            slice.deleted = deleteBatch(db, "DELETE FROM visit_rollups WHERE rowid IN "
+                                            "(SELECT rowid FROM visit_rollups WHERE period_start < ? LIMIT ?)", horizon);
+        if (slice.deleted) return done(true);
+    }
+
+    // visits into one row per URL and (UTC) day; the title is the latest one's
+    const QVariant dayEnd = batchEnd(db, "SELECT MAX(visited_at) FROM "
+                                         "(SELECT visited_at FROM visits WHERE visited_at < ? ORDER BY visited_at LIMIT ?)",
+                                     now - policy.fullDays * kDay);
+    if (!dayEnd.isNull()) {
+        slice.rolledUp = rollUp(db,
+            "INSERT INTO visit_rollups (url, period_start, span, title, visits) "
+            "SELECT url, day, 86400, title, n FROM "
+            "(SELECT url, (visited_at / 86400) * 86400 AS day, title, MAX(visited_at), COUNT(*) AS n "
+            " FROM visits WHERE visited_at <= ? GROUP BY url, day) WHERE true "
+            "ON CONFLICT (url, period_start, span) DO UPDATE SET title = excluded.title, visits = visits + excluded.visits",
+            "DELETE FROM visits WHERE visited_at <= ?", dayEnd);
+        if (slice.rolledUp) return done(true);
+    }
+
+    // days into weeks starting on Monday (the epoch was a Thursday)
+    const QVariant weekEnd = batchEnd(db, "SELECT MAX(period_start) FROM (SELECT period_start FROM visit_rollups "
+                                          "WHERE span = 86400 AND period_start < ? ORDER BY period_start LIMIT ?)",
+                                      now - policy.dailyDays * kDay);
+    if (!weekEnd.isNull()) {
+        slice.merged = rollUp(db,
+            "INSERT INTO visit_rollups (url, period_start, span, title, visits) "
+            "SELECT url, week, 604800, title, n FROM "
+            "(SELECT url, ((period_start + 259200) / 604800) * 604800 - 259200 AS week, title, MAX(period_start), "
+            " SUM(visits) AS n FROM visit_rollups WHERE span = 86400 AND period_start <= ? GROUP BY url, week) WHERE true "
+            "ON CONFLICT (url, period_start, span) DO UPDATE SET title = excluded.title, visits = visits + excluded.visits",
+            "DELETE FROM visit_rollups WHERE span = 86400 AND period_start <= ?", weekEnd);
+        if (slice.merged) return done(true);
+    }
+
+    // a file from before incremental vacuum is left to convertFile()
+    if (scalar(db, "PRAGMA auto_vacuum") != 2) {
+        slice.convert = true;
+        return done(false);
+    }
+    const qint64 before = fileBytes(db);
+    if (scalar(db, "PRAGMA freelist_count") == 0) return done(false);
+    QSqlQuery q(db);
+    // every row stepped frees pages; stopping early would free fewer
+    if (q.exec(QString("PRAGMA incremental_vacuum(%1)").arg(kVacuumPages))) while (q.next()) {}
+    slice.reclaimed = qMax<qint64>(0, before - fileBytes(db));
+    return done(slice.reclaimed > 0 && scalar(db, "PRAGMA freelist_count") > 0);
+}
+
+// Switching auto_vacuum takes a VACUUM, which rewrites the file and returns
+// all its free pages on the way.
+HistoryRetention::Slice HistoryRetention::convertFile(Storage& s) {
+    FLOW_TRACE_SCOPE("HistoryRetention::convertFile");
+    QElapsedTimer timer;
+    timer.start();
+    QSqlDatabase db = s.history();
+    Slice slice;
+    const qint64 before = fileBytes(db);
+    QSqlQuery q(db);
+    if (!q.exec("PRAGMA auto_vacuum = INCREMENTAL") || !q.exec("VACUUM"))
+        qWarning() << "History retention: vacuum failed:" << q.lastError().text();
+    slice.reclaimed = qMax<qint64>(0, before - fileBytes(db));
+    slice.dbBytes = fileBytes(db);
+    slice.ms = timer.nsecsElapsed() / 1e6;
+    metrics().reclaimed->add(slice.reclaimed);
+    return slice;
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QPointer>
+
+class QTimer;
+class Storage;
+
+// Keeps history.db from growing with every year of browsing. Recent visits
+// stay one row each; older ones are rolled up into one row per URL and day,
+// and later per URL and week (visit_rollups); anything past the horizon is
+// deleted and the freed pages are returned to the file system.
+//
+// A pass runs in short slices on the storage thread, at most a couple of
+// thousand rows each, and only while the user has been idle and the storage
+// queue is empty; input pauses it until the next idle check. A pass is due
+// once a day.
+// A history.db from before incremental vacuum is not sliced: the first pass
+// over it ends with a step of its own that rewrites the whole file (VACUUM)
+// to switch it over. That holds the storage thread for as long as the rewrite
+// takes, once, and the report says so.
+class HistoryRetention : public QObject {
+    Q_OBJECT
+public:
+    struct Policy {
+        int fullDays = 90;      // visits kept one by one
+        int dailyDays = 365;    // then per URL and day; per URL and week after
+        int horizonDays = 730;  // deleted past this; 0 keeps history forever
+    };
+    // what one pass did
+    struct Report {
+        int visitsRolledUp = 0;   // visit rows folded into daily rows
+        int daysMerged = 0;       // daily rows folded into weekly rows
+        int rowsDeleted = 0;      // visits and rollups past the horizon
+        qint64 bytesReclaimed = 0;
+        qint64 dbBytes = 0;       // history.db afterwards
+        double ms = 0;            // time spent on the storage thread
+        bool converted = false;   // history.db was rewritten for incremental vacuum
+        QString summary() const;
+    };
+
+    static HistoryRetention* instance();
+    explicit HistoryRetention(QObject* parent = nullptr);
+
+    // watch for idleness and run passes when due
+    void start();
+    // a pass right away, idle or not; nowSecs stands in for the clock (tests)
+    void runPass(qint64 nowSecs = 0);
+    bool isRunning() const { return m_running; }
+
+    Policy policy() const { return m_policy; }
+    // wins over the horizon kept in the profile
+    void setPolicy(const Policy& policy) { m_policy = policy; m_horizonSet = true; }
+    // kept in the profile as history_horizon_days
+    void setHorizonDays(int days);
+
+    static constexpr int kBatchRows = 2000;
+    static constexpr int kVacuumPages = 256;
+    static constexpr int kIdleSecs = 30;
+    static constexpr int kPassIntervalSecs = 24 * 60 * 60;
+
+signals:
+    void passFinished(const HistoryRetention::Report& report);
+
+protected:
+    bool eventFilter(QObject* watched, QEvent* event) override;
+
+private:
+    struct Slice {
+        int rolledUp = 0;
+        int merged = 0;
+        int deleted = 0;
+        qint64 reclaimed = 0;
+        qint64 dbBytes = 0;
+        double ms = 0;
+        bool more = false;
+        bool convert = false; // the file still has to be switched to incremental vacuum
+    };
+    static Slice runSlice(const Policy& policy, qint64 now, Storage& s);
+    // the one-time rewrite, not a slice: it takes as long as the file is big
+    static Slice convertFile(Storage& s);
+    void check();
+    void nextSlice();
+    bool idle() const;
+
+    QTimer* m_timer;
+    QElapsedTimer m_sinceInput;
+    Policy m_policy;
+    bool m_running = false;
+    // a slice is posted or about to be; the pass is not paused
+    bool m_busy = false;
+    bool m_forced = false;
+    bool m_horizonSet = false;
+    bool m_convertPending = false;
+    qint64 m_now = 0;            // the pass's clock, fixed for its slices
+    qint64 m_lastPass = -1;      // epoch secs; -1 until read from the profile
+    Report m_report;
+};
+
+Q_DECLARE_METATYPE(HistoryRetention::Report)
@@ -0,0 +1,123 @@
+#include "JsonRowStream.h"
+#include "Trace.h"
+#include <QCoreApplication>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QPointer>
+#include <QThread>
+
+namespace {
+bool isSpace(char c) { return c == ' ' || c == '\n' || c == '\r' || c == '\t'; }
+
+// owned by qApp; stops and joins the thread when the application goes away
+class ParseThread : public QThread {
+public:
+    using QThread::QThread;
+    ~ParseThread() override {
+        quit();
+        wait();
+    }
+};
+}
+
+void JsonArraySplitter::feed(const QByteArray& chunk, QVector<QByteArray>& out) {
+    const char* p = chunk.constData();
+    const int n = int(chunk.size());
+    int start = m_inElement ? 0 : -1;
+    for (int i = 0; i < n && !m_failed; ++i) {
+        const char c = p[i];
+        if (m_inString) {
+            if (m_escape) m_escape = false;
+            else if (c == '\\') m_escape = true;
+            else if (c == '"') m_inString = false;
+            continue;
+        }
+        if (m_inElement) {
+            if (c == '"') {
+                m_inString = true;
+            } else if (c == '{' || c == '[') {
+                ++m_depth;
+            } else if (c == '}' || c == ']') {
+                if (m_depth > 0) {
+                    if (--m_depth > 0) continue;
+                    m_element.append(p + start, i - start + 1);
+                } else if (c == ']') {
+                    // the array ends right after a scalar element
+                    m_element.append(p + start, i - start);
+                    m_done = true;
+                } else {
+                    m_failed = true;
+                    break;
+                }
+                out.append(m_element.trimmed());
+                m_element.clear();
+                m_inElement = false;
+                start = -1;
+            } else if (c == ',' && m_depth == 0) {
+                m_element.append(p + start, i - start);
+                out.append(m_element.trimmed());
+                m_element.clear();
+                m_inElement = false;
+                start = -1;
+            }
+            continue;
+        }
+        if (isSpace(c)) continue;
+        if (!m_started) {
+            if (c == '[') m_started = true;
+            else m_failed = true;
+            continue;
+        }
+        if (m_done) { m_failed = true; continue; }
+        if (c == ',') continue;
+        if (c == ']') { m_done = true; continue; }
+        m_inElement = true;
+        start = i;
+        m_depth = (c == '{' || c == '[') ? 1 : 0;
+        m_inString = c == '"';
+    }
+    if (m_inElement && start >= 0 && !m_failed) m_element.append(p + start, n - start);
+}
+
+QThread* JsonRowParser::workerThread() {
+    static QPointer<QThread> s_thread;
+    if (!s_thread) {
+        s_thread = new ParseThread(QCoreApplication::instance());
+        s_thread->setObjectName("sync-parse");
+        s_thread->start(QThread::LowPriority);
+    }
+    return s_thread;
+}
+
+void JsonRowParser::feed(const QByteArray& chunk) {
+    if (m_failed) return;
+    FLOW_TRACE_SCOPE("JsonRowParser::feed");
+    m_splitter.feed(chunk, m_elements);
+    for (const QByteArray &element : m_elements) {
+        const QJsonDocument doc = QJsonDocument::fromJson(element);
+        if (!doc.isObject()) { m_failed = true; break; }
+        m_batch.append(doc.object());
+        ++m_rows;
+        if (m_batch.size() >= kBatchRows) flush();
+    }
+    m_elements.clear();
+    if (m_splitter.failed()) m_failed = true;
+}
+
+void JsonRowParser::flush() {
+    if (m_batch.isEmpty()) return;
+    emit rowsParsed(m_batch);
+    m_batch = QJsonArray();
+}
+
+void JsonRowParser::finish() {
+    const bool ok = !m_failed && m_splitter.isComplete();
+    if (ok) flush();
+    emit finished(ok, m_rows);
+    deleteLater();
+}
+
+void JsonRowParser::abort() {
+    m_failed = true;
+    finish();
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <QObject>
+#include <QByteArray>
+#include <QVector>
+#include <QJsonArray>
+
+class QThread;
+
+// Splits a top-level JSON array into the raw bytes of its elements while it
+// is still arriving, so each row can be parsed on its own instead of building
+// one QJsonDocument of the whole response. Only structure is tracked (depth,
+// strings, escapes); the elements themselves are not validated here.
+class JsonArraySplitter {
+public:
+    // appends every element completed by chunk to out
+    void feed(const QByteArray& chunk, QVector<QByteArray>& out);
+    bool failed() const { return m_failed; }
+    // the closing ']' has been seen and nothing is left over
+    bool isComplete() const { return m_done && !m_failed && !m_inElement; }
+
+private:
+    QByteArray m_element;  // start of an element that continues in the next chunk
+    int m_depth = 0;
+    bool m_started = false;
+    bool m_done = false;
+    bool m_inElement = false;
+    bool m_inString = false;
+    bool m_escape = false;
+    bool m_failed = false;
+};
+
+// Parses a PostgREST row array on the shared parse thread as chunks come in
+// and hands the rows back in batches through queued signals. Create it, move
+// it to workerThread() and call feed()/finish() there; it deletes itself after
+// finished().
+class JsonRowParser : public QObject {
+    Q_OBJECT
+public:
+    static constexpr int kBatchRows = 200;
+
+    // one low-priority thread for all collections, stopped with the application
+    static QThread* workerThread();
+
+    void feed(const QByteArray& chunk);
+    void finish();
+    // the response failed; rows already sent stay valid
+    void abort();
+
+signals:
+    void rowsParsed(const QJsonArray& rows);
+    void finished(bool ok, int rows);
+
+private:
+    void flush();
+
+    JsonArraySplitter m_splitter;
+    QVector<QByteArray> m_elements;
+    QJsonArray m_batch;
+    int m_rows = 0;
+    bool m_failed = false;
+};
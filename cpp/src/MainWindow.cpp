@@ -21,7 +21,30 @@
 #include "NotesPanel.h"
 #include "WorkspaceManager.h"
 #include "Toast.h"
+#include "TabMetricsSampler.h"
+#include "TaskManagerPanel.h"
+#include "ClosedTabsCache.h"
+#include "ProfileManager.h"
+#include "SpeculationEngine.h"
+#include "ContentBlockInterceptor.h"
+#include "SupabaseConfig.h"
+#include "NetworkClient.h"
+#include "StorageExecutor.h"
+#include "StartupTrace.h"
+#include "Trace.h"
+#include "MetricsRegistry.h"
+#include "FlowSchemeHandler.h"
+#include "SearchService.h"
+#include "CommandPalette.h"
+#include "PageTextIndex.h"
+#include "PageTextCapture.h"
+#include "BrowserImporter.h"
+#include <QWebEnginePage>
+#include <QWebEngineHistory>
+#include <QDataStream>
 #include <QInputDialog>
+#include <QFileDialog>
+#include <QProgressDialog>
 #include <QColorDialog>
 #include <QDrag>
 #include <QMimeData>
@@ -35,21 +58,43 @@
 #include <QPropertyAnimation>
 #include <QCompleter>
 #include <QStringListModel>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QDir>
+#include <QStandardPaths>
 #include <QTimer>
 #include <QDockWidget>
 #include <QSet>
 
 MainWindow::MainWindow(QWidget* parent, bool incognitoWindow) : QMainWindow(parent), m_isIncognitoWindow(incognitoWindow) {
+    m_startupPending = {"first paint", "bookmarks loaded", "notes loaded", "todos loaded", "workspaces loaded",
+                        "session restored", "first tab interactive"};
+    // queued behind opening and migrating flow.db
+    StorageExecutor::instance()->run([](Storage&){ StartupTrace::mark("storage ready"); });
+
+    // every manager reads its stored state on the storage reader threads while the shell is built and painted
     bookmarksManager = new BookmarksManager(this);
+    connect(bookmarksManager, &SyncEngineBase::loaded, this, [this](){ startupMilestone("bookmarks loaded"); });
 
-    // Supabase config placeholder - edit `cpp/config/supabase_config.json` with your Supabase URL and anon key
-    const QString supabaseUrl = "https://your-project.supabase.co";
-    const QString anonKey = "YOUR_ANON_KEY";
+    // see SupabaseConfig for where the URL and anon key come from
+    const SupabaseConfig supabase = SupabaseConfig::load();
+    const QString supabaseUrl = supabase.url;
+    const QString anonKey = supabase.anonKey;
     bookmarksManager->setSupabaseConfig(supabaseUrl, anonKey);
 
-    authManager = new AuthManager(this);
+    // one session for all windows: each renewal uses up the refresh token
+    authManager = AuthManager::instance();
     authManager->setSupabaseConfig(supabaseUrl, anonKey);
     bookmarksManager->setAuthManager(authManager);
+    // the handshake overlaps window setup instead of delaying the first sync
+    if (authManager->isSignedIn()) NetworkClient::instance()->warmUp(QUrl(supabaseUrl));
+
+    // created before any tab so every view, including cached ones, is tracked
+    m_tabMetrics = new TabMetricsSampler(this);
+    m_closedTabs = new ClosedTabsCache(this);
+    m_speculation = new SpeculationEngine(ProfileManager::instance()->persistentProfile(), this);
+    // never warm up destinations from a private window
+    m_speculation->setEnabled(!m_isIncognitoWindow);
 
     tabs = new QTabWidget(this);
     tabs->setTabsClosable(true);
@@ -59,10 +104,12 @@ MainWindow::MainWindow(QWidget* parent, bool incognitoWindow) : QMainWindow(pare
     historyManager = new HistoryManager(this);
 
     workspaceManager = new WorkspaceManager(this);
+    connect(workspaceManager, &WorkspaceManager::loaded, this, [this](){ startupMilestone("workspaces loaded"); });
     connect(workspaceManager, &WorkspaceManager::workspaceCreated, this, [this](int idx){
         // simple feedback — could show UI
     });
     connect(workspaceManager, &WorkspaceManager::workspaceSwitched, this, [this](int idx){
+        FLOW_TRACE_SCOPE("MainWindow::switchWorkspace");
         // detach existing tabs into cache for previous workspace
         int prev = workspaceManager->currentIndex();
         if (prev >= 0) detachTabsToCache(prev);
@@ -100,22 +147,28 @@ MainWindow::MainWindow(QWidget* parent, bool incognitoWindow) : QMainWindow(pare
         workspaceManager->switchToWorkspace(idx);
     });
     auto *workspaceList = wsMenu->addMenu("Switch Workspace");
-    // populate
-    for (int i=0;i<workspaceManager->workspaces().size();++i) {
-        auto *a = workspaceList->addAction(workspaceManager->workspaces()[i].name);
-        connect(a, &QAction::triggered, this, [this, i]() {
-            int cur = workspaceManager->currentIndex();
-            if (cur >= 0) {
-                QStringList curTabs;
-                for (int j=0;j<tabs->count();++j) {
-                    if (auto *v = qobject_cast<QWebEngineView*>(tabs->widget(j))) curTabs.append(v->url().toString());
+    // populate once the workspaces have been read, and again for each new one
+    auto populateWorkspaces = [this, workspaceList]() {
+        workspaceList->clear();
+        for (int i=0;i<workspaceManager->workspaces().size();++i) {
+            auto *a = workspaceList->addAction(workspaceManager->workspaces()[i].name);
+            connect(a, &QAction::triggered, this, [this, i]() {
+                int cur = workspaceManager->currentIndex();
+                if (cur >= 0) {
+                    QStringList curTabs;
+                    for (int j=0;j<tabs->count();++j) {
+                        if (auto *v = qobject_cast<QWebEngineView*>(tabs->widget(j))) curTabs.append(v->url().toString());
+                    }
+                    workspaceManager->setTabsForWorkspace(cur, curTabs);
+                    detachTabsToCache(cur);
                 }
-                workspaceManager->setTabsForWorkspace(cur, curTabs);
-                detachTabsToCache(cur);
-            }
-            workspaceManager->switchToWorkspace(i);
-        });
-    }
+                workspaceManager->switchToWorkspace(i);
+            });
+        }
+    };
+    populateWorkspaces();
+    connect(workspaceManager, &WorkspaceManager::loaded, this, populateWorkspaces);
+    connect(workspaceManager, &WorkspaceManager::workspaceCreated, this, populateWorkspaces);
     auto *newWindow = wsMenu->addAction("Open New Window");
     connect(newWindow, &QAction::triggered, [this](){
         auto *w = new MainWindow();
@@ -152,17 +205,31 @@ MainWindow::MainWindow(QWidget* parent, bool incognitoWindow) : QMainWindow(pare
     connect(m_omniboxDebounce, &QTimer::timeout, this, [this]() {
         QString q = urlEdit->text();
         if (q.isEmpty()) return;
+        FLOW_TRACE_INSTANT("omnibox query");
         // query history for suggestions
         if (!historyManager) return;
-        auto results = historyManager->search(q, 10);
-        QStringList sl;
-        for (const auto &r : results) {
-            // r.first == url, r.second == title
-            if (!r.second.isEmpty()) sl << QString("%1 — %2").arg(r.first, r.second);
-            else sl << r.first;
-        }
-        auto *model = new QStringListModel(sl, m_urlCompleter);
-        m_urlCompleter->setModel(model);
+        QElapsedTimer asked;
+        asked.start();
+        historyManager->search(q, 10, this, [this, q, asked](const HistoryManager::Results& results){
+            // typed on since: a newer query is on its way
+            if (urlEdit->text() != q) return;
+            FLOW_TRACE_SCOPE("MainWindow::showSuggestions");
+            static MetricsRegistry::Histogram* const latencyMs = MetricsRegistry::histogram("omnibox.latency_ms");
+            QStringList sl;
+            for (const auto &r : results) {
+                // r.first == url, r.second == title
+                if (!r.second.isEmpty()) sl << QString("%1 — %2").arg(r.first, r.second);
+                else sl << r.first;
+            }
+            auto *model = new QStringListModel(sl, m_urlCompleter);
+            m_urlCompleter->setModel(model);
+            if (!results.isEmpty()) {
+                const QUrl top(results.first().first);
+                m_speculation->hint(top, SpeculationEngine::omniboxConfidence(q, top), SpeculationEngine::Source::Omnibox);
+            }
+            // debounce fired to suggestions on screen
+            latencyMs->record(asked.nsecsElapsed() / 1e6);
+        });
     });
     connect(urlEdit, &QLineEdit::textEdited, this, [this](const QString &t){ m_omniboxDebounce->start(); });
 
@@ -178,6 +245,18 @@ MainWindow::MainWindow(QWidget* parent, bool incognitoWindow) : QMainWindow(pare
     auto *reloadAction = toolbar->addAction("Reload");
     connect(reloadAction, &QAction::triggered, [this](){ if(currentView()) currentView()->reload(); });
 
+    auto *reopenAction = toolbar->addAction("Reopen Closed Tab");
+    reopenAction->setShortcut(QKeySequence("Ctrl+Shift+T"));
+    reopenAction->setEnabled(false);
+    connect(reopenAction, &QAction::triggered, this, &MainWindow::reopenClosedTab);
+    connect(m_closedTabs, &ClosedTabsCache::availableChanged, reopenAction, &QAction::setEnabled);
+
+    // not on the toolbar: a window-wide shortcut
+    auto *traceAction = new QAction("Export Trace", this);
+    traceAction->setShortcut(QKeySequence("Ctrl+Alt+Shift+T"));
+    addAction(traceAction);
+    connect(traceAction, &QAction::triggered, this, &MainWindow::exportTrace);
+
     // Bookmarks button
     auto *bmButton = new QToolButton(this);
     bmButton->setText("Bookmarks");
@@ -197,6 +276,10 @@ MainWindow::MainWindow(QWidget* parent, bool incognitoWindow) : QMainWindow(pare
     auto *addBmAction = toolbar->addAction("Add Bookmark");
     connect(addBmAction, &QAction::triggered, [this, refreshBookmarksMenu](){ if(currentView()) { bookmarksManager->addBookmark(currentView()->title(), currentView()->url().toString()); refreshBookmarksMenu(); } });
 
+    auto *importAction = toolbar->addAction("Import");
+    importAction->setToolTip("Import history and bookmarks from Chrome, Firefox or a bookmarks HTML file");
+    connect(importAction, &QAction::triggered, this, &MainWindow::importBrowserData);
+
     // Sign in action
     auto *signInAction = toolbar->addAction("Sign In");
     connect(signInAction, &QAction::triggered, [this](){
@@ -211,19 +294,20 @@ MainWindow::MainWindow(QWidget* parent, bool incognitoWindow) : QMainWindow(pare
     // Load saved session
     // Load saved session (skip if this is an incognito window)
     if (!m_isIncognitoWindow) {
+        // the tabs open once the storage thread has read them
         SessionManager session(this);
-        int active = 0;
-        QStringList urls = session.loadSession(active);
-        if (urls.isEmpty()) {
-            newTab(QUrl("https://www.example.com"));
-        } else {
+        session.loadSession(this, [this](const QStringList& urls, int active){
+            startupMilestone("session restored");
+            if (urls.isEmpty()) {
+                if (tabs->count() == 0) newTab(QUrl("https://www.example.com"));
+                return;
+            }
             for (const auto &u : urls) newTab(QUrl(u));
             tabs->setCurrentIndex(qBound(0, active, tabs->count()-1));
-        }
-        // Hook to record history
-        connect(&session, &QObject::destroyed, [](){}); // keep usage
+        });
     } else {
         // incognito windows start with a single blank tab
+        m_startupPending.remove("session restored");
         newTab(QUrl("https://www.example.com"), true);
     }
 
@@ -236,14 +320,24 @@ MainWindow::MainWindow(QWidget* parent, bool incognitoWindow) : QMainWindow(pare
         auto items = bookmarksManager->bookmarks();
         if (idx < 0 || idx >= items.size()) return;
         auto url = items[idx].url;
+        m_speculation->recordNavigation(QUrl(url));
         if (newTab) newTab(QUrl(url)); else { if (currentView()) currentView()->setUrl(QUrl(url)); else newTab(QUrl(url)); }
     });
+    connect(bmPanel, &BookmarksPanel::itemHovered, this, [this](int idx){
+        auto items = bookmarksManager->bookmarks();
+        if (idx < 0 || idx >= items.size()) return;
+        // hovering is a weaker signal than typing: preconnect, don't prefetch
+        m_speculation->hint(QUrl(items[idx].url), 0.7, SpeculationEngine::Source::BookmarkHover);
+    });
     auto *dock = new QDockWidget("Bookmarks", this);
     dock->setWidget(bmPanel);
     addDockWidget(Qt::LeftDockWidgetArea, dock);
 
     // Create history panel dock
+    m_pageText = new PageTextIndex(this);
+    m_pageTextCapture = new PageTextCapture(m_pageText, this);
     auto *hPanel = new HistoryPanel(historyManager, this);
+    hPanel->setPageTextIndex(m_pageText);
     connect(hPanel, &HistoryPanel::openUrlRequested, this, [this](const QString &url, bool newTab){ if (newTab) newTab(QUrl(url)); else if (currentView()) currentView()->setUrl(QUrl(url)); });
     auto *hdock = new QDockWidget("History", this);
     hdock->setWidget(hPanel);
@@ -251,32 +345,50 @@ MainWindow::MainWindow(QWidget* parent, bool incognitoWindow) : QMainWindow(pare
 
     // Create notes manager and panel
     notesManager = new NotesManager(this);
+    connect(notesManager, &SyncEngineBase::loaded, this, [this](){ startupMilestone("notes loaded"); });
     notesManager->setSupabaseConfig(supabaseUrl, anonKey);
     notesManager->setAuthManager(authManager);
     auto *nPanel = new NotesPanel(notesManager, this);
-    connect(nPanel, &NotesPanel::editRequested, this, [this](int idx){
-        // simple behavior: show a dialog to edit note
-        auto items = notesManager->notes();
-        if (idx < 0 || idx >= items.size()) return;
-        bool ok;
-        QString title = QInputDialog::getText(this, "Edit Note", "Title:", QLineEdit::Normal, items[idx].title, &ok);
-        if (!ok || title.isEmpty()) return;
-        QString content = QInputDialog::getText(this, "Edit Note", "Content:", QLineEdit::Normal, items[idx].content, &ok);
-        if (!ok) return;
-        notesManager->editNote(idx, title, content);
-    });
+    connect(nPanel, &NotesPanel::editRequested, this, &MainWindow::editNote);
     auto *ndock = new QDockWidget("Notes", this);
     ndock->setWidget(nPanel);
     addDockWidget(Qt::RightDockWidgetArea, ndock);
 
     // Create todos manager and panel
     auto *todosManager = new TodosManager(this);
+    connect(todosManager, &SyncEngineBase::loaded, this, [this](){ startupMilestone("todos loaded"); });
     todosManager->setSupabaseConfig(supabaseUrl, anonKey);
     todosManager->setAuthManager(authManager);
     auto *tPanel = new TodosPanel(todosManager, this);
     auto *tdock = new QDockWidget("Todos", this);
     tdock->setWidget(tPanel);
     addDockWidget(Qt::RightDockWidgetArea, tdock);
+    m_todosDock = tdock;
+
+    // Command palette over history, bookmarks, notes and todos
+    m_search = new SearchService(this);
+    m_search->watchHistory(historyManager);
+    m_search->watchBookmarks(bookmarksManager);
+    m_search->watchNotes(notesManager);
+    m_search->watchTodos(todosManager);
+    m_palette = new CommandPalette(m_search, this);
+    connect(m_palette, &CommandPalette::hitActivated, this, &MainWindow::openSearchHit);
+    auto *paletteAction = new QAction("Search Everything", this);
+    paletteAction->setShortcut(QKeySequence("Ctrl+K"));
+    addAction(paletteAction);
+    connect(paletteAction, &QAction::triggered, m_palette, &CommandPalette::popup);
+
+    // Task manager dock: per-tab renderer PID, memory, CPU and load timing
+    auto *tmPanel = new TaskManagerPanel(m_tabMetrics, this);
+    tmPanel->setSpeculationEngine(m_speculation);
+    auto *tmDock = new QDockWidget("Task Manager", this);
+    tmDock->setWidget(tmPanel);
+    addDockWidget(Qt::BottomDockWidgetArea, tmDock);
+    tmDock->hide();
+    auto *tmAction = tmDock->toggleViewAction();
+    tmAction->setText("Task Manager");
+    toolbar->addAction(tmAction);
+    connect(tmDock, &QDockWidget::visibilityChanged, tmPanel, [tmPanel](bool visible){ if (visible) tmPanel->refresh(); });
 
     // Tab bar context menu for groups
     class TabBarEventFilter : public QObject {
@@ -473,6 +585,23 @@ MainWindow::MainWindow(QWidget* parent, bool incognitoWindow) : QMainWindow(pare
     });
 
     // After creating tabs, connect loadFinished per view inside newTab (done in newTab)
+    StartupTrace::mark("window shell built");
+}
+
+bool MainWindow::event(QEvent* e) {
+    if (e->type() != QEvent::UpdateRequest || !m_startupPending.contains("first paint")) return QMainWindow::event(e);
+    // the backing store is flushed once the update request has been handled
+    const bool handled = QMainWindow::event(e);
+    startupMilestone("first paint");
+    return handled;
+}
+
+void MainWindow::startupMilestone(const QString& phase) {
+    if (!m_startupPending.remove(phase)) return;
+    StartupTrace::mark(phase);
+    if (!m_startupPending.isEmpty()) return;
+    StartupTrace::mark("startup finished");
+    emit startupFinished();
 }
 
 MainWindow::~MainWindow() {
@@ -581,11 +710,13 @@ void MainWindow::restoreTabsFromCache(int workspaceIndex) {
     }
 }
 
-void MainWindow::newTab(const QUrl &url, bool incognito) {
+QWebEngineView* MainWindow::createView(bool incognito) {
     auto *view = new QWebEngineView(this);
+    // incognito tabs share the off-the-record profile: no disk cache, no persistent cookies
+    view->setPage(new QWebEnginePage(ProfileManager::instance()->profileFor(incognito || m_isIncognitoWindow), view));
+    ContentBlockInterceptor::install(view->page());
     if (incognito) m_incognitoViews.insert(view);
-    int idx = tabs->addTab(view, "New Tab");
-    tabs->setCurrentIndex(idx);
+    m_tabMetrics->trackView(view);
 
     connect(view, &QWebEngineView::titleChanged, [this, view](const QString &title){
         int idx = tabs->indexOf(view);
@@ -597,14 +728,27 @@ void MainWindow::newTab(const QUrl &url, bool incognito) {
     });
 
     connect(view, &QWebEngineView::loadFinished, [this, view](bool ok){
+        // a failed load still leaves the tab usable
+        if (view == currentView()) startupMilestone("first tab interactive");
+        if (ok) ProfileManager::instance()->collectCacheStats(view->page());
         // only record history for non-incognito views and non-incognito windows
         if (!ok) return;
         if (!historyManager) return;
         if (m_isIncognitoWindow) return;
         if (m_incognitoViews.contains(view)) return;
         historyManager->addVisit(view->url().toString(), view->title());
+        // read later, once the page has settled
+        if (m_pageTextCapture) m_pageTextCapture->pageLoaded(view->page());
     });
 
+    return view;
+}
+
+void MainWindow::newTab(const QUrl &url, bool incognito) {
+    FLOW_TRACE_SCOPE("MainWindow::newTab");
+    auto *view = createView(incognito);
+    int idx = tabs->addTab(view, "New Tab");
+    tabs->setCurrentIndex(idx);
     view->setUrl(url);
 }
 
@@ -614,23 +758,106 @@ void MainWindow::newTabIncognito(const QUrl &url) {
 
 void MainWindow::closeTab(int index) {
     QWidget* w = tabs->widget(index);
+    if (!w) return;
+    FLOW_TRACE_SCOPE("MainWindow::closeTab");
+    closeDevToolsFor(index);
     tabs->removeTab(index);
-    delete w;
+    auto *v = qobject_cast<QWebEngineView*>(w);
+    // private tabs are never kept around after close
+    if (v && !isViewIncognito(v)) {
+        m_tabMetrics->untrackView(v);
+        m_closedTabs->pushView(v, index);
+    } else {
+        m_incognitoViews.remove(v);
+        delete w;
+    }
     if (tabs->count() == 0) newTab();
 }
 
+void MainWindow::reopenClosedTab() {
+    if (m_closedTabs->isEmpty()) return;
+    ClosedTab t = m_closedTabs->takeLast();
+    QWebEngineView* view = t.liveView.data();
+    if (view) {
+        // still within the grace period: the page was only frozen
+        view->setParent(this);
+        m_tabMetrics->trackView(view);
+    } else {
+        view = createView(false);
+        // restoring the history also navigates to its current entry
+        QDataStream in(t.history);
+        in >> *view->history();
+        if (view->history()->count() == 0) view->setUrl(QUrl(t.url));
+    }
+    int idx = tabs->insertTab(qBound(0, t.index, tabs->count()), view, t.title.isEmpty() ? "New Tab" : t.title);
+    view->show();
+    tabs->setCurrentIndex(idx);
+}
+
 void MainWindow::onUrlEntered() {
     if (!currentView()) return;
     QString url = urlEdit->text();
-    if(!url.startsWith("http")) url = "https://" + url;
+    if(!url.startsWith("http") && !url.startsWith(QString::fromLatin1(FlowSchemeHandler::kScheme) + ':')) url = "https://" + url;
+    m_speculation->recordNavigation(QUrl(url));
     currentView()->setUrl(QUrl(url));
 }
 
 void MainWindow::updateUrlForCurrentTab(int index) {
+    FLOW_TRACE_SCOPE("MainWindow::switchTab");
     QWebEngineView* view = currentView();
     if (view) urlEdit->setText(view->url().toString());
 }
 
+void MainWindow::exportTrace() {
+    if (!Trace::enabled()) {
+        Trace::setEnabled(true);
+        statusBar()->showMessage("Tracing started — press Ctrl+Alt+Shift+T again to export", 5000);
+        return;
+    }
+    const QDir dir(QDir(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation)).filePath("traces"));
+    dir.mkpath(".");
+    const QString path = dir.filePath(QString("flow-trace-%1.json").arg(QDateTime::currentDateTime().toString("yyyyMMdd-hhmmss")));
+    if (Trace::exportChromeJson(path)) statusBar()->showMessage(QString("Trace written to %1").arg(path), 8000);
+    else statusBar()->showMessage(QString("Could not write %1").arg(path), 8000);
+}
+
+void MainWindow::editNote(int idx) {
+    // simple behavior: show a dialog to edit note
+    auto items = notesManager->notes();
+    if (idx < 0 || idx >= items.size()) return;
+    bool ok;
+    QString title = QInputDialog::getText(this, "Edit Note", "Title:", QLineEdit::Normal, items[idx].title, &ok);
+    if (!ok || title.isEmpty()) return;
+    QString content = QInputDialog::getText(this, "Edit Note", "Content:", QLineEdit::Normal, items[idx].content, &ok);
+    if (!ok) return;
+    notesManager->editNote(idx, title, content);
+}
+
+void MainWindow::openSearchHit(const SearchHit& hit) {
+    QString url;
+    switch (hit.source) {
+    case SearchSource::History:
+        url = hit.key;
+        break;
+    case SearchSource::Bookmark: {
+        // the index may trail the collection by a moment
+        const int idx = bookmarksManager->indexOfLocalId(hit.key);
+        if (idx < 0) return;
+        url = bookmarksManager->bookmarks()[idx].url;
+        break;
+    }
+    case SearchSource::Note:
+        editNote(notesManager->indexOfLocalId(hit.key));
+        return;
+    case SearchSource::Todo:
+        m_todosDock->show();
+        m_todosDock->raise();
+        return;
+    }
+    m_speculation->recordNavigation(QUrl(url));
+    if (currentView()) currentView()->setUrl(QUrl(url)); else newTab(QUrl(url));
+}
+
 bool MainWindow::isViewIncognito(QWebEngineView* v) const {
     return m_incognitoViews.contains(v) || m_isIncognitoWindow;
 }
@@ -671,3 +898,27 @@ void MainWindow::closeDevToolsFor(int tabIndex) {
         dock->close();
     }
 }
+
+void MainWindow::importBrowserData() {
+    if (m_importer && m_importer->isRunning()) return;
+    const QString path = QFileDialog::getOpenFileName(this, "Import Browser Data", QDir::homePath(),
+                                                      "Browser data (History places.sqlite *.sqlite *.html *.htm);;All files (*)");
+    if (path.isEmpty()) return;
+    if (!m_importer) m_importer = new BrowserImporter(historyManager, bookmarksManager, this);
+    auto *dlg = new QProgressDialog("Importing...", "Cancel", 0, 0, this);
+    dlg->setAttribute(Qt::WA_DeleteOnClose);
+    dlg->setMinimumDuration(500);
+    connect(dlg, &QProgressDialog::canceled, m_importer, &BrowserImporter::cancel);
+    // the dialog shows a percentage; totals can pass int
+    connect(m_importer, &BrowserImporter::progress, dlg, [dlg](qint64 done, qint64 total){
+        dlg->setMaximum(total > 0 ? 1000 : 0);
+        if (total > 0) dlg->setValue(int(done * 1000 / total));
+    });
+    connect(m_importer, &BrowserImporter::finished, dlg, [this, dlg](const BrowserImporter::Result& r){
+        dlg->close();
+        if (!r.error.isEmpty()) m_toast->showMessage("Import failed: " + r.error);
+        else m_toast->showMessage(QString("Imported %1 visits and %2 bookmarks%3").arg(r.visits).arg(r.bookmarks)
+                                  .arg(r.cancelled ? " before it was cancelled" : ""));
+    });
+    m_importer->start(path);
+}
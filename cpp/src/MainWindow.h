@@ -15,6 +15,15 @@ class BookmarksManager;
 class AuthManager;
 class HistoryManager;
 class WorkspaceManager;
+class TabMetricsSampler;
+class ClosedTabsCache;
+class SpeculationEngine;
+class SearchService;
+class PageTextIndex;
+class PageTextCapture;
+class BrowserImporter;
+class CommandPalette;
+struct SearchHit;
 
 class MainWindow : public QMainWindow {
     Q_OBJECT
@@ -22,13 +31,23 @@ public:
     MainWindow(QWidget* parent = nullptr, bool incognitoWindow = false);
     ~MainWindow();
 
+signals:
+    // first paint, every manager loaded and the current tab interactive
+    void startupFinished();
+
+protected:
+    bool event(QEvent* e) override;
+
 private slots:
     // create a new tab; pass incognito=true for a private tab
     void newTab(const QUrl &url = QUrl("https://www.example.com"), bool incognito = false);
     void newTabIncognito(const QUrl &url = QUrl("https://www.example.com"));
     void closeTab(int index);
+    void reopenClosedTab();
     void onUrlEntered();
     void updateUrlForCurrentTab(int index);
+    // first use starts tracing, later ones write what was recorded as Chrome trace JSON
+    void exportTrace();
 
     // DevTools
     void openDevToolsFor(int tabIndex);
@@ -69,11 +88,39 @@ private:
     // DevTools dock widgets per WebView
     QHash<QWebEngineView*, QDockWidget*> m_devTools;
 
+    // Per-tab renderer memory/CPU and load timing (task manager dock)
+    TabMetricsSampler* m_tabMetrics = nullptr;
+
+    // Recently closed tabs (serialized history, briefly the frozen live view)
+    ClosedTabsCache* m_closedTabs = nullptr;
+
+    // Preconnect/prefetch for the top omnibox suggestion and hovered bookmarks
+    SpeculationEngine* m_speculation = nullptr;
+
+    // one index over every store, searched from the command palette (Ctrl+K)
+    SearchService* m_search = nullptr;
+    CommandPalette* m_palette = nullptr;
+    QDockWidget* m_todosDock = nullptr;
+
+    // text of visited pages, read after they load, for "search what I read"
+    PageTextIndex* m_pageText = nullptr;
+    PageTextCapture* m_pageTextCapture = nullptr;
+    // history and bookmarks from another browser's files
+    BrowserImporter* m_importer = nullptr;
+    void importBrowserData();
+    void editNote(int index);
+    void openSearchHit(const SearchHit& hit);
+
+    // startup phases still outstanding; see StartupTrace
+    QSet<QString> m_startupPending;
+    void startupMilestone(const QString& phase);
+
     void detachTabsToCache(int workspaceIndex);
     void restoreTabsFromCache(int workspaceIndex);
 
     void animateTabTextColor(QTabBar* bar, int index, const QColor& from, const QColor& to);
     void animateTabMove(const QRect &startGlobal, const QRect &endGlobal, const QPixmap &pix);
 
+    QWebEngineView* createView(bool incognito);
     QWebEngineView* currentView() const;
 };
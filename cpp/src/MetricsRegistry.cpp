@@ -0,0 +1,163 @@
+#include "MetricsRegistry.h"
+#include <QHash>
+#include <QMutex>
+#include <QObject>
+#include <QPointer>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+constexpr double kBaseMs = 0.01;
+
+struct Source {
+    QString section;
+    QPointer<QObject> owner;
+    std::function<QJsonArray()> collect;
+};
+
+// Metrics are never freed, so a pointer handed out stays valid even while
+// static destructors run at exit.
+struct Registry {
+    QMutex mutex;
+    QHash<QString, MetricsRegistry::Counter*> counters;
+    QHash<QString, MetricsRegistry::Gauge*> gauges;
+    QHash<QString, MetricsRegistry::Histogram*> histograms;
+    QVector<Source> sources;
+};
+
+Registry& registry() {
+    static Registry* r = new Registry;
+    return *r;
+}
+
+template <class T>
+T* lookup(QHash<QString, T*>& map, const QString& name) {
+    QMutexLocker lock(&registry().mutex);
+    T*& m = map[name];
+    if (!m) m = new T;
+    return m;
+}
+
+// std::atomic<double> has no fetch_add before C++20
+void atomicAdd(std::atomic<double>& a, double v) {
+    double cur = a.load(std::memory_order_relaxed);
+    while (!a.compare_exchange_weak(cur, cur + v, std::memory_order_relaxed)) {}
+}
+
+template <class Better>
+void atomicKeep(std::atomic<double>& a, double v, Better better) {
+    double cur = a.load(std::memory_order_relaxed);
+    while (better(v, cur) && !a.compare_exchange_weak(cur, v, std::memory_order_relaxed)) {}
+}
+}
+
+double HistogramSnapshot::percentile(double p) const {
+    if (count <= 0) return 0.0;
+    const qint64 rank = qMax<qint64>(1, qint64(std::ceil(qBound(0.0, p, 1.0) * count)));
+    qint64 seen = 0;
+    for (int i = 0; i < buckets.size(); ++i) {
+        seen += buckets[i];
+        if (seen >= rank) return qBound(min, MetricsRegistry::Histogram::upperBound(i), max);
+    }
+    return max;
+}
+
+QJsonObject HistogramSnapshot::toJson() const {
+    QJsonArray out;
+    for (int i = 0; i < buckets.size(); ++i)
+        if (buckets[i]) out.append(QJsonArray{MetricsRegistry::Histogram::upperBound(i), buckets[i]});
+    return QJsonObject{{"count", count}, {"mean", mean()}, {"min", min}, {"max", max},
+                       {"p50", percentile(0.5)}, {"p90", percentile(0.9)}, {"p99", percentile(0.99)}, {"buckets", out}};
+}
+
+double MetricsRegistry::Histogram::upperBound(int bucket) {
+    return kBaseMs * std::exp2((bucket + 1) / 4.0);
+}
+
+int MetricsRegistry::Histogram::bucketFor(double ms) {
+    if (!(ms > kBaseMs)) return 0;
+    const int i = int(std::ceil(std::log2(ms / kBaseMs) * 4.0)) - 1;
+    return qBound(0, i, kBuckets - 1);
+}
+
+void MetricsRegistry::Histogram::record(double ms) {
+    if (!(ms >= 0.0)) ms = 0.0;
+    m_counts[bucketFor(ms)].fetch_add(1, std::memory_order_relaxed);
+    m_count.fetch_add(1, std::memory_order_relaxed);
+    atomicAdd(m_sum, ms);
+    atomicKeep(m_min, ms, [](double v, double cur){ return v < cur; });
+    atomicKeep(m_max, ms, [](double v, double cur){ return v > cur; });
+}
+
+HistogramSnapshot MetricsRegistry::Histogram::snapshot() const {
+    HistogramSnapshot s;
+    s.buckets.resize(kBuckets);
+    // counted from the buckets, so percentiles agree with count mid-update
+    for (int i = 0; i < kBuckets; ++i) {
+        s.buckets[i] = m_counts[i].load(std::memory_order_relaxed);
+        s.count += s.buckets[i];
+    }
+    if (s.count == 0) return s;
+    s.sum = m_sum.load(std::memory_order_relaxed);
+    s.min = m_min.load(std::memory_order_relaxed);
+    s.max = m_max.load(std::memory_order_relaxed);
+    return s;
+}
+
+void MetricsRegistry::Histogram::reset() {
+    for (auto &c : m_counts) c.store(0, std::memory_order_relaxed);
+    m_count.store(0, std::memory_order_relaxed);
+    m_sum.store(0.0, std::memory_order_relaxed);
+    m_min.store(std::numeric_limits<double>::infinity(), std::memory_order_relaxed);
+    m_max.store(0.0, std::memory_order_relaxed);
+}
+
+MetricsRegistry::Counter* MetricsRegistry::counter(const QString& name) {
+    return lookup(registry().counters, name);
+}
+
+MetricsRegistry::Gauge* MetricsRegistry::gauge(const QString& name) {
+    return lookup(registry().gauges, name);
+}
+
+MetricsRegistry::Histogram* MetricsRegistry::histogram(const QString& name) {
+    return lookup(registry().histograms, name);
+}
+
+void MetricsRegistry::addSource(const QString& section, QObject* owner, std::function<QJsonArray()> collect) {
+    Registry& r = registry();
+    QMutexLocker lock(&r.mutex);
+    r.sources.append(Source{section, owner, std::move(collect)});
+}
+
+QJsonObject MetricsRegistry::toJson() {
+    Registry& r = registry();
+    QJsonObject counters, gauges, histograms;
+    QVector<Source> sources;
+    {
+        QMutexLocker lock(&r.mutex);
+        for (auto it = r.counters.cbegin(); it != r.counters.cend(); ++it) counters[it.key()] = it.value()->value();
+        for (auto it = r.gauges.cbegin(); it != r.gauges.cend(); ++it) gauges[it.key()] = it.value()->value();
+        for (auto it = r.histograms.cbegin(); it != r.histograms.cend(); ++it)
+            histograms[it.key()] = it.value()->snapshot().toJson();
+        r.sources.erase(std::remove_if(r.sources.begin(), r.sources.end(), [](const Source& s){ return s.owner.isNull(); }),
+                        r.sources.end());
+        sources = r.sources;
+    }
+    // outside the lock: a source may look up metrics of its own
+    QJsonObject sections;
+    for (const Source &s : sources) {
+        QJsonArray values = sections.value(s.section).toArray();
+        for (const QJsonValue &v : s.collect()) values.append(v);
+        sections[s.section] = values;
+    }
+    return QJsonObject{{"counters", counters}, {"gauges", gauges}, {"histograms", histograms}, {"sections", sections}};
+}
+
+void MetricsRegistry::reset() {
+    Registry& r = registry();
+    QMutexLocker lock(&r.mutex);
+    for (Counter* c : r.counters) c->m_value.store(0, std::memory_order_relaxed);
+    for (Gauge* g : r.gauges) g->m_value.store(0.0, std::memory_order_relaxed);
+    for (Histogram* h : r.histograms) h->reset();
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QString>
+#include <QVector>
+#include <atomic>
+#include <functional>
+#include <limits>
+
+class QObject;
+
+struct HistogramSnapshot {
+    qint64 count = 0;
+    double sum = 0.0;
+    double min = 0.0;
+    double max = 0.0;
+    QVector<qint64> buckets;
+    double mean() const { return count > 0 ? sum / count : 0.0; }
+    // upper bound of the bucket holding the p-th value (0..1), clamped to [min, max]
+    double percentile(double p) const;
+    // count, mean, min, max, p50/p90/p99 and the non-empty [upper bound, count] buckets
+    QJsonObject toJson() const;
+};
+
+// Process-wide counters, gauges and latency histograms that any subsystem
+// publishes to and flow://performance shows. Look a metric up once and keep
+// the pointer: it lives as long as the process, and updating it is a relaxed
+// atomic operation, safe from any thread.
+//
+//   static MetricsRegistry::Histogram* const searchMs = MetricsRegistry::histogram("history.search_ms");
+//   searchMs->record(timer.nsecsElapsed() / 1e6);
+class MetricsRegistry {
+public:
+    class Counter {
+    public:
+        void add(qint64 n = 1) { m_value.fetch_add(n, std::memory_order_relaxed); }
+        qint64 value() const { return m_value.load(std::memory_order_relaxed); }
+    private:
+        friend class MetricsRegistry;
+        std::atomic<qint64> m_value{0};
+    };
+
+    class Gauge {
+    public:
+        void set(double v) { m_value.store(v, std::memory_order_relaxed); }
+        double value() const { return m_value.load(std::memory_order_relaxed); }
+    private:
+        friend class MetricsRegistry;
+        std::atomic<double> m_value{0.0};
+    };
+
+    // Milliseconds in log-spaced buckets, four per doubling from 10 µs, so a
+    // percentile is within 19% of the true value.
+    class Histogram {
+    public:
+        static constexpr int kBuckets = 96;
+        static double upperBound(int bucket);
+        static int bucketFor(double ms);
+        void record(double ms);
+        HistogramSnapshot snapshot() const;
+    private:
+        friend class MetricsRegistry;
+        void reset();
+        std::atomic<qint64> m_counts[kBuckets]{};
+        std::atomic<qint64> m_count{0};
+        std::atomic<double> m_sum{0.0};
+        std::atomic<double> m_min{std::numeric_limits<double>::infinity()};
+        std::atomic<double> m_max{0.0};
+    };
+
+    static Counter* counter(const QString& name);
+    static Gauge* gauge(const QString& name);
+    static Histogram* histogram(const QString& name);
+
+    // Structured values (e.g. one object per tab) collected on the reading
+    // thread whenever the registry is read; every source of a section adds to
+    // the same array. The source goes away with owner.
+    static void addSource(const QString& section, QObject* owner, std::function<QJsonArray()> collect);
+
+    static QJsonObject toJson();
+    // zero every metric; pointers stay valid (tests)
+    static void reset();
+};
@@ -0,0 +1,464 @@
+#include "MockSupabaseServer.h"
+#include "Gzip.h"
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QHostAddress>
+#include <QJsonDocument>
+#include <QDateTime>
+#include <QPointer>
+#include <QTimer>
+#include <QUrl>
+#include <QUrlQuery>
+#include <QMutexLocker>
+#include <algorithm>
+#include <utility>
+
+namespace {
+
+QString nowIso() { return QDateTime::currentDateTimeUtc().toString(Qt::ISODateWithMs); }
+
+QString mockUuid(qint64 n) { return QString("00000000-0000-4000-8000-%1").arg(n, 12, 10, QChar('0')); }
+
+QByteArray errorBody(const QString& message, const QString& code = QString()) {
+    QJsonObject o;
+    if (!code.isEmpty()) o["code"] = code;
+    o["message"] = message;
+    return QJsonDocument(o).toJson(QJsonDocument::Compact);
+}
+
+// numbers compare as numbers, everything else (including ISO timestamps) as text
+int compareValues(const QJsonValue& v, const QString& operand) {
+    if (v.isDouble()) {
+        bool ok = false;
+        const double d = operand.toDouble(&ok);
+        if (ok) return v.toDouble() < d ? -1 : (v.toDouble() > d ? 1 : 0);
+    }
+    const QString s = v.isBool() ? (v.toBool() ? "true" : "false") : v.toVariant().toString();
+    return QString::compare(s, operand);
+}
+
+} // namespace
+
+MockSupabaseServer::MockSupabaseServer(QObject* parent): QObject(parent), m_rng(1) {
+    m_server = new QTcpServer(this);
+    m_userId = mockUuid(0);
+    connect(m_server, &QTcpServer::newConnection, this, &MockSupabaseServer::onNewConnection);
+}
+
+bool MockSupabaseServer::listen(quint16 port) { return m_server->listen(QHostAddress::LocalHost, port); }
+
+QString MockSupabaseServer::url() const { return QString("http://127.0.0.1:%1").arg(m_server->serverPort()); }
+
+void MockSupabaseServer::setLatency(int ms, int jitterMs) {
+    m_latencyMs = qMax(0, ms);
+    m_jitterMs = qMax(0, jitterMs);
+}
+
+void MockSupabaseServer::setErrorRate(double rate) { m_errorRate = qBound(0.0, rate, 1.0); }
+
+void MockSupabaseServer::failNextRequest(int status, const QString& code, const QString& message) {
+    m_nextFailure = {status, errorBody(message, code)};
+}
+
+QString MockSupabaseServer::timestamp() const { return m_fixedTime.isEmpty() ? nowIso() : m_fixedTime; }
+
+void MockSupabaseServer::seedRows(const QString& table, int count) {
+    for (int i = 0; i < count; ++i) {
+        QJsonObject o;
+        o["user_id"] = m_userId;
+        o["title"] = QString("Seeded %1 #%2").arg(table).arg(i);
+        if (table == "bookmarks") { o["url"] = QString("https://seed.example/%1").arg(i); o["workspace"] = QString(); }
+        else if (table == "notes") { o["content"] = QString("Seeded note body %1").arg(i); o["workspace"] = QString(); }
+        else if (table == "todos") { o["completed"] = (i % 3) == 0; o["workspace"] = QString(); }
+        newRow(table, o);
+    }
+}
+
+int MockSupabaseServer::rowCount(const QString& table) const { return m_tables.value(table).rows.size(); }
+
+QJsonArray MockSupabaseServer::rows(const QString& table) const {
+    return select(m_tables.value(table), {});
+}
+
+bool MockSupabaseServer::editRow(const QString& table, const QString& id, const QJsonObject& fields) {
+    auto t = m_tables.find(table);
+    if (t == m_tables.end() || !t->rows.contains(id)) return false;
+    QJsonObject &row = t->rows[id];
+    for (auto it = fields.constBegin(); it != fields.constEnd(); ++it) row[it.key()] = it.value();
+    row["updated_at"] = timestamp();
+    return true;
+}
+
+MockServerStats MockSupabaseServer::stats() const {
+    QMutexLocker lock(&m_statsMutex);
+    return m_stats;
+}
+
+void MockSupabaseServer::resetStats() {
+    QMutexLocker lock(&m_statsMutex);
+    m_stats = MockServerStats();
+}
+
+QJsonObject MockSupabaseServer::statsJson() const {
+    const MockServerStats s = stats();
+    QJsonObject o;
+    o["requests"] = s.requests;
+    o["bytes_in"] = s.bytesIn;
+    o["bytes_out"] = s.bytesOut;
+    o["injected_errors"] = s.injectedErrors;
+    o["unauthorized"] = s.unauthorized;
+    o["connections"] = s.connections;
+    o["gzip_requests"] = s.gzipRequests;
+    o["gzip_responses"] = s.gzipResponses;
+    QJsonObject routes;
+    for (auto it = s.byRoute.constBegin(); it != s.byRoute.constEnd(); ++it) routes[it.key()] = it.value();
+    o["by_route"] = routes;
+    return o;
+}
+
+void MockSupabaseServer::onNewConnection() {
+    while (QTcpSocket* socket = m_server->nextPendingConnection()) {
+        {
+            QMutexLocker lock(&m_statsMutex);
+            ++m_stats.connections;
+        }
+        m_buffers.insert(socket, QByteArray());
+        connect(socket, &QTcpSocket::readyRead, this, [this, socket](){ onReadyRead(socket); });
+        connect(socket, &QTcpSocket::disconnected, this, [this, socket](){
+            m_buffers.remove(socket);
+            socket->deleteLater();
+        });
+    }
+}
+
+void MockSupabaseServer::onReadyRead(QTcpSocket* socket) {
+    QByteArray &buf = m_buffers[socket];
+    buf += socket->readAll();
+    // HTTP/1.1 with Content-Length bodies is all QNetworkAccessManager sends here
+    for (;;) {
+        const int headerEnd = buf.indexOf("\r\n\r\n");
+        if (headerEnd < 0) return;
+        const QList<QByteArray> lines = buf.left(headerEnd).split('\n');
+        const QList<QByteArray> requestLine = lines.value(0).trimmed().split(' ');
+        if (requestLine.size() < 3) { socket->disconnectFromHost(); return; }
+        Request req;
+        req.method = requestLine[0];
+        req.target = requestLine[1];
+        for (int i = 1; i < lines.size(); ++i) {
+            const int colon = lines[i].indexOf(':');
+            if (colon > 0) req.headers.insert(lines[i].left(colon).trimmed().toLower(), lines[i].mid(colon + 1).trimmed());
+        }
+        const int length = req.headers.value("content-length", "0").toInt();
+        if (buf.size() < headerEnd + 4 + length) return; // body still in flight
+        req.body = buf.mid(headerEnd + 4, length);
+        req.wireBytes = headerEnd + 4 + length;
+        buf.remove(0, headerEnd + 4 + length);
+        dispatch(socket, req);
+    }
+}
+
+void MockSupabaseServer::dispatch(QTcpSocket* socket, Request req) {
+    const bool gzipIn = req.headers.value("content-encoding") == "gzip";
+    Response resp;
+    if (gzipIn) req.body = Gzip::decompress(req.body);
+    if (gzipIn && req.body.isEmpty()) resp = {400, errorBody("invalid gzip body")};
+    else resp = handle(req);
+    QByteArray body = resp.body;
+    const bool gzipOut = body.size() >= 1024 && req.headers.value("accept-encoding").contains("gzip");
+    if (gzipOut) body = Gzip::compress(body);
+    QByteArray out = "HTTP/1.1 " + QByteArray::number(resp.status) + ' ' + statusText(resp.status) + "\r\n";
+    out += "Content-Type: application/json; charset=utf-8\r\n";
+    if (gzipOut) out += "Content-Encoding: gzip\r\n";
+    out += "Content-Length: " + QByteArray::number(body.size()) + "\r\n";
+    out += "Connection: keep-alive\r\n\r\n";
+    out += body;
+
+    const QString path = QUrl(QString::fromUtf8(req.target)).path();
+    {
+        QMutexLocker lock(&m_statsMutex);
+        ++m_stats.requests;
+        m_stats.bytesIn += req.wireBytes;
+        m_stats.bytesOut += out.size();
+        ++m_stats.byRoute[QString::fromLatin1(req.method) + ' ' + path];
+        if (gzipIn) ++m_stats.gzipRequests;
+        if (gzipOut) ++m_stats.gzipResponses;
+    }
+    emit requestHandled(QString::fromLatin1(req.method), path, resp.status);
+
+    const int delay = m_latencyMs + (m_jitterMs > 0 ? int(m_rng.bounded(m_jitterMs + 1)) : 0);
+    if (delay == 0) { socket->write(out); return; }
+    // clients wait for each response before reusing a connection, so order is kept
+    QPointer<QTcpSocket> guard(socket);
+    QTimer::singleShot(delay, this, [guard, out](){ if (guard) guard->write(out); });
+}
+
+MockSupabaseServer::Response MockSupabaseServer::handle(const Request& req) {
+    const QUrl url(QString::fromUtf8(req.target));
+    const QString path = url.path();
+    if (req.headers.value("apikey") != anonKey().toUtf8()) return {401, errorBody("No API key found in request")};
+
+    if (path.startsWith("/auth/v1/")) {
+        QHash<QString, QString> query;
+        for (const auto &item : QUrlQuery(url).queryItems(QUrl::FullyDecoded)) query.insert(item.first, item.second);
+        return handleAuth(req, path, query);
+    }
+    if (path.startsWith("/rest/v1/")) {
+        const QByteArray auth = req.headers.value("authorization");
+        const qint64 expiresAt = auth.startsWith("Bearer ") ? m_accessTokens.value(QString::fromUtf8(auth.mid(7))) : 0;
+        if (expiresAt <= QDateTime::currentMSecsSinceEpoch()) {
+            QMutexLocker lock(&m_statsMutex);
+            ++m_stats.unauthorized;
+            return {401, errorBody("JWT expired")};
+        }
+        if (m_nextFailure.status != 0) return std::exchange(m_nextFailure, Response{0, QByteArray()});
+        if (m_errorRate > 0.0 && m_rng.generateDouble() < m_errorRate) {
+            QMutexLocker lock(&m_statsMutex);
+            ++m_stats.injectedErrors;
+            return {503, errorBody("injected failure")};
+        }
+        return handleRest(req, path.mid(9), QUrlQuery(url).queryItems(QUrl::FullyDecoded));
+    }
+    return {404, errorBody("not found")};
+}
+
+QJsonObject MockSupabaseServer::issueTokens(const QString& email) {
+    const QString access = QString("mock-access-%1").arg(m_nextId++);
+    const QString refresh = QString("mock-refresh-%1").arg(m_nextId++);
+    m_accessTokens.insert(access, QDateTime::currentMSecsSinceEpoch() + qint64(m_tokenLifetime) * 1000);
+    m_refreshTokens.insert(refresh, email);
+    QJsonObject user;
+    user["id"] = m_userId;
+    user["email"] = email;
+    QJsonObject o;
+    o["access_token"] = access;
+    o["refresh_token"] = refresh;
+    o["token_type"] = "bearer";
+    o["expires_in"] = m_tokenLifetime;
+    o["user"] = user;
+    return o;
+}
+
+MockSupabaseServer::Response MockSupabaseServer::handleAuth(const Request& req, const QString& path, const QHash<QString, QString>& query) {
+    if (req.method != "POST") return {405, errorBody("method not allowed")};
+    const QJsonObject body = QJsonDocument::fromJson(req.body).object();
+    if (path == "/auth/v1/signup") {
+        if (body.value("email").toString().isEmpty()) return {422, errorBody("email required")};
+        return {200, QJsonDocument(issueTokens(body.value("email").toString())).toJson(QJsonDocument::Compact)};
+    }
+    if (path == "/auth/v1/token") {
+        const QString grant = query.value("grant_type");
+        if (grant == "password") {
+            if (body.value("email").toString().isEmpty()) return {400, errorBody("invalid_grant")};
+            return {200, QJsonDocument(issueTokens(body.value("email").toString())).toJson(QJsonDocument::Compact)};
+        }
+        if (grant == "refresh_token") {
+            const QString token = body.value("refresh_token").toString();
+            if (!m_refreshTokens.contains(token)) return {400, errorBody("invalid_grant")};
+            // refresh tokens are single use
+            const QString email = m_refreshTokens.take(token);
+            return {200, QJsonDocument(issueTokens(email)).toJson(QJsonDocument::Compact)};
+        }
+        return {400, errorBody("unsupported_grant_type")};
+    }
+    return {404, errorBody("not found")};
+}
+
+QJsonObject MockSupabaseServer::newRow(const QString& table, QJsonObject fields) {
+    Table &t = m_tables[table];
+    // clients may pick the id, as the column only defaults to a random one
+    const QString id = fields.value("id").toString().isEmpty() ? mockUuid(m_nextId++) : fields.value("id").toString();
+    const QString now = timestamp();
+    fields["id"] = id;
+    if (!fields.contains("created_at")) fields["created_at"] = now;
+    fields["updated_at"] = now;
+    t.rows.insert(id, fields);
+    t.order.append(id);
+    return fields;
+}
+
+bool MockSupabaseServer::matches(const QJsonObject& row, const QString& column, const QString& filter) {
+    const int dot = filter.indexOf('.');
+    if (dot < 0) return true;
+    const QString op = filter.left(dot);
+    QString operand = filter.mid(dot + 1);
+    // values in a logic tree may be double-quoted
+    if (operand.size() >= 2 && operand.startsWith('"') && operand.endsWith('"')) operand = operand.mid(1, operand.size() - 2);
+    const QJsonValue v = row.value(column);
+    if (op == "eq") return compareValues(v, operand) == 0;
+    if (op == "neq") return compareValues(v, operand) != 0;
+    if (op == "gt") return compareValues(v, operand) > 0;
+    if (op == "gte") return compareValues(v, operand) >= 0;
+    if (op == "lt") return compareValues(v, operand) < 0;
+    if (op == "lte") return compareValues(v, operand) <= 0;
+    if (op == "is") return operand == "null" ? (v.isNull() || v.isUndefined()) : compareValues(v, operand) == 0;
+    if (op == "in") {
+        QString list = operand;
+        if (list.startsWith('(') && list.endsWith(')')) list = list.mid(1, list.size() - 2);
+        for (const QString &item : list.split(',')) if (compareValues(v, item) == 0) return true;
+        return false;
+    }
+    return true; // unknown operators do not filter
+}
+
+// or=(a.gt.1,and(b.eq.2,c.lt.3)): conditions split at the commas outside
+// parentheses and quotes
+bool MockSupabaseServer::matchesTree(const QJsonObject& row, const QString& tree, bool all) {
+    QString list = tree;
+    if (list.startsWith('(') && list.endsWith(')')) list = list.mid(1, list.size() - 2);
+    QStringList terms;
+    int depth = 0;
+    bool quoted = false;
+    int start = 0;
+    for (int i = 0; i <= list.size(); ++i) {
+        const QChar c = i < list.size() ? list.at(i) : QChar(',');
+        if (c == '"') quoted = !quoted;
+        else if (!quoted && c == '(') ++depth;
+        else if (!quoted && c == ')') --depth;
+        else if (!quoted && depth == 0 && c == ',') {
+            terms.append(list.mid(start, i - start));
+            start = i + 1;
+        }
+    }
+    for (const QString &term : std::as_const(terms)) {
+        bool match;
+        if (term.startsWith("and(") || term.startsWith("or(")) {
+            const bool nestedAll = term.startsWith("and(");
+            match = matchesTree(row, term.mid(nestedAll ? 3 : 2), nestedAll);
+        } else {
+            const int dot = term.indexOf('.');
+            match = dot > 0 && matches(row, term.left(dot), term.mid(dot + 1));
+        }
+        if (all && !match) return false;
+        if (!all && match) return true;
+    }
+    return all;
+}
+
+QJsonArray MockSupabaseServer::select(const Table& t, const QList<QPair<QString, QString>>& query) const {
+    QVector<QJsonObject> out;
+    QVector<QPair<QString, bool>> order; // column, descending
+    int limit = -1, offset = 0;
+    for (const QString &id : t.order) {
+        auto it = t.rows.constFind(id);
+        if (it == t.rows.constEnd()) continue;
+        bool keep = true;
+        for (const auto &q : query) {
+            if (q.first == "select" || q.first == "order" || q.first == "limit" || q.first == "offset") continue;
+            const bool match = q.first == "or" || q.first == "and" ? matchesTree(*it, q.second, q.first == "and")
+                                                                    : matches(*it, q.first, q.second);
+            if (!match) { keep = false; break; }
+        }
+        if (keep) out.append(*it);
+    }
+    for (const auto &q : query) {
+        if (q.first == "order") {
+            for (const QString &term : q.second.split(',')) {
+                const QStringList parts = term.split('.');
+                order.append({parts.value(0), parts.value(1) == "desc"});
+            }
+        } else if (q.first == "limit") {
+            limit = q.second.toInt();
+        } else if (q.first == "offset") {
+            offset = q.second.toInt();
+        }
+    }
+    if (!order.isEmpty()) {
+        std::stable_sort(out.begin(), out.end(), [&](const QJsonObject& a, const QJsonObject& b){
+            for (const auto &term : order) {
+                const int c = compareValues(a.value(term.first), b.value(term.first).toVariant().toString());
+                if (c != 0) return term.second ? c > 0 : c < 0;
+            }
+            return false;
+        });
+    }
+    QJsonArray arr;
+    for (int i = offset; i < out.size() && (limit < 0 || arr.size() < limit); ++i) arr.append(out[i]);
+    return arr;
+}
+
+MockSupabaseServer::Response MockSupabaseServer::handleRest(const Request& req, const QString& table, const QList<QPair<QString, QString>>& query) {
+    if (table.isEmpty() || table.contains('/')) return {404, errorBody("relation does not exist")};
+    Table &t = m_tables[table];
+    const bool representation = req.headers.value("prefer").contains("return=representation");
+
+    if (req.method == "GET") {
+        if (m_withoutUpdatedAt.contains(table)) {
+            for (const auto &q : query)
+                if (q.first == "updated_at" || q.second.contains("updated_at"))
+                    return {400, errorBody(QString("column %1.updated_at does not exist").arg(table), "42703")};
+        }
+        return {200, QJsonDocument(select(t, query)).toJson(QJsonDocument::Compact)};
+    }
+
+    if (req.method == "POST") {
+        const QJsonDocument doc = QJsonDocument::fromJson(req.body);
+        QJsonArray input;
+        if (doc.isArray()) input = doc.array();
+        else if (doc.isObject()) input.append(doc.object());
+        else return {400, errorBody("invalid json")};
+        // upsert: rows whose id exists are merged, or left alone and not
+        // returned, instead of inserted
+        const bool merge = req.headers.value("prefer").contains("resolution=merge-duplicates");
+        const bool ignore = req.headers.value("prefer").contains("resolution=ignore-duplicates");
+        QJsonArray created;
+        for (const QJsonValue &v : input) {
+            const QJsonObject fields = v.toObject();
+            const QString id = fields.value("id").toString();
+            if (ignore && t.rows.contains(id)) continue;
+            if (merge && t.rows.contains(id)) {
+                QJsonObject &row = t.rows[id];
+                for (auto it = fields.constBegin(); it != fields.constEnd(); ++it) row[it.key()] = it.value();
+                row["updated_at"] = timestamp();
+                created.append(row);
+            } else {
+                created.append(newRow(table, fields));
+            }
+        }
+        if (!representation) return {201, QByteArray()};
+        return {201, QJsonDocument(created).toJson(QJsonDocument::Compact)};
+    }
+
+    // PATCH and DELETE act on every row matching the filters
+    if (query.isEmpty()) return {400, errorBody("filter required")};
+    const QJsonArray hit = select(t, query);
+    if (req.method == "PATCH") {
+        const QJsonObject fields = QJsonDocument::fromJson(req.body).object();
+        QJsonArray updated;
+        for (const QJsonValue &v : hit) {
+            QJsonObject &row = t.rows[v.toObject().value("id").toString()];
+            for (auto it = fields.constBegin(); it != fields.constEnd(); ++it) if (it.key() != "id") row[it.key()] = it.value();
+            row["updated_at"] = timestamp();
+            updated.append(row);
+        }
+        if (!representation) return {204, QByteArray()};
+        return {200, QJsonDocument(updated).toJson(QJsonDocument::Compact)};
+    }
+    if (req.method == "DELETE") {
+        for (const QJsonValue &v : hit) t.rows.remove(v.toObject().value("id").toString());
+        // drop dead ids once they dominate, so listing stays proportional to live rows
+        if (t.order.size() > 2 * t.rows.size() + 64) {
+            QVector<QString> live;
+            for (const QString &id : t.order) if (t.rows.contains(id)) live.append(id);
+            t.order = live;
+        }
+        if (!representation) return {204, QByteArray()};
+        return {200, QJsonDocument(hit).toJson(QJsonDocument::Compact)};
+    }
+    return {405, errorBody("method not allowed")};
+}
+
+QByteArray MockSupabaseServer::statusText(int status) {
+    switch (status) {
+    case 200: return "OK";
+    case 201: return "Created";
+    case 204: return "No Content";
+    case 400: return "Bad Request";
+    case 401: return "Unauthorized";
+    case 404: return "Not Found";
+    case 405: return "Method Not Allowed";
+    case 409: return "Conflict";
+    case 422: return "Unprocessable Entity";
+    case 503: return "Service Unavailable";
+    default: return "Unknown";
+    }
+}
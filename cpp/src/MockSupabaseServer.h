@@ -0,0 +1,126 @@
+#pragma once
+
+#include <QObject>
+#include <QHash>
+#include <QSet>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QMutex>
+#include <QRandomGenerator>
+#include <QVector>
+
+class QTcpServer;
+class QTcpSocket;
+
+struct MockServerStats {
+    qint64 requests = 0;
+    qint64 bytesIn = 0;        // request line, headers and body
+    qint64 bytesOut = 0;
+    qint64 injectedErrors = 0;
+    qint64 unauthorized = 0;
+    qint64 connections = 0;
+    qint64 gzipRequests = 0;   // bodies sent with Content-Encoding: gzip
+    qint64 gzipResponses = 0;  // answered gzip-encoded (Accept-Encoding)
+    QHash<QString, qint64> byRoute; // "POST /rest/v1/bookmarks" -> count
+};
+
+// A localhost stand-in for the parts of Supabase the managers talk to:
+//   POST /auth/v1/token?grant_type=password|refresh_token, POST /auth/v1/signup,
+//   GET/POST/PATCH/DELETE /rest/v1/{table} with PostgREST-style filters
+//   (col=eq.x, gt/gte/lt/lte/neq, in.(a,b), or=(...)/and=(...) trees,
+//   order=col.asc|desc[,col2...], limit, offset)
+//   and upserts (POST with Prefer: resolution=merge-duplicates, matched on id).
+// gzip request bodies are decoded and large responses are gzip-encoded for
+// clients that accept it, so wire bytes match what a real gateway would see.
+// Any credentials are accepted and map to a single user. Latency and a REST
+// error rate can be injected, and every byte is counted so sync changes can be
+// compared in numbers.
+class MockSupabaseServer : public QObject {
+    Q_OBJECT
+public:
+    explicit MockSupabaseServer(QObject* parent = nullptr);
+
+    bool listen(quint16 port = 0); // 127.0.0.1; 0 picks a free port
+    QString url() const;
+    QString anonKey() const { return QStringLiteral("mock-anon-key"); }
+    QString userId() const { return m_userId; }
+
+    void setLatency(int ms, int jitterMs = 0);
+    void setErrorRate(double rate); // fraction of REST requests answered with 503
+    void setSeed(quint32 seed) { m_rng.seed(seed); }
+    void setTokenLifetime(int seconds) { m_tokenLifetime = seconds; }
+    // access tokens issued so far stop working, as after a key rotation; refresh tokens stay valid
+    void revokeAccessTokens() { m_accessTokens.clear(); }
+
+    // Rows that already exist remotely before a test starts, owned by userId().
+    void seedRows(const QString& table, int count);
+    int rowCount(const QString& table) const;
+    // rows written from now on all get this updated_at, like the rows of one
+    // transaction; empty goes back to the clock
+    void setFixedTime(const QString& iso) { m_fixedTime = iso; }
+    QJsonArray rows(const QString& table) const;
+    // change an existing row as another client would; false when there is none
+    bool editRow(const QString& table, const QString& id, const QJsonObject& fields);
+    // the table has no updated_at column, as one made before delta pulls:
+    // reads that order or filter by it are refused with 400 and code 42703
+    void dropUpdatedAt(const QString& table) { m_withoutUpdatedAt.insert(table); }
+    // the next REST request is answered with this PostgREST error
+    void failNextRequest(int status, const QString& code, const QString& message);
+
+    MockServerStats stats() const;
+    void resetStats();
+    QJsonObject statsJson() const;
+
+signals:
+    void requestHandled(const QString& method, const QString& path, int status);
+
+private:
+    struct Request {
+        QByteArray method;
+        QByteArray target;
+        QHash<QByteArray, QByteArray> headers; // lowercase names
+        QByteArray body;
+        qint64 wireBytes = 0;
+    };
+    struct Response {
+        int status = 200;
+        QByteArray body;
+    };
+    struct Table {
+        QHash<QString, QJsonObject> rows;
+        QVector<QString> order; // insertion order, may hold deleted ids
+    };
+
+    void onNewConnection();
+    void onReadyRead(QTcpSocket* socket);
+    void dispatch(QTcpSocket* socket, Request req);
+    Response handle(const Request& req);
+    Response handleAuth(const Request& req, const QString& path, const QHash<QString, QString>& query);
+    Response handleRest(const Request& req, const QString& table, const QList<QPair<QString, QString>>& query);
+    QJsonObject issueTokens(const QString& email);
+    QJsonObject newRow(const QString& table, QJsonObject fields);
+    QJsonArray select(const Table& t, const QList<QPair<QString, QString>>& query) const;
+    static bool matches(const QJsonObject& row, const QString& column, const QString& filter);
+    static bool matchesTree(const QJsonObject& row, const QString& tree, bool all);
+    QString timestamp() const;
+    static QByteArray statusText(int status);
+
+    QTcpServer* m_server;
+    QHash<QTcpSocket*, QByteArray> m_buffers;
+    QHash<QString, Table> m_tables;
+    QHash<QString, qint64> m_accessTokens; // access token -> expiry, epoch ms
+    QHash<QString, QString> m_refreshTokens; // refresh token -> email
+    QString m_userId;
+    int m_latencyMs = 0;
+    int m_jitterMs = 0;
+    double m_errorRate = 0.0;
+    int m_tokenLifetime = 3600;
+    qint64 m_nextId = 1;
+    QString m_fixedTime;
+    QSet<QString> m_withoutUpdatedAt;
+    Response m_nextFailure; // status 0 for none
+    QRandomGenerator m_rng;
+
+    mutable QMutex m_statsMutex; // stats may be read from the load-test thread
+    MockServerStats m_stats;
+};
@@ -0,0 +1,188 @@
+#include "NetworkClient.h"
+#include "MetricsRegistry.h"
+#include "Trace.h"
+#include <QCoreApplication>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <memory>
+#if QT_CONFIG(ssl)
+#include <QSslConfiguration>
+#include <QSslSocket>
+#endif
+
+namespace {
+// shown on flow://performance
+struct NetworkMetrics {
+    MetricsRegistry::Gauge* inFlight = MetricsRegistry::gauge("network.in_flight");
+    MetricsRegistry::Gauge* queued = MetricsRegistry::gauge("network.queued");
+    MetricsRegistry::Counter* requests = MetricsRegistry::counter("network.requests");
+    MetricsRegistry::Counter* errors = MetricsRegistry::counter("network.errors");
+    MetricsRegistry::Histogram* queueMs = MetricsRegistry::histogram("network.queue_ms");
+    MetricsRegistry::Histogram* requestMs = MetricsRegistry::histogram("network.request_ms");
+};
+
+const NetworkMetrics& metrics() {
+    static const NetworkMetrics m;
+    return m;
+}
+}
+
+NetworkClient* NetworkClient::instance() {
+    static QPointer<NetworkClient> s_instance;
+    if (!s_instance) s_instance = new NetworkClient(QCoreApplication::instance());
+    return s_instance;
+}
+
+NetworkClient::NetworkClient(QObject* parent): QObject(parent), m_net(new QNetworkAccessManager(this)) {
+    // a stalled transfer gives its slot back and is retried by the caller
+    m_net->setTransferTimeout(30000);
+}
+
+int NetworkClient::queued() const {
+    int n = 0;
+    for (const auto &q : m_queues) n += q.size();
+    return n;
+}
+
+void NetworkClient::setMaxConcurrent(int n) {
+    m_maxConcurrent = qMax(1, n);
+    dispatch();
+}
+
+void NetworkClient::send(QNetworkRequest req, const QByteArray& method, const QByteArray& body, Priority priority,
+                         QObject* context, std::function<void(QNetworkReply*)> onFinished,
+                         std::function<void(QNetworkReply*)> onStarted) {
+    req.setAttribute(QNetworkRequest::Http2AllowedAttribute, true);
+    req.setPriority(priority == Interactive ? QNetworkRequest::HighPriority
+                    : priority == Background ? QNetworkRequest::LowPriority : QNetworkRequest::NormalPriority);
+#if QT_CONFIG(ssl)
+    if (req.url().scheme() == QLatin1String("https")) {
+        // sessions are shared between connections and resumed from tickets
+        QSslConfiguration ssl = req.sslConfiguration();
+        ssl.setSslOption(QSsl::SslOptionDisableSessionSharing, false);
+        ssl.setSslOption(QSsl::SslOptionDisableSessionTickets, false);
+        req.setSslConfiguration(ssl);
+    }
+#endif
+    Pending p;
+    p.req = req;
+    p.method = method;
+    p.body = body;
+    p.context = context;
+    p.onFinished = std::move(onFinished);
+    p.onStarted = std::move(onStarted);
+    p.queuedFor.start();
+    if (Trace::enabled()) {
+        // query strings carry filters and cursors; the path names the table
+        p.traceName = Trace::intern(method + ' ' + req.url().path().toUtf8());
+        p.traceId = Trace::nextAsyncId();
+        Trace::asyncBegin(p.traceName, p.traceId, priority == Interactive ? "interactive" : priority == Background ? "background" : "normal");
+    }
+    const int prio = qBound(0, int(priority), NetworkStats::kPriorities - 1);
+    if (m_inFlight < m_maxConcurrent && queued() == 0) { start(std::move(p), prio); return; }
+    p.waited = true;
+    m_queues[prio].enqueue(std::move(p));
+    dispatch();
+    metrics().queued->set(queued());
+}
+
+void NetworkClient::dispatch() {
+    for (int prio = 0; prio < NetworkStats::kPriorities && m_inFlight < m_maxConcurrent; ++prio) {
+        while (!m_queues[prio].isEmpty() && m_inFlight < m_maxConcurrent) {
+            Pending p = m_queues[prio].dequeue();
+            // the requester went away while its request waited
+            if (p.context.isNull()) {
+                if (p.traceName) Trace::asyncEnd(p.traceName, p.traceId, "dropped");
+                continue;
+            }
+            start(std::move(p), prio);
+        }
+    }
+}
+
+void NetworkClient::start(Pending p, int priority) {
+    const qint64 waitedMs = p.queuedFor.elapsed();
+    ++m_stats.sent[priority];
+    if (p.waited) ++m_stats.waited[priority];
+    m_stats.queueMs[priority] += waitedMs;
+    m_stats.maxQueueMs[priority] = qMax(m_stats.maxQueueMs[priority], waitedMs);
+    ++m_inFlight;
+    m_stats.peakInFlight = qMax(m_stats.peakInFlight, m_inFlight);
+    metrics().queueMs->record(double(waitedMs));
+    metrics().inFlight->set(m_inFlight);
+    QElapsedTimer sentFor;
+    sentFor.start();
+    if (p.traceName) Trace::asyncStep(p.traceName, p.traceId, "sent");
+
+    QNetworkReply* reply;
+    if (p.method == "GET") reply = m_net->get(p.req);
+    else if (p.method == "POST") reply = m_net->post(p.req, p.body);
+    else reply = m_net->sendCustomRequest(p.req, p.method, p.body);
+
+    const bool tls = p.req.url().scheme() == QLatin1String("https");
+    auto handshake = std::make_shared<bool>(false);
+    // only emitted when this reply had to open a TLS session of its own
+    connect(reply, &QNetworkReply::encrypted, this, [handshake](){ *handshake = true; });
+    connect(reply, &QNetworkReply::finished, this,
+            [this, reply, tls, handshake, context = p.context, onFinished = std::move(p.onFinished),
+             traceName = p.traceName, traceId = p.traceId, sentFor](){
+        if (traceName) Trace::asyncEnd(traceName, traceId, reply->error() == QNetworkReply::NoError ? nullptr : "error");
+        FLOW_TRACE_SCOPE_DETAIL("NetworkClient::onFinished", traceName);
+        --m_inFlight;
+        metrics().requestMs->record(sentFor.nsecsElapsed() / 1e6);
+        metrics().requests->add();
+        if (reply->error() != QNetworkReply::NoError) metrics().errors->add();
+        if (tls) {
+            ++m_stats.tlsRequests;
+            if (*handshake) ++m_stats.tlsHandshakes;
+        }
+        if (reply->attribute(QNetworkRequest::Http2WasUsedAttribute).toBool()) ++m_stats.http2Requests;
+        if (context && onFinished) onFinished(reply);
+        reply->deleteLater();
+        dispatch();
+        metrics().inFlight->set(m_inFlight);
+        metrics().queued->set(queued());
+    });
+    if (p.onStarted) p.onStarted(reply);
+}
+
+void NetworkClient::warmUp(const QUrl& url) {
+    if (!url.isValid() || url.host().isEmpty()) return;
+    ++m_stats.warmUps;
+#if QT_CONFIG(ssl)
+    if (url.scheme() == QLatin1String("https") && QSslSocket::supportsSsl()) {
+        QSslConfiguration ssl = QSslConfiguration::defaultConfiguration();
+        ssl.setSslOption(QSsl::SslOptionDisableSessionSharing, false);
+        ssl.setSslOption(QSsl::SslOptionDisableSessionTickets, false);
+        // offer h2 so the warmed connection is the one HTTP/2 requests reuse
+        ssl.setAllowedNextProtocols({QSslConfiguration::ALPNProtocolHTTP2, QSslConfiguration::NextProtocolHttp1_1});
+        m_net->connectToHostEncrypted(url.host(), quint16(url.port(443)), ssl);
+        return;
+    }
+#endif
+    m_net->connectToHost(url.host(), quint16(url.port(80)));
+}
+
+QJsonObject NetworkClient::toJson() const {
+    static const char* const kNames[NetworkStats::kPriorities] = {"interactive", "normal", "background"};
+    QJsonObject o;
+    o["requests"] = m_stats.requests();
+    o["max_concurrent"] = m_maxConcurrent;
+    o["peak_in_flight"] = m_stats.peakInFlight;
+    o["warm_ups"] = m_stats.warmUps;
+    o["tls_requests"] = m_stats.tlsRequests;
+    o["tls_handshakes"] = m_stats.tlsHandshakes;
+    o["tls_handshakes_saved"] = m_stats.handshakesSaved();
+    o["http2_requests"] = m_stats.http2Requests;
+    QJsonObject queue;
+    for (int i = 0; i < NetworkStats::kPriorities; ++i) {
+        QJsonObject q;
+        q["sent"] = m_stats.sent[i];
+        q["waited"] = m_stats.waited[i];
+        q["mean_queue_ms"] = m_stats.meanQueueMs(i);
+        q["max_queue_ms"] = m_stats.maxQueueMs[i];
+        queue[kNames[i]] = q;
+    }
+    o["queue"] = queue;
+    return o;
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <QObject>
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QJsonObject>
+#include <QNetworkRequest>
+#include <QPointer>
+#include <QQueue>
+#include <QUrl>
+#include <functional>
+
+class QNetworkAccessManager;
+class QNetworkReply;
+
+struct NetworkStats {
+    static constexpr int kPriorities = 3;
+    qint64 sent[kPriorities] = {};
+    qint64 waited[kPriorities] = {};       // had to queue behind other requests
+    qint64 queueMs[kPriorities] = {};      // summed enqueue-to-send delay
+    qint64 maxQueueMs[kPriorities] = {};
+    qint64 tlsRequests = 0;                // https requests that finished
+    qint64 tlsHandshakes = 0;              // ... of which had to open a new TLS session
+    qint64 http2Requests = 0;
+    qint64 warmUps = 0;
+    int peakInFlight = 0;
+    qint64 requests() const { qint64 n = 0; for (qint64 s : sent) n += s; return n; }
+    qint64 handshakesSaved() const { return qMax<qint64>(0, tlsRequests - tlsHandshakes); }
+    double meanQueueMs(int priority) const { return sent[priority] > 0 ? double(queueMs[priority]) / sent[priority] : 0.0; }
+};
+
+// The one QNetworkAccessManager of the process, used by AuthManager and every
+// synced collection in every window, so they share connections, HTTP/2
+// sessions and TLS sessions to the Supabase host. Requests go out in priority
+// order with at most maxConcurrent() in flight: a user edit or keepRemote does
+// not wait behind a bulk upload.
+class NetworkClient : public QObject {
+    Q_OBJECT
+public:
+    enum Priority { Interactive = 0, Normal = 1, Background = 2 };
+
+    static NetworkClient* instance();
+
+    // Queue a request. onFinished runs once with the finished reply, which is
+    // deleted afterwards; nothing runs if context is destroyed first. onStarted
+    // runs when the reply exists, e.g. to read it as it downloads.
+    void send(QNetworkRequest req, const QByteArray& method, const QByteArray& body, Priority priority,
+              QObject* context, std::function<void(QNetworkReply*)> onFinished,
+              std::function<void(QNetworkReply*)> onStarted = nullptr);
+
+    // open (and for https, handshake) a connection before the first request needs it
+    void warmUp(const QUrl& url);
+
+    void setMaxConcurrent(int n);
+    int maxConcurrent() const { return m_maxConcurrent; }
+    int inFlight() const { return m_inFlight; }
+    int queued() const;
+
+    NetworkStats stats() const { return m_stats; }
+    void resetStats() { m_stats = NetworkStats(); }
+    QJsonObject toJson() const;
+
+private:
+    explicit NetworkClient(QObject* parent = nullptr);
+
+    struct Pending {
+        QNetworkRequest req;
+        QByteArray method;
+        QByteArray body;
+        QPointer<QObject> context;
+        std::function<void(QNetworkReply*)> onFinished;
+        std::function<void(QNetworkReply*)> onStarted;
+        QElapsedTimer queuedFor;
+        bool waited = false;
+        // "METHOD /path" and id of the request's async trace track; null while tracing is off
+        const char* traceName = nullptr;
+        quint64 traceId = 0;
+    };
+    void dispatch();
+    void start(Pending p, int priority);
+
+    QNetworkAccessManager* m_net;
+    QQueue<Pending> m_queues[NetworkStats::kPriorities];
+    int m_maxConcurrent = 6; // Qt's HTTP/1.1 connections per host
+    int m_inFlight = 0;
+    NetworkStats m_stats;
+};
@@ -36,7 +36,10 @@ void NotesConflictDialog::refreshList() {
     for (int idx : cs) {
         if (idx >=0 && idx < items.size()) {
             const auto &n = items[idx];
-            m_list->addItem(QString("%1: %2 (%3)").arg(QString::number(idx)).arg(n.title).arg(n.content.left(40)));
+            QString text = QString("%1: %2 (%3)").arg(QString::number(idx)).arg(n.title).arg(n.content.left(40));
+            const NoteItem remote = m_mgr->remoteVersion(idx);
+            if (!remote.id.isEmpty()) text += QString("  |  remote: %1 (%2)").arg(remote.title).arg(remote.content.left(40));
+            m_list->addItem(text);
         }
     }
 }
@@ -1,64 +1,39 @@
 #pragma once
 
-#include <QObject>
-#include <QVector>
+#include "SyncedCollection.h"
+#include <QString>
 
-class AuthManager;
-
-enum class SyncStatusNote { Synced=0, Syncing=1, Unsynced=2, Conflict=3 };
+// kept for existing callers; notes share SyncStatus with the other synced types
+using SyncStatusNote = SyncStatus;
 
 struct NoteItem {
     QString id;
     QString title;
     QString content;
     QString workspace;
-    SyncStatusNote status = SyncStatusNote::Synced;
+    SyncStatus status = SyncStatus::Synced;
+};
+
+struct NoteTraits {
+    using Item = NoteItem;
+    static constexpr const char* table = "notes";
+    static QString identityKey(const NoteItem& n) { return n.id; }
+    static QJsonObject toRemote(const NoteItem& n);
+    static NoteItem fromRemote(const QJsonObject& o);
+    static QJsonObject toLocal(const NoteItem& n);
+    static NoteItem fromLocal(const QJsonObject& o);
 };
 
-class NotesManager : public QObject {
+class NotesManager : public SyncedCollection<NoteTraits> {
     Q_OBJECT
 public:
     explicit NotesManager(QObject* parent = nullptr);
-    QVector<NoteItem> notes() const;
+    QVector<NoteItem> notes() const { return items(); }
     void addNote(const QString& title, const QString& content, const QString& workspace = QString(), const QString& id = QString());
     void editNote(int index, const QString& title, const QString& content);
-    void removeNote(int index);
-
-    void setSupabaseConfig(const QString& supabaseUrl, const QString& anonKey);
-    void setAuthManager(AuthManager* auth);
-
-public slots:
-    void syncFromSupabase();
-    void syncPending();
-
-    // Conflict handling
-    QList<int> conflictIndices() const;
-    void retrySync(int index);
-    void keepLocal(int index);
-    void keepRemote(int index);
-
-    // Undo / delete with undo
-    void removeNoteWithUndo(int index);
-    void undoLastRemove();
-    bool hasPendingUndo() const;
+    void removeNote(int index) { remove(index); }
+    void removeNoteWithUndo(int index) { removeWithUndo(index); }
 
 signals:
     void notesUpdated();
-    void syncPendingCountChanged(int count);
-    void lastRemoveAvailable(bool available);
-
-private:
-private:
-    void load();
-    void save();
-
-    QVector<NoteItem> m_notes;
-    QString m_filePath;
-
-    QString m_supabaseUrl;
-    QString m_anonKey;
-    AuthManager* m_auth;
-    QNetworkAccessManager* m_net;
-
-    int pendingCount() const;
-};
\ No newline at end of file
+};
@@ -0,0 +1,36 @@
+#include "NotesModel.h"
+
+NotesModel::NotesModel(NotesManager* manager, QObject* parent)
+    : SyncedCollectionModel<NoteTraits>(manager, parent) {}
+
+QVariant NotesModel::data(const QModelIndex& index, int role) const {
+    if (!index.isValid() || index.row() >= rowCount()) return QVariant();
+    const NoteItem &n = item(index.row());
+    switch (role) {
+    case Qt::DisplayRole:
+        return index.column() == TitleColumn ? n.title : n.content.left(kSummaryLength);
+    case Qt::ToolTipRole:
+        return index.column() == SummaryColumn && n.content.size() > kSummaryLength ? QVariant(n.content) : QVariant();
+    case Qt::ForegroundRole:
+        return index.column() == TitleColumn ? foregroundFor(n.status) : QVariant();
+    case LocalIdRole: return m_localIds.at(index.row());
+    case SyncStatusRole: return int(n.status);
+    case WorkspaceRole: return n.workspace;
+    case SearchTextRole: return QString(n.title + QLatin1Char('\n') + n.content);
+    }
+    return QVariant();
+}
+
+QVariant NotesModel::headerData(int section, Qt::Orientation orientation, int role) const {
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole) return QVariant();
+    return section == TitleColumn ? QStringLiteral("Title") : QStringLiteral("Summary");
+}
+
+Qt::ItemFlags NotesModel::flags(const QModelIndex& index) const {
+    if (!index.isValid()) return Qt::NoItemFlags;
+    return Qt::ItemIsEnabled | Qt::ItemIsSelectable | Qt::ItemNeverHasChildren;
+}
+
+bool NotesModel::sameRow(const NoteItem& a, const NoteItem& b) const {
+    return a.status == b.status && a.title == b.title && a.workspace == b.workspace && a.content == b.content;
+}
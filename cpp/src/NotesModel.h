@@ -0,0 +1,22 @@
+#pragma once
+
+#include "CollectionModel.h"
+#include "NotesManager.h"
+
+// Notes for item views: the title and the start of the content.
+class NotesModel : public SyncedCollectionModel<NoteTraits> {
+    Q_OBJECT
+public:
+    enum Column { TitleColumn, SummaryColumn, ColumnCount };
+    static constexpr int kSummaryLength = 120;
+
+    explicit NotesModel(NotesManager* manager, QObject* parent = nullptr);
+
+    int columnCount(const QModelIndex& parent = QModelIndex()) const override { return parent.isValid() ? 0 : ColumnCount; }
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+    Qt::ItemFlags flags(const QModelIndex& index) const override;
+
+protected:
+    bool sameRow(const NoteItem& a, const NoteItem& b) const override;
+};
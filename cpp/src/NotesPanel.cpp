@@ -1,16 +1,25 @@
 #include "NotesPanel.h"
 #include "NotesManager.h"
+#include "NotesModel.h"
+#include "CollectionFilterBar.h"
+#include "CollectionFilterModel.h"
 #include <QVBoxLayout>
-#include <QTreeWidget>
+#include <QTreeView>
 #include <QPushButton>
 #include <QInputDialog>
 #include <QMenu>
 
 NotesPanel::NotesPanel(NotesManager* manager, QWidget* parent): QWidget(parent), m_manager(manager) {
+    m_model = new NotesModel(m_manager, this);
+    m_filter = new CollectionFilterModel(this);
+    m_filter->setSourceModel(m_model);
+
     auto *lay = new QVBoxLayout(this);
-    m_list = new QTreeWidget(this);
-    m_list->setColumnCount(2);
-    m_list->setHeaderLabels({"Title","Summary"});
+    lay->addWidget(new CollectionFilterBar(m_model, m_filter, false, this));
+    m_list = new QTreeView(this);
+    m_list->setRootIsDecorated(false);
+    m_list->setUniformRowHeights(true);
+    m_list->setModel(m_filter);
     lay->addWidget(m_list);
 
     auto *btnLay = new QHBoxLayout();
@@ -25,47 +34,36 @@ NotesPanel::NotesPanel(NotesManager* manager, QWidget* parent): QWidget(parent),
     connect(addBtn, &QPushButton::clicked, this, &NotesPanel::onAdd);
     connect(editBtn, &QPushButton::clicked, this, &NotesPanel::onEdit);
     connect(delBtn, &QPushButton::clicked, this, &NotesPanel::onDelete);
-    connect(m_manager, &NotesManager::notesUpdated, this, &NotesPanel::refresh);
 
     m_list->setContextMenuPolicy(Qt::CustomContextMenu);
-    connect(m_list, &QTreeWidget::customContextMenuRequested, this, [this](const QPoint &p){
-        auto item = m_list->itemAt(p);
-        if (!item) return;
+    connect(m_list, &QTreeView::customContextMenuRequested, this, [this](const QPoint &p){
+        const QModelIndex row = m_list->indexAt(p);
+        if (!row.isValid()) return;
         QMenu menu(this);
         QAction *open = menu.addAction("Open");
         QAction *edit = menu.addAction("Edit");
         QAction *del = menu.addAction("Delete");
         QAction *selected = menu.exec(m_list->viewport()->mapToGlobal(p));
-        int idx = item->data(0, Qt::UserRole).toInt();
+        const int idx = noteIndex(row);
+        if (idx < 0) return;
         if (selected == open) emit editRequested(idx);
-        else if (selected == edit) { m_list->setCurrentItem(item); onEdit(); }
-        else if (selected == del) { m_list->setCurrentItem(item); onDelete(); }
+        else if (selected == edit) { m_list->setCurrentIndex(row); onEdit(); }
+        else if (selected == del) { m_list->setCurrentIndex(row); onDelete(); }
     });
 
-    connect(m_list, &QTreeWidget::itemActivated, this, [this](QTreeWidgetItem* item, int){
-        if (!item) return;
-        int idx = item->data(0, Qt::UserRole).toInt();
-        emit editRequested(idx);
+    connect(m_list, &QTreeView::activated, this, [this](const QModelIndex& row){
+        const int idx = noteIndex(row);
+        if (idx >= 0) emit editRequested(idx);
     });
-
-    refresh();
 }
 
 void NotesPanel::refresh() {
-    m_list->clear();
-    auto items = m_manager->notes();
-    for (int i=0;i<items.size();++i) {
-        const auto &n = items[i];
-        auto *it = new QTreeWidgetItem(m_list);
-        it->setText(0, n.title);
-        QString summary = n.content.left(120);
-        it->setText(1, summary);
-        it->setData(0, Qt::UserRole, i);
-        if (n.status == SyncStatusNote::Unsynced) it->setForeground(0, QBrush(QColor(0, 102, 204)));
-        else if (n.status == SyncStatusNote::Syncing) it->setForeground(0, QBrush(QColor(255,165,0)));
-        else if (n.status == SyncStatusNote::Conflict) it->setForeground(0, QBrush(QColor(200,0,0)));
-    }
-    m_list->expandAll();
+    m_model->update();
+}
+
+int NotesPanel::noteIndex(const QModelIndex& row) const {
+    if (!row.isValid()) return -1;
+    return m_manager->indexOfLocalId(row.siblingAtColumn(0).data(CollectionModel::LocalIdRole).toString());
 }
 
 void NotesPanel::onAdd() {
@@ -78,23 +76,21 @@ void NotesPanel::onAdd() {
 }
 
 void NotesPanel::onEdit() {
-    auto item = m_list->currentItem();
-    if (!item) return;
-    int idx = item->data(0, Qt::UserRole).toInt();
-    auto items = m_manager->notes();
-    if (idx < 0 || idx >= items.size()) return;
+    const int idx = noteIndex(m_list->currentIndex());
+    if (idx < 0) return;
+    const NoteItem note = m_manager->notes().at(idx);
+    const QString localId = m_manager->localIds().at(idx);
     bool ok;
-    QString title = QInputDialog::getText(this, "Edit Note", "Title:", QLineEdit::Normal, items[idx].title, &ok);
+    QString title = QInputDialog::getText(this, "Edit Note", "Title:", QLineEdit::Normal, note.title, &ok);
     if (!ok || title.isEmpty()) return;
-    QString content = QInputDialog::getText(this, "Edit Note", "Content:", QLineEdit::Normal, items[idx].content, &ok);
+    QString content = QInputDialog::getText(this, "Edit Note", "Content:", QLineEdit::Normal, note.content, &ok);
     if (!ok) return;
-    m_manager->editNote(idx, title, content);
+    // the dialogs ran an event loop: a sync may have moved the note meanwhile
+    m_manager->editNote(m_manager->indexOfLocalId(localId), title, content);
 }
 
 void NotesPanel::onDelete() {
-    auto item = m_list->currentItem();
-    if (!item) return;
-    int idx = item->data(0, Qt::UserRole).toInt();
+    const int idx = noteIndex(m_list->currentIndex());
     if (idx < 0) return;
     m_manager->removeNoteWithUndo(idx);
-}
\ No newline at end of file
+}
@@ -2,7 +2,9 @@
 
 #include <QWidget>
 class NotesManager;
-class QTreeWidget;
+class NotesModel;
+class CollectionFilterModel;
+class QTreeView;
 
 class NotesPanel : public QWidget {
     Q_OBJECT
@@ -12,13 +14,21 @@ public:
 signals:
     void editRequested(int index);
 
-private slots:
+public slots:
+    // show the manager's changes now rather than on the next frame
     void refresh();
+
+private slots:
     void onAdd();
     void onEdit();
     void onDelete();
 
 private:
+    // the manager's index of the note in row, -1 for none
+    int noteIndex(const QModelIndex& row) const;
+
     NotesManager* m_manager;
-    QTreeWidget* m_list;
-};
\ No newline at end of file
+    NotesModel* m_model;
+    CollectionFilterModel* m_filter;
+    QTreeView* m_list;
+};
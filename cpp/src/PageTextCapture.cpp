@@ -0,0 +1,81 @@
+#include "PageTextCapture.h"
+#include "PageTextIndex.h"
+#include "Trace.h"
+#include <QTimer>
+#include <QWebEnginePage>
+#include <QWebEngineScript>
+
+namespace {
+// The main content when the page marks it, else the whole body; innerText
+// leaves out hidden elements, scripts and styles.
+const char* kReadableTextScript = R"JS(
+(function(max) {
+    var root = document.querySelector('article, main, [role="main"]') || document.body;
+    if (!root) return '';
+    var text = root.innerText || '';
+    return text.length > max ? text.slice(0, max) : text;
+})(%1)
+)JS";
+
+// entries in m_recent before old ones are forgotten
+constexpr int kMaxRecent = 1000;
+}
+
+PageTextCapture::PageTextCapture(PageTextIndex* index, QObject* parent)
+    : QObject(parent), m_index(index), m_timer(new QTimer(this)) {
+    m_clock.start();
+    m_timer->setSingleShot(true);
+    connect(m_timer, &QTimer::timeout, this, &PageTextCapture::captureNext);
+}
+
+void PageTextCapture::pageLoaded(QWebEnginePage* page) {
+    if (!m_index->captureEnabled() || !page) return;
+    const QUrl url = page->url();
+    if (url.scheme() != "http" && url.scheme() != "https") return;
+    const auto recent = m_recent.constFind(url.toString());
+    if (recent != m_recent.constEnd() && m_clock.elapsed() - *recent < kRecaptureSecs * 1000LL) return;
+
+    // a later load of the same page replaces its earlier one
+    for (int i = m_queue.size() - 1; i >= 0; --i) {
+        if (!m_queue[i].page || m_queue[i].page == page) m_queue.remove(i);
+    }
+    if (m_queue.size() >= kMaxQueued) m_queue.removeFirst();
+    m_queue.append(Pending{page, url, m_clock.elapsed() + kSettleMs});
+    schedule();
+}
+
+void PageTextCapture::schedule() {
+    if (m_reading || m_queue.isEmpty() || m_timer->isActive()) return;
+    m_timer->start(int(qMax<qint64>(0, m_queue.first().dueMs - m_clock.elapsed())));
+}
+
+void PageTextCapture::captureNext() {
+    if (m_queue.isEmpty()) return;
+    const Pending p = m_queue.takeFirst();
+    // closed, navigated away, or frozen in the background since
+    if (!p.page || p.page->url() != p.url || p.page->lifecycleState() != QWebEnginePage::LifecycleState::Active
+        || !m_index->captureEnabled()) {
+        schedule();
+        return;
+    }
+    FLOW_TRACE_SCOPE("PageTextCapture::capture");
+    m_reading = p.page;
+    if (m_recent.size() >= kMaxRecent) m_recent.clear();
+    m_recent.insert(p.url.toString(), m_clock.elapsed());
+    const QString script = QString::fromLatin1(kReadableTextScript).arg(PageTextIndex::kMaxTextChars);
+    QPointer<QWebEnginePage> page = p.page;
+    const QUrl url = p.url;
+    // the page can outlive the capture (shared profile pages at shutdown)
+    QPointer<PageTextCapture> self(this);
+    page->runJavaScript(script, QWebEngineScript::ApplicationWorld, [self, page, url](const QVariant &v){
+        if (!self) return;
+        self->m_reading = nullptr;
+        const QString text = v.toString();
+        if (page && text.trimmed().size() >= kMinChars) self->m_index->store(url.toString(), page->title(), text);
+        // the next read waits a little, whatever the queue holds
+        if (!self->m_queue.isEmpty()) {
+            self->m_queue.first().dueMs = qMax(self->m_queue.first().dueMs, self->m_clock.elapsed() + kSpacingMs);
+            self->schedule();
+        }
+    });
+}
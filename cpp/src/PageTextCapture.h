@@ -0,0 +1,52 @@
+#pragma once
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QPointer>
+#include <QUrl>
+#include <QVector>
+
+class QWebEnginePage;
+class QTimer;
+class PageTextIndex;
+
+// Reads the readable text of loaded pages into PageTextIndex, away from the
+// page load: a page is read once it has settled for a while after
+// loadFinished, one page at a time with a pause between reads, from the
+// application script world. The text is cut to PageTextIndex::kMaxTextChars
+// inside the renderer, so a huge page never crosses over whole. A URL read
+// recently is not read again.
+class PageTextCapture : public QObject {
+    Q_OBJECT
+public:
+    explicit PageTextCapture(PageTextIndex* index, QObject* parent = nullptr);
+
+    // queue page for reading; call on loadFinished of a recorded visit
+    void pageLoaded(QWebEnginePage* page);
+
+    static constexpr int kSettleMs = 2000;
+    static constexpr int kSpacingMs = 1000;
+    static constexpr int kRecaptureSecs = 30 * 60;
+    // pages with less text are navigation shells, not something read
+    static constexpr int kMinChars = 200;
+    static constexpr int kMaxQueued = 16;
+
+private:
+    struct Pending {
+        QPointer<QWebEnginePage> page;
+        QUrl url;
+        qint64 dueMs;
+    };
+    void captureNext();
+    void schedule();
+
+    PageTextIndex* m_index;
+    QTimer* m_timer;
+    QElapsedTimer m_clock;
+    QVector<Pending> m_queue;
+    // the page being read; cleared by the answer, or when the page goes
+    QPointer<QWebEnginePage> m_reading;
+    // URL -> when it was last read (m_clock ms)
+    QHash<QString, qint64> m_recent;
+};
@@ -0,0 +1,248 @@
+#include "PageTextIndex.h"
+#include "StorageExecutor.h"
+#include "MetricsRegistry.h"
+#include "Trace.h"
+#include <QDateTime>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QVariant>
+
+namespace {
+const char* const kCaptureSetting = "page_text_capture";
+// pages evicted per round while over budget
+constexpr int kEvictBatch = 32;
+
+// shown on flow://performance
+struct PageTextMetrics {
+    MetricsRegistry::Counter* stored = MetricsRegistry::counter("page_text.stored");
+    MetricsRegistry::Counter* evicted = MetricsRegistry::counter("page_text.evicted");
+    MetricsRegistry::Gauge* bytes = MetricsRegistry::gauge("page_text.bytes");
+    MetricsRegistry::Histogram* searchMs = MetricsRegistry::histogram("page_text.search_ms");
+};
+
+const PageTextMetrics& metrics() {
+    static const PageTextMetrics m;
+    return m;
+}
+
+QString unpack(const QVariant& body) {
+    return QString::fromUtf8(qUncompress(body.toByteArray()));
+}
+
+// a contentless FTS5 table forgets a row only when given what it indexed
+bool unindex(QSqlDatabase db, qint64 id, const QString& title, const QString& text) {
+    QSqlQuery q(db);
+    q.prepare("INSERT INTO page_text_fts (page_text_fts, rowid, title, body) VALUES ('delete', ?, ?, ?)");
+    q.addBindValue(id);
+    q.addBindValue(title);
+    q.addBindValue(text);
+    return q.exec();
+}
+
+// drop the least recently visited pages until both limits hold
+void enforceBudget(QSqlDatabase db, qint64 budgetBytes, int maxPages) {
+    QSqlQuery q(db);
+    if (!q.exec("SELECT COUNT(*), COALESCE(SUM(bytes), 0) FROM page_text") || !q.next()) return;
+    int pages = q.value(0).toInt();
+    qint64 bytes = q.value(1).toLongLong();
+    while (pages > maxPages || bytes > budgetBytes) {
+        QSqlQuery oldest(db);
+        oldest.prepare("SELECT id, title, body, bytes FROM page_text ORDER BY last_used, id LIMIT ?");
+        oldest.addBindValue(kEvictBatch);
+        if (!oldest.exec()) return;
+        int dropped = 0;
+        while ((pages > maxPages || bytes > budgetBytes) && oldest.next()) {
+            const qint64 id = oldest.value(0).toLongLong();
+            unindex(db, id, oldest.value(1).toString(), unpack(oldest.value(2)));
+            QSqlQuery del(db);
+            del.prepare("DELETE FROM page_text WHERE id = ?");
+            del.addBindValue(id);
+            del.exec();
+            bytes -= oldest.value(3).toLongLong();
+            --pages;
+            ++dropped;
+        }
+        metrics().evicted->add(dropped);
+        if (!dropped) break;
+    }
+    metrics().bytes->set(double(bytes));
+}
+
+bool isWordChar(QChar c) { return c.isLetterOrNumber(); }
+
+QString escaped(const QString& s) { return s.toHtmlEscaped(); }
+}
+
+PageTextIndex::PageTextIndex(QObject* parent): QObject(parent) {
+    StorageExecutor::instance()->read<QString>(this, [](Storage& s){ return s.value(kCaptureSetting, "1"); },
+                                               [this](QString v){
+        m_captureEnabled = v != "0";
+        emit captureEnabledChanged(m_captureEnabled);
+    });
+}
+
+void PageTextIndex::setCaptureEnabled(bool enabled) {
+    if (enabled == m_captureEnabled) return;
+    m_captureEnabled = enabled;
+    const QString v = enabled ? "1" : "0";
+    StorageExecutor::instance()->write(this, [v](Storage& s){ return s.setValue(kCaptureSetting, v); });
+    emit captureEnabledChanged(enabled);
+}
+
+void PageTextIndex::setBudget(qint64 bytes, int pages) {
+    m_budgetBytes = bytes;
+    m_maxPages = pages;
+}
+
+void PageTextIndex::store(const QString& url, const QString& title, const QString& text) {
+    const QString capped = text.left(kMaxTextChars);
+    const qint64 hash = qint64(qHash(capped));
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    const qint64 budget = m_budgetBytes;
+    const int maxPages = m_maxPages;
+    StorageExecutor::instance()->run([url, title, capped, hash, now, budget, maxPages](Storage& s){
+        FLOW_TRACE_SCOPE("PageTextIndex::store");
+        QSqlDatabase db = s.history();
+        QSqlQuery q(db);
+        q.prepare("SELECT id, title, body, text_hash FROM page_text WHERE url = ?");
+        q.addBindValue(url);
+        if (!q.exec()) return;
+        const bool known = q.next();
+        if (known && q.value(3).toLongLong() == hash && q.value(1).toString() == title) {
+            QSqlQuery touch(db);
+            touch.prepare("UPDATE page_text SET last_used = ? WHERE id = ?");
+            touch.addBindValue(now);
+            touch.addBindValue(q.value(0));
+            touch.exec();
+            return;
+        }
+
+        // compressing outside the transaction keeps it short
+        const QByteArray body = qCompress(capped.toUtf8());
+        db.transaction();
+        qint64 id;
+        QSqlQuery write(db);
+        if (known) {
+            id = q.value(0).toLongLong();
+            unindex(db, id, q.value(1).toString(), unpack(q.value(2)));
+            write.prepare("UPDATE page_text SET title = ?, body = ?, bytes = ?, text_hash = ?, last_used = ? WHERE id = ?");
+            write.addBindValue(title);
+            write.addBindValue(body);
+            write.addBindValue(body.size());
+            write.addBindValue(hash);
+            write.addBindValue(now);
+            write.addBindValue(id);
+            if (!write.exec()) { db.rollback(); return; }
+        } else {
+            write.prepare("INSERT INTO page_text (url, title, body, bytes, text_hash, last_used) VALUES (?, ?, ?, ?, ?, ?)");
+            write.addBindValue(url);
+            write.addBindValue(title);
+            write.addBindValue(body);
+            write.addBindValue(body.size());
+            write.addBindValue(hash);
+            write.addBindValue(now);
+            if (!write.exec()) { db.rollback(); return; }
+            id = write.lastInsertId().toLongLong();
+        }
+        QSqlQuery fts(db);
+        fts.prepare("INSERT INTO page_text_fts (rowid, title, body) VALUES (?, ?, ?)");
+        fts.addBindValue(id);
+        fts.addBindValue(title);
+        fts.addBindValue(capped);
+        if (!fts.exec()) {
+            qWarning() << "Failed to index page text:" << fts.lastError().text();
+            db.rollback();
+            return;
+        }
+        enforceBudget(db, budget, maxPages);
+        db.commit();
+        metrics().stored->add();
+    });
+}
+
+void PageTextIndex::search(const QString& query, int maxResults, QObject* context, std::function<void(const QVector<PageTextHit>&)> done) {
+    const QString match = ftsQuery(query);
+    const QStringList terms = queryTerms(query);
+    if (match.isEmpty()) { if (done) done({}); return; }
+    StorageExecutor::instance()->read<QVector<PageTextHit>>(context, [match, terms, maxResults](Storage& s){
+        FLOW_TRACE_SCOPE("PageTextIndex::search query");
+        QElapsedTimer timer;
+        timer.start();
+        QVector<PageTextHit> hits;
+        QSqlQuery q(s.history());
+        // bm25 ranks a title match ten times a body match
+        q.prepare("SELECT p.url, p.title, p.body FROM page_text_fts JOIN page_text p ON p.id = page_text_fts.rowid "
+                  "WHERE page_text_fts MATCH ? ORDER BY bm25(page_text_fts, 10.0, 1.0) LIMIT ?");
+        q.addBindValue(match);
+        q.addBindValue(maxResults);
+        if (!q.exec()) return hits;
+        while (q.next())
+            hits.append(PageTextHit{q.value(0).toString(), q.value(1).toString(), snippet(unpack(q.value(2)), terms)});
+        metrics().searchMs->record(timer.nsecsElapsed() / 1e6);
+        return hits;
+    }, [done](QVector<PageTextHit> hits){ done(hits); });
+}
+
+QStringList PageTextIndex::queryTerms(const QString& query) {
+    QStringList out;
+    QString word;
+    for (QChar c : query) {
+        if (isWordChar(c)) { word.append(c.toLower()); continue; }
+        if (!word.isEmpty()) out.append(word);
+        word.clear();
+    }
+    if (!word.isEmpty()) out.append(word);
+    return out;
+}
+
+QString PageTextIndex::ftsQuery(const QString& query) {
+    const QStringList terms = queryTerms(query);
+    if (terms.isEmpty()) return QString();
+    // words are letters and digits only, so quoting them is enough
+    QStringList parts;
+    for (const QString &t : terms) parts.append(QString("\"%1\"").arg(t));
+    if (isWordChar(query.back())) parts.last() += "*";
+    return parts.join(' ');
+}
+
+QString PageTextIndex::snippet(const QString& text, const QStringList& terms, int width) {
+    const auto isMatch = [&terms](QStringView word){
+        for (const QString &t : terms) {
+            if (word.startsWith(t, Qt::CaseInsensitive)) return true;
+        }
+        return false;
+    };
+
+    // the first matching word
+    int first = -1;
+    for (int i = 0; i < text.size() && first < 0;) {
+        if (!isWordChar(text[i])) { ++i; continue; }
+        int end = i;
+        while (end < text.size() && isWordChar(text[end])) ++end;
+        if (isMatch(QStringView(text).mid(i, end - i))) first = i;
+        i = end;
+    }
+
+    // a little context before the match, starting at a word
+    int start = first < 0 ? 0 : qMax(0, first - width / 4);
+    while (start > 0 && start < first && isWordChar(text[start - 1])) ++start;
+    int end = qMin(int(text.size()), start + width);
+    while (end < text.size() && isWordChar(text[end]) && end - start < width + 20) ++end;
+
+    QString out;
+    if (start > 0) out += QStringLiteral("… ");
+    const QString piece = text.mid(start, end - start).simplified();
+    for (int i = 0; i < piece.size();) {
+        if (!isWordChar(piece[i])) { out += escaped(piece.mid(i, 1)); ++i; continue; }
+        int w = i;
+        while (w < piece.size() && isWordChar(piece[w])) ++w;
+        const QString word = piece.mid(i, w - i);
+        out += isMatch(word) ? "<b>" + escaped(word) + "</b>" : escaped(word);
+        i = w;
+    }
+    if (end < text.size()) out += QStringLiteral(" …");
+    return out;
+}
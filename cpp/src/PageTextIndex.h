@@ -0,0 +1,60 @@
+#pragma once
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <functional>
+
+struct PageTextHit {
+    QString url;
+    QString title;
+    QString snippet;  // HTML: escaped text with the matched words in <b>
+};
+
+// The readable text of visited pages in history.db, for "search what I read".
+// Each page keeps one row with its text compressed; a contentless FTS5 table
+// indexes it, so the text is stored only once. Snippets are cut from the
+// decompressed text of the few pages a query returns.
+//
+// Storage stays bounded: a page contributes at most kMaxTextChars, and once
+// the pages together pass the byte budget or the page limit the least
+// recently visited ones are dropped.
+class PageTextIndex : public QObject {
+    Q_OBJECT
+public:
+    explicit PageTextIndex(QObject* parent = nullptr);
+
+    // Index a page's text; text the page already had only marks it as used.
+    void store(const QString& url, const QString& title, const QString& text);
+    // done runs on context's thread, unless context is gone by then
+    void search(const QString& query, int maxResults, QObject* context, std::function<void(const QVector<PageTextHit>&)> done);
+
+    // whether pages are captured at all; kept in the profile
+    bool captureEnabled() const { return m_captureEnabled; }
+    void setCaptureEnabled(bool enabled);
+
+    // compressed bytes and pages kept before the least recently visited go
+    void setBudget(qint64 bytes, int pages);
+
+    // exposed for tests
+    // an FTS5 query matching every word, the last one as a prefix while typed
+    static QString ftsQuery(const QString& query);
+    // about width characters of text around the first match, HTML-escaped,
+    // with words starting with one of terms in <b>
+    static QString snippet(const QString& text, const QStringList& terms, int width = 200);
+    // lower-case words of a query
+    static QStringList queryTerms(const QString& query);
+
+    static constexpr int kMaxTextChars = 100000;
+    static constexpr qint64 kDefaultBudgetBytes = 64 * 1024 * 1024;
+    static constexpr int kDefaultMaxPages = 20000;
+
+signals:
+    void captureEnabledChanged(bool enabled);
+
+private:
+    bool m_captureEnabled = true;
+    qint64 m_budgetBytes = kDefaultBudgetBytes;
+    int m_maxPages = kDefaultMaxPages;
+};
@@ -0,0 +1,163 @@
+#include "ProfileManager.h"
+#include <QWebEngineProfile>
+#include <QWebEnginePage>
+#include <QWebEngineScript>
+#include <QCoreApplication>
+#include <QStandardPaths>
+#include <QDir>
+#include <QFile>
+#include <QJsonDocument>
+#include <QPointer>
+#include <climits>
+
+namespace {
+
+// [transferSize, encodedBodySize, decodedBodySize] for the document and every subresource
+const char* kResourceTimingScript = R"JS(
+(function() {
+    var out = [];
+    var add = function(e) { out.push([e.transferSize, e.encodedBodySize, e.decodedBodySize]); };
+    performance.getEntriesByType('navigation').forEach(add);
+    performance.getEntriesByType('resource').forEach(add);
+    return out;
+})()
+)JS";
+
+QJsonObject statsToJson(const CacheStats& s) {
+    QJsonObject o;
+    o["resources"] = s.resources;
+    o["hits"] = s.hits;
+    o["revalidated"] = s.revalidated;
+    o["misses"] = s.misses;
+    o["opaque"] = s.opaque;
+    o["bytes_from_cache"] = s.bytesFromCache;
+    o["bytes_from_network"] = s.bytesFromNetwork;
+    o["hit_rate"] = s.hitRate();
+    return o;
+}
+
+} // namespace
+
+ProfileManager* ProfileManager::instance() {
+    static QPointer<ProfileManager> s_instance;
+    if (!s_instance) s_instance = new ProfileManager(QCoreApplication::instance());
+    return s_instance;
+}
+
+ProfileManager::ProfileManager(QObject* parent): QObject(parent) {
+    QString dataDir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    QDir().mkpath(dataDir);
+    m_configPath = QDir(dataDir).filePath("profile.json");
+
+    // a named profile is disk-backed; an unnamed one is off-the-record
+    m_persistent = new QWebEngineProfile("flow", this);
+    m_incognito = new QWebEngineProfile(this);
+    m_incognito->setHttpCacheType(QWebEngineProfile::MemoryHttpCache);
+    m_incognito->setPersistentCookiesPolicy(QWebEngineProfile::NoPersistentCookies);
+
+    loadConfig();
+}
+
+void ProfileManager::loadConfig() {
+    ProfileConfig cfg;
+    QFile f(m_configPath);
+    if (f.open(QIODevice::ReadOnly)) {
+        QJsonDocument doc = QJsonDocument::fromJson(f.readAll());
+        f.close();
+        if (doc.isObject()) cfg = configFromJson(doc.object());
+    }
+    applyConfig(cfg);
+}
+
+void ProfileManager::applyConfig(const ProfileConfig& cfg) {
+    m_config = cfg;
+    QString dataDir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    const QString storagePath = cfg.storagePath.isEmpty() ? QDir(dataDir).filePath("profile/storage") : cfg.storagePath;
+    const QString cachePath = cfg.cachePath.isEmpty() ? QDir(dataDir).filePath("profile/cache") : cfg.cachePath;
+    m_persistent->setPersistentStoragePath(storagePath);
+    m_persistent->setCachePath(cachePath);
+    if (cfg.httpCacheType == "memory") m_persistent->setHttpCacheType(QWebEngineProfile::MemoryHttpCache);
+    else if (cfg.httpCacheType == "none") m_persistent->setHttpCacheType(QWebEngineProfile::NoCache);
+    else m_persistent->setHttpCacheType(QWebEngineProfile::DiskHttpCache);
+    m_persistent->setHttpCacheMaximumSize(int(qBound<qint64>(0, cfg.httpCacheMaxBytes, INT_MAX)));
+    m_persistent->setPersistentCookiesPolicy(QWebEngineProfile::AllowPersistentCookies);
+}
+
+void ProfileManager::saveConfig() const {
+    QFile f(m_configPath);
+    if (f.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        f.write(QJsonDocument(configToJson(m_config)).toJson());
+        f.close();
+    }
+}
+
+ProfileConfig ProfileManager::configFromJson(const QJsonObject& o) {
+    ProfileConfig cfg;
+    const QString type = o.value("http_cache_type").toString(cfg.httpCacheType);
+    if (type == "disk" || type == "memory" || type == "none") cfg.httpCacheType = type;
+    cfg.httpCacheMaxBytes = qint64(o.value("http_cache_max_mb").toDouble(0)) * 1024 * 1024;
+    cfg.cachePath = o.value("cache_path").toString();
+    cfg.storagePath = o.value("storage_path").toString();
+    return cfg;
+}
+
+QJsonObject ProfileManager::configToJson(const ProfileConfig& cfg) {
+    QJsonObject o;
+    o["http_cache_type"] = cfg.httpCacheType;
+    o["http_cache_max_mb"] = double(cfg.httpCacheMaxBytes / (1024 * 1024));
+    o["cache_path"] = cfg.cachePath;
+    o["storage_path"] = cfg.storagePath;
+    return o;
+}
+
+void ProfileManager::collectCacheStats(QWebEnginePage* page) {
+    if (!page) return;
+    const bool incognito = page->profile() == m_incognito;
+    page->runJavaScript(kResourceTimingScript, QWebEngineScript::ApplicationWorld, [this, incognito](const QVariant &v){
+        accumulate(v.toList(), incognito ? m_incognitoStats : m_stats);
+        emit cacheStatsChanged();
+    });
+}
+
+void ProfileManager::accumulate(const QVariantList& entries, CacheStats& stats) {
+    for (const QVariant &e : entries) {
+        const QVariantList f = e.toList();
+        if (f.size() < 3) continue;
+        const qint64 transfer = f[0].toLongLong();
+        const qint64 encoded = f[1].toLongLong();
+        const qint64 decoded = f[2].toLongLong();
+        ++stats.resources;
+        if (transfer == 0 && decoded == 0) {
+            ++stats.opaque;
+        } else if (transfer == 0) {
+            ++stats.hits;
+            stats.bytesFromCache += encoded;
+        } else if (transfer <= encoded) {
+            // only headers crossed the wire; the body came from cache
+            ++stats.revalidated;
+            stats.bytesFromCache += encoded;
+            stats.bytesFromNetwork += transfer;
+        } else {
+            ++stats.misses;
+            stats.bytesFromNetwork += transfer;
+        }
+    }
+}
+
+CacheStats ProfileManager::cacheStats(bool incognito) const { return incognito ? m_incognitoStats : m_stats; }
+
+void ProfileManager::resetCacheStats() {
+    m_stats = CacheStats();
+    m_incognitoStats = CacheStats();
+    emit cacheStatsChanged();
+}
+
+QJsonObject ProfileManager::toJson() const {
+    QJsonObject o;
+    o["config"] = configToJson(m_config);
+    o["cache_path"] = m_persistent->cachePath();
+    o["http_cache_max_bytes"] = m_persistent->httpCacheMaximumSize();
+    o["persistent"] = statsToJson(m_stats);
+    o["incognito"] = statsToJson(m_incognitoStats);
+    return o;
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <QObject>
+#include <QString>
+#include <QJsonObject>
+
+class QWebEngineProfile;
+class QWebEnginePage;
+
+struct ProfileConfig {
+    QString httpCacheType = "disk"; // "disk", "memory" or "none"
+    qint64 httpCacheMaxBytes = 0;   // 0 lets Chromium size the cache
+    QString cachePath;              // empty = <AppDataLocation>/profile/cache
+    QString storagePath;            // empty = <AppDataLocation>/profile/storage
+};
+
+// HTTP cache effectiveness, derived from the Resource Timing entries of loaded pages.
+// Cross-origin responses without Timing-Allow-Origin report no sizes and count as opaque.
+struct CacheStats {
+    qint64 resources = 0;
+    qint64 hits = 0;        // served from cache without touching the network
+    qint64 revalidated = 0; // conditional request answered with headers only (304)
+    qint64 misses = 0;
+    qint64 opaque = 0;
+    qint64 bytesFromCache = 0;
+    qint64 bytesFromNetwork = 0;
+    double hitRate() const {
+        const qint64 known = hits + revalidated + misses;
+        return known > 0 ? double(hits) / known : 0.0;
+    }
+};
+
+// Owns the browser's two QWebEngineProfiles, shared by every window: a persistent
+// profile with a configurable HTTP cache, and one off-the-record profile that keeps
+// cache and cookies in memory for incognito tabs and windows.
+class ProfileManager : public QObject {
+    Q_OBJECT
+public:
+    static ProfileManager* instance();
+
+    QWebEngineProfile* persistentProfile() const { return m_persistent; }
+    QWebEngineProfile* incognitoProfile() const { return m_incognito; }
+    QWebEngineProfile* profileFor(bool incognito) const { return incognito ? m_incognito : m_persistent; }
+
+    ProfileConfig config() const { return m_config; }
+    void applyConfig(const ProfileConfig& cfg);
+    void saveConfig() const;
+
+    // Sample resource timing from a page once it finished loading.
+    void collectCacheStats(QWebEnginePage* page);
+    CacheStats cacheStats(bool incognito = false) const;
+    void resetCacheStats();
+    QJsonObject toJson() const;
+
+    static ProfileConfig configFromJson(const QJsonObject& o);
+    static QJsonObject configToJson(const ProfileConfig& cfg);
+    // Classify [transferSize, encodedBodySize, decodedBodySize] triples into stats.
+    static void accumulate(const QVariantList& entries, CacheStats& stats);
+
+signals:
+    void cacheStatsChanged();
+
+private:
+    explicit ProfileManager(QObject* parent = nullptr);
+    void loadConfig();
+
+    QWebEngineProfile* m_persistent;
+    QWebEngineProfile* m_incognito;
+    ProfileConfig m_config;
+    QString m_configPath;
+    CacheStats m_stats;
+    CacheStats m_incognitoStats;
+};
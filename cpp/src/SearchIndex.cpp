@@ -0,0 +1,324 @@
+#include "SearchIndex.h"
+#include <QRegularExpression>
+#include <QSet>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+// match quality of a query word
+constexpr float kExact = 1.0f;
+constexpr float kPrefix = 0.75f;
+constexpr float kFuzzy = 0.5f;
+
+// purge tombstones once this many have piled up and they are a quarter of all
+constexpr int kMinDeadToPurge = 1024;
+
+// scheme and host noise every URL carries
+bool isUrlNoise(const QString& term) {
+    return term == QLatin1String("http") || term == QLatin1String("https") || term == QLatin1String("www");
+}
+
+// at most one insertion, deletion, substitution or swap of neighbours apart
+bool withinOneEdit(const QString& a, const QString& b) {
+    const int la = a.size(), lb = b.size();
+    if (qAbs(la - lb) > 1) return false;
+    int i = 0;
+    while (i < la && i < lb && a[i] == b[i]) ++i;
+    if (i == la || i == lb) return qAbs(la - lb) <= 1;
+    if (la == lb) {
+        // substitution, or a swap of a[i] and a[i + 1]
+        if (QStringView(a).mid(i + 1) == QStringView(b).mid(i + 1)) return true;
+        return i + 1 < la && a[i] == b[i + 1] && a[i + 1] == b[i] && QStringView(a).mid(i + 2) == QStringView(b).mid(i + 2);
+    }
+    const QString& longer = la > lb ? a : b;
+    const QString& shorter = la > lb ? b : a;
+    return QStringView(longer).mid(i + 1) == QStringView(shorter).mid(i);
+}
+
+// the per-word score of a match
+float fieldScore(float quality, quint8 fields) {
+    // a title match counts twice a text match
+    return quality * ((fields & 1) ? 2.0f : 1.0f);
+}
+}
+
+SearchIndex::SearchIndex() {
+    // bookmarks and notes were saved on purpose; history is everything
+    m_sourceWeight = {1.0, 1.5, 1.2, 1.1};
+}
+
+QStringList SearchIndex::tokenize(const QString& text) {
+    QString s = text.left(kMaxTextLength);
+    bool ascii = true;
+    for (QChar c : std::as_const(s)) {
+        if (c.unicode() >= 0x80) { ascii = false; break; }
+    }
+    // decomposed, an accent is a mark of its own and dropped below
+    if (!ascii) s = s.normalized(QString::NormalizationForm_KD);
+    QStringList out;
+    QString word;
+    for (QChar c : std::as_const(s)) {
+        if (c.isLetterOrNumber()) {
+            word.append(c.toCaseFolded());
+        } else if (c.category() == QChar::Mark_NonSpacing) {
+            continue;
+        } else if (!word.isEmpty()) {
+            out.append(word);
+            word.clear();
+        }
+    }
+    if (!word.isEmpty()) out.append(word);
+    return out;
+}
+
+bool SearchIndex::upsert(const SearchDocument& doc) {
+    const size_t hash = qHashMulti(0, doc.title, doc.text, doc.subtitle, doc.weight, doc.popularity);
+    QHash<QString, quint32>& byKey = m_byKey[int(doc.source)];
+    const auto existing = byKey.constFind(doc.key);
+    if (existing != byKey.constEnd()) {
+        if (m_docs[*existing].hash == hash) return false;
+        // the old version stays in the postings as a tombstone until purged
+        kill(*existing);
+    }
+
+    quint32 id;
+    if (!m_freeDocs.isEmpty()) {
+        id = m_freeDocs.takeLast();
+    } else {
+        id = quint32(m_docs.size());
+        m_docs.append(Doc());
+    }
+    Doc &d = m_docs[id];
+    d.data = doc;
+    d.data.text = doc.text.left(kMaxTextLength);
+    d.hash = hash;
+    d.alive = true;
+    byKey.insert(doc.key, id);
+
+    QHash<QString, quint8> terms;
+    for (const QString &t : tokenize(doc.title)) terms[t] |= TitleField;
+    for (const QString &t : tokenize(d.data.text)) {
+        if (!isUrlNoise(t)) terms[t] |= TextField;
+    }
+    for (auto it = terms.constBegin(); it != terms.constEnd(); ++it) {
+        QVector<Posting> &list = m_postings[it.key()];
+        const Posting p{id, it.value()};
+        // new documents take the highest id, so this is nearly always an append
+        if (list.isEmpty() || list.last().doc < id) list.append(p);
+        else list.insert(std::lower_bound(list.begin(), list.end(), p), p);
+    }
+    return true;
+}
+
+bool SearchIndex::remove(SearchSource source, const QString& key) {
+    const auto it = m_byKey[int(source)].constFind(key);
+    if (it == m_byKey[int(source)].constEnd()) return false;
+    kill(*it);
+    return true;
+}
+
+int SearchIndex::replaceSource(SearchSource source, const QVector<SearchDocument>& docs) {
+    int changed = 0;
+    QSet<QString> keep;
+    keep.reserve(docs.size());
+    for (const SearchDocument &d : docs) {
+        keep.insert(d.key);
+        if (upsert(d)) ++changed;
+    }
+    const QList<QString> keys = m_byKey[int(source)].keys();
+    for (const QString &key : keys) {
+        if (!keep.contains(key) && remove(source, key)) ++changed;
+    }
+    return changed;
+}
+
+SearchDocument SearchIndex::document(SearchSource source, const QString& key) const {
+    const auto it = m_byKey[int(source)].constFind(key);
+    if (it == m_byKey[int(source)].constEnd()) return SearchDocument();
+    return m_docs[*it].data;
+}
+
+void SearchIndex::kill(quint32 id) {
+    Doc &d = m_docs[id];
+    m_byKey[int(d.data.source)].remove(d.data.key);
+    d.alive = false;
+    m_deadDocs.append(id);
+    if (m_deadDocs.size() >= kMinDeadToPurge && m_deadDocs.size() * 4 >= m_docs.size()) purgeDead();
+}
+
+void SearchIndex::purgeDead() {
+    for (auto it = m_postings.begin(); it != m_postings.end();) {
+        QVector<Posting> &list = it.value();
+        list.erase(std::remove_if(list.begin(), list.end(), [this](const Posting& p){ return !m_docs[p.doc].alive; }), list.end());
+        if (list.isEmpty()) it = m_postings.erase(it);
+        else ++it;
+    }
+    for (quint32 id : std::as_const(m_deadDocs)) m_docs[id] = Doc();
+    m_freeDocs += m_deadDocs;
+    m_deadDocs.clear();
+}
+
+QVector<QString> SearchIndex::fuzzyTerms(const QString& word) const {
+    // typos rarely hit the first letter, so only terms sharing it are tried
+    QVector<QString> out;
+    const QString first = word.left(1);
+    for (auto it = m_postings.lowerBound(first); it != m_postings.constEnd() && it.key().startsWith(first); ++it) {
+        if (withinOneEdit(word, it.key())) out.append(it.key());
+    }
+    return out;
+}
+
+QVector<SearchIndex::Match> SearchIndex::matchWord(const QString& word, bool prefix) const {
+    // terms with the quality of a match through them
+    QVector<QPair<const QVector<Posting>*, float>> lists;
+    if (prefix) {
+        QVector<QPair<const QVector<Posting>*, float>> expanded;
+        for (auto it = m_postings.lowerBound(word); it != m_postings.constEnd() && it.key().startsWith(word); ++it)
+            expanded.append(qMakePair(&it.value(), it.key().size() == word.size() ? kExact : kPrefix));
+        if (expanded.size() > kMaxPrefixTerms) {
+            std::partial_sort(expanded.begin(), expanded.begin() + kMaxPrefixTerms, expanded.end(),
+                              [](const auto& a, const auto& b){ return a.second > b.second || (a.second == b.second && a.first->size() > b.first->size()); });
+            expanded.resize(kMaxPrefixTerms);
+        }
+        lists = expanded;
+    } else {
+        const auto it = m_postings.constFind(word);
+        if (it != m_postings.constEnd()) lists.append(qMakePair(&it.value(), kExact));
+    }
+    if (lists.isEmpty() && word.size() >= 4) {
+        for (const QString &t : fuzzyTerms(word)) lists.append(qMakePair(&m_postings.constFind(t).value(), kFuzzy));
+    }
+
+    QVector<Match> out;
+    if (lists.size() == 1) {
+        // already in id order
+        out.reserve(lists[0].first->size());
+        for (const Posting &p : *lists[0].first) {
+            if (m_docs[p.doc].alive) out.append(Match{p.doc, lists[0].second, p.fields});
+        }
+        return out;
+    }
+    for (const auto &l : std::as_const(lists)) {
+        for (const Posting &p : *l.first) {
+            if (m_docs[p.doc].alive) out.append(Match{p.doc, l.second, p.fields});
+        }
+    }
+    std::sort(out.begin(), out.end(), [](const Match& a, const Match& b){ return a.doc < b.doc; });
+    // one entry per document, the best match of the word
+    int w = 0;
+    for (int r = 0; r < out.size(); ++r) {
+        if (w > 0 && out[w - 1].doc == out[r].doc) {
+            out[w - 1].quality = qMax(out[w - 1].quality, out[r].quality);
+            out[w - 1].fields |= out[r].fields;
+        } else {
+            out[w++] = out[r];
+        }
+    }
+    out.resize(w);
+    return out;
+}
+
+bool SearchIndex::containsPhrase(const QStringList& words, const QStringList& phrase) {
+    for (int i = 0; i + phrase.size() <= words.size(); ++i) {
+        int j = 0;
+        while (j < phrase.size() && words[i + j] == phrase[j]) ++j;
+        if (j == phrase.size()) return true;
+    }
+    return false;
+}
+
+QVector<SearchHit> SearchIndex::search(const QString& query, int limit) const {
+    if (limit <= 0) return {};
+    static const QRegularExpression quoted("\"([^\"]*)\"");
+    QVector<QStringList> phrases;
+    QString rest = query;
+    for (auto m = quoted.globalMatch(query); m.hasNext();) {
+        const QStringList phrase = tokenize(m.next().captured(1));
+        if (!phrase.isEmpty()) phrases.append(phrase);
+    }
+    rest.remove(quoted);
+    // the word being typed is matched as a prefix
+    const bool typing = !query.isEmpty() && query.back().isLetterOrNumber();
+
+    struct Word { QString text; bool prefix; };
+    QVector<Word> words;
+    const QStringList restWords = tokenize(rest);
+    for (int i = 0; i < restWords.size(); ++i) words.append(Word{restWords[i], typing && i == restWords.size() - 1});
+    for (const QStringList &p : std::as_const(phrases)) {
+        for (const QString &w : p) words.append(Word{w, false});
+    }
+    if (words.isEmpty()) return {};
+
+    QVector<QVector<Match>> matches;
+    for (const Word &w : std::as_const(words)) {
+        matches.append(matchWord(w.text, w.prefix));
+        if (matches.last().isEmpty()) return {};
+    }
+    // every word must match: start from the rarest and narrow down
+    std::sort(matches.begin(), matches.end(), [](const auto& a, const auto& b){ return a.size() < b.size(); });
+    struct Candidate { quint32 doc; float score; };
+    QVector<Candidate> candidates;
+    candidates.reserve(matches[0].size());
+    for (const Match &m : std::as_const(matches[0])) candidates.append(Candidate{m.doc, fieldScore(m.quality, m.fields)});
+    for (int i = 1; i < matches.size() && !candidates.isEmpty(); ++i) {
+        const QVector<Match> &other = matches[i];
+        int w = 0, j = 0;
+        for (const Candidate &c : std::as_const(candidates)) {
+            // the other list is longer: gallop through it
+            j = int(std::lower_bound(other.begin() + j, other.end(), c.doc, [](const Match& m, quint32 doc){ return m.doc < doc; }) - other.begin());
+            if (j == other.size()) break;
+            if (other[j].doc == c.doc) candidates[w++] = Candidate{c.doc, c.score + fieldScore(other[j].quality, other[j].fields)};
+        }
+        candidates.resize(w);
+    }
+
+    // scored in place; hits are only built for the few that are returned
+    int kept = 0;
+    const QString first = words[0].text;
+    for (const Candidate &c : std::as_const(candidates)) {
+        const SearchDocument &d = m_docs[c.doc].data;
+        if (!phrases.isEmpty()) {
+            const QStringList title = tokenize(d.title);
+            const QStringList text = tokenize(d.text);
+            bool all = true;
+            for (const QStringList &p : std::as_const(phrases)) {
+                if (!containsPhrase(title, p) && !containsPhrase(text, p)) { all = false; break; }
+            }
+            if (!all) continue;
+        }
+        double s = c.score;
+        // the title starts with what was typed
+        if (d.title.startsWith(first, Qt::CaseInsensitive)) s += 0.5;
+        s = s * m_sourceWeight[int(d.source)] * d.weight + 0.3 * std::log1p(double(d.popularity));
+        candidates[kept++] = Candidate{c.doc, float(s)};
+    }
+    candidates.resize(kept);
+
+    // enough of the best to fill the per-source quotas from
+    const int considered = qMin(kept, limit * kSearchSourceCount);
+    const auto byScore = [](const Candidate& a, const Candidate& b){ return a.score > b.score; };
+    std::partial_sort(candidates.begin(), candidates.begin() + considered, candidates.end(), byScore);
+    candidates.resize(considered);
+
+    // no source takes more than half while the others have hits too
+    const int quota = qMax(1, (limit + 1) / 2);
+    std::array<int, kSearchSourceCount> taken{};
+    QVector<Candidate> chosen;
+    QVector<Candidate> overflow;
+    for (const Candidate &c : std::as_const(candidates)) {
+        if (chosen.size() == limit) break;
+        const int source = int(m_docs[c.doc].data.source);
+        if (taken[source] < quota) { ++taken[source]; chosen.append(c); }
+        else overflow.append(c);
+    }
+    for (int i = 0; chosen.size() < limit && i < overflow.size(); ++i) chosen.append(overflow[i]);
+    std::stable_sort(chosen.begin(), chosen.end(), byScore);
+
+    QVector<SearchHit> out;
+    out.reserve(chosen.size());
+    for (const Candidate &c : std::as_const(chosen)) {
+        const SearchDocument &d = m_docs[c.doc].data;
+        out.append(SearchHit{d.source, d.key, d.title, d.subtitle, c.score});
+    }
+    return out;
+}
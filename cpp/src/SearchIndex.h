@@ -0,0 +1,106 @@
+#pragma once
+
+#include <QHash>
+#include <QMap>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <array>
+
+enum class SearchSource { History = 0, Bookmark, Note, Todo };
+constexpr int kSearchSourceCount = 4;
+
+// One searchable thing. key is unique within its source: the URL for
+// history, the local id for the synced collections.
+struct SearchDocument {
+    SearchSource source = SearchSource::History;
+    QString key;
+    QString title;
+    QString text;       // URL, note content, ...
+    QString subtitle;   // shown under the title
+    double weight = 1.0;   // e.g. lower for completed todos
+    int popularity = 0;    // visit count
+};
+
+struct SearchHit {
+    SearchSource source = SearchSource::History;
+    QString key;
+    QString title;
+    QString subtitle;
+    double score = 0.0;
+};
+
+// An in-memory inverted index over titles and text of documents from every
+// store. Updates are incremental: upserting an unchanged document is free
+// and a changed one only touches its own terms.
+//
+// A query is a list of words, all of which must match, and "quoted phrases".
+// A word matches a term exactly; the last word also matches as a prefix
+// while it is being typed (no trailing space), and a word of four letters or
+// more that matches nothing falls back to terms one edit away. Hits are
+// ranked by field (title over text), match quality, source weight and
+// popularity, and no source takes more than half the results while others
+// have some.
+//
+// Not thread-safe; SearchService keeps it on a thread of its own.
+class SearchIndex {
+public:
+    SearchIndex();
+
+    // true when the document was new or changed
+    bool upsert(const SearchDocument& doc);
+    bool remove(SearchSource source, const QString& key);
+    // make source hold exactly docs; returns how many documents changed
+    int replaceSource(SearchSource source, const QVector<SearchDocument>& docs);
+    // the stored document, or one with an empty key
+    SearchDocument document(SearchSource source, const QString& key) const;
+
+    QVector<SearchHit> search(const QString& query, int limit) const;
+
+    void setSourceWeight(SearchSource source, double weight) { m_sourceWeight[int(source)] = weight; }
+    int size() const { return m_docs.size() - m_freeDocs.size() - m_deadDocs.size(); }
+    int termCount() const { return m_postings.size(); }
+
+    // lower-case words without accents, split on anything else
+    static QStringList tokenize(const QString& text);
+
+    // text beyond this is not indexed
+    static constexpr int kMaxTextLength = 16 * 1024;
+    // a prefix expands into at most this many terms, most frequent first
+    static constexpr int kMaxPrefixTerms = 64;
+
+private:
+    enum Field : quint8 { TitleField = 1, TextField = 2 };
+    struct Posting {
+        quint32 doc;
+        quint8 fields;
+        bool operator<(const Posting& o) const { return doc < o.doc; }
+    };
+    struct Doc {
+        SearchDocument data;
+        size_t hash = 0;
+        bool alive = false;  // false once removed or replaced, until purged
+    };
+    // one query word matched against a document
+    struct Match {
+        quint32 doc;
+        float quality;
+        quint8 fields;
+    };
+
+    void kill(quint32 id);
+    void purgeDead();
+    // live documents matching word, sorted by id
+    QVector<Match> matchWord(const QString& word, bool prefix) const;
+    QVector<QString> fuzzyTerms(const QString& word) const;
+    static bool containsPhrase(const QStringList& words, const QStringList& phrase);
+
+    QVector<Doc> m_docs;
+    QVector<quint32> m_freeDocs;
+    // replaced or removed, still in the postings
+    QVector<quint32> m_deadDocs;
+    std::array<QHash<QString, quint32>, kSearchSourceCount> m_byKey;
+    // ordered so a prefix is a range
+    QMap<QString, QVector<Posting>> m_postings;
+    std::array<double, kSearchSourceCount> m_sourceWeight;
+};
@@ -0,0 +1,250 @@
+#include "SearchService.h"
+#include "BookmarksManager.h"
+#include "NotesManager.h"
+#include "TodosManager.h"
+#include "MetricsRegistry.h"
+#include "Trace.h"
+#include <QElapsedTimer>
+#include <QSet>
+#include <QThread>
+#include <QTimer>
+
+namespace {
+struct SearchMetrics {
+    MetricsRegistry::Histogram* queryMs = MetricsRegistry::histogram("search.query_ms");
+    MetricsRegistry::Histogram* updateMs = MetricsRegistry::histogram("search.update_ms");
+    MetricsRegistry::Gauge* documents = MetricsRegistry::gauge("search.documents");
+};
+
+const SearchMetrics& metrics() {
+    static const SearchMetrics m;
+    return m;
+}
+
+const char* sourceName(SearchSource source) {
+    switch (source) {
+    case SearchSource::History: return "history";
+    case SearchSource::Bookmark: return "bookmarks";
+    case SearchSource::Note: return "notes";
+    case SearchSource::Todo: return "todos";
+    }
+    return "";
+}
+
+SearchDocument visitDocument(const QString& url, const QString& title, int visits) {
+    SearchDocument d;
+    d.source = SearchSource::History;
+    d.key = url;
+    d.title = title.isEmpty() ? url : title;
+    d.text = url;
+    d.subtitle = url;
+    d.popularity = visits;
+    return d;
+}
+
+// the first line of a note, shown under its title
+QString firstLine(const QString& text) {
+    const int nl = text.indexOf('\n');
+    return (nl < 0 ? text : text.left(nl)).left(120);
+}
+
+QVector<SearchDocument> bookmarkDocuments(const QVector<Bookmark>& items, const QVector<QString>& ids) {
+    QVector<SearchDocument> docs;
+    docs.reserve(items.size());
+    for (int i = 0; i < items.size(); ++i) {
+        SearchDocument d;
+        d.source = SearchSource::Bookmark;
+        d.key = ids[i];
+        d.title = items[i].title;
+        d.text = items[i].url;
+        d.subtitle = items[i].folder.isEmpty() ? items[i].url : items[i].folder + " · " + items[i].url;
+        docs.append(d);
+    }
+    return docs;
+}
+
+QVector<SearchDocument> noteDocuments(const QVector<NoteItem>& items, const QVector<QString>& ids) {
+    QVector<SearchDocument> docs;
+    docs.reserve(items.size());
+    for (int i = 0; i < items.size(); ++i) {
+        SearchDocument d;
+        d.source = SearchSource::Note;
+        d.key = ids[i];
+        d.title = items[i].title;
+        d.text = items[i].content;
+        d.subtitle = firstLine(items[i].content);
+        docs.append(d);
+    }
+    return docs;
+}
+
+QVector<SearchDocument> todoDocuments(const QVector<TodoItem>& items, const QVector<QString>& ids) {
+    QVector<SearchDocument> docs;
+    docs.reserve(items.size());
+    for (int i = 0; i < items.size(); ++i) {
+        SearchDocument d;
+        d.source = SearchSource::Todo;
+        d.key = ids[i];
+        d.title = items[i].title;
+        d.subtitle = items[i].completed ? QString("Done") : items[i].workspace;
+        // finished todos still turn up, below open ones
+        d.weight = items[i].completed ? 0.5 : 1.0;
+        docs.append(d);
+    }
+    return docs;
+}
+}
+
+SearchService::SearchService(QObject* parent)
+    : QObject(parent), m_thread(new QThread(this)), m_worker(new QObject), m_index(new SearchIndex) {
+    m_worker->moveToThread(m_thread);
+    connect(m_thread, &QThread::finished, m_worker, &QObject::deleteLater);
+    m_thread->setObjectName("search-index");
+    m_thread->start();
+    for (int i = 0; i < kSearchSourceCount; ++i) {
+        auto *timer = new QTimer(this);
+        timer->setSingleShot(true);
+        timer->setInterval(kCoalesceMs);
+        const auto source = SearchSource(i);
+        connect(timer, &QTimer::timeout, this, [this, source](){ sendSnapshot(source); });
+        m_snapshotTimers[i] = timer;
+    }
+}
+
+SearchService::~SearchService() {
+    m_thread->quit();
+    m_thread->wait();
+    delete m_index;
+}
+
+void SearchService::post(std::function<void(SearchIndex&)> fn) {
+    QMetaObject::invokeMethod(m_worker, [this, fn = std::move(fn)](){ fn(*m_index); });
+}
+
+void SearchService::watchHistory(HistoryManager* history) {
+    connect(history, &HistoryManager::visitAdded, this, [this](const QString& url, const QString& title){
+        if (m_historyLoading) m_visitsWhileLoading.append(qMakePair(url, title));
+        post([url, title](SearchIndex& index){
+            const int visits = index.document(SearchSource::History, url).popularity;
+            index.upsert(visitDocument(url, title, visits + 1));
+        });
+    });
+    // an import is read back whole, like at startup
+    connect(history, &HistoryManager::visitsImported, this, [this, history](){
+        m_historyLoading = true;
+        history->visitedUrls(this, [this](bool ok, const QVector<HistoryManager::VisitedUrl>& urls){ onHistoryLoaded(ok, urls); });
+    });
+    m_historyLoading = true;
+    history->visitedUrls(this, [this](bool ok, const QVector<HistoryManager::VisitedUrl>& urls){ onHistoryLoaded(ok, urls); });
+}
+
+void SearchService::onHistoryLoaded(bool ok, const QVector<HistoryManager::VisitedUrl>& urls) {
+    if (!ok) {
+        // keep what is indexed; visits added meanwhile were indexed as they came
+        m_visitsWhileLoading.clear();
+        m_historyLoading = false;
+        return;
+    }
+    QVector<SearchDocument> docs;
+    docs.reserve(urls.size());
+    for (const auto &u : urls) docs.append(visitDocument(u.url, u.title, u.visits));
+    // URLs first visited while the read ran may be missing from it
+    const QVector<QPair<QString, QString>> since = m_visitsWhileLoading;
+    m_visitsWhileLoading.clear();
+    m_historyLoading = false;
+    post([docs, since](SearchIndex& index) mutable {
+        FLOW_TRACE_SCOPE("SearchService::loadHistory");
+        QElapsedTimer timer;
+        timer.start();
+        QSet<QString> loaded;
+        loaded.reserve(docs.size());
+        for (const SearchDocument &d : std::as_const(docs)) loaded.insert(d.key);
+        for (const auto &v : since) {
+            if (loaded.contains(v.first)) continue;
+            loaded.insert(v.first);
+            const SearchDocument d = index.document(SearchSource::History, v.first);
+            if (!d.key.isEmpty()) docs.append(d);
+        }
+        index.replaceSource(SearchSource::History, docs);
+        metrics().updateMs->record(timer.nsecsElapsed() / 1e6);
+        metrics().documents->set(index.size());
+    });
+}
+
+void SearchService::watchBookmarks(BookmarksManager* bookmarks) {
+    m_bookmarks = bookmarks;
+    connect(bookmarks, &BookmarksManager::bookmarksUpdated, this, [this](){ scheduleSnapshot(SearchSource::Bookmark); });
+    scheduleSnapshot(SearchSource::Bookmark);
+}
+
+void SearchService::watchNotes(NotesManager* notes) {
+    m_notes = notes;
+    connect(notes, &NotesManager::notesUpdated, this, [this](){ scheduleSnapshot(SearchSource::Note); });
+    scheduleSnapshot(SearchSource::Note);
+}
+
+void SearchService::watchTodos(TodosManager* todos) {
+    m_todos = todos;
+    connect(todos, &TodosManager::todosUpdated, this, [this](){ scheduleSnapshot(SearchSource::Todo); });
+    scheduleSnapshot(SearchSource::Todo);
+}
+
+void SearchService::scheduleSnapshot(SearchSource source) {
+    // the first change of a burst starts the timer, later ones ride along
+    QTimer *timer = m_snapshotTimers[int(source)];
+    if (!timer->isActive()) timer->start();
+}
+
+void SearchService::sendSnapshot(SearchSource source) {
+    FLOW_TRACE_SCOPE_DETAIL("SearchService::sendSnapshot", sourceName(source));
+    // the item lists are implicitly shared, so taking them here is cheap;
+    // the documents are built on the index thread
+    std::function<QVector<SearchDocument>()> build;
+    if (source == SearchSource::Bookmark && m_bookmarks)
+        build = [items = m_bookmarks->bookmarks(), ids = m_bookmarks->localIds()](){ return bookmarkDocuments(items, ids); };
+    else if (source == SearchSource::Note && m_notes)
+        build = [items = m_notes->notes(), ids = m_notes->localIds()](){ return noteDocuments(items, ids); };
+    else if (source == SearchSource::Todo && m_todos)
+        build = [items = m_todos->todos(), ids = m_todos->localIds()](){ return todoDocuments(items, ids); };
+    else
+        return;
+    post([source, build](SearchIndex& index){
+        FLOW_TRACE_SCOPE_DETAIL("SearchService::index", sourceName(source));
+        QElapsedTimer timer;
+        timer.start();
+        index.replaceSource(source, build());
+        metrics().updateMs->record(timer.nsecsElapsed() / 1e6);
+        metrics().documents->set(index.size());
+    });
+}
+
+void SearchService::search(const QString& query, int limit, QObject* context, std::function<void(const QVector<SearchHit>&)> done) {
+    QPointer<QObject> ctx(context);
+    post([this, query, limit, ctx, done](SearchIndex& index){
+        FLOW_TRACE_SCOPE("SearchService::search");
+        QElapsedTimer timer;
+        timer.start();
+        const QVector<SearchHit> hits = index.search(query, limit);
+        metrics().queryMs->record(timer.nsecsElapsed() / 1e6);
+        QMetaObject::invokeMethod(this, [ctx, done, hits](){
+            if (ctx && done) done(hits);
+        });
+    });
+}
+
+void SearchService::waitForIdle() {
+    // pending snapshots go out first
+    for (int i = 0; i < kSearchSourceCount; ++i) {
+        if (m_snapshotTimers[i]->isActive()) {
+            m_snapshotTimers[i]->stop();
+            sendSnapshot(SearchSource(i));
+        }
+    }
+    QMetaObject::invokeMethod(m_worker, [](){}, Qt::BlockingQueuedConnection);
+}
+
+int SearchService::documentCount() {
+    int count = 0;
+    QMetaObject::invokeMethod(m_worker, [this, &count](){ count = m_index->size(); }, Qt::BlockingQueuedConnection);
+    return count;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <QObject>
+#include <QPointer>
+#include <QVector>
+#include <array>
+#include <functional>
+#include "SearchIndex.h"
+#include "HistoryManager.h"
+
+class QThread;
+class QTimer;
+class BookmarksManager;
+class NotesManager;
+class TodosManager;
+
+// Keeps one SearchIndex over history, bookmarks, notes and todos up to date
+// and answers queries from it, for the command palette.
+//
+// The index lives on the "search-index" thread. A visit is indexed as it is
+// added; a burst of changes to a synced collection is coalesced and the
+// collection's item list, implicitly shared, sent over as one snapshot. The
+// index thread turns it into documents and diffs them against what it holds,
+// so only changed items are reindexed and the GUI thread copies nothing.
+// History is read once at start.
+class SearchService : public QObject {
+    Q_OBJECT
+public:
+    explicit SearchService(QObject* parent = nullptr);
+    ~SearchService() override;
+
+    void watchHistory(HistoryManager* history);
+    void watchBookmarks(BookmarksManager* bookmarks);
+    void watchNotes(NotesManager* notes);
+    void watchTodos(TodosManager* todos);
+
+    // done runs on context's thread, unless context is gone by then
+    void search(const QString& query, int limit, QObject* context, std::function<void(const QVector<SearchHit>&)> done);
+
+    // Block until every update posted so far is indexed (tests, benchmarks).
+    void waitForIdle();
+    // documents in the index, counted on its thread
+    int documentCount();
+
+    // collection changes closer together than this are indexed together
+    static constexpr int kCoalesceMs = 100;
+
+private:
+    void post(std::function<void(SearchIndex&)> fn);
+    void scheduleSnapshot(SearchSource source);
+    void sendSnapshot(SearchSource source);
+    void onHistoryLoaded(bool ok, const QVector<HistoryManager::VisitedUrl>& urls);
+
+    QThread* m_thread;
+    QObject* m_worker;
+    SearchIndex* m_index;
+
+    QPointer<BookmarksManager> m_bookmarks;
+    QPointer<NotesManager> m_notes;
+    QPointer<TodosManager> m_todos;
+    std::array<QTimer*, kSearchSourceCount> m_snapshotTimers{};
+    // visits added while history is being read, indexed again after it
+    bool m_historyLoading = false;
+    QVector<QPair<QString, QString>> m_visitsWhileLoading;
+};
@@ -1,41 +1,40 @@
 #include "SessionManager.h"
-#include <QStandardPaths>
-#include <QDir>
-#include <QFile>
-#include <QJsonDocument>
-#include <QJsonArray>
+#include "StorageExecutor.h"
+#include <QSqlQuery>
+#include <QVariant>
+
+namespace {
+struct SavedSession {
+    QStringList urls;
+    int active = 0;
+};
+}
 
 SessionManager::SessionManager(QObject* parent): QObject(parent) {
-    QString dataDir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
-    QDir().mkpath(dataDir);
-    m_filePath = QDir(dataDir).filePath("session.json");
 }
 
 void SessionManager::saveSession(const QStringList& urls, int activeIndex) {
-    QJsonObject o;
-    QJsonArray arr;
-    for (const auto &u : urls) arr.append(u);
-    o["tabs"] = arr;
-    o["active"] = activeIndex;
-    QFile f(m_filePath);
-    if (f.open(QIODevice::WriteOnly)) {
-        f.write(QJsonDocument(o).toJson());
-        f.close();
-    }
+    // the whole snapshot replaces the previous one, or nothing does
+    StorageExecutor::instance()->write(nullptr, [urls, activeIndex](Storage& s){
+        QSqlQuery q(s.database());
+        if (!q.exec("DELETE FROM session_tabs")) return false;
+        q.prepare("INSERT INTO session_tabs (position, url) VALUES (?, ?)");
+        for (int i = 0; i < urls.size(); ++i) {
+            q.addBindValue(i);
+            q.addBindValue(urls[i]);
+            if (!q.exec()) return false;
+        }
+        return s.setValue("session_active", QString::number(activeIndex));
+    });
 }
 
-QStringList SessionManager::loadSession(int &activeIndex) {
-    QStringList result;
-    activeIndex = 0;
-    QFile f(m_filePath);
-    if (!f.open(QIODevice::ReadOnly)) return result;
-    QByteArray data = f.readAll();
-    f.close();
-    QJsonDocument doc = QJsonDocument::fromJson(data);
-    if (!doc.isObject()) return result;
-    QJsonObject o = doc.object();
-    QJsonArray arr = o["tabs"].toArray();
-    for (auto v : arr) result.append(v.toString());
-    activeIndex = o["active"].toInt();
-    return result;
-}
\ No newline at end of file
+void SessionManager::loadSession(QObject* context, std::function<void(const QStringList& urls, int activeIndex)> done) {
+    StorageExecutor::instance()->readConcurrently<SavedSession>(context, [](Storage& s){
+        SavedSession session;
+        QSqlQuery q(s.database());
+        if (!q.exec("SELECT url FROM session_tabs ORDER BY position")) return session;
+        while (q.next()) session.urls.append(q.value(0).toString());
+        session.active = s.value("session_active", "0").toInt();
+        return session;
+    }, [done](SavedSession session){ done(session.urls, session.active); });
+}
@@ -3,14 +3,15 @@
 #include <QObject>
 #include <QString>
 #include <QStringList>
+#include <functional>
 
+// The tabs of the last window, kept in Storage. Both calls only post work to
+// the storage thread.
 class SessionManager : public QObject {
     Q_OBJECT
 public:
     explicit SessionManager(QObject* parent = nullptr);
     void saveSession(const QStringList& urls, int activeIndex);
-    QStringList loadSession(int &activeIndex);
-
-private:
-    QString m_filePath;
-};
\ No newline at end of file
+    // done runs on context's thread with the saved tabs, unless context is gone by then
+    void loadSession(QObject* context, std::function<void(const QStringList& urls, int activeIndex)> done);
+};
@@ -0,0 +1,133 @@
+#include "SpeculationEngine.h"
+#include <QWebEngineProfile>
+#include <QWebEnginePage>
+#include <QDateTime>
+#include <cstring>
+
+SpeculationEngine::SpeculationEngine(QWebEngineProfile* profile, QObject* parent): QObject(parent), m_profile(profile) {
+}
+
+void SpeculationEngine::setThresholds(double preconnect, double prefetch) {
+    m_preconnectThreshold = qBound(0.0, preconnect, 1.0);
+    m_prefetchThreshold = qBound(m_preconnectThreshold, prefetch, 1.0);
+}
+
+void SpeculationEngine::setRateLimit(int maxPerWindow, int windowMs) {
+    m_maxPerWindow = qMax(0, maxPerWindow);
+    m_windowMs = qMax(1, windowMs);
+}
+
+QString SpeculationEngine::originKey(const QUrl& url) {
+    return url.scheme().toLower() + "://" + url.host().toLower() + ":" + QString::number(url.port(url.scheme() == "http" ? 80 : 443));
+}
+
+bool SpeculationEngine::takeToken(qint64 now) {
+    while (!m_recent.isEmpty() && now - m_recent.first() >= m_windowMs) m_recent.removeFirst();
+    if (m_recent.size() >= m_maxPerWindow) return false;
+    m_recent.append(now);
+    return true;
+}
+
+void SpeculationEngine::hint(const QUrl& url, double confidence, Source source) {
+    Q_UNUSED(source)
+    if (!m_enabled) return;
+    if (!url.isValid() || (url.scheme() != "https" && url.scheme() != "http") || url.host().isEmpty()) return;
+    ++m_stats.hints;
+    if (confidence < m_preconnectThreshold) { ++m_stats.belowThreshold; return; }
+
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    const bool prefetch = confidence >= m_prefetchThreshold;
+    const QString key = originKey(url);
+    auto it = m_warm.find(key);
+    if (it != m_warm.end() && now - it->at < kWarmTtlMs) {
+        // origin is warm already; only upgrade to a prefetch of a new URL
+        if (!prefetch || it->prefetched == url) { ++m_stats.duplicates; return; }
+    }
+    if (!takeToken(now)) { ++m_stats.rateLimited; return; }
+
+    Warm &w = m_warm[key];
+    w.at = now;
+    if (prefetch) w.prefetched = url;
+    if (prefetch) ++m_stats.prefetches; else ++m_stats.preconnects;
+    issue(url, prefetch);
+    emit statsChanged();
+}
+
+void SpeculationEngine::issue(const QUrl& url, bool prefetch) {
+    if (!m_profile) return;
+    if (!m_page) m_page = new QWebEnginePage(m_profile, this);
+    // Resource hints in a throwaway document. Chromium keys the HTTP cache, and
+    // depending on the version sockets and DNS, by the site of the top frame,
+    // and does not cache at all for an opaque one such as about:blank. So the
+    // document claims the target's origin: the later navigation to it has the
+    // same top-frame site and finds the warm socket and the prefetched response.
+    const QUrl originUrl = url.adjusted(QUrl::RemovePath | QUrl::RemoveQuery | QUrl::RemoveFragment);
+    const QString href = QString::fromUtf8(url.toEncoded()).toHtmlEscaped();
+    const QString origin = QString::fromUtf8(originUrl.toEncoded()).toHtmlEscaped();
+    QString html = QString("<link rel=\"dns-prefetch\" href=\"%1\"><link rel=\"preconnect\" href=\"%1\">").arg(origin);
+    if (prefetch) html += QString("<link rel=\"prefetch\" href=\"%1\">").arg(href);
+    QUrl base = originUrl;
+    base.setPath("/");
+    m_page->setHtml(html, base);
+}
+
+void SpeculationEngine::recordNavigation(const QUrl& url) {
+    if (!m_enabled || !url.isValid() || url.host().isEmpty()) return;
+    ++m_stats.navigations;
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    auto it = m_warm.find(originKey(url));
+    if (it != m_warm.end() && now - it->at < kWarmTtlMs) {
+        ++m_stats.hits;
+        m_stats.totalLeadMs += now - it->at;
+        if (it->prefetched == url) ++m_stats.prefetchHits;
+        m_warm.erase(it);
+    }
+    // forget anything that went cold
+    for (auto w = m_warm.begin(); w != m_warm.end();) {
+        if (now - w->at >= kWarmTtlMs) w = m_warm.erase(w); else ++w;
+    }
+    emit statsChanged();
+}
+
+double SpeculationEngine::omniboxConfidence(const QString& typed, const QUrl& candidate) {
+    auto strip = [](QString s) {
+        s = s.trimmed().toLower();
+        for (const char* p : {"https://", "http://"}) if (s.startsWith(p)) { s = s.mid(int(strlen(p))); break; }
+        if (s.startsWith("www.")) s = s.mid(4);
+        return s;
+    };
+    const QString t = strip(typed);
+    if (t.isEmpty() || !candidate.isValid()) return 0.0;
+    const QString host = strip(candidate.host());
+    const QString hostPath = host + candidate.path();
+    if (host.isEmpty()) return 0.0;
+    if (hostPath.startsWith(t) && t.size() > host.size()) return 0.95;
+    if (host.startsWith(t)) {
+        // one or two letters match too many hosts to be worth a socket
+        if (t.size() < 3) return 0.3;
+        // the path is still unknown, so never confident enough to prefetch
+        return qMin(0.8, 0.5 + 0.3 * double(t.size()) / host.size());
+    }
+    if (host.contains("." + t)) return 0.5; // matches a later label, e.g. "github" for gist.github.com
+    if (candidate.toString().toLower().contains(t)) return 0.35;
+    return 0.2; // matched on title only
+}
+
+QJsonObject SpeculationEngine::toJson() const {
+    const SpeculationStats &s = m_stats;
+    QJsonObject o;
+    o["enabled"] = m_enabled;
+    o["hints"] = s.hints;
+    o["below_threshold"] = s.belowThreshold;
+    o["rate_limited"] = s.rateLimited;
+    o["duplicates"] = s.duplicates;
+    o["preconnects"] = s.preconnects;
+    o["prefetches"] = s.prefetches;
+    o["navigations"] = s.navigations;
+    o["hits"] = s.hits;
+    o["prefetch_hits"] = s.prefetchHits;
+    o["hit_rate"] = s.hitRate();
+    o["precision"] = s.precision();
+    o["avg_lead_ms"] = s.hits > 0 ? double(s.totalLeadMs) / s.hits : 0.0;
+    return o;
+}
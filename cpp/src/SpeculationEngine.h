@@ -0,0 +1,82 @@
+#pragma once
+
+#include <QObject>
+#include <QHash>
+#include <QUrl>
+#include <QVector>
+#include <QJsonObject>
+
+class QWebEngineProfile;
+class QWebEnginePage;
+
+struct SpeculationStats {
+    qint64 hints = 0;           // candidates offered by the omnibox / bookmarks
+    qint64 belowThreshold = 0;  // dropped for low confidence
+    qint64 rateLimited = 0;
+    qint64 duplicates = 0;      // origin already warm
+    qint64 preconnects = 0;
+    qint64 prefetches = 0;
+    qint64 navigations = 0;
+    qint64 hits = 0;            // navigation to an origin we had warmed up
+    qint64 prefetchHits = 0;    // ... to the exact URL we had prefetched
+    qint64 totalLeadMs = 0;     // sum of speculation-to-navigation time over hits
+    double hitRate() const { return navigations > 0 ? double(hits) / navigations : 0.0; }
+    double precision() const {
+        const qint64 issued = preconnects + prefetches;
+        return issued > 0 ? double(hits) / issued : 0.0;
+    }
+};
+
+// Warms up the likely next destination while the user is still deciding: the top
+// omnibox suggestion or a hovered bookmark. Hints above the preconnect threshold
+// get a DNS + TCP/TLS preconnect, very confident ones an HTTP prefetch, both issued
+// through a hidden page on the browsing profile. That page's document has the
+// target's origin, so the warm sockets and cache entries fall in the partition
+// the real navigation will use.
+class SpeculationEngine : public QObject {
+    Q_OBJECT
+public:
+    enum class Source { Omnibox, BookmarkHover };
+
+    // Without a profile the engine only does its bookkeeping (used by tests).
+    explicit SpeculationEngine(QWebEngineProfile* profile, QObject* parent = nullptr);
+
+    void hint(const QUrl& url, double confidence, Source source);
+    void recordNavigation(const QUrl& url);
+
+    void setThresholds(double preconnect, double prefetch);
+    // at most maxPerWindow speculative requests per windowMs
+    void setRateLimit(int maxPerWindow, int windowMs);
+    void setEnabled(bool enabled) { m_enabled = enabled; }
+    bool isEnabled() const { return m_enabled; }
+
+    SpeculationStats stats() const { return m_stats; }
+    QJsonObject toJson() const;
+
+    // How likely the user is heading to candidate, given what they typed so far.
+    static double omniboxConfidence(const QString& typed, const QUrl& candidate);
+
+    // Chromium drops unused preconnected sockets after about 10s.
+    static const int kWarmTtlMs = 10000;
+
+signals:
+    void statsChanged();
+
+private:
+    struct Warm { qint64 at = 0; QUrl prefetched; };
+
+    bool takeToken(qint64 now);
+    void issue(const QUrl& url, bool prefetch);
+    static QString originKey(const QUrl& url);
+
+    QWebEngineProfile* m_profile;
+    QWebEnginePage* m_page = nullptr;
+    bool m_enabled = true;
+    double m_preconnectThreshold = 0.5;
+    double m_prefetchThreshold = 0.85;
+    int m_maxPerWindow = 6;
+    int m_windowMs = 10000;
+    QVector<qint64> m_recent; // issue times inside the rate window
+    QHash<QString, Warm> m_warm;
+    SpeculationStats m_stats;
+};
@@ -0,0 +1,110 @@
+#include "StartupTrace.h"
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QMutex>
+#include <QThread>
+#include <QTextStream>
+#ifdef Q_OS_LINUX
+#include <unistd.h>
+#endif
+
+namespace {
+struct TraceState {
+    QMutex mutex;
+    QElapsedTimer clock;
+    double offsetMs = 0;  // process age when the clock started
+    Qt::HANDLE mainThread = nullptr;
+    QVector<StartupTrace::Phase> phases;
+};
+
+TraceState& state() {
+    static TraceState s;
+    return s;
+}
+
+// how long ago the kernel created this process; 0 where we cannot tell
+double processAgeMs() {
+#ifdef Q_OS_LINUX
+    QFile stat("/proc/self/stat");
+    QFile uptime("/proc/uptime");
+    if (!stat.open(QIODevice::ReadOnly) || !uptime.open(QIODevice::ReadOnly)) return 0;
+    // the command name may contain spaces; fields are counted after its ')'
+    const QByteArray line = stat.readAll();
+    const QList<QByteArray> fields = line.mid(line.lastIndexOf(')') + 2).split(' ');
+    // starttime is field 22 overall, the 20th after the command name
+    if (fields.size() < 20) return 0;
+    const double startSec = fields.at(19).toDouble() / double(sysconf(_SC_CLK_TCK));
+    const double upSec = uptime.readAll().split(' ').value(0).toDouble();
+    return qMax(0.0, (upSec - startSec) * 1000.0);
+#else
+    return 0;
+#endif
+}
+
+// callers hold the mutex
+void startLocked(TraceState& s) {
+    if (s.clock.isValid()) return;
+    s.offsetMs = processAgeMs();
+    s.mainThread = QThread::currentThreadId();
+    s.clock.start();
+    s.phases.append({"process start", 0, QString()});
+}
+}
+
+void StartupTrace::start() {
+    TraceState& s = state();
+    QMutexLocker lock(&s.mutex);
+    startLocked(s);
+}
+
+void StartupTrace::mark(const QString& phase) {
+    TraceState& s = state();
+    QMutexLocker lock(&s.mutex);
+    startLocked(s);
+    for (const Phase &p : s.phases) if (p.name == phase) return;
+    QString thread = QThread::currentThread()->objectName();
+    if (thread.isEmpty()) thread = QThread::currentThreadId() == s.mainThread ? "main" : "worker";
+    s.phases.append({phase, s.offsetMs + s.clock.nsecsElapsed() / 1e6, thread});
+}
+
+bool StartupTrace::reached(const QString& phase) {
+    TraceState& s = state();
+    QMutexLocker lock(&s.mutex);
+    for (const Phase &p : s.phases) if (p.name == phase) return true;
+    return false;
+}
+
+double StartupTrace::elapsedMs() {
+    TraceState& s = state();
+    QMutexLocker lock(&s.mutex);
+    startLocked(s);
+    return s.offsetMs + s.clock.nsecsElapsed() / 1e6;
+}
+
+QVector<StartupTrace::Phase> StartupTrace::phases() {
+    TraceState& s = state();
+    QMutexLocker lock(&s.mutex);
+    return s.phases;
+}
+
+QString StartupTrace::report() {
+    QString out;
+    QTextStream ts(&out);
+    ts << qSetFieldWidth(28) << Qt::left << "phase" << qSetFieldWidth(10) << Qt::right << "at ms" << "+ms"
+       << qSetFieldWidth(0) << "  thread" << Qt::endl;
+    double previous = 0;
+    for (const Phase &p : phases()) {
+        ts << qSetFieldWidth(28) << Qt::left << p.name << qSetFieldWidth(10) << Qt::right
+           << QString::number(p.atMs, 'f', 1) << QString::number(p.atMs - previous, 'f', 1)
+           << qSetFieldWidth(0) << "  " << p.thread << Qt::endl;
+        previous = p.atMs;
+    }
+    return out;
+}
+
+QJsonObject StartupTrace::toJson() {
+    QJsonArray arr;
+    for (const Phase &p : phases()) arr.append(QJsonObject{{"phase", p.name}, {"at_ms", p.atMs}, {"thread", p.thread}});
+    return QJsonObject{{"phases", arr}};
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <QString>
+#include <QVector>
+#include <QJsonObject>
+
+// Phase markers for cold start, from process start to the first interactive
+// tab. Times are milliseconds since the process was created (read from
+// /proc on Linux; elsewhere since start() ran, which main() calls first).
+// mark() may be called from any thread and only records the first time a
+// phase is reached, so a second window does not move the markers.
+class StartupTrace {
+public:
+    struct Phase {
+        QString name;
+        double atMs = 0;
+        QString thread;
+    };
+
+    static void start();
+    static void mark(const QString& phase);
+    static bool reached(const QString& phase);
+    static double elapsedMs();
+    static QVector<Phase> phases();
+
+    // a table of the phases with the time each took since the previous one
+    static QString report();
+    static QJsonObject toJson();
+};
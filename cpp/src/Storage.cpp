@@ -0,0 +1,447 @@
+#include "Storage.h"
+#include "Trace.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QUuid>
+#include <QJsonDocument>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QVariant>
+#include <QDebug>
+
+namespace {
+const char* const kConnection = "flow_connection";
+const char* const kSyncedTables[] = {"bookmarks", "notes", "todos"};
+
+bool isSyncedTable(const QString& table) {
+    for (const char* t : kSyncedTables) if (table == QLatin1String(t)) return true;
+    return false;
+}
+
+QStringList syncedTableSchema(const QString& t) {
+    return {
+        QString("CREATE TABLE %1 (local_id TEXT PRIMARY KEY, position REAL NOT NULL, remote_id TEXT NOT NULL DEFAULT '', "
+                "status INTEGER NOT NULL DEFAULT 0, data TEXT NOT NULL)").arg(t),
+        QString("CREATE INDEX %1_position ON %1(position)").arg(t),
+        QString("CREATE INDEX %1_remote_id ON %1(remote_id) WHERE remote_id <> ''").arg(t),
+    };
+}
+
+// statements of schema version i + 1; append, never edit a released one
+const QVector<QStringList>& migrations() {
+    static const QVector<QStringList> s_migrations = [](){
+        QStringList v1;
+        for (const char* t : kSyncedTables) v1 += syncedTableSchema(QLatin1String(t));
+        v1 << "CREATE INDEX notes_workspace ON notes(json_extract(data, '$.workspace'))"
+           << "CREATE INDEX todos_workspace ON todos(json_extract(data, '$.workspace'))"
+           << "CREATE INDEX bookmarks_folder ON bookmarks(json_extract(data, '$.folder'))"
+           << "CREATE TABLE sync_queue (table_name TEXT PRIMARY KEY, ops TEXT NOT NULL)"
+           << "CREATE TABLE sync_state (table_name TEXT PRIMARY KEY, user_id TEXT NOT NULL, cursor TEXT NOT NULL)"
+           << "CREATE TABLE workspaces (position INTEGER PRIMARY KEY, name TEXT NOT NULL, type TEXT NOT NULL, "
+              "groups TEXT NOT NULL, tabs TEXT NOT NULL)"
+           << "CREATE TABLE session_tabs (position INTEGER PRIMARY KEY, url TEXT NOT NULL)"
+           << "CREATE TABLE settings (key TEXT PRIMARY KEY, value TEXT NOT NULL)";
+        // the server version each item was last pushed or pulled at, and the
+        // remote side of an unresolved conflict
+        QStringList v2;
+        for (const char* t : kSyncedTables)
+            v2 << QString("ALTER TABLE %1 ADD COLUMN revision TEXT NOT NULL DEFAULT ''").arg(QLatin1String(t))
+               << QString("ALTER TABLE %1 ADD COLUMN conflict TEXT NOT NULL DEFAULT ''").arg(QLatin1String(t));
+        return QVector<QStringList>{v1, v2};
+    }();
+    return s_migrations;
+}
+
+QJsonDocument readJson(const QString& path) {
+    QFile f(path);
+    if (!f.open(QIODevice::ReadOnly)) return QJsonDocument();
+    return QJsonDocument::fromJson(f.readAll());
+}
+
+QString compact(const QJsonObject& o) { return QString::fromUtf8(QJsonDocument(o).toJson(QJsonDocument::Compact)); }
+QString compact(const QJsonArray& a) { return QString::fromUtf8(QJsonDocument(a).toJson(QJsonDocument::Compact)); }
+}
+
+Storage::Storage(const QString& path, QObject* parent): QObject(parent), m_path(path), m_connection(kConnection) {
+    m_dataDir = QFileInfo(path).absolutePath();
+}
+
+Storage::~Storage() {
+    m_db.close();
+    m_db = QSqlDatabase();
+    QSqlDatabase::removeDatabase(m_connection);
+    if (!m_history.isValid()) return;
+    m_history.close();
+    m_history = QSqlDatabase();
+    QSqlDatabase::removeDatabase(m_connection + "_history");
+}
+
+bool Storage::init() {
+    QDir().mkpath(m_dataDir);
+    return open() && migrate();
+}
+
+bool Storage::initReader(const QString& connection) {
+    m_connection = connection;
+    m_db = QSqlDatabase::addDatabase("QSQLITE", m_connection);
+    m_db.setDatabaseName(m_path);
+    m_db.setConnectOptions("QSQLITE_OPEN_READONLY;QSQLITE_BUSY_TIMEOUT=5000");
+    if (!m_db.open()) {
+        qWarning() << "Failed to open storage DB for reading:" << m_db.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+bool Storage::beginRead() {
+    // a deferred transaction takes its WAL snapshot at the first read
+    if (!exec("BEGIN")) return false;
+    QSqlQuery q(m_db);
+    if (q.exec("SELECT COUNT(*) FROM sqlite_master") && q.next()) return true;
+    exec("ROLLBACK");
+    return false;
+}
+
+void Storage::endRead() {
+    exec("COMMIT");
+}
+
+QSqlDatabase Storage::history() {
+    if (m_history.isOpen()) return m_history;
+    if (!m_history.isValid()) {
+        m_history = QSqlDatabase::addDatabase("QSQLITE", m_connection + "_history");
+        m_history.setDatabaseName(QDir(m_dataDir).filePath("history.db"));
+    }
+    if (!m_history.open()) {
+        qWarning() << "Failed to open history DB:" << m_history.lastError().text();
+        return m_history;
+    }
+    QSqlQuery q(m_history);
+    // takes effect for a new file only; HistoryRetention converts older ones
+    q.exec("PRAGMA auto_vacuum = INCREMENTAL");
+    q.exec("CREATE TABLE IF NOT EXISTS visits (id INTEGER PRIMARY KEY AUTOINCREMENT, url TEXT, title TEXT, visited_at INTEGER)");
+    q.exec("CREATE INDEX IF NOT EXISTS visits_visited_at ON visits (visited_at)");
+    q.exec("CREATE INDEX IF NOT EXISTS visits_url ON visits (url)");
+    // older visits, one row per URL and day (span 86400) or week (604800)
+    q.exec("CREATE TABLE IF NOT EXISTS visit_rollups (url TEXT NOT NULL, period_start INTEGER NOT NULL, span INTEGER NOT NULL, "
+           "title TEXT, visits INTEGER NOT NULL, PRIMARY KEY (url, period_start, span))");
+    q.exec("CREATE INDEX IF NOT EXISTS visit_rollups_period_start ON visit_rollups (period_start)");
+    // text of visited pages, compressed, with a contentless full-text index
+    // over it (see PageTextIndex); last_used is epoch ms
+    q.exec("CREATE TABLE IF NOT EXISTS page_text (id INTEGER PRIMARY KEY, url TEXT UNIQUE, title TEXT, body BLOB, "
+           "bytes INTEGER, text_hash INTEGER, last_used INTEGER)");
+    q.exec("CREATE INDEX IF NOT EXISTS page_text_last_used ON page_text (last_used)");
+    if (!q.exec("CREATE VIRTUAL TABLE IF NOT EXISTS page_text_fts USING fts5(title, body, content='', tokenize='unicode61 remove_diacritics 2')"))
+        qWarning() << "Page text search is unavailable, SQLite lacks FTS5:" << q.lastError().text();
+    return m_history;
+}
+
+bool Storage::open() {
+    m_db = QSqlDatabase::addDatabase("QSQLITE", m_connection);
+    m_db.setDatabaseName(m_path);
+    // another process (flow_cli, a backup tool) may hold the write lock briefly
+    m_db.setConnectOptions("QSQLITE_BUSY_TIMEOUT=5000");
+    if (!m_db.open()) {
+        qWarning() << "Failed to open storage DB:" << m_db.lastError().text();
+        return false;
+    }
+    // readers never block the writer; NORMAL is durable enough with WAL and
+    // only loses the last commits on power failure, never consistency
+    QSqlQuery q(m_db);
+    if (!q.exec("PRAGMA journal_mode=WAL") || !q.next() || q.value(0).toString().compare("wal", Qt::CaseInsensitive) != 0)
+        qWarning() << "Storage DB is not in WAL mode:" << q.lastError().text();
+    exec("PRAGMA synchronous=NORMAL");
+    return true;
+}
+
+bool Storage::exec(const QString& sql) {
+    QSqlQuery q(m_db);
+    if (q.exec(sql)) return true;
+    qWarning() << "Storage:" << q.lastError().text() << "in" << sql.left(80);
+    return false;
+}
+
+int Storage::schemaVersion() const {
+    QSqlQuery q(m_db);
+    if (!q.exec("PRAGMA user_version") || !q.next()) return -1;
+    return q.value(0).toInt();
+}
+
+int Storage::latestSchemaVersion() {
+    return migrations().size();
+}
+
+bool Storage::migrate() {
+    const int from = schemaVersion();
+    if (from < 0) return false;
+    if (from > latestSchemaVersion()) {
+        qWarning() << "Storage DB has schema" << from << "- newer than this build knows (" << latestSchemaVersion() << ")";
+        return true;
+    }
+    QStringList imported;
+    for (int v = from; v < latestSchemaVersion(); ++v) {
+        const bool ok = transaction([&](){
+            for (const QString &sql : migrations().at(v)) if (!exec(sql)) return false;
+            // a new profile imports the legacy files once the schema is complete,
+            // since the import writes through the current writeItems()
+            if (from == 0 && v + 1 == latestSchemaVersion() && !importLegacyJson(imported)) return false;
+            return exec(QString("PRAGMA user_version = %1").arg(v + 1));
+        });
+        if (!ok) {
+            qWarning() << "Storage migration to schema" << v + 1 << "failed";
+            return false;
+        }
+    }
+    // only once the rows are committed; a failed import leaves the files in place
+    for (const QString &file : imported) {
+        QFile::remove(file + ".imported");
+        QFile::rename(file, file + ".imported");
+    }
+    return true;
+}
+
+// The JSON files written before flow.db existed, as the managers left them.
+bool Storage::importLegacyJson(QStringList& imported) {
+    const QDir dir(m_dataDir);
+    for (const char* t : kSyncedTables) {
+        const QString table = QLatin1String(t);
+        const QString itemsPath = dir.filePath(table + ".json");
+        const QJsonDocument items = readJson(itemsPath);
+        if (items.isArray()) {
+            QVector<StoredItem> rows;
+            const QJsonArray arr = items.array();
+            for (int i = 0; i < arr.size(); ++i) {
+                QJsonObject data = arr.at(i).toObject();
+                StoredItem row;
+                row.localId = data.take("local_id").toString();
+                if (row.localId.isEmpty()) row.localId = QUuid::createUuid().toString(QUuid::WithoutBraces);
+                row.position = i;
+                row.status = data.take("status").toInt();
+                row.remoteId = data.value("id").toString();
+                row.data = data;
+                rows.append(row);
+            }
+            if (!writeItems(table, rows, QStringList())) return false;
+            imported << itemsPath;
+        }
+        const QString queuePath = dir.filePath(table + ".queue.json");
+        const QJsonDocument queue = readJson(queuePath);
+        if (queue.isArray()) {
+            if (!writeQueue(table, queue.array())) return false;
+            imported << queuePath;
+        }
+    }
+
+    const QString statePath = dir.filePath("sync_state.json");
+    const QJsonDocument state = readJson(statePath);
+    if (state.isObject()) {
+        const QJsonObject o = state.object();
+        for (auto it = o.constBegin(); it != o.constEnd(); ++it) {
+            const QJsonObject entry = it.value().toObject();
+            if (!setSyncCursor(it.key(), entry.value("user_id").toString(), entry.value("updated_at").toString())) return false;
+        }
+        imported << statePath;
+    }
+
+    const QString workspacesPath = dir.filePath("workspaces.json");
+    const QJsonDocument workspaces = readJson(workspacesPath);
+    if (workspaces.isObject()) {
+        const QJsonObject root = workspaces.object();
+        const QJsonArray arr = root.value("workspaces").toArray();
+        QSqlQuery q(m_db);
+        q.prepare("INSERT INTO workspaces (position, name, type, groups, tabs) VALUES (?, ?, ?, ?, ?)");
+        for (int i = 0; i < arr.size(); ++i) {
+            const QJsonObject w = arr.at(i).toObject();
+            q.addBindValue(i);
+            q.addBindValue(w.value("name").toString());
+            q.addBindValue(w.value("type").toString());
+            q.addBindValue(compact(w.value("groups").toArray()));
+            q.addBindValue(compact(w.value("tabs").toArray()));
+            if (!q.exec()) return false;
+        }
+        if (!setValue("current_workspace", QString::number(root.value("current").toInt(-1)))) return false;
+        imported << workspacesPath;
+    }
+
+    const QString sessionPath = dir.filePath("session.json");
+    const QJsonDocument session = readJson(sessionPath);
+    if (session.isObject()) {
+        const QJsonObject o = session.object();
+        const QJsonArray tabs = o.value("tabs").toArray();
+        QSqlQuery q(m_db);
+        q.prepare("INSERT INTO session_tabs (position, url) VALUES (?, ?)");
+        for (int i = 0; i < tabs.size(); ++i) {
+            q.addBindValue(i);
+            q.addBindValue(tabs.at(i).toString());
+            if (!q.exec()) return false;
+        }
+        if (!setValue("session_active", QString::number(o.value("active").toInt()))) return false;
+        imported << sessionPath;
+    }
+    return true;
+}
+
+bool Storage::transaction(const std::function<bool()>& fn) {
+    if (!isOpen()) return false;
+    if (m_depth == 0) {
+        if (!m_db.transaction()) {
+            qWarning() << "Storage: cannot begin a transaction:" << m_db.lastError().text();
+            return false;
+        }
+        m_rollback = false;
+    }
+    ++m_depth;
+    const bool ok = fn();
+    if (!ok) m_rollback = true;
+    if (--m_depth > 0) return ok;
+    FLOW_TRACE_SCOPE("Storage::commit");
+    if (m_rollback) {
+        m_db.rollback();
+        return false;
+    }
+    if (!m_db.commit()) {
+        qWarning() << "Storage: commit failed:" << m_db.lastError().text();
+        m_db.rollback();
+        return false;
+    }
+    ++m_commits;
+    return true;
+}
+
+StoredCollection Storage::readCollection(const QString& table) {
+    FLOW_TRACE_SCOPE_DETAIL("Storage::readCollection", Trace::detail(table));
+    StoredCollection c;
+    c.items = readItems(table);
+    c.queue = readQueue(table);
+    QSqlQuery q(m_db);
+    q.prepare("SELECT user_id, cursor FROM sync_state WHERE table_name = ?");
+    q.addBindValue(table);
+    if (q.exec() && q.next()) {
+        c.cursorUserId = q.value(0).toString();
+        c.cursor = q.value(1).toString();
+    }
+    return c;
+}
+
+QVector<StoredItem> Storage::readItems(const QString& table) {
+    QVector<StoredItem> out;
+    if (!isSyncedTable(table) || !isOpen()) return out;
+    QSqlQuery q(m_db);
+    q.setForwardOnly(true);
+    if (!q.exec(QString("SELECT local_id, position, remote_id, status, data, revision, conflict FROM %1 ORDER BY position").arg(table))) {
+        qWarning() << "Storage:" << q.lastError().text();
+        return out;
+    }
+    while (q.next()) {
+        StoredItem row;
+        row.localId = q.value(0).toString();
+        row.position = q.value(1).toDouble();
+        row.remoteId = q.value(2).toString();
+        row.status = q.value(3).toInt();
+        row.data = QJsonDocument::fromJson(q.value(4).toString().toUtf8()).object();
+        row.revision = q.value(5).toString();
+        const QString conflict = q.value(6).toString();
+        if (!conflict.isEmpty()) row.conflict = QJsonDocument::fromJson(conflict.toUtf8()).object();
+        out.append(row);
+    }
+    return out;
+}
+
+bool Storage::writeItems(const QString& table, const QVector<StoredItem>& upserts, const QStringList& removedLocalIds) {
+    if (!isSyncedTable(table)) return false;
+    FLOW_TRACE_SCOPE_DETAIL("Storage::writeItems", Trace::detail(table));
+    return transaction([&](){
+        QSqlQuery put(m_db);
+        put.prepare(QString("INSERT OR REPLACE INTO %1 (local_id, position, remote_id, status, data, revision, conflict) "
+                            "VALUES (?, ?, ?, ?, ?, ?, ?)").arg(table));
+        for (const StoredItem &row : upserts) {
+            put.addBindValue(row.localId);
+            put.addBindValue(row.position);
+            put.addBindValue(row.remoteId);
+            put.addBindValue(row.status);
+            put.addBindValue(compact(row.data));
+            put.addBindValue(row.revision);
+            put.addBindValue(row.conflict.isEmpty() ? QString() : compact(row.conflict));
+            if (!put.exec()) { qWarning() << "Storage:" << put.lastError().text(); return false; }
+        }
+        QSqlQuery del(m_db);
+        del.prepare(QString("DELETE FROM %1 WHERE local_id = ?").arg(table));
+        for (const QString &localId : removedLocalIds) {
+            del.addBindValue(localId);
+            if (!del.exec()) { qWarning() << "Storage:" << del.lastError().text(); return false; }
+        }
+        return true;
+    });
+}
+
+QJsonArray Storage::readQueue(const QString& table) {
+    QSqlQuery q(m_db);
+    q.prepare("SELECT ops FROM sync_queue WHERE table_name = ?");
+    q.addBindValue(table);
+    if (!q.exec() || !q.next()) return QJsonArray();
+    return QJsonDocument::fromJson(q.value(0).toString().toUtf8()).array();
+}
+
+bool Storage::writeQueue(const QString& table, const QJsonArray& ops) {
+    FLOW_TRACE_SCOPE_DETAIL("Storage::writeQueue", Trace::detail(table));
+    QSqlQuery q(m_db);
+    if (ops.isEmpty()) {
+        q.prepare("DELETE FROM sync_queue WHERE table_name = ?");
+        q.addBindValue(table);
+    } else {
+        q.prepare("INSERT OR REPLACE INTO sync_queue (table_name, ops) VALUES (?, ?)");
+        q.addBindValue(table);
+        q.addBindValue(compact(ops));
+    }
+    return transaction([&](){ return q.exec(); });
+}
+
+QString Storage::syncCursor(const QString& table, const QString& userId) {
+    QSqlQuery q(m_db);
+    q.prepare("SELECT cursor FROM sync_state WHERE table_name = ? AND user_id = ?");
+    q.addBindValue(table);
+    q.addBindValue(userId);
+    if (!q.exec() || !q.next()) return QString();
+    return q.value(0).toString();
+}
+
+bool Storage::setSyncCursor(const QString& table, const QString& userId, const QString& cursor) {
+    FLOW_TRACE_SCOPE_DETAIL("Storage::setSyncCursor", Trace::detail(table));
+    QSqlQuery q(m_db);
+    q.prepare("INSERT OR REPLACE INTO sync_state (table_name, user_id, cursor) VALUES (?, ?, ?)");
+    q.addBindValue(table);
+    q.addBindValue(userId);
+    q.addBindValue(cursor);
+    return transaction([&](){ return q.exec(); });
+}
+
+QString Storage::value(const QString& key, const QString& fallback) {
+    QSqlQuery q(m_db);
+    q.prepare("SELECT value FROM settings WHERE key = ?");
+    q.addBindValue(key);
+    if (!q.exec() || !q.next()) return fallback;
+    return q.value(0).toString();
+}
+
+bool Storage::setValue(const QString& key, const QString& value) {
+    FLOW_TRACE_SCOPE("Storage::setValue");
+    QSqlQuery q(m_db);
+    q.prepare("INSERT OR REPLACE INTO settings (key, value) VALUES (?, ?)");
+    q.addBindValue(key);
+    q.addBindValue(value);
+    return transaction([&](){ return q.exec(); });
+}
+
+bool Storage::backup(const QString& path) {
+    // VACUUM cannot run inside a transaction and refuses an existing target
+    if (!isOpen() || m_depth > 0) return false;
+    FLOW_TRACE_SCOPE("Storage::backup");
+    QFile::remove(path);
+    QSqlQuery q(m_db);
+    q.prepare("VACUUM INTO ?");
+    q.addBindValue(path);
+    if (q.exec()) return true;
+    qWarning() << "Storage backup failed:" << q.lastError().text();
+    return false;
+}
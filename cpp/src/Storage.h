@@ -0,0 +1,102 @@
+#pragma once
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QSqlDatabase>
+#include <functional>
+
+// One row of a synced collection table. position orders the rows; an item
+// inserted between two others gets the midpoint, so nothing else is rewritten.
+struct StoredItem {
+    QString localId;
+    double position = 0;
+    QString remoteId;
+    int status = 0;
+    QJsonObject data;  // Traits::toLocal() without local_id/status
+    QString revision;  // server updated_at the local copy is based on
+    QJsonObject conflict; // the server's version while status is Conflict
+};
+
+// Everything a synced collection keeps on disk, read in one go at startup.
+struct StoredCollection {
+    QVector<StoredItem> items;
+    QJsonArray queue;
+    QString cursorUserId;  // whose pull the cursor belongs to
+    QString cursor;
+};
+
+// The profile database, flow.db under AppDataLocation, in WAL mode. It holds
+// the synced collections (bookmarks, notes, todos) with their op queues and
+// pull cursors, workspaces and the saved session; history keeps its own
+// history.db, opened through history(). The schema is versioned through
+// PRAGMA user_version; migrating a new database imports the JSON files earlier
+// versions wrote, renaming each to <name>.imported afterwards.
+//
+// Storage lives on StorageExecutor's thread and owns the database handles
+// there; it is only used from jobs posted to the executor. The executor's
+// reader threads each keep a read-only Storage of their own. Writes go through
+// transaction(), which nests: a job can change several stores under one
+// outer transaction and they commit or roll back together.
+class Storage : public QObject {
+    Q_OBJECT
+public:
+    explicit Storage(const QString& path, QObject* parent = nullptr);
+    ~Storage() override;
+
+    // open and migrate; the first job the executor runs
+    bool init();
+    // open read-only under its own connection name, for a reader thread
+    bool initReader(const QString& connection);
+    // pin a snapshot of the database; reads until endRead() all see it
+    bool beginRead();
+    void endRead();
+
+    QString path() const { return m_path; }
+    bool isOpen() const { return m_db.isOpen(); }
+    int schemaVersion() const;
+    static int latestSchemaVersion();
+    QSqlDatabase database() const { return m_db; }
+    // history.db, opened on first use
+    QSqlDatabase history();
+
+    // Run fn in a transaction; false from fn or a failed statement rolls back.
+    // Inside another transaction() fn joins it and the outermost one decides.
+    bool transaction(const std::function<bool()>& fn);
+    // committed outermost transactions (sync load tests)
+    int commitCount() const { return m_commits; }
+
+    // synced collections, one table each
+    StoredCollection readCollection(const QString& table);
+    QVector<StoredItem> readItems(const QString& table);
+    bool writeItems(const QString& table, const QVector<StoredItem>& upserts, const QStringList& removedLocalIds);
+    QJsonArray readQueue(const QString& table);
+    bool writeQueue(const QString& table, const QJsonArray& ops);
+    QString syncCursor(const QString& table, const QString& userId);
+    bool setSyncCursor(const QString& table, const QString& userId, const QString& cursor);
+
+    // small settings such as the current workspace
+    QString value(const QString& key, const QString& fallback = QString());
+    bool setValue(const QString& key, const QString& value);
+
+    // a consistent copy of the whole database, taken while it stays in use
+    bool backup(const QString& path);
+
+private:
+    bool open();
+    bool migrate();
+    bool importLegacyJson(QStringList& imported);
+    bool exec(const QString& sql);
+
+    QString m_path;
+    QString m_connection;
+    QString m_dataDir;
+    QSqlDatabase m_db;
+    QSqlDatabase m_history;
+    int m_depth = 0;
+    bool m_rollback = false;
+    int m_commits = 0;
+};
@@ -0,0 +1,174 @@
+#include "StorageExecutor.h"
+#include "MetricsRegistry.h"
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QStandardPaths>
+#include <QDir>
+#include <QThread>
+#include <QThreadPool>
+#include <QSemaphore>
+#include <memory>
+#include <utility>
+
+namespace {
+// shown on flow://performance
+struct StorageMetrics {
+    MetricsRegistry::Gauge* queueDepth = MetricsRegistry::gauge("storage.queue_depth");
+    MetricsRegistry::Counter* jobs = MetricsRegistry::counter("storage.jobs");
+    MetricsRegistry::Counter* writes = MetricsRegistry::counter("storage.writes");
+    MetricsRegistry::Counter* failedWrites = MetricsRegistry::counter("storage.failed_writes");
+    MetricsRegistry::Histogram* waitMs = MetricsRegistry::histogram("storage.queue_wait_ms");
+    MetricsRegistry::Histogram* jobMs = MetricsRegistry::histogram("storage.job_ms");
+    MetricsRegistry::Histogram* snapshotReadMs = MetricsRegistry::histogram("storage.snapshot_read_ms");
+};
+
+const StorageMetrics& metrics() {
+    static const StorageMetrics m;
+    return m;
+}
+
+double elapsedMs(const QElapsedTimer& t) { return t.nsecsElapsed() / 1e6; }
+}
+
+StorageExecutor* StorageExecutor::instance() {
+    static QPointer<StorageExecutor> s_instance;
+    if (!s_instance) s_instance = new StorageExecutor(QCoreApplication::instance());
+    return s_instance;
+}
+
+StorageExecutor::StorageExecutor(QObject* parent): QObject(parent), m_thread(new QThread(this)), m_readers(new QThreadPool(this)) {
+    const QString dataDir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    m_storage = new Storage(QDir(dataDir).filePath("flow.db"));
+    m_storage->moveToThread(m_thread);
+    // the connections are removed on the thread that opened them
+    connect(m_thread, &QThread::finished, m_storage, &QObject::deleteLater);
+    m_thread->setObjectName("storage-io");
+    m_thread->start();
+    // readers keep their connection for the life of the pool
+    m_readers->setObjectName("storage-read");
+    m_readers->setMaxThreadCount(qBound(2, QThread::idealThreadCount(), 4));
+    m_readers->setExpiryTimeout(-1);
+    // opening and migrating is the first job, so every later one sees the schema
+    post("storage init", [this](){ m_storage->init(); });
+}
+
+StorageExecutor::~StorageExecutor() {
+    // pending saves reach the disk before the application goes away
+    waitForIdle();
+    // reader connections are removed as their threads exit
+    delete m_readers;
+    m_thread->quit();
+    m_thread->wait();
+}
+
+int StorageExecutor::readerThreadCount() const {
+    return m_readers->maxThreadCount();
+}
+
+void StorageExecutor::post(const char* what, std::function<void()> fn) {
+    metrics().queueDepth->set(++m_queued);
+    QElapsedTimer queued;
+    queued.start();
+    QMetaObject::invokeMethod(m_storage, [this, what, queued, fn = std::move(fn)](){
+        FLOW_TRACE_SCOPE(what);
+        metrics().waitMs->record(elapsedMs(queued));
+        QElapsedTimer ran;
+        ran.start();
+        if (const int ms = m_latencyMs.load()) QThread::msleep(ulong(ms));
+        fn();
+        metrics().jobMs->record(elapsedMs(ran));
+        metrics().jobs->add();
+        metrics().queueDepth->set(--m_queued);
+        ++m_jobs;
+    });
+}
+
+void StorageExecutor::postReader(std::function<void(Storage&)> fn) {
+    // Dispatched from the storage thread, which waits only until the reader
+    // has its snapshot: writes posted earlier are in it, later ones are not.
+    post("storage snapshot", [this, fn = std::move(fn)](){
+        auto pinned = std::make_shared<QSemaphore>();
+        auto fallback = std::make_shared<bool>(false);
+        m_readers->start([this, fn, pinned, fallback](){
+            Storage* reader = threadReader();
+            if (!reader || !reader->beginRead()) {
+                *fallback = true;
+                pinned->release();
+                return;
+            }
+            pinned->release();
+            FLOW_TRACE_SCOPE("storage snapshot read");
+            QElapsedTimer ran;
+            ran.start();
+            if (const int ms = m_latencyMs.load()) QThread::msleep(ulong(ms));
+            fn(*reader);
+            reader->endRead();
+            metrics().snapshotReadMs->record(elapsedMs(ran));
+            ++m_jobs;
+        });
+        pinned->acquire();
+        // no reader connection (e.g. a locked-down profile): read here instead
+        if (*fallback) fn(*m_storage);
+    });
+}
+
+Storage* StorageExecutor::threadReader() {
+    if (!m_threadReaders.hasLocalData()) {
+        auto *reader = new Storage(m_storage->path());
+        const QString connection = QString("flow_reader_%1").arg(quintptr(QThread::currentThreadId()));
+        if (!reader->initReader(connection)) {
+            delete reader;
+            reader = nullptr;
+        }
+        m_threadReaders.setLocalData(reader);
+    }
+    return m_threadReaders.localData();
+}
+
+void StorageExecutor::write(QObject* context, std::function<bool(Storage&)> job, std::function<void(bool ok)> done) {
+    PendingWrite w{context, std::move(job), std::move(done)};
+    if (m_batchDepth > 0) { m_batch.append(std::move(w)); return; }
+    const QVector<PendingWrite> writes{std::move(w)};
+    post("storage write", [this, writes](){
+        const bool ok = m_storage->transaction([&](){ return writes.first().job(*m_storage); });
+        finish(writes, ok);
+    });
+}
+
+void StorageExecutor::run(std::function<void(Storage&)> job) {
+    post("storage run", [this, job = std::move(job)](){ job(*m_storage); });
+}
+
+bool StorageExecutor::batch(const std::function<bool()>& fn) {
+    ++m_batchDepth;
+    const bool ok = fn();
+    if (!ok) m_batchFailed = true;
+    if (--m_batchDepth > 0) return ok;
+    const QVector<PendingWrite> writes = std::exchange(m_batch, {});
+    if (std::exchange(m_batchFailed, false)) {
+        finish(writes, false);
+        return false;
+    }
+    if (writes.isEmpty()) return true;
+    post("storage batch write", [this, writes](){
+        const bool committed = m_storage->transaction([&](){
+            for (const PendingWrite &w : writes) if (!w.job(*m_storage)) return false;
+            return true;
+        });
+        finish(writes, committed);
+    });
+    return true;
+}
+
+// called on either thread; the callbacks always run on ours
+void StorageExecutor::finish(const QVector<PendingWrite>& writes, bool ok) {
+    (ok ? metrics().writes : metrics().failedWrites)->add(writes.size());
+    QMetaObject::invokeMethod(this, [writes, ok](){
+        for (const PendingWrite &w : writes) if (w.context && w.done) w.done(ok);
+    }, Qt::QueuedConnection);
+}
+
+void StorageExecutor::waitForIdle() {
+    QMetaObject::invokeMethod(m_storage, [](){}, Qt::BlockingQueuedConnection);
+    QCoreApplication::sendPostedEvents(this);
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <QObject>
+#include <QPointer>
+#include <QVector>
+#include <QThreadStorage>
+#include <atomic>
+#include <functional>
+#include "Storage.h"
+#include "Trace.h"
+
+class QThread;
+class QThreadPool;
+
+// The storage I/O thread. It owns Storage and with it every database handle
+// (flow.db, history.db), and runs posted jobs one after another in the order
+// they were posted. Managers keep their state in memory and only post work
+// here, so a slow or network-mounted profile directory never blocks the GUI.
+//
+// Completion callbacks run on the executor's (GUI) thread, and only while
+// their context object is alive.
+//
+// A small pool of reader threads, each with a read-only connection, serves
+// readConcurrently() next to the storage thread.
+class StorageExecutor : public QObject {
+    Q_OBJECT
+public:
+    static StorageExecutor* instance();
+    ~StorageExecutor() override;
+
+    // job runs on the storage thread; done gets its result afterwards
+    template <class R>
+    void read(QObject* context, std::function<R(Storage&)> job, std::function<void(R)> done) {
+        QPointer<QObject> ctx(context);
+        post("storage read", [this, ctx, job = std::move(job), done = std::move(done)](){
+            R result = job(*m_storage);
+            QMetaObject::invokeMethod(this, [ctx, done, result = std::move(result)](){
+                FLOW_TRACE_SCOPE("storage read callback");
+                if (ctx && done) done(result);
+            });
+        });
+    }
+    // Like read(), but job runs on one of the reader threads against a
+    // read-only snapshot taken in posting order: it sees every write posted
+    // before it and none posted after. Startup loads use it so the managers'
+    // reads overlap each other instead of queueing behind one another.
+    template <class R>
+    void readConcurrently(QObject* context, std::function<R(Storage&)> job, std::function<void(R)> done) {
+        QPointer<QObject> ctx(context);
+        postReader([this, ctx, job = std::move(job), done = std::move(done)](Storage& s){
+            R result = job(s);
+            QMetaObject::invokeMethod(this, [ctx, done, result = std::move(result)](){
+                FLOW_TRACE_SCOPE("storage read callback");
+                if (ctx && done) done(result);
+            });
+        });
+    }
+    // job runs in its own transaction, or joins the one of an enclosing batch()
+    void write(QObject* context, std::function<bool(Storage&)> job, std::function<void(bool ok)> done = nullptr);
+    // job runs outside any transaction (history.db)
+    void run(std::function<void(Storage&)> job);
+    // ... and done gets its result afterwards, like read()
+    template <class R>
+    void run(QObject* context, std::function<R(Storage&)> job, std::function<void(R)> done) {
+        QPointer<QObject> ctx(context);
+        post("storage run", [this, ctx, job = std::move(job), done = std::move(done)](){
+            R result = job(*m_storage);
+            QMetaObject::invokeMethod(this, [ctx, done, result = std::move(result)](){
+                FLOW_TRACE_SCOPE("storage run callback");
+                if (ctx && done) done(result);
+            });
+        });
+    }
+
+    // Writes posted while fn runs commit in one transaction, e.g. a note and
+    // the workspace it moves to. Returning false drops them all; their done
+    // callbacks get ok == false either way the batch fails.
+    bool batch(const std::function<bool()>& fn);
+
+    // Block until every job posted so far has run and deliver the finished
+    // callbacks. For shutdown and tests, never on a GUI path.
+    void waitForIdle();
+    template <class R>
+    R blockingRead(std::function<R(Storage&)> job) {
+        R result{};
+        QMetaObject::invokeMethod(m_storage, [&](){ result = job(*m_storage); }, Qt::BlockingQueuedConnection);
+        return result;
+    }
+
+    QThread* ioThread() const { return m_thread; }
+    int readerThreadCount() const;
+    // jobs run so far
+    int jobsRun() const { return m_jobs.load(); }
+    // jobs posted and not yet finished
+    int queuedJobs() const { return m_queued.load(); }
+    // every job first waits this long, like a profile on a slow network share (tests)
+    void setSimulatedLatency(int ms) { m_latencyMs.store(ms); }
+
+private:
+    struct PendingWrite {
+        QPointer<QObject> context;
+        std::function<bool(Storage&)> job;
+        std::function<void(bool)> done;
+    };
+
+    explicit StorageExecutor(QObject* parent = nullptr);
+    // what names the job in traces
+    void post(const char* what, std::function<void()> fn);
+    void postReader(std::function<void(Storage&)> fn);
+    Storage* threadReader();
+    void finish(const QVector<PendingWrite>& writes, bool ok);
+
+    QThread* m_thread;
+    Storage* m_storage;
+    QThreadPool* m_readers;
+    QThreadStorage<Storage*> m_threadReaders;
+    int m_batchDepth = 0;
+    bool m_batchFailed = false;
+    QVector<PendingWrite> m_batch;
+    std::atomic<int> m_jobs{0};
+    std::atomic<int> m_queued{0};
+    std::atomic<int> m_latencyMs{0};
+};
@@ -0,0 +1,168 @@
+#include "StoreTransfer.h"
+#include "JsonRowStream.h"
+#include "Storage.h"
+#include "Trace.h"
+#include <QFileInfo>
+#include <QIODevice>
+#include <QJsonDocument>
+#include <QJsonParseError>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QVariant>
+
+namespace {
+constexpr qint64 kReadChunk = 64 * 1024;
+
+bool fail(QString* error, const QString& message) {
+    if (error) *error = message;
+    return false;
+}
+}
+
+StoreTransfer::Format StoreTransfer::formatForPath(const QString& path) {
+    const QString suffix = QFileInfo(path).suffix().toLower();
+    return suffix == "ndjson" || suffix == "jsonl" ? Format::Ndjson : Format::Json;
+}
+
+bool StoreTransfer::parseFormat(const QString& name, Format& format) {
+    if (name == "json") format = Format::Json;
+    else if (name == "ndjson" || name == "jsonl") format = Format::Ndjson;
+    else return false;
+    return true;
+}
+
+bool StoreTransfer::Writer::write(const QJsonObject& record) {
+    if (m_failed) return false;
+    QByteArray line;
+    if (m_format == Format::Json) line = m_count == 0 ? "[\n" : ",\n";
+    line += QJsonDocument(record).toJson(QJsonDocument::Compact);
+    if (m_format == Format::Ndjson) line += '\n';
+    m_failed = m_out.write(line) != line.size();
+    ++m_count;
+    return !m_failed;
+}
+
+bool StoreTransfer::Writer::finish() {
+    if (m_format == Format::Json && !m_failed) {
+        const QByteArray end = m_count == 0 ? "[]\n" : "\n]\n";
+        m_failed = m_out.write(end) != end.size();
+    }
+    return !m_failed;
+}
+
+bool StoreTransfer::read(QIODevice& in, Format format, const std::function<bool(const QJsonObject&)>& found, QString* error) {
+    FLOW_TRACE_SCOPE("StoreTransfer::read");
+    QJsonParseError parseError;
+    if (format == Format::Ndjson) {
+        for (qint64 line = 1; !in.atEnd(); ++line) {
+            const QByteArray text = in.readLine().trimmed();
+            if (text.isEmpty()) continue;
+            const QJsonDocument doc = QJsonDocument::fromJson(text, &parseError);
+            if (!doc.isObject())
+                return fail(error, QString("line %1: %2").arg(line).arg(doc.isNull() ? parseError.errorString() : "not an object"));
+            if (!found(doc.object())) return true;
+        }
+        return true;
+    }
+
+    JsonArraySplitter splitter;
+    QVector<QByteArray> elements;
+    qint64 record = 0;
+    while (!in.atEnd()) {
+        splitter.feed(in.read(kReadChunk), elements);
+        if (splitter.failed()) return fail(error, "not a JSON array");
+        for (const QByteArray &element : std::as_const(elements)) {
+            ++record;
+            const QJsonDocument doc = QJsonDocument::fromJson(element, &parseError);
+            if (!doc.isObject())
+                return fail(error, QString("record %1: %2").arg(record).arg(doc.isNull() ? parseError.errorString() : "not an object"));
+            if (!found(doc.object())) return true;
+        }
+        elements.clear();
+    }
+    return splitter.isComplete() || fail(error, "the JSON array is cut short");
+}
+
+qint64 StoreTransfer::exportCollection(Storage& s, const QString& table, Writer& out) {
+    FLOW_TRACE_SCOPE("StoreTransfer::exportCollection");
+    for (const StoredItem &item : s.readItems(table))
+        if (!out.write(item.data)) return -1;
+    return out.count();
+}
+
+qint64 StoreTransfer::exportHistory(Storage& s, Writer& out) {
+    FLOW_TRACE_SCOPE("StoreTransfer::exportHistory");
+    QSqlDatabase db = s.history();
+    QSqlQuery visits(db);
+    visits.setForwardOnly(true);
+    if (!visits.exec("SELECT url, title, visited_at FROM visits ORDER BY visited_at, id")) return -1;
+    while (visits.next()) {
+        QJsonObject o;
+        o["url"] = visits.value(0).toString();
+        o["title"] = visits.value(1).toString();
+        o["visited_at"] = visits.value(2).toLongLong();
+        if (!out.write(o)) return -1;
+    }
+    QSqlQuery rollups(db);
+    rollups.setForwardOnly(true);
+    if (!rollups.exec("SELECT url, title, period_start, span, visits FROM visit_rollups ORDER BY period_start, url")) return -1;
+    while (rollups.next()) {
+        QJsonObject o;
+        o["url"] = rollups.value(0).toString();
+        o["title"] = rollups.value(1).toString();
+        o["period_start"] = rollups.value(2).toLongLong();
+        o["span"] = rollups.value(3).toLongLong();
+        o["visits"] = rollups.value(4).toLongLong();
+        if (!out.write(o)) return -1;
+    }
+    return out.count();
+}
+
+qint64 StoreTransfer::importHistory(Storage& s, const QVector<QJsonObject>& records) {
+    FLOW_TRACE_SCOPE("StoreTransfer::importHistory");
+    QSqlDatabase db = s.history();
+    if (!db.transaction()) return -1;
+    QSqlQuery visit(db);
+    visit.prepare("INSERT INTO visits (url, title, visited_at) SELECT ?, ?, ? "
+                  "WHERE NOT EXISTS (SELECT 1 FROM visits WHERE url = ? AND visited_at = ?)");
+    QSqlQuery rollup(db);
+    rollup.prepare("INSERT INTO visit_rollups (url, period_start, span, title, visits) VALUES (?, ?, ?, ?, ?) "
+                   "ON CONFLICT (url, period_start, span) DO UPDATE SET visits = excluded.visits "
+                   "WHERE excluded.visits > visits");
+    qint64 added = 0;
+    for (const QJsonObject &o : records) {
+        const QString url = o.value("url").toString();
+        // records without a URL or a time are skipped, not fatal
+        if (url.isEmpty()) continue;
+        const QString title = o.value("title").toString();
+        bool ok = true;
+        if (o.contains("span")) {
+            const qint64 start = o.value("period_start").toInteger();
+            const qint64 span = o.value("span").toInteger();
+            const qint64 count = o.value("visits").toInteger();
+            if (start <= 0 || span <= 0 || count <= 0) continue;
+            rollup.bindValue(0, url);
+            rollup.bindValue(1, start);
+            rollup.bindValue(2, span);
+            rollup.bindValue(3, title);
+            rollup.bindValue(4, count);
+            ok = rollup.exec();
+            if (ok) added += rollup.numRowsAffected();
+        } else {
+            const qint64 at = o.value("visited_at").toInteger();
+            if (at <= 0) continue;
+            visit.bindValue(0, url);
+            visit.bindValue(1, title);
+            visit.bindValue(2, at);
+            visit.bindValue(3, url);
+            visit.bindValue(4, at);
+            ok = visit.exec();
+            if (ok) added += visit.numRowsAffected();
+        }
+        if (!ok) {
+            db.rollback();
+            return -1;
+        }
+    }
+    return db.commit() ? added : -1;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <QJsonObject>
+#include <QString>
+#include <QVector>
+#include <functional>
+
+class QIODevice;
+class Storage;
+
+// Profile data as portable records, for flow_cli export and import: one JSON
+// array, or NDJSON with one object per line. Both are read and written a
+// record at a time, so a history of millions of visits never sits in memory
+// as one document.
+//
+// Bookmarks, notes and todos are their stored rows (Traits::toLocal()).
+// History is its visits, {url, title, visited_at}, followed by its rollups,
+// which also carry period_start, span and visits.
+class StoreTransfer {
+public:
+    enum class Format { Json, Ndjson };
+    // .ndjson and .jsonl are NDJSON, anything else JSON
+    static Format formatForPath(const QString& path);
+    static bool parseFormat(const QString& name, Format& format);
+
+    class Writer {
+    public:
+        Writer(QIODevice& out, Format format): m_out(out), m_format(format) {}
+        bool write(const QJsonObject& record);
+        // closes the array; false when anything failed to write
+        bool finish();
+        qint64 count() const { return m_count; }
+
+    private:
+        QIODevice& m_out;
+        Format m_format;
+        qint64 m_count = 0;
+        bool m_failed = false;
+    };
+
+    // Every record of in, in order, until found returns false. false with
+    // error set on malformed input; records before it were delivered.
+    static bool read(QIODevice& in, Format format, const std::function<bool(const QJsonObject&)>& found, QString* error = nullptr);
+
+    // on the storage thread; records written, -1 on failure
+    static qint64 exportCollection(Storage& s, const QString& table, Writer& out);
+    static qint64 exportHistory(Storage& s, Writer& out);
+    // Adds history records in one transaction, skipping visits already there
+    // (same URL and time) and keeping the larger count of a rollup both have,
+    // so importing an export twice changes nothing. Rows added, -1 on failure.
+    static qint64 importHistory(Storage& s, const QVector<QJsonObject>& records);
+
+    static constexpr int kImportBatch = 10000;
+};
@@ -0,0 +1,44 @@
+#include "SupabaseConfig.h"
+#include <QCoreApplication>
+#include <QStandardPaths>
+#include <QDir>
+#include <QFile>
+#include <QJsonDocument>
+
+bool SupabaseConfig::isValid() const {
+    // the shipped config file only holds placeholders
+    return !url.isEmpty() && !anonKey.isEmpty() && !url.contains("your-project") && anonKey != "YOUR_ANON_KEY";
+}
+
+SupabaseConfig SupabaseConfig::fromJson(const QJsonObject& o) {
+    SupabaseConfig c;
+    c.url = o.value("supabase_url").toString();
+    while (c.url.endsWith('/')) c.url.chop(1);
+    c.anonKey = o.value("anon_key").toString();
+    return c;
+}
+
+SupabaseConfig SupabaseConfig::load() {
+    SupabaseConfig env;
+    env.url = qEnvironmentVariable("FLOW_SUPABASE_URL");
+    env.anonKey = qEnvironmentVariable("FLOW_SUPABASE_ANON_KEY");
+    if (!env.url.isEmpty() && !env.anonKey.isEmpty()) return env;
+
+    QStringList candidates;
+    const QString explicitPath = qEnvironmentVariable("FLOW_SUPABASE_CONFIG");
+    if (!explicitPath.isEmpty()) candidates << explicitPath;
+    candidates << QDir(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation)).filePath("supabase_config.json");
+    const QString appDir = QCoreApplication::applicationDirPath();
+    candidates << QDir(appDir).filePath("config/supabase_config.json")
+               << QDir(appDir).filePath("../config/supabase_config.json");
+
+    for (const QString &path : candidates) {
+        QFile f(path);
+        if (!f.open(QIODevice::ReadOnly)) continue;
+        const QJsonDocument doc = QJsonDocument::fromJson(f.readAll());
+        if (!doc.isObject()) continue;
+        const SupabaseConfig c = fromJson(doc.object());
+        if (!c.url.isEmpty()) return c;
+    }
+    return SupabaseConfig();
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <QString>
+#include <QJsonObject>
+
+// Where the sync backend lives. Resolved once at startup, first match wins:
+//  1. FLOW_SUPABASE_URL / FLOW_SUPABASE_ANON_KEY environment variables
+//  2. the file named by FLOW_SUPABASE_CONFIG
+//  3. <AppDataLocation>/supabase_config.json
+//  4. config/supabase_config.json next to the executable (or one level up)
+// so tests and load runs can point the app at a local mock server.
+struct SupabaseConfig {
+    QString url;
+    QString anonKey;
+
+    bool isValid() const;
+    static SupabaseConfig load();
+    static SupabaseConfig fromJson(const QJsonObject& o);
+};
@@ -0,0 +1,237 @@
+#include "SyncEngineBase.h"
+#include "AuthManager.h"
+#include "JsonRowStream.h"
+#include "Gzip.h"
+#include "Trace.h"
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QNetworkRequest>
+#include <QNetworkReply>
+#include <QNetworkInformation>
+#include <QDateTime>
+#include <QTimer>
+#include <memory>
+
+SyncEngineBase::SyncEngineBase(const QString& table, QObject* parent)
+    : QObject(parent), m_table(table), m_storage(StorageExecutor::instance()),
+      m_queueLength(MetricsRegistry::gauge(QString("sync.%1.queue_length").arg(table))) {
+    m_saveTimer = new QTimer(this);
+    m_saveTimer->setSingleShot(true);
+    m_saveTimer->setInterval(kSaveDelayMs);
+    connect(m_saveTimer, &QTimer::timeout, this, &SyncEngineBase::saveNow);
+    m_retryTimer = new QTimer(this);
+    m_retryTimer->setSingleShot(true);
+    connect(m_retryTimer, &QTimer::timeout, this, [this](){ push(); });
+
+    m_storage->readConcurrently<StoredCollection>(this, [table](Storage& s){ return s.readCollection(table); },
+                                                  [this](StoredCollection stored){ onStoredLoaded(stored); });
+
+    // without a reachability backend the engine assumes it is online
+    if (!QNetworkInformation::instance()) QNetworkInformation::loadBackendByFeatures(QNetworkInformation::Feature::Reachability);
+    if (auto *info = QNetworkInformation::instance())
+        connect(info, &QNetworkInformation::reachabilityChanged, this, &SyncEngineBase::onReachabilityChanged);
+}
+
+bool SyncEngineBase::isOnline() const {
+    const auto *info = QNetworkInformation::instance();
+    if (!info) return true;
+    const auto r = info->reachability();
+    return r != QNetworkInformation::Reachability::Disconnected;
+}
+
+void SyncEngineBase::onReachabilityChanged() {
+    if (!isOnline()) { m_retryTimer->stop(); return; }
+    // backoff was about the outage that just ended
+    m_queue.clearBackoff();
+    push();
+}
+
+SyncOp::Outcome SyncEngineBase::classify(QNetworkReply* reply) {
+    if (reply->error() == QNetworkReply::NoError) return SyncOp::Done;
+    const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    // no HTTP answer at all: connection refused, timeout, DNS, TLS
+    if (status == 0) return SyncOp::Retry;
+    if (status == 408 || status == 425 || status == 429 || status >= 500) return SyncOp::Retry;
+    // expired tokens are refreshed rather than surfaced
+    if (status == 401) return SyncOp::Retry;
+    return SyncOp::Conflict;
+}
+
+qint64 SyncEngineBase::nowMs() {
+    return QDateTime::currentMSecsSinceEpoch();
+}
+
+void SyncEngineBase::scheduleRetry(const QSet<QString>& held) {
+    const qint64 due = m_queue.nextDue(held);
+    if (due < 0 || !canSync() || !isOnline()) { m_retryTimer->stop(); return; }
+    m_retryTimer->start(int(qBound<qint64>(0, due - nowMs(), 10 * 60 * 1000)));
+}
+
+void SyncEngineBase::setSupabaseConfig(const QString& supabaseUrl, const QString& anonKey) {
+    m_supabaseUrl = supabaseUrl;
+    m_anonKey = anonKey;
+}
+
+void SyncEngineBase::setAuthManager(AuthManager* auth) {
+    m_auth = auth;
+    if (!m_auth) return;
+    connect(m_auth, &AuthManager::signedIn, this, &SyncEngineBase::syncFromSupabase);
+    // a renewed token is the same session: send what is queued, no full pull
+    connect(m_auth, &AuthManager::tokenRefreshed, this, &SyncEngineBase::syncPending);
+}
+
+bool SyncEngineBase::canSync() const {
+    return m_auth && m_auth->isSignedIn() && !m_supabaseUrl.isEmpty();
+}
+
+QString SyncEngineBase::userId() const {
+    return m_auth ? m_auth->userId() : QString();
+}
+
+void SyncEngineBase::request(const QByteArray& method, const QString& query, const QByteArray& body, const QByteArray& prefer,
+                             NetworkClient::Priority priority, std::function<void(QNetworkReply*)> onFinished,
+                             std::function<void(QNetworkReply*)> onStarted) {
+    // requests made while the token is being renewed wait for the new one
+    if (!m_auth) { send(method, query, body, prefer, priority, std::move(onFinished), std::move(onStarted), true, m_compress); return; }
+    m_auth->whenTokenReady(this, [=](){ send(method, query, body, prefer, priority, onFinished, onStarted, false, m_compress); });
+}
+
+void SyncEngineBase::send(const QByteArray& method, const QString& query, const QByteArray& body, const QByteArray& prefer,
+                          NetworkClient::Priority priority, std::function<void(QNetworkReply*)> onFinished,
+                          std::function<void(QNetworkReply*)> onStarted, bool retried, bool compress) {
+    const QString token = m_auth ? m_auth->accessToken() : QString();
+    QNetworkRequest req(QUrl(m_supabaseUrl + "/rest/v1/" + m_table + query));
+    if (!body.isEmpty()) req.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
+    req.setRawHeader("apikey", m_anonKey.toUtf8());
+    req.setRawHeader("Authorization", QString("Bearer %1").arg(token).toUtf8());
+    if (!prefer.isEmpty()) req.setRawHeader("Prefer", prefer);
+    // Accept-Encoding is left to QNetworkAccessManager, which decodes the response itself
+    QByteArray wire = body;
+    bool sentEncoded = false;
+    if (compress && body.size() >= kCompressMinBytes) {
+        const QByteArray gz = Gzip::compress(body);
+        if (!gz.isEmpty() && gz.size() < body.size()) {
+            wire = gz;
+            sentEncoded = true;
+            req.setRawHeader("Content-Encoding", "gzip");
+        }
+    }
+    if (!body.isEmpty()) {
+        ++m_wireStats.uploads;
+        m_wireStats.wireBytes += wire.size();
+        if (sentEncoded) ++m_wireStats.compressed;
+    }
+    NetworkClient::instance()->send(req, method, wire, priority, this,
+                                    [=](QNetworkReply* reply){
+        const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+        // a token the server no longer accepts is renewed once and the request replayed
+        if (status == 401 && !retried && m_auth) {
+            m_auth->tokenRejected(token, this, [=](){ send(method, query, body, prefer, priority, onFinished, onStarted, true, compress); });
+            return;
+        }
+        // a server that cannot decode the body gets plain JSON from now on; a 400
+        // is about the content and goes to the caller like any other answer
+        if (sentEncoded && status == 415) {
+            m_compress = false;
+            send(method, query, body, prefer, priority, onFinished, onStarted, retried, false);
+            return;
+        }
+        onFinished(reply);
+    }, onStarted);
+}
+
+void SyncEngineBase::streamRows(const QString& query, NetworkClient::Priority priority,
+                                std::function<void(const QJsonArray&)> onRows,
+                                std::function<void(bool ok, int httpStatus, const QJsonObject& error, int rows)> onDone) {
+    auto *parser = new JsonRowParser;
+    parser->moveToThread(JsonRowParser::workerThread());
+    connect(parser, &JsonRowParser::rowsParsed, this, onRows);
+    auto status = std::make_shared<int>(0);
+    auto error = std::make_shared<QJsonObject>();
+    connect(parser, &JsonRowParser::finished, this, [status, error, onDone](bool ok, int rows){ onDone(ok, *status, *error, rows); });
+    // a collection destroyed mid-download takes its parser along
+    connect(this, &QObject::destroyed, parser, &QObject::deleteLater);
+
+    auto onStarted = [this, parser](QNetworkReply* reply){
+        connect(reply, &QNetworkReply::readyRead, this, [reply, parser](){
+            // error bodies (a 401 about to be replayed, a 400) are left for onFinished
+            if (reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt() / 100 != 2) return;
+            const QByteArray chunk = reply->readAll();
+            QMetaObject::invokeMethod(parser, [parser, chunk](){ parser->feed(chunk); });
+        });
+    };
+    request("GET", query, QByteArray(), QByteArray(), priority, [parser, status, error](QNetworkReply* reply){
+        *status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+        if (reply->error() != QNetworkReply::NoError) {
+            *error = QJsonDocument::fromJson(reply->readAll()).object();
+            QMetaObject::invokeMethod(parser, [parser](){ parser->abort(); });
+            return;
+        }
+        const QByteArray rest = reply->readAll();
+        QMetaObject::invokeMethod(parser, [parser, rest](){
+            parser->feed(rest);
+            parser->finish();
+        });
+    }, onStarted);
+}
+
+void SyncEngineBase::scheduleSave() {
+    if (!m_saveTimer->isActive()) m_saveTimer->start();
+}
+
+void SyncEngineBase::flushSave() {
+    if (!m_saveTimer->isActive()) return;
+    m_saveTimer->stop();
+    saveNow();
+}
+
+void SyncEngineBase::saveNow() {
+    FLOW_TRACE_SCOPE_DETAIL("SyncEngineBase::saveNow", Trace::detail(m_table));
+    QStringList removed;
+    const QVector<StoredItem> rows = takeUnsaved(removed);
+    QStringList written;
+    written.reserve(rows.size());
+    for (const StoredItem &row : rows) written.append(row.localId);
+    const QString table = m_table;
+    const QJsonArray queue = m_queue.toJson();
+    m_queueLength->set(queue.size());
+    m_storage->write(this, [table, rows, removed, queue](Storage& s){
+        // the queue is written with the items, so both describe the same moment
+        return s.writeItems(table, rows, removed) && s.writeQueue(table, queue);
+    }, [this, written, removed](bool ok){
+        if (ok) { ++m_saveCount; return; }
+        // the rows stay unsaved for the next attempt
+        restoreUnsaved(written, removed);
+        scheduleSave();
+    });
+}
+
+void SyncEngineBase::onStoredLoaded(const StoredCollection& stored) {
+    FLOW_TRACE_SCOPE_DETAIL("SyncEngineBase::onStoredLoaded", Trace::detail(m_table));
+    // ops queued before the stored ones arrived are about items created meanwhile
+    QJsonArray ops = stored.queue;
+    for (const QJsonValue &op : m_queue.toJson()) ops.append(op);
+    m_queue = SyncOpQueue::fromJson(ops);
+    m_queueLength->set(m_queue.size());
+    m_cursorUserId = stored.cursorUserId;
+    m_cursor = stored.cursor;
+    applyStored(stored.items);
+    m_loaded = true;
+    emit loaded();
+    if (m_pullAfterLoad) pull();
+    else if (m_pushAfterLoad) push();
+    m_pullAfterLoad = m_pushAfterLoad = false;
+}
+
+QString SyncEngineBase::pullCursor() const {
+    // a cursor from another account would skip that account's older rows
+    return m_cursorUserId == userId() ? m_cursor : QString();
+}
+
+void SyncEngineBase::setPullCursor(const QString& cursor) {
+    m_cursorUserId = userId();
+    m_cursor = cursor;
+    m_storage->write(this, [table = m_table, user = m_cursorUserId, cursor](Storage& s){
+        return s.setSyncCursor(table, user, cursor);
+    });
+}
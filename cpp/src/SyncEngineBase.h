@@ -0,0 +1,166 @@
+#pragma once
+
+#include <QObject>
+#include <QString>
+#include <QByteArray>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <functional>
+#include "SyncOpQueue.h"
+#include "NetworkClient.h"
+#include "StorageExecutor.h"
+#include "MetricsRegistry.h"
+
+class AuthManager;
+class QNetworkReply;
+class QTimer;
+
+// One sync state for every synced item type. Unsynced items are the dirty set
+// that the next push sends.
+enum class SyncStatus { Synced=0, Syncing=1, Unsynced=2, Conflict=3 };
+
+// Upload volume of one collection: what whole uncompressed rows would have
+// cost, what the changed columns came to and what went on the wire.
+struct SyncWireStats {
+    qint64 uploads = 0;        // POST/PATCH requests with a body
+    qint64 fullRowBytes = 0;
+    qint64 payloadBytes = 0;
+    qint64 wireBytes = 0;
+    qint64 compressed = 0;     // uploads sent with Content-Encoding: gzip
+    qint64 savedBytes() const { return fullRowBytes - wireBytes; }
+};
+
+// The non-template half of SyncedCollection<Traits>: signals, the Supabase
+// connection, the collection's table in Storage, the outbound operation queue
+// with its retry timer, connectivity and the delta-pull cursor. The stored
+// state is read on the storage thread after construction; until loaded() the
+// collection holds only what was added meanwhile and does not sync.
+// moc cannot handle class templates, so everything that does not need the item
+// type lives here.
+class SyncEngineBase : public QObject {
+    Q_OBJECT
+public:
+    explicit SyncEngineBase(const QString& table, QObject* parent = nullptr);
+
+    QString table() const { return m_table; }
+    void setSupabaseConfig(const QString& supabaseUrl, const QString& anonKey);
+    void setAuthManager(AuthManager* auth);
+
+    // how many transactions have written changed rows (sync load tests)
+    int saveCount() const { return m_saveCount; }
+    // post a pending debounced save now
+    void flushSave();
+    bool isLoaded() const { return m_loaded; }
+
+    // outbound changes not yet confirmed by the server, including deletes
+    int queuedOperations() const { return m_queue.size(); }
+    // false while QNetworkInformation reports no connectivity; pushes wait for it
+    bool isOnline() const;
+
+    SyncWireStats wireStats() const { return m_wireStats; }
+    // gzip request bodies of kCompressMinBytes and more; switched off by
+    // itself when the server answers 415 to an encoded body
+    void setRequestCompression(bool enabled) { m_compress = enabled; }
+    bool requestCompression() const { return m_compress; }
+
+public slots:
+    void syncFromSupabase() { pull(); }
+    void syncPending() { push(); }
+
+signals:
+    void itemsChanged();
+    void syncPendingCountChanged(int count);
+    void lastRemoveAvailable(bool available);
+    void loaded();
+    // a pull has merged its last page, or failed
+    void pullFinished(bool ok);
+
+protected:
+    static constexpr int kBatchSize = 500;        // rows per POST
+    static constexpr int kDeleteBatchSize = 100;  // ids per DELETE ?id=in.(...)
+    static constexpr int kPatchBatchSize = 100;   // ids per PATCH ?id=in.(...)
+    static constexpr int kPullPageSize = 1000;
+    static constexpr int kSaveDelayMs = 200;
+    static constexpr int kUndoMs = 5000;
+    static constexpr int kApplyBudgetMs = 8;      // merging pulled rows, per event-loop turn
+    static constexpr int kCompressMinBytes = 1024;
+    // a push this small is someone editing, not a bulk upload, and goes first
+    static constexpr int kInteractiveRows = 20;
+    static NetworkClient::Priority priorityFor(int rows) {
+        return rows <= kInteractiveRows ? NetworkClient::Interactive : NetworkClient::Background;
+    }
+
+    virtual void push() = 0;
+    virtual void pull() = 0;
+    // take the rows changed or removed since the last save; a failed write gives them back
+    virtual QVector<StoredItem> takeUnsaved(QStringList& removedLocalIds) = 0;
+    virtual void restoreUnsaved(const QStringList& localIds, const QStringList& removedLocalIds) = 0;
+    // the stored rows have arrived; items added before that go after them
+    virtual void applyStored(const QVector<StoredItem>& rows) = 0;
+
+    // How a failed request is treated: conflicts (409, 412) and other
+    // permanent client errors go to the user, the rest is retried with backoff.
+    static SyncOp::Outcome classify(QNetworkReply* reply);
+    static qint64 nowMs();
+    // arm the retry timer for the op that becomes due first; held ops wait for the user
+    void scheduleRetry(const QSet<QString>& held = QSet<QString>());
+
+    bool canSync() const;
+    QString userId() const;
+    // REST call on /rest/v1/<table><query> through the shared NetworkClient;
+    // onFinished gets the finished reply, which is deleted afterwards. A 401 is
+    // answered by one token refresh and a replay before onFinished sees it.
+    void request(const QByteArray& method, const QString& query, const QByteArray& body, const QByteArray& prefer,
+                 NetworkClient::Priority priority, std::function<void(QNetworkReply*)> onFinished,
+                 std::function<void(QNetworkReply*)> onStarted = nullptr);
+    // GET whose row array is parsed on JsonRowParser::workerThread() while it
+    // downloads. onRows gets batches on this thread; onDone runs once after the
+    // last of them, with ok false on HTTP or parse errors. error is the body of
+    // a refused request, PostgREST's {"code", "message", ...}.
+    void streamRows(const QString& query, NetworkClient::Priority priority,
+                    std::function<void(const QJsonArray&)> onRows,
+                    std::function<void(bool ok, int httpStatus, const QJsonObject& error, int rows)> onDone);
+    // coalesce bursts of changes into one transaction
+    void scheduleSave();
+
+    // an upload of payloadBytes that would have been fullRowBytes as whole rows
+    void countUpload(qint64 fullRowBytes, qint64 payloadBytes) {
+        m_wireStats.fullRowBytes += fullRowBytes;
+        m_wireStats.payloadBytes += payloadBytes;
+    }
+
+    // newest updated_at seen by a pull for the signed-in user, kept in sync_state
+    // and cached here
+    QString pullCursor() const;
+    void setPullCursor(const QString& cursor);
+
+    SyncOpQueue m_queue;
+    // push()/pull() asked for before the stored state was there
+    bool m_pushAfterLoad = false;
+    bool m_pullAfterLoad = false;
+
+private:
+    void send(const QByteArray& method, const QString& query, const QByteArray& body, const QByteArray& prefer,
+              NetworkClient::Priority priority, std::function<void(QNetworkReply*)> onFinished,
+              std::function<void(QNetworkReply*)> onStarted, bool retried, bool compress);
+    void saveNow();
+    void onStoredLoaded(const StoredCollection& stored);
+    void onReachabilityChanged();
+
+    QString m_table;
+    StorageExecutor* m_storage;
+    // sync.<table>.queue_length, ops waiting to go up as of the last save
+    MetricsRegistry::Gauge* m_queueLength;
+    bool m_loaded = false;
+    QString m_cursorUserId;
+    QString m_cursor;
+    int m_saveCount = 0;
+    QTimer* m_saveTimer;
+    QTimer* m_retryTimer;
+
+    QString m_supabaseUrl;
+    QString m_anonKey;
+    AuthManager* m_auth = nullptr;
+    bool m_compress = true;
+    SyncWireStats m_wireStats;
+};
@@ -0,0 +1,187 @@
+#include "SyncOpQueue.h"
+#include <QJsonObject>
+#include <QRandomGenerator>
+#include <QUuid>
+#include <algorithm>
+
+SyncOp& SyncOpQueue::add(SyncOp::Kind kind, const QString& localId, const QString& remoteId) {
+    SyncOp op;
+    op.kind = kind;
+    op.localId = localId;
+    op.remoteId = remoteId;
+    // the id goes with every POST of the row, so a repeated one cannot add a twin
+    if (kind == SyncOp::Create && remoteId.isEmpty()) op.remoteId = QUuid::createUuid().toString(QUuid::WithoutBraces);
+    op.seq = m_nextSeq++;
+    return m_ops.insert(localId, op).value();
+}
+
+void SyncOpQueue::enqueueCreate(const QString& localId) {
+    if (m_ops.contains(localId)) return;
+    add(SyncOp::Create, localId, QString());
+}
+
+void SyncOpQueue::enqueueUpdate(const QString& localId, const QString& remoteId, const QStringList& fields) {
+    auto it = m_ops.find(localId);
+    if (it == m_ops.end()) {
+        SyncOp &op = add(remoteId.isEmpty() ? SyncOp::Create : SyncOp::Update, localId, remoteId);
+        if (op.kind == SyncOp::Update) op.fields = fields;
+        return;
+    }
+    if (it->inFlight) {
+        if (it->followUp == SyncOp::Delete) return;
+        it->followUpFields = it->followUp == SyncOp::Update ? mergeFields(it->followUpFields, fields) : fields;
+        it->followUp = SyncOp::Update;
+        return;
+    }
+    // a waiting create sends the current content anyway; a waiting update widens
+    if (it->kind == SyncOp::Update) it->fields = mergeFields(it->fields, fields);
+}
+
+void SyncOpQueue::enqueueDelete(const QString& localId, const QString& remoteId) {
+    auto it = m_ops.find(localId);
+    if (it == m_ops.end()) {
+        if (!remoteId.isEmpty()) add(SyncOp::Delete, localId, remoteId);
+        return;
+    }
+    if (it->inFlight) { it->followUp = SyncOp::Delete; return; }
+    if (it->kind == SyncOp::Create && !it->sent) { m_ops.erase(it); return; } // never reached the server
+    it->kind = SyncOp::Delete;
+    if (!remoteId.isEmpty()) it->remoteId = remoteId;
+}
+
+void SyncOpQueue::adopt(const QString& localId, const QString& remoteId) {
+    auto it = m_ops.find(localId);
+    if (it == m_ops.end() || it->inFlight || it->kind != SyncOp::Create) return;
+    it->kind = SyncOp::Update;
+    it->remoteId = remoteId;
+    it->fields.clear(); // the remote row may differ in any column
+}
+
+const SyncOp* SyncOpQueue::find(const QString& localId) const {
+    auto it = m_ops.constFind(localId);
+    return it == m_ops.constEnd() ? nullptr : &it.value();
+}
+
+QStringList SyncOpQueue::deletedRemoteIds() const {
+    QStringList out;
+    for (const SyncOp &op : m_ops) if (op.kind == SyncOp::Delete || op.followUp == SyncOp::Delete) out << op.remoteId;
+    return out;
+}
+
+QVector<SyncOp> SyncOpQueue::takeDue(qint64 nowMs, const QSet<QString>& held) {
+    QVector<SyncOp*> due;
+    for (auto it = m_ops.begin(); it != m_ops.end(); ++it) {
+        if (it->inFlight || it->notBefore > nowMs || held.contains(it.key())) continue;
+        due.append(&it.value());
+    }
+    std::sort(due.begin(), due.end(), [](const SyncOp* a, const SyncOp* b){ return a->seq < b->seq; });
+    QVector<SyncOp> out;
+    out.reserve(due.size());
+    for (SyncOp* op : due) {
+        op->inFlight = true;
+        if (op->kind == SyncOp::Create) op->sent = true;
+        out.append(*op);
+    }
+    return out;
+}
+
+bool SyncOpQueue::complete(const QString& localId, SyncOp::Outcome outcome, const QString& newRemoteId, qint64 nowMs) {
+    auto it = m_ops.find(localId);
+    if (it == m_ops.end()) return false;
+    SyncOp &op = *it;
+    op.inFlight = false;
+    if (!newRemoteId.isEmpty()) op.remoteId = newRemoteId;
+    const int followUp = op.followUp;
+    const QStringList followUpFields = op.followUpFields;
+    op.followUp = -1;
+    op.followUpFields.clear();
+
+    if (outcome == SyncOp::Retry) {
+        // the resend also carries what changed meanwhile
+        if (followUp == SyncOp::Update && op.kind == SyncOp::Update) op.fields = mergeFields(op.fields, followUpFields);
+        ++op.attempts;
+        op.notBefore = nowMs + backoffMs(op.attempts, 0.5 + QRandomGenerator::global()->generateDouble());
+        // the failed create may have stored the row all the same
+        if (followUp == SyncOp::Delete) op.kind = SyncOp::Delete;
+        return true;
+    }
+    // done, or a conflict the user resolves; a delete asked for meanwhile still goes out
+    if (followUp == SyncOp::Delete && !op.remoteId.isEmpty()) {
+        op.kind = SyncOp::Delete;
+        op.attempts = 0;
+        op.notBefore = 0;
+        return true;
+    }
+    if (outcome == SyncOp::Done && followUp == SyncOp::Update && !op.remoteId.isEmpty()) {
+        op.kind = SyncOp::Update;
+        op.fields = followUpFields;
+        op.attempts = 0;
+        op.notBefore = 0;
+        return true;
+    }
+    m_ops.erase(it);
+    return false;
+}
+
+qint64 SyncOpQueue::nextDue(const QSet<QString>& held) const {
+    qint64 next = -1;
+    for (const SyncOp &op : m_ops) {
+        if (op.inFlight || held.contains(op.localId)) continue;
+        if (next < 0 || op.notBefore < next) next = op.notBefore;
+    }
+    return next;
+}
+
+void SyncOpQueue::clearBackoff() {
+    for (SyncOp &op : m_ops) op.notBefore = 0;
+}
+
+QStringList SyncOpQueue::mergeFields(const QStringList& a, const QStringList& b) {
+    if (a.isEmpty() || b.isEmpty()) return QStringList();
+    QStringList out = a;
+    for (const QString &f : b) if (!out.contains(f)) out.append(f);
+    return out;
+}
+
+qint64 SyncOpQueue::backoffMs(int attempts, double jitter) {
+    const qint64 base = 1000LL << qMin(attempts - 1, 9);
+    return qint64(qMin<qint64>(base, 5 * 60 * 1000) * jitter);
+}
+
+QJsonArray SyncOpQueue::toJson() const {
+    QVector<const SyncOp*> ordered;
+    for (const SyncOp &op : m_ops) ordered.append(&op);
+    std::sort(ordered.begin(), ordered.end(), [](const SyncOp* a, const SyncOp* b){ return a->seq < b->seq; });
+    QJsonArray arr;
+    for (const SyncOp* op : ordered) {
+        QJsonObject o;
+        o["kind"] = int(op->kind);
+        o["local_id"] = op->localId;
+        o["remote_id"] = op->remoteId;
+        o["attempts"] = op->attempts;
+        if (op->followUp >= 0) o["follow_up"] = op->followUp;
+        if (op->sent) o["sent"] = true;
+        // an interrupted send is repeated together with its follow-up
+        const QStringList fields = op->followUp == SyncOp::Update ? mergeFields(op->fields, op->followUpFields) : op->fields;
+        if (op->kind == SyncOp::Update && !fields.isEmpty()) o["fields"] = QJsonArray::fromStringList(fields);
+        arr.append(o);
+    }
+    return arr;
+}
+
+SyncOpQueue SyncOpQueue::fromJson(const QJsonArray& arr) {
+    SyncOpQueue q;
+    for (const QJsonValue &v : arr) {
+        const QJsonObject o = v.toObject();
+        const QString localId = o.value("local_id").toString();
+        if (localId.isEmpty()) continue;
+        SyncOp &op = q.add(SyncOp::Kind(qBound(0, o.value("kind").toInt(), 2)), localId, o.value("remote_id").toString());
+        op.attempts = o.value("attempts").toInt();
+        op.sent = o.value("sent").toBool();
+        for (const QJsonValue &f : o.value("fields").toArray()) op.fields.append(f.toString());
+        // a send interrupted by shutdown is repeated; a delete queued behind it
+        // wins, also over a create that may have got through
+        if (o.value("follow_up").toInt(-1) == SyncOp::Delete) op.kind = SyncOp::Delete;
+    }
+    return q;
+}
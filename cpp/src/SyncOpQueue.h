@@ -0,0 +1,71 @@
+#pragma once
+
+#include <QString>
+#include <QHash>
+#include <QSet>
+#include <QStringList>
+#include <QVector>
+#include <QJsonArray>
+
+// One outbound change for one local item. Later changes to the same item are
+// folded into it: create+edit is a create, edit+delete is a delete and
+// create+delete is nothing at all, unless the create was sent: a POST that
+// timed out may still have stored the row, so that becomes a delete of it.
+struct SyncOp {
+    enum Kind { Create=0, Update=1, Delete=2 };
+    enum Outcome { Done, Retry, Conflict };
+
+    Kind kind = Create;
+    QString localId;
+    QString remoteId;      // Create: the id the row is created with, chosen here
+    int attempts = 0;      // failed sends so far
+    qint64 notBefore = 0;  // epoch ms; backoff after a transient failure
+    quint64 seq = 0;       // enqueue order
+    bool inFlight = false;
+    bool sent = false;     // Create: a POST went out, so the row may exist
+    int followUp = -1;     // Kind queued while in flight, -1 for none
+    QStringList fields;         // Update: remote columns to send, empty for the whole row
+    QStringList followUpFields; // ... of an Update queued while in flight
+};
+
+// Durable, collapsing queue of SyncOps keyed by local item id. Persisted by
+// SyncEngineBase next to the items so pending work survives restarts.
+class SyncOpQueue {
+public:
+    void enqueueCreate(const QString& localId);
+    // fields are the remote columns that changed; empty means the whole row
+    void enqueueUpdate(const QString& localId, const QString& remoteId, const QStringList& fields = QStringList());
+    void enqueueDelete(const QString& localId, const QString& remoteId);
+    // a remote row matched an unsent create: update that row instead
+    void adopt(const QString& localId, const QString& remoteId);
+    void drop(const QString& localId) { m_ops.remove(localId); }
+
+    bool contains(const QString& localId) const { return m_ops.contains(localId); }
+    const SyncOp* find(const QString& localId) const;
+    bool isEmpty() const { return m_ops.isEmpty(); }
+    int size() const { return m_ops.size(); }
+    QStringList deletedRemoteIds() const;
+
+    // ops that may be sent now, oldest first; they are marked in flight
+    QVector<SyncOp> takeDue(qint64 nowMs, const QSet<QString>& held = QSet<QString>());
+    // Settle an in-flight op. Returns whether an op for the item is still queued.
+    bool complete(const QString& localId, SyncOp::Outcome outcome, const QString& newRemoteId, qint64 nowMs);
+    // earliest notBefore of a waiting op that is not held, or -1 when nothing waits
+    qint64 nextDue(const QSet<QString>& held = QSet<QString>()) const;
+    // connectivity came back: retry everything now, keeping attempt counts
+    void clearBackoff();
+
+    QJsonArray toJson() const;
+    static SyncOpQueue fromJson(const QJsonArray& arr);
+
+    // 1s, 2s, 4s ... capped at 5 minutes, scaled by jitter in [0.5, 1.5)
+    static qint64 backoffMs(int attempts, double jitter);
+    // union of two field sets where empty stands for every column
+    static QStringList mergeFields(const QStringList& a, const QStringList& b);
+
+private:
+    SyncOp& add(SyncOp::Kind kind, const QString& localId, const QString& remoteId);
+
+    QHash<QString, SyncOp> m_ops;
+    quint64 m_nextSeq = 1;
+};
@@ -0,0 +1,816 @@
+#pragma once
+
+#include "SyncEngineBase.h"
+#include "Trace.h"
+#include <QVector>
+#include <QHash>
+#include <QMap>
+#include <QSet>
+#include <QStringList>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QDateTime>
+#include <QUrl>
+#include <QUuid>
+#include <cmath>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QNetworkReply>
+#include <memory>
+
+// A locally persisted list of items mirrored to one Supabase table. It owns
+// storage, dirty tracking, batched push, delta pull, conflicts and undo-delete;
+// the per-type parts come from a traits class:
+//
+//   struct NoteTraits {
+//       using Item = NoteItem;                    // has QString id and SyncStatus status
+//       static constexpr const char* table = "notes";
+//       static QString identityKey(const Item&);  // dedupes remote rows against unsynced local ones
+//       static QJsonObject toRemote(const Item&); // row columns without id/user_id
+//       static Item fromRemote(const QJsonObject&);
+//       static QJsonObject toLocal(const Item&);  // stored row data, without status
+//       static Item fromLocal(const QJsonObject&);
+//   };
+//
+// Items live in their own table of Storage and are read on the storage thread
+// after construction; a save posts only the rows that changed since the
+// previous one, written in one transaction with the op queue.
+// Every local change becomes an op in the durable SyncOpQueue. Push sends the
+// due ops in a few requests: creates as one POST array per batch, each row
+// with the id its op picked so a repeated POST adds nothing, whole-row
+// edits as one upsert per batch, edits of some columns as one PATCH
+// ?id=in.(...) per set of new values and removals as DELETE ?id=in.(...).
+// Transient failures are retried with backoff and nothing is sent while
+// offline; only conflicts are shown to the user. Each item remembers the server
+// updated_at it was last pushed or pulled at, so a pull only reports a conflict
+// for rows someone else changed since; the local edit of a conflict stays
+// queued, unsent, until the user picks a side. Pull asks only for rows after the last one it merged in
+// (updated_at, id) order, falling back to a full listing when the table has no
+// updated_at column.
+// Responses are parsed on a worker while they download and merged in
+// time-boxed batches, so a large table never stalls the GUI thread.
+template <class Traits>
+class SyncedCollection : public SyncEngineBase {
+public:
+    using Item = typename Traits::Item;
+
+    explicit SyncedCollection(QObject* parent = nullptr)
+        : SyncEngineBase(QString::fromLatin1(Traits::table), parent) {}
+    ~SyncedCollection() override { flushSave(); }
+
+    QVector<Item> items() const { return m_items; }
+    int count() const { return m_items.size(); }
+    // stable per item, unlike its index or the server id of an unsynced item
+    QVector<QString> localIds() const { return m_localIds; }
+    // -1 when the item is gone
+    int indexOfLocalId(const QString& localId) {
+        if (!m_localIndexValid) {
+            m_localIndex.clear();
+            m_localIndex.reserve(m_localIds.size());
+            for (int i = 0; i < m_localIds.size(); ++i) m_localIndex.insert(m_localIds[i], i);
+            m_localIndexValid = true;
+        }
+        return m_localIndex.value(localId, -1);
+    }
+
+    int pendingCount() const {
+        int c = 0;
+        for (const auto &it : m_items) if (it.status == SyncStatus::Unsynced || it.status == SyncStatus::Syncing) ++c;
+        return c;
+    }
+
+    QList<int> conflictIndices() const {
+        QList<int> out;
+        for (int i = 0; i < m_items.size(); ++i) if (m_items[i].status == SyncStatus::Conflict) out.append(i);
+        return out;
+    }
+
+    // the server's side of a conflict as the pull that found it saw it; an
+    // item with an empty id when there is none (a refused upload)
+    Item remoteVersion(int index) const {
+        if (index < 0 || index >= m_items.size()) return Item();
+        return m_conflicts.value(m_localIds[index]);
+    }
+
+    void append(Item item) {
+        FLOW_TRACE_SCOPE_DETAIL("SyncedCollection::append", Traits::table);
+        item.status = SyncStatus::Unsynced;
+        insertAt(m_items.size(), item, QString());
+        m_queue.enqueueUpdate(m_localIds.last(), item.id);
+        changed();
+        if (canSync()) push();
+    }
+
+    // Add items at the end as one change: a single save, itemsChanged and
+    // push however many there are (imports).
+    void appendMany(QVector<Item> items) {
+        if (items.isEmpty()) return;
+        FLOW_TRACE_SCOPE_DETAIL("SyncedCollection::appendMany", Traits::table);
+        m_items.reserve(m_items.size() + items.size());
+        m_localIds.reserve(m_localIds.size() + items.size());
+        m_positions.reserve(m_positions.size() + items.size());
+        for (Item &item : items) {
+            item.status = SyncStatus::Unsynced;
+            insertAt(m_items.size(), item, QString());
+            m_queue.enqueueUpdate(m_localIds.last(), item.id);
+        }
+        changed();
+        if (canSync()) push();
+    }
+
+    // replace the content of an item and queue the changed columns for upload
+    void update(int index, Item item) {
+        if (index < 0 || index >= m_items.size()) return;
+        FLOW_TRACE_SCOPE_DETAIL("SyncedCollection::update", Traits::table);
+        item.id = m_items[index].id;
+        const QStringList fields = changedColumns(Traits::toRemote(m_items[index]), Traits::toRemote(item));
+        if (fields.isEmpty()) {
+            // nothing the server stores has changed
+            item.status = m_items[index].status;
+            m_items[index] = item;
+            touch(index);
+            changed();
+            return;
+        }
+        // an edit to one side of a conflict does not resolve it
+        item.status = m_conflicts.contains(m_localIds[index]) ? SyncStatus::Conflict : SyncStatus::Unsynced;
+        m_items[index] = item;
+        touch(index);
+        m_queue.enqueueUpdate(m_localIds[index], item.id, fields);
+        changed();
+        if (canSync()) push();
+    }
+
+    void remove(int index) {
+        if (index < 0 || index >= m_items.size()) return;
+        FLOW_TRACE_SCOPE_DETAIL("SyncedCollection::remove", Traits::table);
+        m_queue.enqueueDelete(m_localIds[index], m_items[index].id);
+        forget(m_localIds[index]);
+        removeAt(index);
+        changed();
+        if (canSync()) push();
+    }
+
+    // Remove now, delete remotely once the undo window has passed.
+    void removeWithUndo(int index) {
+        if (index < 0 || index >= m_items.size()) return;
+        FLOW_TRACE_SCOPE_DETAIL("SyncedCollection::removeWithUndo", Traits::table);
+        if (m_hasPendingUndo) finalizeUndo();
+        m_lastRemoved = m_items[index];
+        m_lastRemovedLocalId = m_localIds[index];
+        m_lastRemovedIndex = index;
+        removeAt(index);
+        changed();
+        m_hasPendingUndo = true;
+        emit lastRemoveAvailable(true);
+        if (!m_undoTimer) {
+            m_undoTimer = new QTimer(this);
+            m_undoTimer->setSingleShot(true);
+            connect(m_undoTimer, &QTimer::timeout, this, [this](){ finalizeUndo(); });
+        }
+        m_undoTimer->start(kUndoMs);
+    }
+
+    void undoLastRemove() {
+        if (!m_hasPendingUndo) return;
+        FLOW_TRACE_SCOPE_DETAIL("SyncedCollection::undoLastRemove", Traits::table);
+        if (m_undoTimer) m_undoTimer->stop();
+        insertAt(qBound(0, m_lastRemovedIndex, m_items.size()), m_lastRemoved, m_lastRemovedLocalId);
+        clearUndo();
+        changed();
+    }
+
+    bool hasPendingUndo() const { return m_hasPendingUndo; }
+
+    void retrySync(int index) { markUnsynced(index); }
+    // overwrite the remote row with the local copy
+    void keepLocal(int index) { markUnsynced(index); }
+
+    // replace the local copy with the remote row
+    void keepRemote(int index) {
+        if (index < 0 || index >= m_items.size() || !canSync()) return;
+        const QString id = m_items[index].id;
+        if (id.isEmpty()) return;
+        // a large note is parsed on the worker like a pull
+        auto row = std::make_shared<QJsonObject>();
+        streamRows("?id=eq." + id + "&select=*", NetworkClient::Interactive,
+                   [row](const QJsonArray& rows){ if (row->isEmpty() && !rows.isEmpty()) *row = rows.at(0).toObject(); },
+                   [this, id, row](bool ok, int, const QJsonObject&, int){
+            if (!ok || row->isEmpty()) return;
+            for (int i = 0; i < m_items.size(); ++i) {
+                if (m_items[i].id != id) continue;
+                Item remote = Traits::fromRemote(*row);
+                remote.status = SyncStatus::Synced;
+                m_items[i] = remote;
+                touch(i);
+                m_queue.drop(m_localIds[i]);
+                m_conflicts.remove(m_localIds[i]);
+                setRevision(m_localIds[i], row->value("updated_at").toString());
+                break;
+            }
+            changed();
+        });
+    }
+
+protected:
+    void push() override {
+        if (!isLoaded()) { m_pushAfterLoad = true; return; }
+        if (!canSync() || !isOnline()) return;
+        if (m_pushInFlight) { m_pushAgain = true; return; }
+
+        const QVector<SyncOp> due = m_queue.takeDue(nowMs(), heldOps());
+        QVector<int> creates;
+        // edits grouped by the columns they touch; "" is whole rows
+        QMap<QString, QVector<int>> updates;
+        QStringList deleteLocalIds;
+        for (const SyncOp &op : due) {
+            if (op.kind == SyncOp::Delete) { deleteLocalIds.append(op.localId); continue; }
+            const int i = indexOfLocalId(op.localId);
+            if (i < 0) { m_queue.drop(op.localId); continue; }
+            m_items[i].status = SyncStatus::Syncing;
+            if (op.kind == SyncOp::Create) { creates.append(i); continue; }
+            QStringList fields = op.fields;
+            fields.sort();
+            updates[fields.join(',')].append(i);
+        }
+        if (creates.isEmpty() && updates.isEmpty() && deleteLocalIds.isEmpty()) { scheduleRetry(heldOps()); return; }
+
+        m_pushInFlight = true;
+        m_pushAgain = false;
+        auto outstanding = std::make_shared<int>(0);
+        for (int from = 0; from < creates.size(); from += kBatchSize) sendBatch(creates.mid(from, kBatchSize), true, outstanding);
+        for (auto it = updates.cbegin(); it != updates.cend(); ++it) {
+            if (!it.key().isEmpty()) { sendPatches(*it, it.key().split(','), outstanding); continue; }
+            for (int from = 0; from < it->size(); from += kBatchSize) sendBatch(it->mid(from, kBatchSize), false, outstanding);
+        }
+        for (int from = 0; from < deleteLocalIds.size(); from += kDeleteBatchSize) sendDeletes(deleteLocalIds.mid(from, kDeleteBatchSize), outstanding);
+        emit itemsChanged();
+        emit syncPendingCountChanged(pendingCount());
+    }
+
+    void pull() override {
+        if (!isLoaded()) { m_pullAfterLoad = true; return; }
+        if (!canSync() || m_pullInFlight) return;
+        m_pullInFlight = true;
+        m_pullCursor = m_deltaSupported ? pullCursor() : QString();
+        m_pageLast = m_pullCursor;
+        fetchPage(m_pageLast);
+    }
+
+    QVector<StoredItem> takeUnsaved(QStringList& removedLocalIds) override {
+        removedLocalIds = QStringList(m_removed.cbegin(), m_removed.cend());
+        m_removed.clear();
+        QVector<StoredItem> rows;
+        rows.reserve(m_dirty.size());
+        for (const QString &localId : std::as_const(m_dirty)) {
+            const int i = indexOfLocalId(localId);
+            if (i < 0) continue;
+            const Item &it = m_items[i];
+            StoredItem row;
+            row.localId = localId;
+            row.position = m_positions[i];
+            row.remoteId = it.id;
+            // in-flight uploads are still queued and go out again after a restart
+            row.status = int(it.status == SyncStatus::Syncing ? SyncStatus::Unsynced : it.status);
+            row.data = Traits::toLocal(it);
+            row.revision = m_revisions.value(localId);
+            const auto conflict = m_conflicts.constFind(localId);
+            if (conflict != m_conflicts.constEnd()) row.conflict = Traits::toLocal(*conflict);
+            rows.append(row);
+        }
+        m_dirty.clear();
+        return rows;
+    }
+
+    void restoreUnsaved(const QStringList& localIds, const QStringList& removedLocalIds) override {
+        for (const QString &localId : localIds) if (indexOfLocalId(localId) >= 0) m_dirty.insert(localId);
+        for (const QString &localId : removedLocalIds) if (indexOfLocalId(localId) < 0) m_removed.insert(localId);
+    }
+
+    void applyStored(const QVector<StoredItem>& rows) override {
+        FLOW_TRACE_SCOPE_DETAIL("SyncedCollection::applyStored", Traits::table);
+        QVector<Item> items;
+        QVector<QString> localIds;
+        QVector<double> positions;
+        items.reserve(rows.size() + m_items.size());
+        localIds.reserve(rows.size() + m_items.size());
+        positions.reserve(rows.size() + m_items.size());
+        bool queued = false;
+        for (const StoredItem &row : rows) {
+            Item it = Traits::fromLocal(row.data);
+            it.status = SyncStatus(row.status);
+            if (!row.revision.isEmpty()) m_revisions.insert(row.localId, row.revision);
+            if (it.status == SyncStatus::Conflict && !row.conflict.isEmpty()) {
+                // still waiting for the user; the local edit stays queued
+                m_conflicts.insert(row.localId, Traits::fromLocal(row.conflict));
+            } else if (m_queue.contains(row.localId)) {
+                it.status = SyncStatus::Unsynced;
+            } else if (it.status == SyncStatus::Unsynced || it.status == SyncStatus::Syncing) {
+                // data saved before the queue existed only carries the status
+                m_queue.enqueueUpdate(row.localId, it.id);
+                it.status = SyncStatus::Unsynced;
+                queued = true;
+            }
+            items.append(it);
+            localIds.append(row.localId);
+            positions.append(row.position);
+        }
+        // items added while the rows were being read go after them
+        double next = positions.isEmpty() ? 0 : std::floor(positions.last()) + 1;
+        for (int i = 0; i < m_items.size(); ++i) {
+            items.append(m_items[i]);
+            localIds.append(m_localIds[i]);
+            positions.append(next++);
+            m_dirty.insert(m_localIds[i]);
+        }
+        if (m_hasPendingUndo) m_lastRemovedIndex += rows.size();
+        m_items = std::move(items);
+        m_localIds = std::move(localIds);
+        m_positions = std::move(positions);
+        m_localIndexValid = false;
+        if (queued || !m_dirty.isEmpty()) scheduleSave();
+        emit itemsChanged();
+        emit syncPendingCountChanged(pendingCount());
+    }
+
+private:
+    // Insert keeping the stored order: the new row's position falls between
+    // its neighbours', so no other row has to be rewritten.
+    void insertAt(int index, const Item& item, QString localId) {
+        if (localId.isEmpty()) localId = QUuid::createUuid().toString(QUuid::WithoutBraces);
+        double position = 0;
+        if (!m_positions.isEmpty()) {
+            if (index >= m_positions.size()) position = std::floor(m_positions.last()) + 1;
+            else if (index == 0) position = std::floor(m_positions.first()) - 1;
+            else position = (m_positions[index - 1] + m_positions[index]) / 2;
+        }
+        m_items.insert(index, item);
+        m_localIds.insert(index, localId);
+        m_positions.insert(index, position);
+        m_localIndexValid = false;
+        m_removed.remove(localId);
+        m_dirty.insert(localId);
+        // halved too often to tell the neighbours apart: renumber everything once
+        const bool tie = (index > 0 && m_positions[index - 1] >= position)
+                         || (index + 1 < m_positions.size() && m_positions[index + 1] <= position);
+        if (!tie) return;
+        for (int i = 0; i < m_positions.size(); ++i) {
+            m_positions[i] = i;
+            touch(i);
+        }
+    }
+
+    void removeAt(int index) {
+        m_dirty.remove(m_localIds[index]);
+        m_removed.insert(m_localIds[index]);
+        m_items.remove(index);
+        m_localIds.remove(index);
+        m_positions.remove(index);
+        m_localIndexValid = false;
+    }
+
+    // the item's row is rewritten by the next save
+    void touch(int index) { m_dirty.insert(m_localIds[index]); }
+
+    void setRevision(const QString& localId, const QString& updatedAt) {
+        if (updatedAt.isEmpty() || m_revisions.value(localId) == updatedAt) return;
+        m_revisions.insert(localId, updatedAt);
+        m_dirty.insert(localId);
+    }
+
+    // whether a pulled row was written after the version the local copy is
+    // based on; with no known base (rows stored before revisions were kept,
+    // tables without updated_at) it is assumed to be
+    bool changedSinceBase(const QString& localId, const QString& updatedAt) const {
+        const QString base = m_revisions.value(localId);
+        if (base.isEmpty() || updatedAt.isEmpty()) return true;
+        const QDateTime a = QDateTime::fromString(updatedAt, Qt::ISODateWithMs);
+        const QDateTime b = QDateTime::fromString(base, Qt::ISODateWithMs);
+        if (a.isValid() && b.isValid()) return a > b;
+        return updatedAt > base;
+    }
+
+    // the item is gone for good
+    void forget(const QString& localId) {
+        m_revisions.remove(localId);
+        m_conflicts.remove(localId);
+    }
+
+    // ops push leaves alone: an item inside the undo window keeps them until
+    // the window closes, one in conflict until the user picks a side
+    QSet<QString> heldOps() const {
+        QSet<QString> held;
+        held.reserve(m_conflicts.size() + 1);
+        if (m_hasPendingUndo) held.insert(m_lastRemovedLocalId);
+        for (auto it = m_conflicts.constBegin(); it != m_conflicts.constEnd(); ++it) held.insert(it.key());
+        return held;
+    }
+
+    void changed() {
+        scheduleSave();
+        emit itemsChanged();
+        emit syncPendingCountChanged(pendingCount());
+    }
+
+    void markUnsynced(int index) {
+        if (index < 0 || index >= m_items.size()) return;
+        m_conflicts.remove(m_localIds[index]);
+        m_items[index].status = SyncStatus::Unsynced;
+        touch(index);
+        m_queue.enqueueUpdate(m_localIds[index], m_items[index].id);
+        changed();
+        push();
+    }
+
+    void clearUndo() {
+        m_hasPendingUndo = false;
+        m_lastRemovedIndex = -1;
+        m_lastRemoved = Item();
+        m_lastRemovedLocalId.clear();
+        emit lastRemoveAvailable(false);
+    }
+
+    void finalizeUndo() {
+        if (m_undoTimer) m_undoTimer->stop();
+        m_queue.enqueueDelete(m_lastRemovedLocalId, m_lastRemoved.id);
+        forget(m_lastRemovedLocalId);
+        clearUndo();
+        scheduleSave();
+        emit syncPendingCountChanged(pendingCount());
+        if (canSync()) push();
+    }
+
+    void batchFinished(const std::shared_ptr<int>& outstanding) {
+        changed();
+        if (--*outstanding > 0) return;
+        m_pushInFlight = false;
+        if (m_pushAgain) push();
+        else scheduleRetry(heldOps());
+    }
+
+    // Settle the ops of a finished batch and derive item states from what is
+    // left in the queue: still queued is Unsynced, gone is Synced or Conflict.
+    // createdIds are the ids of the rows a create batch stored; written are
+    // the rows the server returned, their updated_at is the new base of each
+    // item.
+    void settle(const QStringList& localIds, SyncOp::Outcome outcome, const QStringList& createdIds, const QJsonArray& written) {
+        QHash<QString, QString> revisions;
+        for (const QJsonValue &v : written) {
+            const QJsonObject row = v.toObject();
+            revisions.insert(row.value("id").toString(), row.value("updated_at").toString());
+        }
+        const qint64 now = nowMs();
+        for (int j = 0; j < localIds.size(); ++j) {
+            const QString newId = createdIds.value(j);
+            const bool queued = m_queue.complete(localIds[j], outcome, newId, now);
+            if (queued && outcome != SyncOp::Retry) m_pushAgain = true; // follow-up edit or delete
+            const int i = indexOfLocalId(localIds[j]);
+            if (i < 0) {
+                // created while sitting in the undo window: remember the row to delete
+                if (m_hasPendingUndo && localIds[j] == m_lastRemovedLocalId && !newId.isEmpty()) m_lastRemoved.id = newId;
+                continue;
+            }
+            Item &it = m_items[i];
+            touch(i);
+            if (!newId.isEmpty()) it.id = newId;
+            if (outcome == SyncOp::Done) setRevision(localIds[j], revisions.value(it.id));
+            if (queued) it.status = SyncStatus::Unsynced;
+            else it.status = outcome == SyncOp::Conflict ? SyncStatus::Conflict : SyncStatus::Synced;
+        }
+    }
+
+    static QStringList changedColumns(const QJsonObject& before, const QJsonObject& after) {
+        QStringList out;
+        for (auto it = after.constBegin(); it != after.constEnd(); ++it) if (before.value(it.key()) != it.value()) out.append(it.key());
+        for (auto it = before.constBegin(); it != before.constEnd(); ++it) if (!after.contains(it.key())) out.append(it.key());
+        return out;
+    }
+
+    // Upload whole items: creates as one POST array, edits of every column as
+    // an upsert on the primary key, so one request covers rows with different
+    // values. A create carries the id its op picked and skips a row that is
+    // there already: a POST repeated after a timeout or a restart may find the
+    // row the first one stored, and only adds the ones it did not.
+    void sendBatch(const QVector<int>& indices, bool create, const std::shared_ptr<int>& outstanding) {
+        QJsonArray rows;
+        QStringList localIds, ids;
+        localIds.reserve(indices.size());
+        ids.reserve(indices.size());
+        const QString uid = userId();
+        for (int i : indices) {
+            const Item &it = m_items[i];
+            const SyncOp* op = create ? m_queue.find(m_localIds[i]) : nullptr;
+            const QString id = op ? op->remoteId : it.id;
+            QJsonObject o = Traits::toRemote(it);
+            o["user_id"] = uid;
+            o["id"] = id;
+            rows.append(o);
+            localIds.append(m_localIds[i]);
+            ids.append(id);
+        }
+        ++*outstanding;
+        const QByteArray body = QJsonDocument(rows).toJson(QJsonDocument::Compact);
+        countUpload(body.size(), body.size());
+        auto onFinished = [this, localIds, ids, create, outstanding](QNetworkReply* r){
+            const SyncOp::Outcome outcome = classify(r);
+            QJsonArray written;
+            if (outcome == SyncOp::Done) written = QJsonDocument::fromJson(r->readAll()).array();
+            settle(localIds, outcome, create && outcome == SyncOp::Done ? ids : QStringList(), written);
+            if (create && outcome == SyncOp::Done) resendSkipped(localIds, ids, written);
+            batchFinished(outstanding);
+        };
+        const NetworkClient::Priority priority = priorityFor(rows.size());
+        // creates always ask for the rows back: a skipped one is missing there
+        if (create) request("POST", "?on_conflict=id&select=" + QString(m_deltaSupported ? "id,updated_at" : "id"), body,
+                            "resolution=ignore-duplicates,return=representation", priority, onFinished);
+        else request("POST", "?on_conflict=id" + returnedColumns(), body, "resolution=merge-duplicates," + returnPreference(),
+                     priority, onFinished);
+    }
+
+    // A create the server skipped repeated one that got through before: the
+    // stored row has the content of then, so the item goes up again as a
+    // whole-row edit.
+    void resendSkipped(const QStringList& localIds, const QStringList& ids, const QJsonArray& written) {
+        QSet<QString> stored;
+        stored.reserve(written.size());
+        for (const QJsonValue &v : written) stored.insert(v.toObject().value("id").toString());
+        for (int j = 0; j < localIds.size(); ++j) {
+            if (stored.contains(ids[j])) continue;
+            const int i = indexOfLocalId(localIds[j]);
+            if (i < 0 || m_items[i].status == SyncStatus::Conflict) continue;
+            m_queue.enqueueUpdate(localIds[j], ids[j]);
+            m_items[i].status = SyncStatus::Unsynced;
+            m_pushAgain = true;
+        }
+    }
+
+    // Edits of some columns. An upsert of partial rows is no option: Postgres
+    // checks NOT NULL columns before it resolves ON CONFLICT, so it is refused.
+    // A PATCH sets one body on every row its filter matches, so the rows are
+    // grouped by the values they get (a bulk "mark done" is one request) and
+    // each group goes out as ?id=in.(...).
+    void sendPatches(const QVector<int>& indices, const QStringList& fields, const std::shared_ptr<int>& outstanding) {
+        QHash<QByteArray, QVector<int>> byBody;
+        QVector<QByteArray> bodies; // in queue order
+        for (int i : indices) {
+            const QJsonObject full = Traits::toRemote(m_items[i]);
+            QJsonObject o;
+            for (const QString &f : fields) o[f] = full.value(f);
+            const QByteArray body = QJsonDocument(o).toJson(QJsonDocument::Compact);
+            QVector<int> &group = byBody[body];
+            if (group.isEmpty()) bodies.append(body);
+            group.append(i);
+        }
+        for (const QByteArray &body : std::as_const(bodies)) {
+            const QVector<int> &group = byBody[body];
+            for (int from = 0; from < group.size(); from += kPatchBatchSize) sendPatch(group.mid(from, kPatchBatchSize), body, outstanding);
+        }
+    }
+
+    void sendPatch(const QVector<int>& indices, const QByteArray& body, const std::shared_ptr<int>& outstanding) {
+        QStringList localIds, ids;
+        localIds.reserve(indices.size());
+        ids.reserve(indices.size());
+        const QString uid = userId();
+        qint64 fullRowBytes = 0;
+        for (int i : indices) {
+            const Item &it = m_items[i];
+            QJsonObject full = Traits::toRemote(it);
+            full["user_id"] = uid;
+            full["id"] = it.id;
+            fullRowBytes += QJsonDocument(full).toJson(QJsonDocument::Compact).size() + 1;
+            localIds.append(m_localIds[i]);
+            ids.append(it.id);
+        }
+        ++*outstanding;
+        countUpload(fullRowBytes + 1, body.size());
+        const QString filter = ids.size() == 1 ? "?id=eq." + ids.first() : "?id=in.(" + ids.join(',') + ")";
+        request("PATCH", filter + returnedColumns(), body, returnPreference(), priorityFor(ids.size()),
+                [this, localIds, outstanding](QNetworkReply* r){
+            const SyncOp::Outcome outcome = classify(r);
+            QJsonArray written;
+            if (outcome == SyncOp::Done) written = QJsonDocument::fromJson(r->readAll()).array();
+            settle(localIds, outcome, QStringList(), written);
+            batchFinished(outstanding);
+        });
+    }
+
+    // Edits bring back the new updated_at of their rows, the base later pulls
+    // are compared with; a table without the column has no delta pull to compare.
+    QString returnedColumns() const { return m_deltaSupported ? QStringLiteral("&select=id,updated_at") : QString(); }
+    QByteArray returnPreference() const { return m_deltaSupported ? "return=representation" : "return=minimal"; }
+
+    void sendDeletes(const QStringList& localIds, const std::shared_ptr<int>& outstanding) {
+        QStringList ids;
+        for (const QString &lid : localIds) if (const SyncOp* op = m_queue.find(lid)) ids.append(op->remoteId);
+        ++*outstanding;
+        request("DELETE", "?id=in.(" + ids.join(',') + ")", QByteArray(), QByteArray(), priorityFor(ids.size()),
+                [this, localIds, outstanding](QNetworkReply* r){
+            SyncOp::Outcome outcome = classify(r);
+            // there is no local item left to show a refused delete on
+            if (outcome == SyncOp::Conflict) outcome = SyncOp::Done;
+            const qint64 now = nowMs();
+            for (const QString &lid : localIds) m_queue.complete(lid, outcome, QString(), now);
+            batchFinished(outstanding);
+        });
+    }
+
+    // Keyset pages: the rows after the last one read, in (updated_at, id) order.
+    // updated_at alone is not unique (one transaction stamps all its rows with
+    // the same now()), and an offset shifts when rows are written mid-pull;
+    // this way tied rows are neither skipped nor read twice and rewritten rows
+    // only move to the end. The cursor is "<updated_at> <id>", or the id alone
+    // on a full listing.
+    void fetchPage(const QString& after) {
+        QString query = "?user_id=eq." + userId();
+        if (m_deltaSupported) {
+            query += "&order=updated_at.asc,id.asc";
+            const int space = after.indexOf(' ');
+            if (space > 0) {
+                const QString tree = QString("(updated_at.gt.\"%1\",and(updated_at.eq.\"%1\",id.gt.%2))")
+                                         .arg(after.left(space), after.mid(space + 1));
+                query += "&or=" + QString::fromLatin1(QUrl::toPercentEncoding(tree));
+            } else if (!after.isEmpty()) {
+                // a cursor saved without the id: read the rows of that instant again,
+                // merging a known row changes nothing
+                query += "&updated_at=gte." + QString::fromLatin1(QUrl::toPercentEncoding(after));
+            }
+        } else {
+            query += "&order=id.asc";
+            if (!after.isEmpty()) query += "&id=gt." + after;
+        }
+        query += QString("&limit=%1").arg(kPullPageSize);
+        m_pageDone = false;
+        // pulls are bulk transfers; edits made meanwhile overtake them
+        streamRows(query, NetworkClient::Background,
+                   [this](const QJsonArray& rows){
+            if (!rows.isEmpty()) m_pageLast = cursorOf(rows.last().toObject());
+            m_incoming.append(rows);
+            scheduleApply();
+        },
+                   [this](bool ok, int status, const QJsonObject& error, int rows){
+            if (!ok) {
+                m_incoming.clear();
+                // Only a table without updated_at falls back to full listings:
+                // PostgREST refuses ordering by a column the table does not have
+                // (42703). Any other refusal, a bad cursor say, is a failed pull
+                // and keeps delta pulls and conflict detection.
+                if (status == 400 && m_deltaSupported && error.value("code").toString() == "42703"
+                    && error.value("message").toString().contains("updated_at")) {
+                    m_deltaSupported = false;
+                    m_pullCursor.clear();
+                    m_pageLast.clear();
+                    fetchPage(QString());
+                    return;
+                }
+                m_pullInFlight = false;
+                changed();
+                emit pullFinished(false);
+                push();
+                return;
+            }
+            m_pageDone = true;
+            m_pageRows = rows;
+            scheduleApply();
+        });
+    }
+
+    QString cursorOf(const QJsonObject& row) const {
+        const QString id = row.value("id").toString();
+        return m_deltaSupported ? row.value("updated_at").toString() + ' ' + id : id;
+    }
+
+    void scheduleApply() {
+        if (m_applyScheduled) return;
+        m_applyScheduled = true;
+        QTimer::singleShot(0, this, [this](){ applyIncoming(); });
+    }
+
+    // Merge parsed batches for at most kApplyBudgetMs per event-loop turn so
+    // the window keeps painting, then go on with the next page or finish.
+    void applyIncoming() {
+        FLOW_TRACE_SCOPE_DETAIL("SyncedCollection::applyIncoming", Traits::table);
+        m_applyScheduled = false;
+        QElapsedTimer budget;
+        budget.start();
+        while (!m_incoming.isEmpty() && budget.elapsed() < kApplyBudgetMs)
+            merge(m_incoming.takeFirst(), !m_pullCursor.isEmpty());
+        if (!m_incoming.isEmpty()) { scheduleApply(); return; }
+        if (!m_pageDone) return; // still downloading
+        m_pageDone = false;
+        if (m_pageRows >= kPullPageSize) {
+            fetchPage(m_pageLast);
+            return;
+        }
+        m_pullInFlight = false;
+        if (m_deltaSupported && !m_pageLast.isEmpty() && m_pageLast != m_pullCursor) setPullCursor(m_pageLast);
+        changed();
+        emit pullFinished(true);
+        // local changes made while signed out go up once the remote state is merged
+        push();
+    }
+
+    // Apply remote rows: untouched local copies follow the server and unknown
+    // rows are added. A local edit only conflicts with a row of a delta pull
+    // written after the version the edit was based on, not with the echo of
+    // this client's own push; on a full listing the local edit wins.
+    void merge(const QJsonArray& rows, bool delta) {
+        FLOW_TRACE_SCOPE_DETAIL("SyncedCollection::merge", Traits::table);
+        QHash<QString, int> byId, byKey;
+        byId.reserve(m_items.size());
+        for (int i = 0; i < m_items.size(); ++i) {
+            if (!m_items[i].id.isEmpty()) byId.insert(m_items[i].id, i);
+            // the row of a create whose answer was lost comes back under the op's id
+            else if (const SyncOp* op = m_queue.find(m_localIds[i]); op && op->kind == SyncOp::Create) byId.insert(op->remoteId, i);
+            const QString key = Traits::identityKey(m_items[i]);
+            if (!key.isEmpty() && !byKey.contains(key)) byKey.insert(key, i);
+        }
+        const QStringList deletedIds = m_queue.deletedRemoteIds();
+        QSet<QString> deleting(deletedIds.cbegin(), deletedIds.cend());
+        if (m_hasPendingUndo && !m_lastRemoved.id.isEmpty()) deleting.insert(m_lastRemoved.id);
+
+        for (const QJsonValue &v : rows) {
+            const QJsonObject o = v.toObject();
+            const QString updatedAt = o.value("updated_at").toString();
+            Item remote = Traits::fromRemote(o);
+            remote.status = SyncStatus::Synced;
+            if (remote.id.isEmpty() || deleting.contains(remote.id)) continue;
+
+            int i = byId.value(remote.id, -1);
+            if (i < 0) {
+                i = byKey.value(Traits::identityKey(remote), -1);
+                // the same item under another id is a duplicate row, not a new item
+                if (i >= 0 && !m_items[i].id.isEmpty()) continue;
+            }
+            if (i < 0) {
+                insertAt(m_items.size(), remote, QString());
+                byId.insert(remote.id, m_items.size() - 1);
+                setRevision(m_localIds.last(), updatedAt);
+                continue;
+            }
+            Item &local = m_items[i];
+            const QString &lid = m_localIds[i];
+            const bool same = Traits::toRemote(local) == Traits::toRemote(remote);
+            switch (local.status) {
+            case SyncStatus::Syncing:
+                break;
+            case SyncStatus::Synced:
+                setRevision(lid, updatedAt);
+                if (same) break;
+                local = remote;
+                touch(i);
+                break;
+            case SyncStatus::Unsynced:
+            case SyncStatus::Conflict:
+                touch(i);
+                if (same) {
+                    local.id = remote.id;
+                    local.status = SyncStatus::Synced;
+                    m_queue.drop(lid);
+                    m_conflicts.remove(lid);
+                    setRevision(lid, updatedAt);
+                } else if (local.id.isEmpty()) {
+                    // adopt the row instead of creating a twin
+                    local.id = remote.id;
+                    m_queue.adopt(lid, remote.id);
+                    setRevision(lid, updatedAt);
+                } else if (delta && changedSinceBase(lid, updatedAt)) {
+                    // both sides changed: the local edit stays queued but is not
+                    // sent until the user has seen both and picked one
+                    local.status = SyncStatus::Conflict;
+                    m_conflicts.insert(lid, remote);
+                }
+                break;
+            }
+        }
+    }
+
+    QVector<Item> m_items;
+    QVector<QString> m_localIds; // stable per item, keys the op queue
+    QVector<double> m_positions; // sort key of each item's row
+    QSet<QString> m_dirty;       // local ids whose rows the next save writes
+    QSet<QString> m_removed;     // local ids whose rows the next save deletes
+    QHash<QString, int> m_localIndex;
+    bool m_localIndexValid = false;
+    QHash<QString, QString> m_revisions; // local id -> server updated_at the local copy is based on
+    QHash<QString, Item> m_conflicts;    // local id -> remote side of an unresolved conflict
+
+    bool m_pushInFlight = false;
+    bool m_pushAgain = false;
+    bool m_pullInFlight = false;
+    bool m_deltaSupported = true;
+    // state of the running pull
+    QString m_pullCursor;
+    QString m_pageLast;  // cursor of the last row read so far
+    QVector<QJsonArray> m_incoming; // parsed, not yet merged
+    bool m_applyScheduled = false;
+    bool m_pageDone = false;
+    int m_pageRows = 0;
+
+    // Undo buffer
+    Item m_lastRemoved;
+    QString m_lastRemovedLocalId;
+    int m_lastRemovedIndex = -1;
+    QTimer* m_undoTimer = nullptr;
+    bool m_hasPendingUndo = false;
+};
@@ -0,0 +1,219 @@
+#include "TabMetricsSampler.h"
+#include "ProfileManager.h"
+#include "MetricsRegistry.h"
+#include <QWebEngineView>
+#include <QWebEnginePage>
+#include <QWebEngineScript>
+#include <QTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QDateTime>
+#include <QPointer>
+#include <QVariantMap>
+#ifdef Q_OS_LINUX
+#include <unistd.h>
+#endif
+
+namespace {
+
+// Paint and navigation entries are relative to the page's timeOrigin, which is
+// the navigation start, so they line up with our own navigation clock.
+const char* kPaintTimingScript = R"JS(
+(function() {
+    var r = {};
+    performance.getEntriesByType('paint').forEach(function(e) { r[e.name] = e.startTime; });
+    var n = performance.getEntriesByType('navigation')[0];
+    if (n) r['dom-content-loaded'] = n.domContentLoadedEventEnd;
+    return r;
+})()
+)JS";
+
+QByteArray readProcFile(qint64 pid, const char* name) {
+    QFile f(QString("/proc/%1/%2").arg(pid).arg(name));
+    if (!f.open(QIODevice::ReadOnly)) return QByteArray();
+    return f.readAll();
+}
+
+} // namespace
+
+TabMetricsSampler::TabMetricsSampler(QObject* parent): QObject(parent) {
+    m_timer = new QTimer(this);
+    m_timer->setInterval(2000);
+    connect(m_timer, &QTimer::timeout, this, &TabMetricsSampler::sample);
+    m_timer->start();
+    m_sampleClock.start();
+    // per-tab memory and CPU on flow://performance, one entry per window's tabs
+    MetricsRegistry::addSource("tabs", this, [this](){ return toJson().value("tabs").toArray(); });
+}
+
+void TabMetricsSampler::trackView(QWebEngineView* view) {
+    if (!view || m_entries.contains(view)) return;
+    m_entries.insert(view, Entry());
+    connect(view, &QWebEngineView::loadStarted, this, [this, view](){ onLoadStarted(view); });
+    connect(view, &QWebEngineView::loadFinished, this, [this, view](bool ok){ onLoadFinished(view, ok); });
+    connect(view, &QObject::destroyed, this, [this, view](){ m_entries.remove(view); });
+}
+
+void TabMetricsSampler::untrackView(QWebEngineView* view) {
+    if (!m_entries.remove(view)) return;
+    disconnect(view, nullptr, this, nullptr);
+}
+
+QList<QWebEngineView*> TabMetricsSampler::views() const { return m_entries.keys(); }
+
+TabMetrics TabMetricsSampler::metricsFor(QWebEngineView* view) const {
+    return m_entries.value(view).metrics;
+}
+
+void TabMetricsSampler::setInterval(int ms) { m_timer->setInterval(qMax(100, ms)); }
+int TabMetricsSampler::interval() const { return m_timer->interval(); }
+
+void TabMetricsSampler::onLoadStarted(QWebEngineView* view) {
+    auto it = m_entries.find(view);
+    if (it == m_entries.end()) return;
+    NavigationTiming nav;
+    nav.url = view->url().toString();
+    nav.startedAt = QDateTime::currentMSecsSinceEpoch();
+    auto &navs = it->metrics.navigations;
+    navs.append(nav);
+    if (navs.size() > kMaxNavigationsPerTab) navs.remove(0, navs.size() - kMaxNavigationsPerTab);
+    it->navClock.start();
+}
+
+void TabMetricsSampler::onLoadFinished(QWebEngineView* view, bool ok) {
+    auto it = m_entries.find(view);
+    if (it == m_entries.end() || it->metrics.navigations.isEmpty()) return;
+    auto &nav = it->metrics.navigations.last();
+    // the url is only final once redirects have been followed
+    nav.url = view->url().toString();
+    nav.loadFinishedMs = it->navClock.isValid() ? it->navClock.elapsed() : -1;
+    nav.ok = ok;
+    if (ok) collectPaintTiming(view);
+}
+
+void TabMetricsSampler::collectPaintTiming(QWebEngineView* view) {
+    QPointer<QWebEngineView> guard(view);
+    const qint64 startedAt = m_entries.value(view).metrics.navigations.last().startedAt;
+    // run in the application world so page scripts can't tamper with the result
+    view->page()->runJavaScript(kPaintTimingScript, QWebEngineScript::ApplicationWorld, [this, guard, startedAt](const QVariant &v){
+        if (!guard) return;
+        auto it = m_entries.find(guard.data());
+        if (it == m_entries.end()) return;
+        // match by start time in case another navigation began in the meantime
+        for (auto &nav : it->metrics.navigations) {
+            if (nav.startedAt != startedAt) continue;
+            const QVariantMap m = v.toMap();
+            if (m.contains("first-paint")) nav.firstPaintMs = qRound64(m.value("first-paint").toDouble());
+            if (m.contains("first-contentful-paint")) nav.firstContentfulPaintMs = qRound64(m.value("first-contentful-paint").toDouble());
+            if (m.contains("dom-content-loaded")) nav.domContentLoadedMs = qRound64(m.value("dom-content-loaded").toDouble());
+            break;
+        }
+    });
+}
+
+void TabMetricsSampler::sample() {
+    const double elapsedSec = m_sampleClock.restart() / 1000.0;
+#ifdef Q_OS_LINUX
+    static const qint64 pageSize = sysconf(_SC_PAGESIZE);
+    static const double ticksPerSec = sysconf(_SC_CLK_TCK);
+#endif
+    for (auto it = m_entries.begin(); it != m_entries.end(); ++it) {
+        QWebEngineView* view = it.key();
+        Entry &e = it.value();
+        const qint64 pid = view->page() ? view->page()->renderProcessPid() : 0;
+        e.metrics.pid = pid;
+        if (pid <= 0) {
+            e.metrics.rssBytes = 0;
+            e.metrics.cpuPercent = 0.0;
+            e.lastPid = 0;
+            continue;
+        }
+#ifdef Q_OS_LINUX
+        qint64 rss = 0;
+        if (parseStatm(readProcFile(pid, "statm"), pageSize, &rss)) e.metrics.rssBytes = rss;
+        quint64 utime = 0, stime = 0;
+        if (parseStat(readProcFile(pid, "stat"), &utime, &stime)) {
+            const quint64 ticks = utime + stime;
+            // a new renderer (crash, cross-site navigation) restarts the CPU baseline
+            if (pid == e.lastPid && ticks >= e.lastCpuTicks && elapsedSec > 0)
+                e.metrics.cpuPercent = (ticks - e.lastCpuTicks) / ticksPerSec / elapsedSec * 100.0;
+            else
+                e.metrics.cpuPercent = 0.0;
+            e.lastCpuTicks = ticks;
+        }
+        e.lastPid = pid;
+#else
+        Q_UNUSED(elapsedSec)
+#endif
+    }
+    emit sampled();
+}
+
+bool TabMetricsSampler::parseStatm(const QByteArray& statm, qint64 pageSize, qint64* rssBytes) {
+    // size resident shared text lib data dt (in pages)
+    const QList<QByteArray> fields = statm.simplified().split(' ');
+    if (fields.size() < 2) return false;
+    bool ok = false;
+    const qint64 pages = fields[1].toLongLong(&ok);
+    if (!ok) return false;
+    *rssBytes = pages * pageSize;
+    return true;
+}
+
+bool TabMetricsSampler::parseStat(const QByteArray& stat, quint64* utime, quint64* stime) {
+    // the comm field is parenthesised and may contain spaces, so start after the last ')'
+    const int close = stat.lastIndexOf(')');
+    if (close < 0) return false;
+    const QList<QByteArray> fields = stat.mid(close + 1).simplified().split(' ');
+    // fields[0] is the state (field 3); utime and stime are fields 14 and 15
+    if (fields.size() < 13) return false;
+    bool okU = false, okS = false;
+    *utime = fields[11].toULongLong(&okU);
+    *stime = fields[12].toULongLong(&okS);
+    return okU && okS;
+}
+
+QJsonObject TabMetricsSampler::toJson() const {
+    QJsonArray tabsArr;
+    for (auto it = m_entries.constBegin(); it != m_entries.constEnd(); ++it) {
+        QWebEngineView* view = it.key();
+        const TabMetrics &m = it.value().metrics;
+        QJsonObject o;
+        o["title"] = view->title();
+        o["url"] = view->url().toString();
+        // views parked in a workspace cache are detached from the window
+        o["cached"] = view->parentWidget() == nullptr;
+        o["pid"] = m.pid;
+        o["rss_bytes"] = m.rssBytes;
+        o["cpu_percent"] = m.cpuPercent;
+        QJsonArray navs;
+        for (const auto &n : m.navigations) {
+            QJsonObject no;
+            no["url"] = n.url;
+            no["started_at"] = n.startedAt;
+            no["first_paint_ms"] = n.firstPaintMs;
+            no["first_contentful_paint_ms"] = n.firstContentfulPaintMs;
+            no["dom_content_loaded_ms"] = n.domContentLoadedMs;
+            no["load_finished_ms"] = n.loadFinishedMs;
+            no["ok"] = n.ok;
+            navs.append(no);
+        }
+        o["navigations"] = navs;
+        tabsArr.append(o);
+    }
+    QJsonObject root;
+    root["sampled_at"] = QDateTime::currentMSecsSinceEpoch();
+    root["interval_ms"] = interval();
+    root["tabs"] = tabsArr;
+    root["profiles"] = ProfileManager::instance()->toJson();
+    return root;
+}
+
+bool TabMetricsSampler::dumpJson(const QString& path) const {
+    QFile f(path);
+    if (!f.open(QIODevice::WriteOnly | QIODevice::Truncate)) return false;
+    f.write(QJsonDocument(toJson()).toJson());
+    f.close();
+    return true;
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <QObject>
+#include <QHash>
+#include <QVector>
+#include <QElapsedTimer>
+#include <QJsonObject>
+
+class QWebEngineView;
+class QTimer;
+
+// Timing for a single navigation in a tab. All *Ms values are relative to the
+// navigation start; -1 means "not observed (yet)".
+struct NavigationTiming {
+    QString url;
+    qint64 startedAt = 0; // epoch ms
+    qint64 firstPaintMs = -1;
+    qint64 firstContentfulPaintMs = -1;
+    qint64 domContentLoadedMs = -1;
+    qint64 loadFinishedMs = -1;
+    bool ok = false;
+};
+
+struct TabMetrics {
+    qint64 pid = 0;          // renderer process; several tabs may share one
+    qint64 rssBytes = 0;
+    double cpuPercent = 0.0; // of one core, over the last sample interval
+    QVector<NavigationTiming> navigations; // most recent last
+};
+
+// Maps every tracked QWebEngineView (visible or parked in a workspace cache) to its
+// render process and samples RSS / CPU time from /proc on an interval. Also records
+// per-navigation load timing, using the page's performance entries for first paint.
+class TabMetricsSampler : public QObject {
+    Q_OBJECT
+public:
+    explicit TabMetricsSampler(QObject* parent = nullptr);
+
+    void trackView(QWebEngineView* view);
+    void untrackView(QWebEngineView* view);
+    QList<QWebEngineView*> views() const;
+    TabMetrics metricsFor(QWebEngineView* view) const;
+
+    void setInterval(int ms);
+    int interval() const;
+
+    QJsonObject toJson() const;
+    bool dumpJson(const QString& path) const;
+
+    // /proc parsing helpers (exposed for unit tests)
+    static bool parseStatm(const QByteArray& statm, qint64 pageSize, qint64* rssBytes);
+    static bool parseStat(const QByteArray& stat, quint64* utime, quint64* stime);
+
+    static const int kMaxNavigationsPerTab = 20;
+
+signals:
+    void sampled();
+
+public slots:
+    void sample();
+
+private:
+    struct Entry {
+        TabMetrics metrics;
+        quint64 lastCpuTicks = 0;
+        qint64 lastPid = 0;
+        QElapsedTimer navClock;
+    };
+
+    void onLoadStarted(QWebEngineView* view);
+    void onLoadFinished(QWebEngineView* view, bool ok);
+    void collectPaintTiming(QWebEngineView* view);
+
+    QHash<QWebEngineView*, Entry> m_entries;
+    QTimer* m_timer;
+    QElapsedTimer m_sampleClock;
+};
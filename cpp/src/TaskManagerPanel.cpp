@@ -0,0 +1,140 @@
+#include "TaskManagerPanel.h"
+#include "TabMetricsSampler.h"
+#include "ProfileManager.h"
+#include "SpeculationEngine.h"
+#include "ContentBlocker.h"
+#include "ContentBlockInterceptor.h"
+#include "NetworkClient.h"
+#include <QJsonDocument>
+#include <QFile>
+#include <QVBoxLayout>
+#include <QTreeWidget>
+#include <QHeaderView>
+#include <QLabel>
+#include <QPushButton>
+#include <QFileDialog>
+#include <QMessageBox>
+#include <QStandardPaths>
+#include <QDir>
+#include <QWebEngineView>
+
+enum Column { ColTab = 0, ColPid, ColMemory, ColCpu, ColFirstPaint, ColLoad, ColBlocked, ColCount };
+
+TaskManagerPanel::TaskManagerPanel(TabMetricsSampler* sampler, QWidget* parent): QWidget(parent), m_sampler(sampler) {
+    auto *lay = new QVBoxLayout(this);
+    m_list = new QTreeWidget(this);
+    m_list->setColumnCount(ColCount);
+    m_list->setHeaderLabels({"Tab", "PID", "Memory", "CPU", "First paint", "Load", "Blocked"});
+    m_list->setRootIsDecorated(false);
+    m_list->setSortingEnabled(true);
+    m_list->sortByColumn(ColMemory, Qt::DescendingOrder);
+    m_list->header()->setSectionResizeMode(ColTab, QHeaderView::Stretch);
+    lay->addWidget(m_list);
+    m_cacheLabel = new QLabel(this);
+    lay->addWidget(m_cacheLabel);
+    m_speculationLabel = new QLabel(this);
+    m_speculationLabel->hide();
+    lay->addWidget(m_speculationLabel);
+    m_networkLabel = new QLabel(this);
+    lay->addWidget(m_networkLabel);
+
+    auto *btnLay = new QHBoxLayout();
+    auto *refreshBtn = new QPushButton("Sample Now", this);
+    auto *dumpBtn = new QPushButton("Dump JSON...", this);
+    btnLay->addWidget(refreshBtn);
+    btnLay->addWidget(dumpBtn);
+    lay->addLayout(btnLay);
+
+    connect(refreshBtn, &QPushButton::clicked, m_sampler, &TabMetricsSampler::sample);
+    connect(dumpBtn, &QPushButton::clicked, this, &TaskManagerPanel::onDumpJson);
+    connect(m_sampler, &TabMetricsSampler::sampled, this, &TaskManagerPanel::refresh);
+    connect(ProfileManager::instance(), &ProfileManager::cacheStatsChanged, this, &TaskManagerPanel::refresh);
+
+    refresh();
+}
+
+void TaskManagerPanel::setSpeculationEngine(SpeculationEngine* engine) {
+    m_speculation = engine;
+    m_speculationLabel->setVisible(engine != nullptr);
+    if (engine) connect(engine, &SpeculationEngine::statsChanged, this, &TaskManagerPanel::refresh);
+    refresh();
+}
+
+// QTreeWidgetItem compares text by default; sort numeric columns by the raw value instead
+class MetricsItem : public QTreeWidgetItem {
+public:
+    using QTreeWidgetItem::QTreeWidgetItem;
+    bool operator<(const QTreeWidgetItem &other) const override {
+        int col = treeWidget() ? treeWidget()->sortColumn() : 0;
+        if (col == ColTab) return text(col) < other.text(col);
+        return data(col, Qt::UserRole).toDouble() < other.data(col, Qt::UserRole).toDouble();
+    }
+};
+
+static QString formatMs(qint64 ms) { return ms < 0 ? QString("-") : QString("%1 ms").arg(ms); }
+
+void TaskManagerPanel::refresh() {
+    if (!isVisible()) return; // nothing to repaint while the dock is hidden
+    m_list->setSortingEnabled(false);
+    m_list->clear();
+    for (QWebEngineView* v : m_sampler->views()) {
+        const TabMetrics m = m_sampler->metricsFor(v);
+        auto *it = new MetricsItem(m_list);
+        QString title = v->title().isEmpty() ? v->url().toString() : v->title();
+        if (!v->parentWidget()) title += " (cached)";
+        it->setText(ColTab, title);
+        it->setToolTip(ColTab, v->url().toString());
+        it->setText(ColPid, m.pid > 0 ? QString::number(m.pid) : QString("-"));
+        it->setData(ColPid, Qt::UserRole, m.pid);
+        it->setText(ColMemory, QString("%1 MB").arg(m.rssBytes / (1024.0 * 1024.0), 0, 'f', 1));
+        it->setData(ColMemory, Qt::UserRole, m.rssBytes);
+        it->setText(ColCpu, QString("%1%").arg(m.cpuPercent, 0, 'f', 1));
+        it->setData(ColCpu, Qt::UserRole, m.cpuPercent);
+        qint64 fcp = -1, load = -1;
+        if (!m.navigations.isEmpty()) {
+            const auto &n = m.navigations.last();
+            fcp = n.firstContentfulPaintMs >= 0 ? n.firstContentfulPaintMs : n.firstPaintMs;
+            load = n.loadFinishedMs;
+        }
+        it->setText(ColFirstPaint, formatMs(fcp));
+        it->setData(ColFirstPaint, Qt::UserRole, fcp);
+        it->setText(ColLoad, formatMs(load));
+        it->setData(ColLoad, Qt::UserRole, load);
+        const ContentBlockInterceptor* interceptor = ContentBlockInterceptor::forPage(v->page());
+        const quint64 blocked = interceptor ? interceptor->blockedCount() : 0;
+        it->setText(ColBlocked, QString::number(blocked));
+        it->setData(ColBlocked, Qt::UserRole, double(blocked));
+    }
+    m_list->setSortingEnabled(true);
+
+    const CacheStats cs = ProfileManager::instance()->cacheStats();
+    m_cacheLabel->setText(QString("HTTP cache: %1% hits (%2 hit, %3 revalidated, %4 miss, %5 opaque) — %6 MB from cache, %7 MB from network")
+        .arg(cs.hitRate() * 100.0, 0, 'f', 1).arg(cs.hits).arg(cs.revalidated).arg(cs.misses).arg(cs.opaque)
+        .arg(cs.bytesFromCache / (1024.0 * 1024.0), 0, 'f', 1).arg(cs.bytesFromNetwork / (1024.0 * 1024.0), 0, 'f', 1));
+    if (m_speculation) {
+        const SpeculationStats ss = m_speculation->stats();
+        m_speculationLabel->setText(QString("Speculation: %1 preconnects, %2 prefetches — %3% of navigations warm, %4% of speculations used")
+            .arg(ss.preconnects).arg(ss.prefetches).arg(ss.hitRate() * 100.0, 0, 'f', 1).arg(ss.precision() * 100.0, 0, 'f', 1));
+    }
+    const NetworkStats ns = NetworkClient::instance()->stats();
+    m_networkLabel->setText(QString("Sync network: %1 requests, %2 over HTTP/2 — %3 TLS handshakes saved — queued %4 ms interactive, %5 ms background (mean)")
+        .arg(ns.requests()).arg(ns.http2Requests).arg(ns.handshakesSaved())
+        .arg(ns.meanQueueMs(NetworkClient::Interactive), 0, 'f', 1).arg(ns.meanQueueMs(NetworkClient::Background), 0, 'f', 1));
+}
+
+void TaskManagerPanel::onDumpJson() {
+    QString dataDir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    QString path = QFileDialog::getSaveFileName(this, "Dump Tab Metrics", QDir(dataDir).filePath("tab_metrics.json"), "JSON (*.json)");
+    if (path.isEmpty()) return;
+    QJsonObject root = m_sampler->toJson();
+    if (m_speculation) root["speculation"] = m_speculation->toJson();
+    root["content_blocking"] = ContentBlocker::instance()->toJson();
+    root["network"] = NetworkClient::instance()->toJson();
+    QFile f(path);
+    if (!f.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        QMessageBox::warning(this, "Dump Tab Metrics", "Could not write " + path);
+        return;
+    }
+    f.write(QJsonDocument(root).toJson());
+    f.close();
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <QWidget>
+class TabMetricsSampler;
+class SpeculationEngine;
+class QTreeWidget;
+class QLabel;
+
+class TaskManagerPanel : public QWidget {
+    Q_OBJECT
+public:
+    explicit TaskManagerPanel(TabMetricsSampler* sampler, QWidget* parent = nullptr);
+    void setSpeculationEngine(SpeculationEngine* engine);
+
+public slots:
+    void refresh();
+
+private slots:
+    void onDumpJson();
+
+private:
+    TabMetricsSampler* m_sampler;
+    QTreeWidget* m_list;
+    QLabel* m_cacheLabel;
+    SpeculationEngine* m_speculation = nullptr;
+    QLabel* m_speculationLabel;
+    QLabel* m_networkLabel;
+};
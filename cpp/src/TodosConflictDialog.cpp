@@ -36,7 +36,10 @@ void TodosConflictDialog::refreshList() {
     for (int idx : cs) {
         if (idx >=0 && idx < items.size()) {
             const auto &t = items[idx];
-            m_list->addItem(QString("%1: %2 (%3)").arg(QString::number(idx)).arg(t.title).arg(t.completed ? "done" : "pending"));
+            QString text = QString("%1: %2 (%3)").arg(QString::number(idx)).arg(t.title).arg(t.completed ? "done" : "pending");
+            const TodoItem remote = m_mgr->remoteVersion(idx);
+            if (!remote.id.isEmpty()) text += QString("  |  remote: %1 (%2)").arg(remote.title).arg(remote.completed ? "done" : "pending");
+            m_list->addItem(text);
         }
     }
 }
@@ -1,62 +1,40 @@
 #pragma once
 
-#include <QObject>
-#include <QVector>
-
-class AuthManager;
+#include "SyncedCollection.h"
+#include <QString>
 
 enum class TodoStatusFlag { Pending=0, Done=1 };
-enum class SyncStatusTodo { Synced=0, Syncing=1, Unsynced=2, Conflict=3 };
+// kept for existing callers; todos share SyncStatus with the other synced types
+using SyncStatusTodo = SyncStatus;
 
 struct TodoItem {
     QString id;
     QString title;
     bool completed = false;
     QString workspace;
-    SyncStatusTodo status = SyncStatusTodo::Synced;
+    SyncStatus status = SyncStatus::Synced;
+};
+
+struct TodoTraits {
+    using Item = TodoItem;
+    static constexpr const char* table = "todos";
+    static QString identityKey(const TodoItem& t) { return t.id; }
+    static QJsonObject toRemote(const TodoItem& t);
+    static TodoItem fromRemote(const QJsonObject& o);
+    static QJsonObject toLocal(const TodoItem& t);
+    static TodoItem fromLocal(const QJsonObject& o);
 };
 
-class TodosManager : public QObject {
+class TodosManager : public SyncedCollection<TodoTraits> {
     Q_OBJECT
 public:
     explicit TodosManager(QObject* parent = nullptr);
-    QVector<TodoItem> todos() const;
+    QVector<TodoItem> todos() const { return items(); }
     void addTodo(const QString& title, const QString& workspace = QString(), const QString& id = QString());
     void setCompleted(int index, bool done);
-    void removeTodo(int index);
-    // Undo support
-    void removeTodoWithUndo(int index);
-    void undoLastRemove();
-    bool hasPendingUndo() const;
-
-    void setSupabaseConfig(const QString& supabaseUrl, const QString& anonKey);
-    void setAuthManager(AuthManager* auth);
-
-public slots:
-    void syncFromSupabase();
-    void syncPending();
-
-    // Conflict handling
-    QList<int> conflictIndices() const;
-    void retrySync(int index);
-    void keepLocal(int index);
-    void keepRemote(int index);
+    void removeTodo(int index) { remove(index); }
+    void removeTodoWithUndo(int index) { removeWithUndo(index); }
 
 signals:
     void todosUpdated();
-    void syncPendingCountChanged(int count);
-
-private:
-    void load();
-    void save();
-
-    QVector<TodoItem> m_todos;
-    QString m_filePath;
-
-    QString m_supabaseUrl;
-    QString m_anonKey;
-    AuthManager* m_auth;
-    QNetworkAccessManager* m_net;
-
-    int pendingCount() const;
-};
\ No newline at end of file
+};
@@ -0,0 +1,40 @@
+#include "TodosModel.h"
+
+TodosModel::TodosModel(TodosManager* manager, QObject* parent)
+    : SyncedCollectionModel<TodoTraits>(manager, parent), m_manager(manager) {}
+
+QVariant TodosModel::data(const QModelIndex& index, int role) const {
+    if (!index.isValid() || index.row() >= rowCount()) return QVariant();
+    const TodoItem &t = item(index.row());
+    switch (role) {
+    case Qt::DisplayRole:
+    case Qt::EditRole: return t.title;
+    case Qt::CheckStateRole: return int(t.completed ? Qt::Checked : Qt::Unchecked);
+    case Qt::ForegroundRole: return foregroundFor(t.status);
+    case LocalIdRole: return m_localIds.at(index.row());
+    case SyncStatusRole: return int(t.status);
+    case WorkspaceRole: return t.workspace;
+    case DoneRole: return t.completed;
+    case SearchTextRole: return t.title;
+    }
+    return QVariant();
+}
+
+bool TodosModel::setData(const QModelIndex& index, const QVariant& value, int role) {
+    if (!index.isValid() || role != Qt::CheckStateRole) return false;
+    const int at = m_manager->indexOfLocalId(localId(index.row()));
+    if (at < 0) return false;
+    m_manager->setCompleted(at, value.toInt() == Qt::Checked);
+    // the box should not flick back for a frame
+    update();
+    return true;
+}
+
+Qt::ItemFlags TodosModel::flags(const QModelIndex& index) const {
+    if (!index.isValid()) return Qt::NoItemFlags;
+    return Qt::ItemIsEnabled | Qt::ItemIsSelectable | Qt::ItemIsUserCheckable | Qt::ItemNeverHasChildren;
+}
+
+bool TodosModel::sameRow(const TodoItem& a, const TodoItem& b) const {
+    return a.completed == b.completed && a.status == b.status && a.title == b.title && a.workspace == b.workspace;
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "CollectionModel.h"
+#include "TodosManager.h"
+
+// Todos for item views: one column, the title with a check box for done.
+// Checking it goes through TodosManager::setCompleted.
+class TodosModel : public SyncedCollectionModel<TodoTraits> {
+    Q_OBJECT
+public:
+    explicit TodosModel(TodosManager* manager, QObject* parent = nullptr);
+
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+    bool setData(const QModelIndex& index, const QVariant& value, int role = Qt::EditRole) override;
+    Qt::ItemFlags flags(const QModelIndex& index) const override;
+
+protected:
+    bool sameRow(const TodoItem& a, const TodoItem& b) const override;
+
+private:
+    TodosManager* m_manager;
+};
@@ -1,13 +1,24 @@
 #include "TodosPanel.h"
 #include "TodosManager.h"
+#include "TodosModel.h"
+#include "CollectionFilterBar.h"
+#include "CollectionFilterModel.h"
 #include <QVBoxLayout>
-#include <QListWidget>
+#include <QListView>
 #include <QPushButton>
 #include <QInputDialog>
 
 TodosPanel::TodosPanel(TodosManager* manager, QWidget* parent): QWidget(parent), m_manager(manager) {
+    m_model = new TodosModel(m_manager, this);
+    m_filter = new CollectionFilterModel(this);
+    m_filter->setSourceModel(m_model);
+
     auto *lay = new QVBoxLayout(this);
-    m_list = new QListWidget(this);
+    lay->addWidget(new CollectionFilterBar(m_model, m_filter, true, this));
+    m_list = new QListView(this);
+    // one row height for all: a 50k-row list is laid out without measuring each row
+    m_list->setUniformItemSizes(true);
+    m_list->setModel(m_filter);
     lay->addWidget(m_list);
 
     auto *btnLay = new QHBoxLayout();
@@ -22,23 +33,16 @@ TodosPanel::TodosPanel(TodosManager* manager, QWidget* parent): QWidget(parent),
     connect(addBtn, &QPushButton::clicked, this, &TodosPanel::onAdd);
     connect(toggleBtn, &QPushButton::clicked, this, &TodosPanel::onToggle);
     connect(delBtn, &QPushButton::clicked, this, &TodosPanel::onDelete);
-    connect(m_manager, &TodosManager::todosUpdated, this, &TodosPanel::refresh);
-
-    refresh();
 }
 
 void TodosPanel::refresh() {
-    m_list->clear();
-    auto items = m_manager->todos();
-    for (int i=0;i<items.size();++i) {
-        const auto &t = items[i];
-        QString txt = QString("%1%2").arg(t.completed ? "[x] " : "[ ] ").arg(t.title);
-        auto *it = new QListWidgetItem(txt, m_list);
-        it->setData(Qt::UserRole, i);
-        if (t.status == SyncStatusTodo::Unsynced) it->setForeground(QBrush(QColor(0,102,204)));
-        else if (t.status == SyncStatusTodo::Syncing) it->setForeground(QBrush(QColor(255,165,0)));
-        else if (t.status == SyncStatusTodo::Conflict) it->setForeground(QBrush(QColor(200,0,0)));
-    }
+    m_model->update();
+}
+
+int TodosPanel::currentIndex() const {
+    const QModelIndex current = m_list->currentIndex();
+    if (!current.isValid()) return -1;
+    return m_manager->indexOfLocalId(current.data(CollectionModel::LocalIdRole).toString());
 }
 
 void TodosPanel::onAdd() {
@@ -49,18 +53,13 @@ void TodosPanel::onAdd() {
 }
 
 void TodosPanel::onToggle() {
-    auto *it = m_list->currentItem();
-    if (!it) return;
-    int idx = it->data(Qt::UserRole).toInt();
-    auto items = m_manager->todos();
-    if (idx < 0 || idx >= items.size()) return;
-    m_manager->setCompleted(idx, !items[idx].completed);
+    const int idx = currentIndex();
+    if (idx < 0) return;
+    m_manager->setCompleted(idx, !m_manager->todos().at(idx).completed);
 }
 
 void TodosPanel::onDelete() {
-    auto *it = m_list->currentItem();
-    if (!it) return;
-    int idx = it->data(Qt::UserRole).toInt();
+    const int idx = currentIndex();
     if (idx < 0) return;
     m_manager->removeTodoWithUndo(idx);
-}
\ No newline at end of file
+}
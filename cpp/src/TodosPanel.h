@@ -2,20 +2,30 @@
 
 #include <QWidget>
 class TodosManager;
-class QListWidget;
+class TodosModel;
+class CollectionFilterModel;
+class QListView;
 
 class TodosPanel : public QWidget {
     Q_OBJECT
 public:
     explicit TodosPanel(TodosManager* manager, QWidget* parent = nullptr);
 
-private slots:
+public slots:
+    // show the manager's changes now rather than on the next frame
     void refresh();
+
+private slots:
     void onAdd();
     void onToggle();
     void onDelete();
 
 private:
+    // the manager's index of the selected todo, -1 without one
+    int currentIndex() const;
+
     TodosManager* m_manager;
-    QListWidget* m_list;
-};
\ No newline at end of file
+    TodosModel* m_model;
+    CollectionFilterModel* m_filter;
+    QListView* m_list;
+};
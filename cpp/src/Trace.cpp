@@ -0,0 +1,205 @@
+#include "Trace.h"
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutex>
+#include <QSet>
+#include <QThread>
+#include <QVector>
+#include <memory>
+
+std::atomic<bool> Trace::s_enabled{false};
+
+namespace {
+// Fields are atomics so a reader racing the writer is well defined; seq is
+// odd while a slot is being written and 2 * (n + 1) once event n is in it.
+struct Slot {
+    std::atomic<std::uint64_t> seq{0};
+    std::atomic<const char*> name{nullptr};
+    std::atomic<const char*> detail{nullptr};
+    std::atomic<std::int64_t> ts{0};
+    std::atomic<std::int64_t> dur{0};
+    std::atomic<std::uint64_t> id{0};
+    std::atomic<char> phase{0};
+};
+
+struct ThreadBuffer {
+    int tid = 0;
+    QString threadName;
+    std::atomic<std::uint64_t> written{0};
+    std::atomic<std::uint64_t> firstValid{0};  // moved up by clear()
+    Slot ring[Trace::kRingSize];
+};
+
+struct Event {
+    char phase;
+    const char* name;
+    const char* detail;
+    std::int64_t ts;
+    std::int64_t dur;
+    std::uint64_t id;
+};
+
+// Buffers outlive their threads so a finished worker still shows up in the
+// export; only threads that recorded while tracing was on get one.
+struct Registry {
+    QMutex mutex;
+    QVector<ThreadBuffer*> buffers;
+    QSet<QByteArray> interned;
+    std::atomic<std::uint64_t> asyncIds{0};
+};
+
+Registry& registry() {
+    static Registry r;
+    return r;
+}
+
+const QElapsedTimer& clock() {
+    static const QElapsedTimer c = [](){ QElapsedTimer t; t.start(); return t; }();
+    return c;
+}
+
+ThreadBuffer* threadBuffer() {
+    thread_local ThreadBuffer* t_buffer = nullptr;
+    if (t_buffer) return t_buffer;
+    auto *b = new ThreadBuffer;
+    QThread* thread = QThread::currentThread();
+    const QCoreApplication* app = QCoreApplication::instance();
+    Registry& r = registry();
+    QMutexLocker lock(&r.mutex);
+    b->tid = int(r.buffers.size()) + 1;
+    b->threadName = thread->objectName();
+    if (b->threadName.isEmpty()) b->threadName = app && app->thread() == thread ? QString("main") : QString("thread %1").arg(b->tid);
+    r.buffers.append(b);
+    t_buffer = b;
+    return b;
+}
+
+void record(char phase, const char* name, const char* detail, std::int64_t ts, std::int64_t dur, std::uint64_t id) {
+    if (!name) return;
+    ThreadBuffer* b = threadBuffer();
+    // only this thread writes to b, so a relaxed read of our own counter is enough
+    const std::uint64_t n = b->written.load(std::memory_order_relaxed);
+    Slot &s = b->ring[n % Trace::kRingSize];
+    s.seq.store(2 * n + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    s.phase.store(phase, std::memory_order_relaxed);
+    s.name.store(name, std::memory_order_relaxed);
+    s.detail.store(detail, std::memory_order_relaxed);
+    s.ts.store(ts, std::memory_order_relaxed);
+    s.dur.store(dur, std::memory_order_relaxed);
+    s.id.store(id, std::memory_order_relaxed);
+    s.seq.store(2 * n + 2, std::memory_order_release);
+    b->written.store(n + 1, std::memory_order_release);
+}
+
+// the events of b still in its ring; a slot overwritten while we read it is skipped
+QVector<Event> snapshot(ThreadBuffer* b) {
+    QVector<Event> out;
+    const std::uint64_t written = b->written.load(std::memory_order_acquire);
+    std::uint64_t first = written > std::uint64_t(Trace::kRingSize) ? written - Trace::kRingSize : 0;
+    first = qMax(first, b->firstValid.load(std::memory_order_acquire));
+    out.reserve(int(written - qMin(first, written)));
+    for (std::uint64_t n = first; n < written; ++n) {
+        const Slot &s = b->ring[n % Trace::kRingSize];
+        const std::uint64_t seq = s.seq.load(std::memory_order_acquire);
+        if (seq != 2 * n + 2) continue;
+        Event e{s.phase.load(std::memory_order_relaxed), s.name.load(std::memory_order_relaxed),
+                s.detail.load(std::memory_order_relaxed), s.ts.load(std::memory_order_relaxed),
+                s.dur.load(std::memory_order_relaxed), s.id.load(std::memory_order_relaxed)};
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (s.seq.load(std::memory_order_relaxed) != seq) continue;
+        out.append(e);
+    }
+    return out;
+}
+
+double micros(std::int64_t ns) { return double(ns) / 1000.0; }
+}
+
+void Trace::setEnabled(bool on) {
+    clock();
+    s_enabled.store(on, std::memory_order_relaxed);
+}
+
+void Trace::enableFromEnvironment() {
+    const QByteArray v = qgetenv("FLOW_TRACE");
+    if (!v.isEmpty() && v != "0") setEnabled(true);
+}
+
+const char* Trace::intern(const QByteArray& name) {
+    Registry& r = registry();
+    QMutexLocker lock(&r.mutex);
+    auto it = r.interned.constFind(name);
+    if (it == r.interned.cend()) it = r.interned.insert(name);
+    // the set never drops or changes an entry, so its bytes stay put
+    return it->constData();
+}
+
+std::uint64_t Trace::nextAsyncId() {
+    return registry().asyncIds.fetch_add(1, std::memory_order_relaxed) + 1;
+}
+
+std::int64_t Trace::nowNs() {
+    return clock().nsecsElapsed();
+}
+
+void Trace::complete(const char* name, const char* detail, std::int64_t startNs, std::int64_t endNs) {
+    record('X', name, detail, startNs, endNs - startNs, 0);
+}
+
+void Trace::instant(const char* name, const char* detail) {
+    record('i', name, detail, nowNs(), 0, 0);
+}
+
+void Trace::asyncBegin(const char* name, std::uint64_t id, const char* detail) {
+    record('b', name, detail, nowNs(), 0, id);
+}
+
+void Trace::asyncStep(const char* name, std::uint64_t id, const char* step) {
+    record('n', name, step, nowNs(), 0, id);
+}
+
+void Trace::asyncEnd(const char* name, std::uint64_t id, const char* detail) {
+    record('e', name, detail, nowNs(), 0, id);
+}
+
+QByteArray Trace::toChromeJson() {
+    QVector<ThreadBuffer*> buffers;
+    {
+        Registry& r = registry();
+        QMutexLocker lock(&r.mutex);
+        buffers = r.buffers;
+    }
+    const qint64 pid = QCoreApplication::applicationPid();
+    QJsonArray events;
+    for (ThreadBuffer* b : buffers) {
+        events.append(QJsonObject{{"name", "thread_name"}, {"ph", "M"}, {"pid", pid}, {"tid", b->tid},
+                                  {"args", QJsonObject{{"name", b->threadName}}}});
+        for (const Event &e : snapshot(b)) {
+            QJsonObject o{{"name", QString::fromUtf8(e.name)}, {"cat", "flow"}, {"ph", QString(QChar(e.phase))},
+                          {"ts", micros(e.ts)}, {"pid", pid}, {"tid", b->tid}};
+            if (e.phase == 'X') o["dur"] = micros(e.dur);
+            if (e.phase == 'i') o["s"] = "t";
+            if (e.id) o["id"] = QString("0x%1").arg(e.id, 0, 16);
+            if (e.detail) o["args"] = QJsonObject{{e.phase == 'n' ? "step" : "detail", QString::fromUtf8(e.detail)}};
+            events.append(o);
+        }
+    }
+    return QJsonDocument(QJsonObject{{"traceEvents", events}, {"displayTimeUnit", "ms"}}).toJson(QJsonDocument::Compact);
+}
+
+bool Trace::exportChromeJson(const QString& path) {
+    QFile f(path);
+    if (!f.open(QIODevice::WriteOnly | QIODevice::Truncate)) return false;
+    return f.write(toChromeJson()) >= 0;
+}
+
+void Trace::clear() {
+    Registry& r = registry();
+    QMutexLocker lock(&r.mutex);
+    for (ThreadBuffer* b : r.buffers) b->firstValid.store(b->written.load(std::memory_order_acquire), std::memory_order_release);
+}
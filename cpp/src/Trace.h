@@ -0,0 +1,73 @@
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+#include <atomic>
+#include <cstdint>
+
+// Scoped trace events in the Chrome trace-event format, for finding where a
+// stutter went (a panel refresh, a save, a sync reply). Each thread records
+// into its own fixed-size ring buffer without locks; the oldest events are
+// overwritten. Export writes JSON that chrome://tracing or Perfetto loads.
+//
+// Disabled (the default) a trace point costs one relaxed atomic load. Event
+// names and details must outlive the process (string literals, Traits::table)
+// or come from Trace::intern(). Enable with FLOW_TRACE=1 or setEnabled().
+//
+//   FLOW_TRACE_SCOPE("BookmarksPanel::refresh");
+//   FLOW_TRACE_SCOPE_DETAIL("SyncedCollection::update", Traits::table);
+//   FLOW_TRACE_ASYNC_BEGIN(Trace::intern(method + ' ' + path), id);
+class Trace {
+public:
+    static bool enabled() { return s_enabled.load(std::memory_order_relaxed); }
+    static void setEnabled(bool on);
+    // FLOW_TRACE in the environment; called once at startup
+    static void enableFromEnvironment();
+
+    // a stable copy of name for event names built at run time
+    static const char* intern(const QByteArray& name);
+    // intern(text) while tracing is on, otherwise null: a detail built at run time
+    static const char* detail(const QString& text) { return enabled() ? intern(text.toUtf8()) : nullptr; }
+    static std::uint64_t nextAsyncId();
+
+    static void complete(const char* name, const char* detail, std::int64_t startNs, std::int64_t endNs);
+    static void instant(const char* name, const char* detail = nullptr);
+    static void asyncBegin(const char* name, std::uint64_t id, const char* detail = nullptr);
+    static void asyncStep(const char* name, std::uint64_t id, const char* step);
+    static void asyncEnd(const char* name, std::uint64_t id, const char* detail = nullptr);
+    static std::int64_t nowNs();
+
+    // everything currently in the ring buffers, as Chrome trace JSON
+    static QByteArray toChromeJson();
+    static bool exportChromeJson(const QString& path);
+    // drop recorded events (tests)
+    static void clear();
+    // events each thread keeps before overwriting the oldest
+    static constexpr int kRingSize = 8192;
+
+    class Scope {
+    public:
+        Scope(const char* name, const char* detail = nullptr)
+            : m_name(enabled() ? name : nullptr), m_detail(detail), m_start(m_name ? nowNs() : 0) {}
+        ~Scope() { if (m_name) complete(m_name, m_detail, m_start, nowNs()); }
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    private:
+        const char* m_name;
+        const char* m_detail;
+        std::int64_t m_start;
+    };
+
+private:
+    static std::atomic<bool> s_enabled;
+};
+
+#define FLOW_TRACE_CONCAT_INNER(a, b) a##b
+#define FLOW_TRACE_CONCAT(a, b) FLOW_TRACE_CONCAT_INNER(a, b)
+#define FLOW_TRACE_SCOPE(name) const Trace::Scope FLOW_TRACE_CONCAT(flowTraceScope, __LINE__)(name)
+#define FLOW_TRACE_SCOPE_DETAIL(name, detail) const Trace::Scope FLOW_TRACE_CONCAT(flowTraceScope, __LINE__)(name, detail)
+// the arguments are only evaluated while tracing is on
+#define FLOW_TRACE_INSTANT(name) do { if (Trace::enabled()) Trace::instant(name); } while (0)
+#define FLOW_TRACE_ASYNC_BEGIN(name, id) do { if (Trace::enabled()) Trace::asyncBegin(name, id); } while (0)
+#define FLOW_TRACE_ASYNC_STEP(name, id, step) do { if (Trace::enabled()) Trace::asyncStep(name, id, step); } while (0)
+#define FLOW_TRACE_ASYNC_END(name, id) do { if (Trace::enabled()) Trace::asyncEnd(name, id); } while (0)
@@ -1,114 +1,161 @@
 #include "WorkspaceManager.h"
-#include <QStandardPaths>
-#include <QDir>
-#include <QFile>
+#include "StorageExecutor.h"
+#include "Trace.h"
 #include <QJsonDocument>
 #include <QJsonArray>
 #include <QJsonObject>
+#include <QSqlQuery>
+#include <QVariant>
+#include <utility>
+
+namespace {
+struct WorkspaceState {
+    QVector<Workspace> workspaces;
+    int current = -1;
+};
+
+// runs on the storage thread
+WorkspaceState readState(Storage& s) {
+    WorkspaceState state;
+    QSqlQuery q(s.database());
+    if (!q.exec("SELECT name, type, groups, tabs FROM workspaces ORDER BY position")) return state;
+    while (q.next()) {
+        Workspace w;
+        w.name = q.value(0).toString();
+        w.type = q.value(1).toString();
+        QJsonArray groupsArr = QJsonDocument::fromJson(q.value(2).toString().toUtf8()).array();
+        for (auto g : groupsArr) {
+            QJsonObject go = g.toObject();
+            TabGroup tg;
+            tg.name = go["name"].toString();
+            tg.color = QColor(go["color"].toString());
+            w.groups.push_back(tg);
+        }
+        QJsonArray tabsArr = QJsonDocument::fromJson(q.value(3).toString().toUtf8()).array();
+        for (auto t : tabsArr) w.tabs.append(t.toString());
+        state.workspaces.push_back(w);
+    }
+    state.current = s.value("current_workspace", "-1").toInt();
+    return state;
+}
+
+struct WorkspaceRow {
+    int position;
+    QString name;
+    QString type;
+    QString groups;
+    QString tabs;
+};
+
+WorkspaceRow toRow(int index, const Workspace& w) {
+    QJsonArray tabsArr;
+    for (const auto &t : w.tabs) tabsArr.append(t);
+    QJsonArray groupsArr;
+    for (const auto &g : w.groups) {
+        QJsonObject go;
+        go["name"] = g.name;
+        go["color"] = g.color.name();
+        groupsArr.append(go);
+    }
+    return {index, w.name, w.type,
+            QString::fromUtf8(QJsonDocument(groupsArr).toJson(QJsonDocument::Compact)),
+            QString::fromUtf8(QJsonDocument(tabsArr).toJson(QJsonDocument::Compact))};
+}
+
+bool writeRows(Storage& s, const QVector<WorkspaceRow>& rows) {
+    QSqlQuery q(s.database());
+    q.prepare("INSERT OR REPLACE INTO workspaces (position, name, type, groups, tabs) VALUES (?, ?, ?, ?, ?)");
+    for (const WorkspaceRow &r : rows) {
+        q.addBindValue(r.position);
+        q.addBindValue(r.name);
+        q.addBindValue(r.type);
+        q.addBindValue(r.groups);
+        q.addBindValue(r.tabs);
+        if (!q.exec()) return false;
+    }
+    return true;
+}
+}
 
 WorkspaceManager::WorkspaceManager(QObject* parent): QObject(parent) {
-    QString dataDir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
-    QDir().mkpath(dataDir);
-    m_filePath = QDir(dataDir).filePath("workspaces.json");
     load();
 }
 
 QVector<Workspace> WorkspaceManager::workspaces() const { return m_workspaces; }
 int WorkspaceManager::currentIndex() const { return m_current; }
 
+bool WorkspaceManager::deferred(std::function<void()> fn) {
+    if (m_loaded) return false;
+    m_afterLoad.append(std::move(fn));
+    return true;
+}
+
 int WorkspaceManager::createWorkspace(const QString& name, const QString& type) {
+    if (deferred([this, name, type](){ createWorkspace(name, type); })) return -1;
+    FLOW_TRACE_SCOPE("WorkspaceManager::createWorkspace");
     Workspace w;
     w.name = name;
     w.type = type;
     m_workspaces.push_back(w);
     int idx = m_workspaces.size() - 1;
-    save();
+    writeRow(idx);
     emit workspaceCreated(idx);
     return idx;
 }
 
 void WorkspaceManager::switchToWorkspace(int index) {
+    if (deferred([this, index](){ switchToWorkspace(index); })) return;
     if (index < 0 || index >= m_workspaces.size()) return;
+    FLOW_TRACE_SCOPE("WorkspaceManager::switchToWorkspace");
     m_current = index;
-    save();
+    StorageExecutor::instance()->write(this, [index](Storage& s){ return s.setValue("current_workspace", QString::number(index)); });
     emit workspaceSwitched(index);
 }
 
 void WorkspaceManager::setTabsForWorkspace(int index, const QStringList& tabs) {
+    if (deferred([this, index, tabs](){ setTabsForWorkspace(index, tabs); })) return;
     if (index < 0 || index >= m_workspaces.size()) return;
     m_workspaces[index].tabs = tabs;
-    save();
+    writeRow(index);
+}
+
+void WorkspaceManager::writeRow(int index) {
+    const QVector<WorkspaceRow> rows{toRow(index, m_workspaces[index])};
+    StorageExecutor::instance()->write(this, [rows](Storage& s){ return writeRows(s, rows); });
 }
+
 void WorkspaceManager::save() {
-    QJsonArray arr;
-    for (const auto &w : m_workspaces) {
-        QJsonObject wo;
-        wo["name"] = w.name;
-        wo["type"] = w.type;
-        QJsonArray tabsArr;
-        for (const auto &t : w.tabs) tabsArr.append(t);
-        wo["tabs"] = tabsArr;
-        QJsonArray groupsArr;
-        for (const auto &g : w.groups) {
-            QJsonObject go;
-            go["name"] = g.name;
-            go["color"] = g.color.name();
-            groupsArr.append(go);
-        }
-        wo["groups"] = groupsArr;
-        arr.append(wo);
-    }
-    QJsonObject root;
-    root["workspaces"] = arr;
-    root["current"] = m_current;
-    QJsonDocument doc(root);
-    QFile f(m_filePath);
-    if (f.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
-        f.write(doc.toJson());
-        f.close();
-    }
+    QVector<WorkspaceRow> rows;
+    for (int i = 0; i < m_workspaces.size(); ++i) rows.append(toRow(i, m_workspaces[i]));
+    StorageExecutor::instance()->write(this, [rows, current = m_current](Storage& s){
+        QSqlQuery q(s.database());
+        return q.exec("DELETE FROM workspaces") && writeRows(s, rows)
+               && s.setValue("current_workspace", QString::number(current));
+    });
 }
 
 void WorkspaceManager::load() {
-    QFile f(m_filePath);
-    if (!f.open(QIODevice::ReadOnly)) return;
-    QByteArray data = f.readAll();
-    f.close();
-    QJsonDocument doc = QJsonDocument::fromJson(data);
-    if (!doc.isObject()) return;
-    QJsonObject root = doc.object();
-    m_workspaces.clear();
-    QJsonArray arr = root["workspaces"].toArray();
-    for (auto v : arr) {
-        QJsonObject wo = v.toObject();
-        Workspace w;
-        w.name = wo["name"].toString();
-        w.type = wo["type"].toString();
-        QJsonArray tabsArr = wo["tabs"].toArray();
-        for (auto t : tabsArr) w.tabs.append(t.toString());
-        QJsonArray groupsArr = wo["groups"].toArray();
-        for (auto g : groupsArr) {
-            QJsonObject go = g.toObject();
-            TabGroup tg;
-            tg.name = go["name"].toString();
-            tg.color = QColor(go["color"].toString());
-            w.groups.push_back(tg);
-        }
-        m_workspaces.push_back(w);
-    }
-    m_current = root["current"].toInt(-1);
+    StorageExecutor::instance()->readConcurrently<WorkspaceState>(this, readState, [this](WorkspaceState state){
+        m_workspaces = state.workspaces;
+        m_current = state.current;
+        m_loaded = true;
+        emit loaded();
+        const auto pending = std::exchange(m_afterLoad, {});
+        for (const auto &fn : pending) fn();
+    });
 }
 
 void WorkspaceManager::addGroup(int workspaceIndex, const QString& groupName, const QColor& color) {
+    if (deferred([this, workspaceIndex, groupName, color](){ addGroup(workspaceIndex, groupName, color); })) return;
     if (workspaceIndex < 0 || workspaceIndex >= m_workspaces.size()) return;
     TabGroup g;
     g.name = groupName;
     g.color = color;
     m_workspaces[workspaceIndex].groups.push_back(g);
-    save();
+    writeRow(workspaceIndex);
 }
 
 QVector<TabGroup> WorkspaceManager::groupsFor(int workspaceIndex) const {
     if (workspaceIndex < 0 || workspaceIndex >= m_workspaces.size()) return {};
     return m_workspaces[workspaceIndex].groups;
-}
\ No newline at end of file
+}
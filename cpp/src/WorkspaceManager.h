@@ -4,20 +4,28 @@
 #include <QString>
 #include <QVector>
 #include <QColor>
+#include <functional>
 
 struct TabGroup { QString name; QColor color; };
 struct Workspace { QString name; QString type; QVector<TabGroup> groups; QStringList tabs; };
 
+// Workspaces are rows of Storage's workspaces table; every change posts a
+// write of just the workspace it touched. The list is read on the storage
+// thread after construction; changes requested before loaded() are applied
+// once it is there.
 class WorkspaceManager : public QObject {
     Q_OBJECT
 public:
     explicit WorkspaceManager(QObject* parent = nullptr);
     QVector<Workspace> workspaces() const;
     int currentIndex() const;
+    bool isLoaded() const { return m_loaded; }
 
+    // -1 while the stored workspaces are still being read
     int createWorkspace(const QString& name, const QString& type = "window");
     void switchToWorkspace(int index);
     void setTabsForWorkspace(int index, const QStringList& tabs);
+    // rewrite every workspace and the current index in one transaction
     void save();
     void load();
 
@@ -27,9 +35,15 @@ public:
 signals:
     void workspaceCreated(int index);
     void workspaceSwitched(int index);
+    void loaded();
 
 private:
+    void writeRow(int index);
+    // true when the call has to wait for load() and was queued
+    bool deferred(std::function<void()> fn);
+
     QVector<Workspace> m_workspaces;
     int m_current = -1;
-    QString m_filePath;
-};
\ No newline at end of file
+    bool m_loaded = false;
+    QVector<std::function<void()>> m_afterLoad;
+};
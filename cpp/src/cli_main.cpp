@@ -0,0 +1,31 @@
+#include <QCoreApplication>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include "FlowCli.h"
+#include "Trace.h"
+
+int main(int argc, char *argv[]) {
+    // FLOW_TRACE=1 records from the start; FLOW_TRACE=<file>.json also writes the trace on exit
+    Trace::enableFromEnvironment();
+    // bench fills a throwaway profile where AppDataLocation follows
+    // XDG_DATA_HOME; elsewhere it refuses the real one, which has data
+    QTemporaryDir scratch;
+    const bool bench = argc > 1 && qstrcmp(argv[1], "bench") == 0;
+    if (bench) qputenv("XDG_DATA_HOME", scratch.path().toUtf8());
+    QCoreApplication app(argc, argv);
+    // AppDataLocation follows the application name: open the browser's profile
+    QCoreApplication::setApplicationName("flow_browser_cpp");
+
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+    int status = 0;
+    {
+        FlowCli cli(out, err);
+        status = cli.run(app.arguments().mid(1));
+    }
+    out.flush();
+    err.flush();
+    const QString tracePath = qEnvironmentVariable("FLOW_TRACE");
+    if (Trace::enabled() && tracePath.endsWith(".json")) Trace::exportChromeJson(tracePath);
+    return status;
+}
@@ -1,11 +1,103 @@
 #include <QApplication>
+#include <QJsonDocument>
+#include <QTextStream>
+#include <QTimer>
 #include "MainWindow.h"
+#include "EventLoopMonitor.h"
+#include "FlowSchemeHandler.h"
+#include "HistoryRetention.h"
+#include "ProfileManager.h"
+#include "StartupTrace.h"
+#include "Trace.h"
+
+namespace {
+// --startup-benchmark: print where cold start went once the first tab is
+// interactive and every manager has loaded, then exit. --json prints the
+// phases as JSON; --startup-budget <ms> exits with 1 when startup took longer.
+struct BenchmarkOptions {
+    bool enabled = false;
+    bool json = false;
+    double budgetMs = 0;
+    int timeoutMs = 60000;
+};
+
+BenchmarkOptions parseBenchmarkArgs(const QStringList& args) {
+    BenchmarkOptions o;
+    for (int i = 1; i < args.size(); ++i) {
+        const QString a = args[i];
+        const QString v = i + 1 < args.size() ? args[i + 1] : QString();
+        if (a == "--startup-benchmark") { o.enabled = true; continue; }
+        if (a == "--json") { o.json = true; continue; }
+        if (a == "--startup-budget") o.budgetMs = v.toDouble();
+        else if (a == "--startup-timeout") o.timeoutMs = v.toInt();
+        else continue;
+        ++i;
+    }
+    return o;
+}
+
+int finishBenchmark(const BenchmarkOptions& opt, bool timedOut) {
+    QTextStream out(stdout);
+    const double totalMs = StartupTrace::elapsedMs();
+    const bool overBudget = opt.budgetMs > 0 && totalMs > opt.budgetMs;
+    if (opt.json) {
+        QJsonObject report = StartupTrace::toJson();
+        report["total_ms"] = totalMs;
+        report["timed_out"] = timedOut;
+        if (opt.budgetMs > 0) report["budget_ms"] = opt.budgetMs;
+        out << QJsonDocument(report).toJson();
+    } else {
+        out << StartupTrace::report();
+        if (timedOut) out << "timed out after " << opt.timeoutMs << " ms waiting for startup to finish" << Qt::endl;
+        if (opt.budgetMs > 0)
+            out << "budget:  " << totalMs << " ms of " << opt.budgetMs << " ms" << (overBudget ? " - OVER" : "") << Qt::endl;
+    }
+    return timedOut ? 2 : overBudget ? 1 : 0;
+}
+
+QString argValue(const QStringList& args, const QString& name) {
+    const int i = args.indexOf(name);
+    return i >= 0 && i + 1 < args.size() ? args[i + 1] : QString();
+}
+}
 
 int main(int argc, char *argv[]) {
-    QApplication app(argc, argv);
+    StartupTrace::start();
+    // FLOW_TRACE=1 records from the start; FLOW_TRACE=<file>.json also writes the trace on exit
+    Trace::enableFromEnvironment();
+    FlowSchemeHandler::registerScheme();
+    MonitoredApplication<QApplication> app(argc, argv);
+    StartupTrace::mark("QApplication created");
+    // --long-task-ms <ms> sets what counts as a long task (default 50);
+    // --event-loop-report <file> writes the lag and task histograms on exit
+    EventLoopMonitor* monitor = EventLoopMonitor::instance();
+    if (const int ms = argValue(app.arguments(), "--long-task-ms").toInt(); ms > 0) monitor->setThresholdMs(ms);
+    monitor->start();
+    FlowSchemeHandler::install(ProfileManager::instance()->persistentProfile());
+    FlowSchemeHandler::install(ProfileManager::instance()->incognitoProfile());
+    const BenchmarkOptions benchmark = parseBenchmarkArgs(app.arguments());
 
     MainWindow w;
+    StartupTrace::mark("window constructed");
+    if (benchmark.enabled) {
+        QObject::connect(&w, &MainWindow::startupFinished, &app, [&app, benchmark](){
+            app.exit(finishBenchmark(benchmark, false));
+        });
+        QTimer::singleShot(benchmark.timeoutMs, &app, [&app, benchmark](){
+            app.exit(finishBenchmark(benchmark, true));
+        });
+    }
     w.show();
+    StartupTrace::mark("window shown");
+    // --history-horizon-days <n> keeps history for n days from now on (0: forever)
+    HistoryRetention* retention = HistoryRetention::instance();
+    if (const QString days = argValue(app.arguments(), "--history-horizon-days"); !days.isEmpty()) retention->setHorizonDays(days.toInt());
+    retention->start();
 
-    return app.exec();
+    const int status = app.exec();
+    const QString eventLoopReport = argValue(app.arguments(), "--event-loop-report");
+    if (!eventLoopReport.isEmpty()) monitor->exportJson(eventLoopReport);
+    const QString tracePath = qEnvironmentVariable("FLOW_TRACE");
+    if (Trace::enabled() && tracePath.endsWith(".json")) Trace::exportChromeJson(tracePath);
+    return status;
 }
@@ -0,0 +1,107 @@
+#include <QtTest>
+#include "../cpp/src/MockSupabaseServer.h"
+#include "../cpp/src/AuthManager.h"
+#include "../cpp/src/NotesManager.h"
+
+class AuthRefreshTest : public QObject {
+    Q_OBJECT
+private slots:
+    void initTestCase();
+    void testRefreshBeforeExpiry();
+    void testOneRefreshForAllRejectedRequests();
+    void testWaitsForRunningRefresh();
+    void testSessionRenewedElsewhere();
+
+private:
+    qint64 refreshRequests() const { return m_server.stats().byRoute.value("POST /auth/v1/token"); }
+
+    MockSupabaseServer m_server;
+    AuthManager* m_auth = nullptr;
+    NotesManager* m_mgr = nullptr;
+};
+
+void AuthRefreshTest::initTestCase() {
+    QStandardPaths::setTestModeEnabled(true);
+    const QDir dataDir(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation));
+    for (const QString &f : dataDir.entryList({"flow.db*"}, QDir::Files)) QFile::remove(dataDir.filePath(f));
+    QFile::remove(dataDir.filePath("auth.json"));
+    QVERIFY(m_server.listen());
+    m_auth = new AuthManager(this);
+    m_auth->setSupabaseConfig(m_server.url(), m_server.anonKey());
+    m_mgr = new NotesManager(this);
+    m_mgr->setSupabaseConfig(m_server.url(), m_server.anonKey());
+    m_mgr->setAuthManager(m_auth);
+}
+
+void AuthRefreshTest::testRefreshBeforeExpiry() {
+    m_server.setTokenLifetime(2);
+    QSignalSpy signedIn(m_auth, &AuthManager::signedIn);
+    QSignalSpy refreshed(m_auth, &AuthManager::tokenRefreshed);
+    m_auth->signIn("a@b.c", "x");
+    QTRY_COMPARE_WITH_TIMEOUT(signedIn.count(), 1, 5000);
+    const QString first = m_auth->accessToken();
+    m_server.setTokenLifetime(3600);
+    // renewed halfway through the two seconds, before the token lapses
+    QTRY_COMPARE_WITH_TIMEOUT(refreshed.count(), 1, 3000);
+    QVERIFY(m_auth->accessToken() != first);
+    QVERIFY(m_auth->isSignedIn());
+    // the session went on: nobody saw a sign-in, so nothing pulled everything again
+    QCOMPARE(signedIn.count(), 1);
+    QTRY_COMPARE_WITH_TIMEOUT(m_server.stats().byRoute.value("GET /rest/v1/notes"), 1, 2000);
+    QTest::qWait(100);
+    QCOMPARE(m_server.stats().byRoute.value("GET /rest/v1/notes"), 1);
+}
+
+void AuthRefreshTest::testOneRefreshForAllRejectedRequests() {
+    const qint64 refreshesBefore = refreshRequests();
+    const qint64 unauthorizedBefore = m_server.stats().unauthorized;
+    m_server.revokeAccessTokens();
+    // a pull and an upload go out together with the revoked token
+    m_mgr->syncFromSupabase();
+    m_mgr->addNote("After revoke", "body");
+    QTRY_COMPARE_WITH_TIMEOUT(m_mgr->pendingCount(), 0, 5000);
+    QCOMPARE(m_server.rowCount("notes"), 1);
+    QVERIFY(m_server.stats().unauthorized - unauthorizedBefore >= 2);
+    QCOMPARE(refreshRequests() - refreshesBefore, 1);
+    QVERIFY(m_mgr->conflictIndices().isEmpty());
+}
+
+void AuthRefreshTest::testWaitsForRunningRefresh() {
+    m_server.setLatency(100);
+    const qint64 unauthorizedBefore = m_server.stats().unauthorized;
+    m_server.revokeAccessTokens();
+    m_mgr->syncFromSupabase();
+    QTRY_VERIFY_WITH_TIMEOUT(m_auth->isRefreshing(), 2000);
+    // issued mid-refresh: held back and sent once with the new token
+    m_mgr->addNote("During refresh", "body");
+    QTRY_COMPARE_WITH_TIMEOUT(m_mgr->pendingCount(), 0, 5000);
+    QCOMPARE(m_server.rowCount("notes"), 2);
+    QCOMPARE(m_server.stats().unauthorized - unauthorizedBefore, 1);
+    m_server.setLatency(0);
+}
+
+// two managers on one auth.json, as the app and flow_cli: the second does not
+// send the refresh token the first one used up, and does not sign out
+void AuthRefreshTest::testSessionRenewedElsewhere() {
+    AuthManager other;
+    other.setSupabaseConfig(m_server.url(), m_server.anonKey());
+    QCOMPARE(other.accessToken(), m_auth->accessToken());
+    QSignalSpy refreshed(m_auth, &AuthManager::tokenRefreshed);
+    QSignalSpy otherRefreshed(&other, &AuthManager::tokenRefreshed);
+    QSignalSpy otherSignedOut(&other, &AuthManager::signedOut);
+    const qint64 refreshesBefore = refreshRequests();
+    m_server.revokeAccessTokens();
+    bool released = false;
+    m_auth->tokenRejected(m_auth->accessToken(), this, [](){});
+    QTRY_COMPARE_WITH_TIMEOUT(refreshed.count(), 1, 5000);
+    other.tokenRejected(other.accessToken(), this, [&released](){ released = true; });
+    QTRY_VERIFY_WITH_TIMEOUT(released, 5000);
+    QCOMPARE(otherRefreshed.count(), 1);
+    QCOMPARE(otherSignedOut.count(), 0);
+    QCOMPARE(other.accessToken(), m_auth->accessToken());
+    QCOMPARE(refreshRequests() - refreshesBefore, 1);
+    QVERIFY(m_auth->isSignedIn());
+}
+
+QTEST_MAIN(AuthRefreshTest)
+#include "auth_refresh_test.moc"
@@ -0,0 +1,248 @@
+#include <QtTest>
+#include <QBuffer>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QTemporaryDir>
+#include "../cpp/src/BrowserImporter.h"
+#include "../cpp/src/HistoryManager.h"
+#include "../cpp/src/StorageExecutor.h"
+
+class BrowserImporterTest : public QObject {
+    Q_OBJECT
+private slots:
+    void initTestCase();
+    void init();
+    void testChromeTime();
+    void testReadBookmarksHtml();
+    void testChromeHistoryInBatches();
+    void testReimportAddsOnlyNewVisits();
+    void testFirefoxPlaces();
+    void testBookmarksHtmlSkipsKnown();
+    void testRejectsOtherFiles();
+
+private:
+    // a Chrome History file with n visits over 100 pages, a minute apart
+    QString writeChromeHistory(const QString& name, int n, qint64 firstSecs);
+    BrowserImporter::Result import(BrowserImporter& importer, const QString& path);
+    static qint64 visitCount();
+
+    QTemporaryDir m_dir;
+};
+
+void BrowserImporterTest::initTestCase() {
+    QStandardPaths::setTestModeEnabled(true);
+    const QDir dataDir(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation));
+    for (const QString &f : dataDir.entryList({"flow.db*", "history.db*"}, QDir::Files)) QFile::remove(dataDir.filePath(f));
+    QVERIFY(m_dir.isValid());
+    StorageExecutor::instance()->waitForIdle();
+}
+
+void BrowserImporterTest::init() {
+    StorageExecutor::instance()->blockingRead<bool>([](Storage& s){
+        QSqlQuery q(s.history());
+        return q.exec("DELETE FROM visits");
+    });
+}
+
+QString BrowserImporterTest::writeChromeHistory(const QString& name, int n, qint64 firstSecs) {
+    const QString path = m_dir.filePath(name);
+    QFile::remove(path);
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", "chrome_fixture");
+        db.setDatabaseName(path);
+        db.open();
+        QSqlQuery q(db);
+        q.exec("CREATE TABLE urls (id INTEGER PRIMARY KEY, url LONGVARCHAR, title LONGVARCHAR, visit_count INTEGER, last_visit_time INTEGER)");
+        q.exec("CREATE TABLE visits (id INTEGER PRIMARY KEY, url INTEGER NOT NULL, visit_time INTEGER NOT NULL, from_visit INTEGER, transition INTEGER)");
+        q.exec("CREATE INDEX visits_time_index ON visits (visit_time)");
+        db.transaction();
+        q.prepare("INSERT INTO urls (id, url, title) VALUES (?, ?, ?)");
+        for (int i = 1; i <= 100; ++i) {
+            q.addBindValue(i);
+            // one internal page, which is not imported
+            q.addBindValue(i == 100 ? QString("chrome://settings/") : QString("https://site%1.example/").arg(i));
+            q.addBindValue(QString("Site %1").arg(i));
+            q.exec();
+        }
+        q.prepare("INSERT INTO visits (url, visit_time) VALUES (?, ?)");
+        for (int i = 0; i < n; ++i) {
+            q.addBindValue(i % 100 + 1);
+            q.addBindValue((firstSecs + i * 60 + 11644473600LL) * 1000000);
+            q.exec();
+        }
+        db.commit();
+        db.close();
+    }
+    QSqlDatabase::removeDatabase("chrome_fixture");
+    return path;
+}
+
+BrowserImporter::Result BrowserImporterTest::import(BrowserImporter& importer, const QString& path) {
+    QSignalSpy finished(&importer, &BrowserImporter::finished);
+    if (!importer.start(path) || !finished.wait(60000)) return BrowserImporter::Result();
+    return finished.takeFirst().at(0).value<BrowserImporter::Result>();
+}
+
+qint64 BrowserImporterTest::visitCount() {
+    return StorageExecutor::instance()->blockingRead<qint64>([](Storage& s){
+        QSqlQuery q(s.history());
+        return q.exec("SELECT COUNT(*) FROM visits") && q.next() ? q.value(0).toLongLong() : -1;
+    });
+}
+
+void BrowserImporterTest::testChromeTime() {
+    QCOMPARE(BrowserImporter::chromeTimeToSecs(11644473600LL * 1000000), qint64(0));
+    QCOMPARE(BrowserImporter::chromeTimeToSecs((1700000000LL + 11644473600LL) * 1000000 + 999999), qint64(1700000000));
+}
+
+void BrowserImporterTest::testReadBookmarksHtml() {
+    QByteArray html =
+        "<!DOCTYPE NETSCAPE-Bookmark-file-1>\n"
+        "<TITLE>Bookmarks</TITLE>\n<H1>Bookmarks</H1>\n"
+        "<DL><p>\n"
+        "    <DT><H3 ADD_DATE=\"1\" PERSONAL_TOOLBAR_FOLDER=\"true\">Bookmarks bar</H3>\n"
+        "    <DL><p>\n"
+        "        <DT><A HREF=\"https://a.example/?x=1&amp;y=2\" ADD_DATE=\"1\">A &amp; B &#8211; &#x263A;</A>\n"
+        "        <DT><H3>Dev</H3>\n"
+        "        <DL><p>\n"
+        "            <DT><A HREF=\"https://qt.io/\" ICON=\"data:image/png;base64,AAAA\">Qt</A>\n"
+        "            <DT><A HREF=\"javascript:alert(1)\">Bookmarklet</A>\n"
+        "        </DL><p>\n"
+        "        <DT><A HREF=\"https://b.example/\"></A>\n"
+        "    </DL><p>\n"
+        "    <DT><A HREF=\"https://top.example/\">Top</A>\n"
+        "</DL><p>\n";
+    QBuffer in(&html);
+    in.open(QIODevice::ReadOnly);
+    QVector<Bookmark> found;
+    BrowserImporter::readBookmarksHtml(in, [&found](const Bookmark& b){ found.append(b); return true; });
+    QCOMPARE(found.size(), 4);
+    QCOMPARE(found[0].url, QString("https://a.example/?x=1&y=2"));
+    QCOMPARE(found[0].title, QString::fromUtf8("A & B – ☺"));
+    QCOMPARE(found[0].folder, QString());
+    QCOMPARE(found[1].title, QString("Qt"));
+    QCOMPARE(found[1].folder, QString("Dev"));
+    // back in the toolbar after the folder closed; no title falls back to the URL
+    QCOMPARE(found[2].folder, QString());
+    QCOMPARE(found[2].title, QString("https://b.example/"));
+    QCOMPARE(found[3].url, QString("https://top.example/"));
+
+    in.seek(0);
+    int seen = 0;
+    BrowserImporter::readBookmarksHtml(in, [&seen](const Bookmark&){ return ++seen < 2; });
+    QCOMPARE(seen, 2);
+}
+
+void BrowserImporterTest::testChromeHistoryInBatches() {
+    const int n = 2 * BrowserImporter::kVisitBatch + 500;
+    const QString path = writeChromeHistory("History", n, 1600000000);
+    HistoryManager history;
+    QSignalSpy imported(&history, &HistoryManager::visitsImported);
+    BrowserImporter importer(&history, nullptr);
+    QSignalSpy progress(&importer, &BrowserImporter::progress);
+    const BrowserImporter::Result r = import(importer, path);
+    QVERIFY2(r.error.isEmpty(), qPrintable(r.error));
+    QCOMPARE(r.format, BrowserImporter::Format::ChromeHistory);
+    // every hundredth visit was to chrome://settings
+    QCOMPARE(r.visits, qint64(n - n / 100));
+    QCOMPARE(visitCount(), r.visits);
+    QCOMPARE(imported.size(), 1);
+    QVERIFY(progress.size() >= 3);
+    QCOMPARE(progress.last().at(0).toLongLong(), qint64(n));
+
+    const qint64 first = StorageExecutor::instance()->blockingRead<qint64>([](Storage& s){
+        QSqlQuery q(s.history());
+        return q.exec("SELECT MIN(visited_at) FROM visits") && q.next() ? q.value(0).toLongLong() : -1;
+    });
+    QCOMPARE(first, qint64(1600000000));
+}
+
+void BrowserImporterTest::testReimportAddsOnlyNewVisits() {
+    const QString path = writeChromeHistory("History-2", 1000, 1650000000);
+    BrowserImporter importer(nullptr, nullptr);
+    QCOMPARE(import(importer, path).visits, qint64(990));
+    QCOMPARE(import(importer, path).visits, qint64(0));
+
+    // the browser kept going: only the 500 visits after the first 1000 are new
+    writeChromeHistory("History-2", 1500, 1650000000);
+    QCOMPARE(import(importer, path).visits, qint64(495));
+    QCOMPARE(visitCount(), qint64(1485));
+}
+
+void BrowserImporterTest::testFirefoxPlaces() {
+    const QString path = m_dir.filePath("places.sqlite");
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", "firefox_fixture");
+        db.setDatabaseName(path);
+        db.open();
+        QSqlQuery q(db);
+        q.exec("CREATE TABLE moz_places (id INTEGER PRIMARY KEY, url LONGVARCHAR, title LONGVARCHAR)");
+        q.exec("CREATE TABLE moz_historyvisits (id INTEGER PRIMARY KEY, place_id INTEGER, visit_date INTEGER)");
+        q.exec("CREATE TABLE moz_bookmarks (id INTEGER PRIMARY KEY, type INTEGER, fk INTEGER, parent INTEGER, "
+               "position INTEGER, title LONGVARCHAR, guid TEXT)");
+        q.exec("INSERT INTO moz_places VALUES (1, 'https://mozilla.org/', 'Mozilla'), (2, 'https://mdn.dev/', 'MDN'), "
+               "(3, 'place:sort=8', 'Recent')");
+        q.exec("INSERT INTO moz_historyvisits (place_id, visit_date) VALUES (1, 1600000000000000), (2, 1600000060000000), "
+               "(1, 1600000120000000)");
+        q.exec("INSERT INTO moz_bookmarks VALUES (1, 2, NULL, 0, 0, '', 'root________'), (2, 2, NULL, 1, 0, 'menu', 'menu________'), "
+               "(3, 2, NULL, 2, 0, 'Docs', 'folder000001'), (4, 1, 1, 2, 1, 'Mozilla', 'bookmark0001'), "
+               "(5, 1, 2, 3, 0, 'MDN', 'bookmark0002'), (6, 1, 3, 2, 2, 'Recent', 'bookmark0003')");
+        db.close();
+    }
+    QSqlDatabase::removeDatabase("firefox_fixture");
+
+    BookmarksManager bookmarks;
+    QTRY_VERIFY(bookmarks.isLoaded());
+    const int before = bookmarks.count();
+    BrowserImporter importer(nullptr, &bookmarks);
+    const BrowserImporter::Result r = import(importer, path);
+    QVERIFY2(r.error.isEmpty(), qPrintable(r.error));
+    QCOMPARE(r.format, BrowserImporter::Format::FirefoxPlaces);
+    QCOMPARE(r.visits, qint64(3));
+    QCOMPARE(r.bookmarks, 2);
+    QCOMPARE(bookmarks.count(), before + 2);
+    const QVector<Bookmark> added = bookmarks.bookmarks().mid(before);
+    QCOMPARE(added[0].url, QString("https://mozilla.org/"));
+    QCOMPARE(added[0].folder, QString());
+    QCOMPARE(added[1].folder, QString("Docs"));
+}
+
+void BrowserImporterTest::testBookmarksHtmlSkipsKnown() {
+    BookmarksManager bookmarks;
+    QTRY_VERIFY(bookmarks.isLoaded());
+    bookmarks.addBookmark("Known", "https://known.example/");
+    const int before = bookmarks.count();
+    QSignalSpy changes(&bookmarks, &BookmarksManager::bookmarksUpdated);
+
+    const QString path = m_dir.filePath("bookmarks.html");
+    QFile f(path);
+    QVERIFY(f.open(QIODevice::WriteOnly));
+    f.write("<!DOCTYPE NETSCAPE-Bookmark-file-1>\n<DL><p>\n<DT><A HREF=\"https://known.example/\">Known</A>\n");
+    for (int i = 0; i < 2500; ++i) f.write(QString("<DT><A HREF=\"https://page%1.example/\">Page %1</A>\n").arg(i).toUtf8());
+    f.write("</DL><p>\n");
+    f.close();
+
+    BrowserImporter importer(nullptr, &bookmarks);
+    const BrowserImporter::Result r = import(importer, path);
+    QCOMPARE(r.format, BrowserImporter::Format::BookmarksHtml);
+    QCOMPARE(r.bookmarks, 2500);
+    QCOMPARE(r.knownBookmarks, 1);
+    QCOMPARE(bookmarks.count(), before + 2500);
+    // one change per batch, not per bookmark
+    QCOMPARE(changes.size(), 3);
+}
+
+void BrowserImporterTest::testRejectsOtherFiles() {
+    const QString path = m_dir.filePath("notes.txt");
+    QFile f(path);
+    QVERIFY(f.open(QIODevice::WriteOnly));
+    f.write("just some text\n");
+    f.close();
+    BrowserImporter importer(nullptr, nullptr);
+    const BrowserImporter::Result r = import(importer, path);
+    QVERIFY(!r.error.isEmpty());
+    QCOMPARE(r.visits, qint64(0));
+}
+
+QTEST_MAIN(BrowserImporterTest)
+#include "browser_importer_test.moc"
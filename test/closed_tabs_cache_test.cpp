@@ -0,0 +1,51 @@
+#include <QtTest>
+#include "../cpp/src/ClosedTabsCache.h"
+
+class ClosedTabsCacheTest : public QObject {
+    Q_OBJECT
+private slots:
+    void testStackOrder();
+    void testCountLimit();
+    void testByteLimit();
+};
+
+static ClosedTab makeTab(const QString& url, int historyBytes = 100) {
+    ClosedTab t;
+    t.url = url;
+    t.history = QByteArray(historyBytes, 'h');
+    return t;
+}
+
+void ClosedTabsCacheTest::testStackOrder() {
+    ClosedTabsCache cache;
+    QSignalSpy spy(&cache, &ClosedTabsCache::availableChanged);
+    cache.push(makeTab("https://a.example"));
+    cache.push(makeTab("https://b.example"));
+    QCOMPARE(cache.count(), 2);
+    QCOMPARE(cache.takeLast().url, QString("https://b.example"));
+    QCOMPARE(cache.takeLast().url, QString("https://a.example"));
+    QVERIFY(cache.isEmpty());
+    QCOMPARE(cache.totalBytes(), qint64(0));
+    QCOMPARE(spy.count(), 2); // became available, then empty
+}
+
+void ClosedTabsCacheTest::testCountLimit() {
+    ClosedTabsCache cache;
+    cache.setLimits(3, 1024 * 1024);
+    for (int i = 0; i < 5; ++i) cache.push(makeTab(QString("https://%1.example").arg(i)));
+    QCOMPARE(cache.count(), 3);
+    // oldest entries are evicted first
+    QCOMPARE(cache.entries().first().url, QString("https://2.example"));
+}
+
+void ClosedTabsCacheTest::testByteLimit() {
+    ClosedTabsCache cache;
+    cache.setLimits(100, 2500);
+    for (int i = 0; i < 5; ++i) cache.push(makeTab(QString("https://%1.example").arg(i), 1000));
+    QVERIFY(cache.totalBytes() <= 2500);
+    QCOMPARE(cache.count(), 2);
+    QCOMPARE(cache.takeLast().url, QString("https://4.example"));
+}
+
+QTEST_MAIN(ClosedTabsCacheTest)
+#include "closed_tabs_cache_test.moc"
@@ -0,0 +1,240 @@
+#include <QtTest>
+#include <QSqlQuery>
+#include "../cpp/src/TodosModel.h"
+#include "../cpp/src/NotesModel.h"
+#include "../cpp/src/CollectionFilterModel.h"
+#include "../cpp/src/StorageExecutor.h"
+
+class CollectionModelTest : public QObject {
+    Q_OBJECT
+private slots:
+    void initTestCase();
+    void init();
+    void testRowLevelSignals();
+    void testBurstIsOneUpdate();
+    void testWorkspaces();
+    void testFilter();
+    void testOrder();
+    void testNotesColumns();
+    void testLargeSyncBurst();
+};
+
+void CollectionModelTest::initTestCase() {
+    QStandardPaths::setTestModeEnabled(true);
+    StorageExecutor::instance()->waitForIdle();
+}
+
+// rows left by the previous test would be loaded too
+void CollectionModelTest::init() {
+    StorageExecutor::instance()->blockingRead<bool>([](Storage& s){
+        QSqlQuery q(s.database());
+        return q.exec("DELETE FROM todos") && q.exec("DELETE FROM notes") && q.exec("DELETE FROM sync_queue");
+    });
+}
+
+void CollectionModelTest::testRowLevelSignals() {
+    TodosManager todos;
+    QTRY_VERIFY(todos.isLoaded());
+    for (int i = 0; i < 5; ++i) todos.addTodo(QString("T%1").arg(i));
+    TodosModel model(&todos);
+    QCOMPARE(model.rowCount(), 5);
+    QSignalSpy resets(&model, &QAbstractItemModel::modelReset);
+    QSignalSpy inserted(&model, &QAbstractItemModel::rowsInserted);
+    QSignalSpy removed(&model, &QAbstractItemModel::rowsRemoved);
+    QSignalSpy changed(&model, &QAbstractItemModel::dataChanged);
+
+    todos.addTodo("T5");
+    todos.addTodo("T6");
+    model.update();
+    QCOMPARE(inserted.size(), 1);
+    QCOMPARE(inserted[0][1].toInt(), 5);
+    QCOMPARE(inserted[0][2].toInt(), 6);
+
+    todos.removeTodo(1);
+    todos.removeTodo(1);
+    todos.setCompleted(3, true);
+    model.update();
+    QCOMPARE(removed.size(), 1);
+    QCOMPARE(removed[0][1].toInt(), 1);
+    QCOMPARE(removed[0][2].toInt(), 2);
+    QCOMPARE(changed.size(), 1);
+    QCOMPARE(changed[0][0].toModelIndex().row(), 3);
+    QCOMPARE(changed[0][1].toModelIndex().row(), 3);
+    QCOMPARE(model.index(3, 0).data(Qt::CheckStateRole).toInt(), int(Qt::Checked));
+
+    // an undone remove comes back where it was
+    todos.removeTodoWithUndo(0);
+    model.update();
+    todos.undoLastRemove();
+    model.update();
+    QCOMPARE(inserted.size(), 2);
+    QCOMPARE(inserted[1][1].toInt(), 0);
+
+    // nothing visible changed, nothing is signalled
+    model.update();
+    QCOMPARE(changed.size(), 1);
+    QCOMPARE(resets.size(), 0);
+    QCOMPARE(model.resetCount(), 0);
+    QCOMPARE(model.rowCount(), todos.count());
+    for (int row = 0; row < model.rowCount(); ++row)
+        QCOMPARE(model.index(row, 0).data().toString(), todos.todos()[row].title);
+}
+
+void CollectionModelTest::testBurstIsOneUpdate() {
+    TodosManager todos;
+    QTRY_VERIFY(todos.isLoaded());
+    TodosModel model(&todos);
+    QSignalSpy inserted(&model, &QAbstractItemModel::rowsInserted);
+    for (int i = 0; i < 100; ++i) todos.addTodo(QString("T%1").arg(i));
+    // nothing until the frame is over
+    QCOMPARE(model.rowCount(), 0);
+    QTRY_COMPARE(model.rowCount(), 100);
+    QCOMPARE(model.updateCount(), 1);
+    QCOMPARE(inserted.size(), 1);
+
+    // checking a box shows at once
+    QVERIFY(model.setData(model.index(7, 0), int(Qt::Checked), Qt::CheckStateRole));
+    QVERIFY(todos.todos()[7].completed);
+    QCOMPARE(model.index(7, 0).data(CollectionModel::DoneRole).toBool(), true);
+}
+
+void CollectionModelTest::testWorkspaces() {
+    TodosManager todos;
+    QTRY_VERIFY(todos.isLoaded());
+    todos.addTodo("a", "Work");
+    TodosModel model(&todos);
+    QCOMPARE(model.workspaces(), QStringList{"Work"});
+    QSignalSpy workspaces(&model, &CollectionModel::workspacesChanged);
+    todos.addTodo("b", "Work");
+    todos.addTodo("c");
+    model.update();
+    QCOMPARE(workspaces.size(), 0);
+    todos.addTodo("d", "home");
+    model.update();
+    QCOMPARE(workspaces.size(), 1);
+    QCOMPARE(model.workspaces(), QStringList({"home", "Work"}));
+    todos.removeTodo(3);
+    model.update();
+    QCOMPARE(workspaces.size(), 2);
+    QCOMPARE(model.workspaces(), QStringList{"Work"});
+}
+
+void CollectionModelTest::testFilter() {
+    TodosManager todos;
+    QTRY_VERIFY(todos.isLoaded());
+    todos.addTodo("Buy milk", "Home");
+    todos.addTodo("Write report", "Work");
+    todos.addTodo("Buy paper", "Work");
+    todos.setCompleted(2, true);
+    TodosModel model(&todos);
+    CollectionFilterModel filter;
+    filter.setSourceModel(&model);
+    QCOMPARE(filter.rowCount(), 3);
+
+    filter.setWorkspace("Work");
+    QCOMPARE(filter.rowCount(), 2);
+    filter.setStatus(CollectionFilterModel::Status::Open);
+    QCOMPARE(filter.rowCount(), 1);
+    QCOMPARE(filter.index(0, 0).data().toString(), QString("Write report"));
+    filter.setStatus(CollectionFilterModel::Status::Any);
+    filter.setWorkspace(QString());
+    filter.setText("  BUY  ");
+    QCOMPARE(filter.rowCount(), 2);
+    filter.setText("buy pap");
+    QCOMPARE(filter.rowCount(), 1);
+    QCOMPARE(filter.index(0, 0).data().toString(), QString("Buy paper"));
+
+    // the proxy follows row changes of the source
+    filter.setText("buy");
+    todos.addTodo("Buy stamps");
+    todos.addTodo("Call back");
+    model.update();
+    QCOMPARE(filter.rowCount(), 3);
+}
+
+void CollectionModelTest::testOrder() {
+    TodosManager todos;
+    QTRY_VERIFY(todos.isLoaded());
+    todos.addTodo("charlie");
+    todos.addTodo("Alpha");
+    todos.addTodo("bravo");
+    todos.setCompleted(1, true);
+    TodosModel model(&todos);
+    CollectionFilterModel filter;
+    filter.setSourceModel(&model);
+    auto titles = [&filter]() {
+        QStringList t;
+        for (int row = 0; row < filter.rowCount(); ++row) t << filter.index(row, 0).data().toString();
+        return t;
+    };
+    filter.setOrder(CollectionFilterModel::Order::Title);
+    QCOMPARE(titles(), QStringList({"Alpha", "bravo", "charlie"}));
+    // open first
+    filter.setOrder(CollectionFilterModel::Order::Status);
+    QCOMPARE(titles(), QStringList({"bravo", "charlie", "Alpha"}));
+    filter.setOrder(CollectionFilterModel::Order::Title, Qt::DescendingOrder);
+    QCOMPARE(titles(), QStringList({"charlie", "bravo", "Alpha"}));
+    // a new row goes to its place
+    todos.addTodo("delta");
+    model.update();
+    QCOMPARE(titles().first(), QString("delta"));
+    filter.setOrder(CollectionFilterModel::Order::Manual);
+    QCOMPARE(titles(), QStringList({"charlie", "Alpha", "bravo", "delta"}));
+}
+
+void CollectionModelTest::testNotesColumns() {
+    NotesManager notes;
+    QTRY_VERIFY(notes.isLoaded());
+    notes.addNote("Title", QString(300, QLatin1Char('x')), "Work");
+    NotesModel model(&notes);
+    QCOMPARE(model.columnCount(), 2);
+    QCOMPARE(model.headerData(1, Qt::Horizontal).toString(), QString("Summary"));
+    QCOMPARE(model.index(0, 1).data().toString().size(), NotesModel::kSummaryLength);
+    QSignalSpy changed(&model, &QAbstractItemModel::dataChanged);
+    notes.editNote(0, "Renamed", "short");
+    model.update();
+    QCOMPARE(changed.size(), 1);
+    QCOMPARE(changed[0][1].toModelIndex().column(), 1);
+
+    CollectionFilterModel filter;
+    filter.setSourceModel(&model);
+    filter.setText("short");
+    QCOMPARE(filter.rowCount(), 1);
+    filter.setStatus(CollectionFilterModel::Status::Conflict);
+    QCOMPARE(filter.rowCount(), 0);
+    filter.setStatus(CollectionFilterModel::Status::Pending);
+    QCOMPARE(filter.rowCount(), 1);
+}
+
+// what a pull does to a big list: scattered edits and a page of new rows,
+// which must reach the views as row changes in one update
+void CollectionModelTest::testLargeSyncBurst() {
+    const int n = 50000;
+    TodosManager todos;
+    QTRY_VERIFY(todos.isLoaded());
+    QVector<TodoItem> seed;
+    for (int i = 0; i < n; ++i) seed.append({QString(), QString("Todo %1").arg(i), false, i % 2 ? "Work" : "Home"});
+    todos.appendMany(seed);
+    TodosModel model(&todos);
+    CollectionFilterModel filter;
+    filter.setSourceModel(&model);
+    filter.setStatus(CollectionFilterModel::Status::Done);
+    QCOMPARE(filter.rowCount(), 0);
+    QSignalSpy resets(&model, &QAbstractItemModel::modelReset);
+    QSignalSpy changed(&model, &QAbstractItemModel::dataChanged);
+
+    for (int i = 0; i < n; i += 100) todos.setCompleted(i, true);
+    QVector<TodoItem> page;
+    for (int i = 0; i < 1000; ++i) page.append({QString(), QString("Pulled %1").arg(i)});
+    todos.appendMany(page);
+    todos.removeTodo(n / 2 + 1);
+    const int updates = model.updateCount();
+    QTRY_COMPARE(model.rowCount(), n + 1000 - 1);
+    QCOMPARE(model.updateCount(), updates + 1);
+    QCOMPARE(resets.size(), 0);
+    QCOMPARE(changed.size(), n / 100);
+    QCOMPARE(filter.rowCount(), n / 100);
+}
+
+QTEST_MAIN(CollectionModelTest)
+#include "collection_model_test.moc"
@@ -0,0 +1,153 @@
+#include <QtTest>
+#include <QTemporaryDir>
+#include "../cpp/src/ContentBlocker.h"
+#include "../cpp/src/ContentFilter.h"
+
+class ContentFilterTest : public QObject {
+    Q_OBJECT
+private slots:
+    void testHostRules();
+    void testPatternRules();
+    void testOptions();
+    void testExceptions();
+    void testUnsupported();
+    void testMappedCache();
+    void testBlockerReusesCache();
+    void testRegistrableDomain();
+};
+
+static bool blocks(const ContentFilter& f, const char* url, const char* page = "", quint32 type = ContentFilter::Script) {
+    return f.shouldBlock(QByteArray(url), QByteArray(page), type);
+}
+
+void ContentFilterTest::testHostRules() {
+    ContentFilter f;
+    QVERIFY(f.load(ContentFilter::compile({"||ads.example.com^", "||tracker.net^$third-party"})));
+    QVERIFY(blocks(f, "https://ads.example.com/x.js"));
+    QVERIFY(blocks(f, "https://cdn.ads.example.com/x.js"));
+    QVERIFY(!blocks(f, "https://example.com/ads.js"));
+    QVERIFY(!blocks(f, "https://badads.example.com/x.js"));
+    QVERIFY(blocks(f, "https://tracker.net/p.gif", "news.org", ContentFilter::Image));
+    QVERIFY(!blocks(f, "https://tracker.net/p.gif", "www.tracker.net", ContentFilter::Image));
+    // the navigation itself is never blocked
+    QVERIFY(!blocks(f, "https://ads.example.com/", "", ContentFilter::Document));
+}
+
+void ContentFilterTest::testPatternRules() {
+    ContentFilter f;
+    QVERIFY(f.load(ContentFilter::compile({"/banner/*/img^", "||cdn.site.com/ads/", "|https://start.example/", "swf|", "&adtype="})));
+    QVERIFY(blocks(f, "https://x.org/banner/foo/img?x=1"));
+    QVERIFY(blocks(f, "https://x.org/banner/foo/img"));
+    QVERIFY(!blocks(f, "https://x.org/banner/foo/imgs"));
+    QVERIFY(blocks(f, "https://cdn.site.com/ads/1.png"));
+    QVERIFY(!blocks(f, "https://cdn.site.com/media/ads/1.png"));
+    QVERIFY(blocks(f, "https://start.example/a"));
+    QVERIFY(!blocks(f, "https://x.org/?u=https://start.example/a"));
+    QVERIFY(blocks(f, "https://x.org/movie.swf"));
+    QVERIFY(!blocks(f, "https://x.org/movie.swf?x"));
+    QVERIFY(blocks(f, "https://x.org/q?a=1&adtype=2"));
+    QVERIFY(!blocks(f, "https://X.org/Banner/foo/IMG")); // the raw overload expects lowercase
+    QVERIFY(f.shouldBlock(QUrl("https://X.org/Banner/foo/IMG"), QUrl(), ContentFilter::Image));
+}
+
+void ContentFilterTest::testOptions() {
+    ContentFilter f;
+    QVERIFY(f.load(ContentFilter::compile({
+        "/pixel.$image,third-party",
+        "||widgets.example^$script,domain=news.org|~sports.news.org",
+        "/popunder.$~script"})));
+    QVERIFY(blocks(f, "https://t.co/pixel.gif", "blog.org", ContentFilter::Image));
+    QVERIFY(!blocks(f, "https://t.co/pixel.gif", "blog.org", ContentFilter::Script));
+    QVERIFY(!blocks(f, "https://blog.org/pixel.gif", "blog.org", ContentFilter::Image));
+    QVERIFY(blocks(f, "https://widgets.example/w.js", "www.news.org"));
+    QVERIFY(!blocks(f, "https://widgets.example/w.js", "sports.news.org"));
+    QVERIFY(!blocks(f, "https://widgets.example/w.js", "other.org"));
+    QVERIFY(blocks(f, "https://x.org/popunder.html", "", ContentFilter::Subdocument));
+    QVERIFY(!blocks(f, "https://x.org/popunder.js", "", ContentFilter::Script));
+}
+
+void ContentFilterTest::testExceptions() {
+    ContentFilter f;
+    QVERIFY(f.load(ContentFilter::compile({
+        "||ads.example.com^",
+        "@@||ads.example.com/consent/",
+        "/track.js",
+        "/beacon.js$important",
+        "@@/beacon.js",
+        "@@||trusted.org^$document"})));
+    QVERIFY(blocks(f, "https://ads.example.com/x.js"));
+    QVERIFY(!blocks(f, "https://ads.example.com/consent/x.js"));
+    QVERIFY(blocks(f, "https://x.org/track.js", "news.org"));
+    QVERIFY(!blocks(f, "https://x.org/track.js", "www.trusted.org"));
+    QVERIFY(blocks(f, "https://x.org/beacon.js", "www.trusted.org"));
+}
+
+void ContentFilterTest::testUnsupported() {
+    ContentFilter::CompileStats st;
+    const QByteArray image = ContentFilter::compile({
+        "[Adblock Plus 2.0]", "! comment", "", "example.com##.ad", "/ads[0-9]+/",
+        "||x.com^$redirect=noop.js", "||y.com^", "/a/b/"}, &st);
+    QCOMPARE(st.lines, 8);
+    QCOMPARE(st.unsupported, 4);
+    QCOMPARE(st.hostRules, 1);
+    ContentFilter f;
+    QVERIFY(f.load(image));
+    QCOMPARE(f.ruleCount(), 1);
+    QVERIFY(!f.load(QByteArray("not a filter")));
+    QVERIFY(!f.load(image.left(image.size() / 2)));
+    QVERIFY(f.isLoaded()); // a failed load keeps the previous image
+}
+
+void ContentFilterTest::testMappedCache() {
+    QTemporaryDir dir;
+    const QString path = dir.filePath("compiled.bin");
+    QVERIFY(ContentFilter::writeCompiled(path, ContentFilter::compile({"||ads.example.com^", "/banner/*/img^"})));
+    ContentFilter f;
+    QVERIFY(f.mapFile(path));
+    QVERIFY(blocks(f, "https://ads.example.com/"));
+    QVERIFY(blocks(f, "https://x.org/banner/1/img.png", "", ContentFilter::Image));
+    QVERIFY(!blocks(f, "https://x.org/"));
+}
+
+void ContentFilterTest::testBlockerReusesCache() {
+    QStandardPaths::setTestModeEnabled(true);
+    QTemporaryDir dir;
+    auto writeList = [&dir](const char* name, const QByteArray& rules) {
+        QFile f(dir.filePath(name));
+        QVERIFY(f.open(QIODevice::WriteOnly));
+        f.write(rules);
+    };
+    writeList("easylist.txt", "||ads.example.com^\n");
+    ContentBlocker* blocker = ContentBlocker::instance();
+    blocker->setListsDir(dir.path());
+    QVERIFY(blocker->isCompiling());
+    QTRY_VERIFY(!blocker->isCompiling());
+    QVERIFY(blocks(*blocker->filter(), "https://ads.example.com/"));
+
+    // writing the cache touched the directory; the cache is still current
+    blocker->reload();
+    QVERIFY(!blocker->isCompiling());
+    QVERIFY(blocks(*blocker->filter(), "https://ads.example.com/"));
+
+    // a new list, or a changed one, is compiled in
+    writeList("extra.txt", "||tracker.net^\n");
+    blocker->reload();
+    QVERIFY(blocker->isCompiling());
+    QTRY_VERIFY(!blocker->isCompiling());
+    QVERIFY(blocks(*blocker->filter(), "https://tracker.net/"));
+    writeList("extra.txt", "||other.net^\n");
+    blocker->reload();
+    QVERIFY(blocker->isCompiling());
+    QTRY_VERIFY(!blocker->isCompiling());
+    QVERIFY(!blocks(*blocker->filter(), "https://tracker.net/"));
+}
+
+void ContentFilterTest::testRegistrableDomain() {
+    QCOMPARE(ContentFilter::registrableDomain("www.example.com"), QByteArray("example.com"));
+    QCOMPARE(ContentFilter::registrableDomain("news.bbc.co.uk"), QByteArray("bbc.co.uk"));
+    QCOMPARE(ContentFilter::registrableDomain("cdn.abc.de"), QByteArray("abc.de"));
+    QCOMPARE(ContentFilter::registrableDomain("localhost"), QByteArray("localhost"));
+}
+
+QTEST_MAIN(ContentFilterTest)
+#include "content_filter_test.moc"
@@ -0,0 +1,138 @@
+#include <QtTest>
+#include <QJsonArray>
+#include <QJsonObject>
+#include "../cpp/src/EventLoopMonitor.h"
+
+namespace {
+// run the event loop for ms, the way the application's main loop would
+void spin(int ms) {
+    QEventLoop loop;
+    QTimer::singleShot(ms, &loop, &QEventLoop::quit);
+    loop.exec();
+}
+
+// a timer firing once, soon, with fn as its slot
+QTimer* fireOnce(const QString& name, std::function<void()> fn, QObject* parent) {
+    auto *t = new QTimer(parent);
+    t->setObjectName(name);
+    t->setSingleShot(true);
+    QObject::connect(t, &QTimer::timeout, fn);
+    t->start(0);
+    return t;
+}
+
+class Sleeper : public QObject {
+public:
+    bool event(QEvent* e) override {
+        if (e->type() != QEvent::User) return QObject::event(e);
+        QThread::msleep(60);
+        return true;
+    }
+};
+}
+
+class EventLoopMonitorTest : public QObject {
+    Q_OBJECT
+private slots:
+    void initTestCase();
+    void testLongHandlerIsReported();
+    void testHangIsFlaggedWhileRunning();
+    void testSentEventsBelongToTheirSender();
+    void testNestedLoopIsNotATask();
+    void testLagIsMeasured();
+    void testJsonReport();
+
+private:
+    static EventLoopMonitor* monitor() { return EventLoopMonitor::instance(); }
+    // long tasks reported since count were taken
+    static QVector<LongTask> since(int count) { return monitor()->longTasks().mid(count); }
+};
+
+void EventLoopMonitorTest::initTestCase() {
+    monitor()->setThresholdMs(30);
+    monitor()->setSampleIntervalMs(5);
+    monitor()->start();
+    QVERIFY(monitor()->isRunning());
+}
+
+void EventLoopMonitorTest::testLongHandlerIsReported() {
+    const int before = monitor()->longTasks().size();
+    QObject owner;
+    fireOnce("quick", [](){}, &owner);
+    fireOnce("saveTimer", [](){ QThread::msleep(80); }, &owner);
+    spin(50);
+    const QVector<LongTask> tasks = since(before);
+    QCOMPARE(tasks.size(), 1);
+    QCOMPARE(tasks[0].receiverClass, QString("QTimer"));
+    QCOMPARE(tasks[0].receiverName, QString("saveTimer"));
+    QCOMPARE(tasks[0].event, QString("Timer"));
+    QVERIFY(tasks[0].ms >= 80.0);
+    QVERIFY(tasks[0].label().contains("saveTimer"));
+}
+
+void EventLoopMonitorTest::testHangIsFlaggedWhileRunning() {
+    const int before = monitor()->longTasks().size();
+    QObject owner;
+    fireOnce("hang", [](){ QThread::msleep(200); }, &owner);
+    spin(30);
+    const QVector<LongTask> tasks = since(before);
+    QCOMPARE(tasks.size(), 1);
+    // the sampler thread saw it before it returned
+    QVERIFY(tasks[0].flagged);
+}
+
+void EventLoopMonitorTest::testSentEventsBelongToTheirSender() {
+    const int before = monitor()->longTasks().size();
+    QObject owner;
+    Sleeper sleeper;
+    sleeper.setObjectName("sleeper");
+    fireOnce("caller", [&sleeper](){
+        QEvent e(QEvent::User);
+        QCoreApplication::sendEvent(&sleeper, &e);
+    }, &owner);
+    spin(30);
+    const QVector<LongTask> tasks = since(before);
+    QCOMPARE(tasks.size(), 1);
+    QCOMPARE(tasks[0].receiverName, QString("caller"));
+}
+
+void EventLoopMonitorTest::testNestedLoopIsNotATask() {
+    const int before = monitor()->longTasks().size();
+    QObject owner;
+    // like a modal dialog: the handler waits in a loop of its own
+    fireOnce("dialog", [](){ spin(150); }, &owner);
+    spin(200);
+    QVERIFY(since(before).isEmpty());
+}
+
+void EventLoopMonitorTest::testLagIsMeasured() {
+    MetricsRegistry::Histogram* lag = MetricsRegistry::histogram("gui.event_loop_lag_ms");
+    spin(50);
+    QVERIFY(lag->snapshot().count > 0);
+    QObject owner;
+    fireOnce("block", [](){ QThread::msleep(100); }, &owner);
+    spin(50);
+    // a ping posted while the handler ran waited for most of it
+    QVERIFY(lag->snapshot().max >= 50.0);
+}
+
+void EventLoopMonitorTest::testJsonReport() {
+    const QJsonObject o = monitor()->toJson();
+    QCOMPARE(o["threshold_ms"].toInt(), 30);
+    QVERIFY(o["task_ms"].toObject()["count"].toInt() > 0);
+    QVERIFY(o["event_loop_lag_ms"].toObject().contains("p99"));
+    const QJsonArray tasks = o["long_tasks"].toArray();
+    QCOMPARE(tasks.size(), monitor()->longTasks().size());
+    QCOMPARE(tasks.first().toObject()["name"].toString(), QString("saveTimer"));
+    QVERIFY(MetricsRegistry::toJson()["sections"].toObject()["long_tasks"].toArray().size() == tasks.size());
+}
+
+int main(int argc, char** argv) {
+    MonitoredApplication<QCoreApplication> app(argc, argv);
+    EventLoopMonitorTest test;
+    const int status = QTest::qExec(&test, argc, argv);
+    EventLoopMonitor::instance()->stop();
+    return status;
+}
+
+#include "event_loop_monitor_test.moc"
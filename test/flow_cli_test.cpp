@@ -0,0 +1,214 @@
+#include <QtTest>
+#include <QSqlQuery>
+#include <QTemporaryDir>
+#include "../cpp/src/FlowCli.h"
+#include "../cpp/src/BookmarksManager.h"
+#include "../cpp/src/HistoryManager.h"
+#include "../cpp/src/NotesManager.h"
+#include "../cpp/src/StorageExecutor.h"
+#include "../cpp/src/StoreTransfer.h"
+
+class FlowCliTest : public QObject {
+    Q_OBJECT
+private slots:
+    void initTestCase();
+    void testUsageErrors();
+    void testBookmarksRoundTrip();
+    void testUnsyncedNotesRoundTrip();
+    void testHistoryRoundTrip();
+    void testMalformedInput();
+    void testSearch();
+    void testCheck();
+
+private:
+    // runs the command line; what it printed ends up in m_out and m_err
+    int cli(const QStringList& args);
+    static qint64 count(const QString& sql);
+    static QByteArray readFile(const QString& path);
+    static void writeFile(const QString& path, const QByteArray& data);
+
+    QTemporaryDir m_dir;
+    QString m_out;
+    QString m_err;
+};
+
+void FlowCliTest::initTestCase() {
+    QStandardPaths::setTestModeEnabled(true);
+    const QDir dataDir(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation));
+    for (const QString &f : dataDir.entryList({"flow.db*", "history.db*"}, QDir::Files)) QFile::remove(dataDir.filePath(f));
+    StorageExecutor::instance()->waitForIdle();
+    QVERIFY(m_dir.isValid());
+}
+
+int FlowCliTest::cli(const QStringList& args) {
+    m_out.clear();
+    m_err.clear();
+    QTextStream out(&m_out);
+    QTextStream err(&m_err);
+    FlowCli cli(out, err);
+    const int status = cli.run(args);
+    out.flush();
+    err.flush();
+    return status;
+}
+
+qint64 FlowCliTest::count(const QString& sql) {
+    return StorageExecutor::instance()->blockingRead<qint64>([&sql](Storage& s){
+        QSqlQuery q(s.history());
+        return q.exec(sql) && q.next() ? q.value(0).toLongLong() : -1;
+    });
+}
+
+QByteArray FlowCliTest::readFile(const QString& path) {
+    QFile f(path);
+    return f.open(QIODevice::ReadOnly) ? f.readAll() : QByteArray();
+}
+
+void FlowCliTest::writeFile(const QString& path, const QByteArray& data) {
+    QFile f(path);
+    QVERIFY(f.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    f.write(data);
+}
+
+void FlowCliTest::testUsageErrors() {
+    QCOMPARE(cli({}), 2);
+    QCOMPARE(cli({"frobnicate"}), 2);
+    QVERIFY(m_err.contains("unknown command"));
+    QCOMPARE(cli({"export", "passwords"}), 2);
+    QCOMPARE(cli({"export", "notes", "--format", "xml"}), 2);
+    QCOMPARE(cli({"sync", "history"}), 2);
+    QCOMPARE(cli({"help"}), 0);
+    QVERIFY(m_out.contains("usage: flow_cli"));
+}
+
+void FlowCliTest::testBookmarksRoundTrip() {
+    {
+        BookmarksManager bookmarks;
+        QTRY_VERIFY(bookmarks.isLoaded());
+        bookmarks.addBookmark("One", "https://one.example/");
+        bookmarks.addBookmark("Two", "https://two.example/", "Work");
+        bookmarks.flushSave();
+        StorageExecutor::instance()->waitForIdle();
+    }
+    const QString path = m_dir.filePath("bookmarks.ndjson");
+    QCOMPARE(cli({"export", "bookmarks", "--out", path}), 0);
+    QList<QByteArray> lines = readFile(path).trimmed().split('\n');
+    QCOMPARE(lines.size(), 2);
+    QCOMPARE(QJsonDocument::fromJson(lines[1]).object().value("folder").toString(), QString("Work"));
+
+    // known URLs are skipped, the new one is added
+    lines.append(R"({"title":"Three","url":"https://three.example/","folder":""})");
+    writeFile(path, lines.join('\n'));
+    QCOMPARE(cli({"import", "bookmarks", path}), 0);
+    QVERIFY2(m_out.startsWith("imported 1 of 3"), qPrintable(m_out));
+    QCOMPARE(cli({"import", "bookmarks", path}), 0);
+    QVERIFY2(m_out.startsWith("imported 0 of 3"), qPrintable(m_out));
+
+    BookmarksManager reloaded;
+    QTRY_VERIFY(reloaded.isLoaded());
+    QCOMPARE(reloaded.count(), 3);
+    QCOMPARE(reloaded.bookmarks().last().status, SyncStatus::Unsynced);
+    QCOMPARE(reloaded.queuedOperations(), 3);
+}
+
+void FlowCliTest::testUnsyncedNotesRoundTrip() {
+    {
+        NotesManager notes;
+        QTRY_VERIFY(notes.isLoaded());
+        notes.addNote("Same", "text");
+        notes.addNote("Same", "text");
+        notes.addNote("Other", "text");
+        notes.flushSave();
+        StorageExecutor::instance()->waitForIdle();
+    }
+    const QString path = m_dir.filePath("notes.ndjson");
+    QCOMPARE(cli({"export", "notes", "--out", path}), 0);
+    // nothing was pushed, so there are no ids: the notes are matched by content
+    QCOMPARE(cli({"import", "notes", path}), 0);
+    QVERIFY2(m_out.startsWith("imported 0 of 3"), qPrintable(m_out));
+
+    // into an empty profile, both copies come back, and only once
+    StorageExecutor::instance()->blockingRead<bool>([](Storage& s){
+        QSqlQuery q(s.database());
+        return q.exec("DELETE FROM notes") && q.exec("DELETE FROM sync_queue WHERE table_name = 'notes'");
+    });
+    QCOMPARE(cli({"import", "notes", path}), 0);
+    QVERIFY2(m_out.startsWith("imported 3 of 3"), qPrintable(m_out));
+    QCOMPARE(cli({"import", "notes", path}), 0);
+    QVERIFY2(m_out.startsWith("imported 0 of 3"), qPrintable(m_out));
+
+    NotesManager reloaded;
+    QTRY_VERIFY(reloaded.isLoaded());
+    QCOMPARE(reloaded.count(), 3);
+}
+
+void FlowCliTest::testHistoryRoundTrip() {
+    // enough records that the JSON reader sees the array in several chunks
+    const int n = 20000;
+    StorageExecutor::instance()->blockingRead<bool>([](Storage& s){
+        QVector<HistoryManager::Visit> visits;
+        for (int i = 0; i < n; ++i) visits.append({QString("https://site.example/%1").arg(i), QString("Page %1").arg(i), 1700000000 + i});
+        QSqlQuery q(s.history());
+        return HistoryManager::writeVisits(s, visits)
+            && q.exec("INSERT INTO visit_rollups (url, period_start, span, title, visits) VALUES ('https://old.example/', 1600000000, 86400, 'Old', 4)");
+    });
+    const QString path = m_dir.filePath("history.json");
+    QCOMPARE(cli({"export", "history", "--out", path}), 0);
+    QVERIFY2(m_err.contains(QString("exported %1 history").arg(n + 1)), qPrintable(m_err));
+    const QJsonArray exported = QJsonDocument::fromJson(readFile(path)).array();
+    QCOMPARE(exported.size(), n + 1);
+    QCOMPARE(exported.last().toObject().value("visits").toInt(), 4);
+
+    StorageExecutor::instance()->blockingRead<bool>([](Storage& s){
+        QSqlQuery q(s.history());
+        return q.exec("DELETE FROM visits WHERE id % 2 = 0") && q.exec("DELETE FROM visit_rollups");
+    });
+    QCOMPARE(cli({"import", "history", path}), 0);
+    QVERIFY2(m_out.startsWith(QString("imported %1 of %2").arg(n / 2 + 1).arg(n + 1)), qPrintable(m_out));
+    QCOMPARE(count("SELECT COUNT(*) FROM visits"), n);
+    QCOMPARE(count("SELECT SUM(visits) FROM visit_rollups"), 4);
+    // a second import changes nothing
+    QCOMPARE(cli({"import", "history", path, "--format", "json"}), 0);
+    QVERIFY2(m_out.startsWith(QString("imported 0 of %1").arg(n + 1)), qPrintable(m_out));
+    QCOMPARE(count("SELECT COUNT(*) FROM visits"), n);
+}
+
+void FlowCliTest::testMalformedInput() {
+    const QString json = m_dir.filePath("bad.json");
+    writeFile(json, R"([{"url":"https://a.example/","visited_at":1700000000}, 5])");
+    QCOMPARE(cli({"import", "history", json}), 1);
+    QVERIFY2(m_err.contains("record 2"), qPrintable(m_err));
+
+    const QString ndjson = m_dir.filePath("bad.ndjson");
+    writeFile(ndjson, "{\"url\":\"https://a.example/\",\"visited_at\":1700000000}\n\n{\"url\":\n");
+    QCOMPARE(cli({"import", "history", ndjson}), 1);
+    QVERIFY2(m_err.contains("line 3"), qPrintable(m_err));
+
+    const QString cut = m_dir.filePath("cut.json");
+    writeFile(cut, R"([{"url":"https://a.example/","visited_at":1700000000})");
+    QCOMPARE(cli({"import", "history", cut}), 1);
+    QCOMPARE(cli({"import", "history", m_dir.filePath("missing.json")}), 1);
+}
+
+void FlowCliTest::testSearch() {
+    StorageExecutor::instance()->blockingRead<bool>([](Storage& s){
+        return HistoryManager::writeVisits(s, {{"https://needle.example/", "Needle in history", 1800000000}});
+    });
+    QCOMPARE(cli({"search", "needle", "--json"}), 0);
+    const QJsonArray results = QJsonDocument::fromJson(m_out.toUtf8()).array();
+    QCOMPARE(results.size(), 1);
+    QCOMPARE(results[0].toObject().value("url").toString(), QString("https://needle.example/"));
+    QCOMPARE(cli({"search", "needle"}), 0);
+    QCOMPARE(m_out, QString("Needle in history\thttps://needle.example/\n"));
+}
+
+void FlowCliTest::testCheck() {
+    QCOMPARE(cli({"check"}), 0);
+    QCOMPARE(m_out, QString("flow.db: ok\nhistory.db: ok\n"));
+    QCOMPARE(cli({"vacuum"}), 0);
+    QVERIFY2(m_out.contains("history.db: "), qPrintable(m_out));
+    QCOMPARE(count("SELECT COUNT(*) FROM visits"), 20001);
+}
+
+QTEST_MAIN(FlowCliTest)
+#include "flow_cli_test.moc"
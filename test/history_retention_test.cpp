@@ -0,0 +1,214 @@
+#include <QtTest>
+#include <QSqlQuery>
+#include "../cpp/src/HistoryRetention.h"
+#include "../cpp/src/HistoryManager.h"
+#include "../cpp/src/StorageExecutor.h"
+
+class HistoryRetentionTest : public QObject {
+    Q_OBJECT
+private slots:
+    void initTestCase();
+    void init();
+    void testRecentVisitsKept();
+    void testOldVisitsRollIntoDays();
+    void testDaysMergeIntoWeeks();
+    void testHorizonDeletes();
+    void testLargeBacklogInBatches();
+    void testSearchSeesRollups();
+    void testReclaimsSpace();
+    void testConvertsOldFileOnce();
+
+private:
+    // a Tuesday, 2023-11-14 22:13:20 UTC
+    static constexpr qint64 kNow = 1700000000;
+    static constexpr qint64 kDay = 24 * 60 * 60;
+    struct Visit { QString url; qint64 at; QString title; };
+    static void addVisits(const QVector<Visit>& visits);
+    static qint64 count(const QString& sql);
+    HistoryRetention::Report pass(HistoryRetention& retention);
+};
+
+void HistoryRetentionTest::initTestCase() {
+    QStandardPaths::setTestModeEnabled(true);
+    const QDir dataDir(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation));
+    for (const QString &f : dataDir.entryList({"flow.db*", "history.db*"}, QDir::Files)) QFile::remove(dataDir.filePath(f));
+    StorageExecutor::instance()->waitForIdle();
+}
+
+void HistoryRetentionTest::init() {
+    StorageExecutor::instance()->blockingRead<bool>([](Storage& s){
+        QSqlQuery q(s.history());
+        return q.exec("DELETE FROM visits") && q.exec("DELETE FROM visit_rollups");
+    });
+}
+
+void HistoryRetentionTest::addVisits(const QVector<Visit>& visits) {
+    StorageExecutor::instance()->blockingRead<bool>([&visits](Storage& s){
+        QSqlDatabase db = s.history();
+        db.transaction();
+        QSqlQuery q(db);
+        q.prepare("INSERT INTO visits (url, title, visited_at) VALUES (?, ?, ?)");
+        for (const Visit &v : visits) {
+            q.addBindValue(v.url);
+            q.addBindValue(v.title.isEmpty() ? v.url : v.title);
+            q.addBindValue(v.at);
+            q.exec();
+        }
+        return db.commit();
+    });
+}
+
+qint64 HistoryRetentionTest::count(const QString& sql) {
+    return StorageExecutor::instance()->blockingRead<qint64>([&sql](Storage& s){
+        QSqlQuery q(s.history());
+        return q.exec(sql) && q.next() ? q.value(0).toLongLong() : -1;
+    });
+}
+
+HistoryRetention::Report HistoryRetentionTest::pass(HistoryRetention& retention) {
+    QSignalSpy finished(&retention, &HistoryRetention::passFinished);
+    retention.runPass(kNow);
+    if (!finished.wait(30000)) return HistoryRetention::Report();
+    return finished.takeFirst().at(0).value<HistoryRetention::Report>();
+}
+
+void HistoryRetentionTest::testRecentVisitsKept() {
+    addVisits({{"https://a.example/", kNow - 1 * kDay}, {"https://a.example/", kNow - 89 * kDay}});
+    HistoryRetention retention;
+    const HistoryRetention::Report r = pass(retention);
+    QCOMPARE(r.visitsRolledUp, 0);
+    QCOMPARE(count("SELECT COUNT(*) FROM visits"), 2);
+    QCOMPARE(count("SELECT COUNT(*) FROM visit_rollups"), 0);
+}
+
+void HistoryRetentionTest::testOldVisitsRollIntoDays() {
+    const qint64 day = (kNow - 100 * kDay) / kDay * kDay;
+    addVisits({{"https://a.example/", day + 10, "Old title"}, {"https://a.example/", day + 20, "New title"},
+               {"https://a.example/", day + 30, "New title"}, {"https://a.example/", day + kDay + 5},
+               {"https://b.example/", day + 40}, {"https://a.example/", kNow - kDay}});
+    HistoryRetention retention;
+    const HistoryRetention::Report r = pass(retention);
+    QCOMPARE(r.visitsRolledUp, 5);
+    QCOMPARE(count("SELECT COUNT(*) FROM visits"), 1);
+    QCOMPARE(count("SELECT COUNT(*) FROM visit_rollups WHERE span = 86400"), 3);
+    QCOMPARE(count(QString("SELECT visits FROM visit_rollups WHERE url = 'https://a.example/' AND period_start = %1").arg(day)), 3);
+    QCOMPARE(count("SELECT COUNT(*) FROM visit_rollups WHERE title = 'New title'"), 1);
+
+    // a second pass finds nothing left to do, and counts are not doubled
+    QCOMPARE(pass(retention).visitsRolledUp, 0);
+    QCOMPARE(count("SELECT SUM(visits) FROM visit_rollups"), 5);
+}
+
+void HistoryRetentionTest::testDaysMergeIntoWeeks() {
+    // one visit a day for two weeks, 400 days back: daily rows first, then weeks
+    QVector<Visit> visits;
+    for (int i = 0; i < 14; ++i) visits.append({"https://a.example/", kNow - (400 + i) * kDay});
+    addVisits(visits);
+    HistoryRetention retention;
+    const HistoryRetention::Report r = pass(retention);
+    QCOMPARE(r.visitsRolledUp, 14);
+    QCOMPARE(r.daysMerged, 14);
+    QCOMPARE(count("SELECT COUNT(*) FROM visit_rollups WHERE span = 86400"), 0);
+    QVERIFY(count("SELECT COUNT(*) FROM visit_rollups WHERE span = 604800") <= 3);
+    QCOMPARE(count("SELECT SUM(visits) FROM visit_rollups"), 14);
+    // weeks start on Monday
+    QCOMPARE(count(QString("SELECT COUNT(*) FROM visit_rollups WHERE strftime('%w', period_start, 'unixepoch') <> '1'")), 0);
+}
+
+void HistoryRetentionTest::testHorizonDeletes() {
+    addVisits({{"https://gone.example/", kNow - 800 * kDay}, {"https://kept.example/", kNow - 700 * kDay},
+               {"https://kept.example/", kNow - 10 * kDay}});
+    HistoryRetention retention;
+    HistoryRetention::Policy policy;
+    policy.horizonDays = 730;
+    retention.setPolicy(policy);
+    const HistoryRetention::Report r = pass(retention);
+    QCOMPARE(r.rowsDeleted, 1);
+    QCOMPARE(count("SELECT COUNT(*) FROM visit_rollups WHERE url = 'https://gone.example/'"), 0);
+    QCOMPARE(count("SELECT SUM(visits) FROM visit_rollups WHERE url = 'https://kept.example/'"), 1);
+
+    // rollups age past the horizon too
+    policy.horizonDays = 365;
+    retention.setPolicy(policy);
+    QCOMPARE(pass(retention).rowsDeleted, 1);
+    QCOMPARE(count("SELECT COUNT(*) FROM visit_rollups"), 0);
+    QCOMPARE(count("SELECT COUNT(*) FROM visits"), 1);
+
+    // 0 keeps everything
+    addVisits({{"https://old.example/", kNow - 5000 * kDay}});
+    policy.horizonDays = 0;
+    retention.setPolicy(policy);
+    QCOMPARE(pass(retention).rowsDeleted, 0);
+    QCOMPARE(count("SELECT SUM(visits) FROM visit_rollups"), 1);
+}
+
+void HistoryRetentionTest::testLargeBacklogInBatches() {
+    const int n = 5 * HistoryRetention::kBatchRows + 7;
+    QVector<Visit> visits;
+    for (int i = 0; i < n; ++i)
+        visits.append({QString("https://site%1.example/").arg(i % 50), kNow - 91 * kDay - i * 600});
+    addVisits(visits);
+    HistoryRetention retention;
+    const HistoryRetention::Report r = pass(retention);
+    QCOMPARE(r.visitsRolledUp, n);
+    QCOMPARE(count("SELECT COUNT(*) FROM visits"), 0);
+    QCOMPARE(count("SELECT SUM(visits) FROM visit_rollups"), n);
+}
+
+void HistoryRetentionTest::testSearchSeesRollups() {
+    const qint64 day = (kNow - 200 * kDay) / kDay * kDay;
+    addVisits({{"https://old.example/", day + 10, "Old Example"}, {"https://old.example/", day + 20, "Old Example"},
+               {"https://new.example/", QDateTime::currentSecsSinceEpoch(), "New Example"}});
+    HistoryRetention retention;
+    pass(retention);
+
+    HistoryManager history;
+    HistoryManager::Results results;
+    history.search("example", 10, this, [&results](const HistoryManager::Results& r){ results = r; });
+    QVector<HistoryManager::VisitedUrl> urls;
+    history.visitedUrls(this, [&urls](bool ok, const QVector<HistoryManager::VisitedUrl>& u){ if (ok) urls = u; });
+    QTRY_COMPARE(urls.size(), 2);
+    QTRY_COMPARE(results.size(), 2);
+    // kept visits come before rolled-up ones
+    QCOMPARE(results[0].first, QString("https://new.example/"));
+    QCOMPARE(results[1].first, QString("https://old.example/"));
+    for (const auto &u : urls) QCOMPARE(u.visits, u.url == "https://old.example/" ? 2 : 1);
+}
+
+void HistoryRetentionTest::testReclaimsSpace() {
+    QVector<Visit> visits;
+    for (int i = 0; i < 20000; ++i)
+        visits.append({QString("https://site.example/page/%1").arg(i), kNow - 1000 * kDay - i, QString(200, QChar('x'))});
+    addVisits(visits);
+    const qint64 before = count("PRAGMA page_count") * count("PRAGMA page_size");
+    HistoryRetention retention;
+    const HistoryRetention::Report r = pass(retention);
+    QCOMPARE(r.rowsDeleted, 20000);
+    QVERIFY(r.bytesReclaimed > 0);
+    QVERIFY(r.dbBytes < before);
+    QCOMPARE(count("PRAGMA auto_vacuum"), 2);
+    QCOMPARE(count("PRAGMA freelist_count"), 0);
+    QVERIFY(!r.converted);
+}
+
+// a history.db made before incremental vacuum is rewritten in a step of its
+// own after the slices, and only once
+void HistoryRetentionTest::testConvertsOldFileOnce() {
+    StorageExecutor::instance()->blockingRead<bool>([](Storage& s){
+        QSqlQuery q(s.history());
+        return q.exec("PRAGMA auto_vacuum = NONE") && q.exec("VACUUM");
+    });
+    QCOMPARE(count("PRAGMA auto_vacuum"), 0);
+    addVisits({{"https://old.example/", kNow - 1000 * kDay}});
+    HistoryRetention retention;
+    HistoryRetention::Report r = pass(retention);
+    QCOMPARE(r.rowsDeleted, 1);
+    QVERIFY(r.converted);
+    QVERIFY(r.summary().contains("one-time rewrite"));
+    QCOMPARE(count("PRAGMA auto_vacuum"), 2);
+    r = pass(retention);
+    QVERIFY(!r.converted);
+}
+
+QTEST_MAIN(HistoryRetentionTest)
+#include "history_retention_test.moc"
@@ -13,7 +13,10 @@ void HistorySearchTest::testAddAndSearch() {
     hm.addVisit("https://example.org/bar", "Example Bar");
     // small delay to ensure visited_at ordering
     QTest::qWait(10);
-    auto res = hm.search("example", 10);
+    HistoryManager::Results res;
+    bool done = false;
+    hm.search("example", 10, this, [&](const HistoryManager::Results& r){ res = r; done = true; });
+    QTRY_VERIFY(done);
     QVERIFY(!res.isEmpty());
     bool foundFoo = false;
     for (const auto &p : res) {
@@ -0,0 +1,106 @@
+#include <QtTest>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QThread>
+#include "../cpp/src/JsonRowStream.h"
+
+class JsonRowStreamTest : public QObject {
+    Q_OBJECT
+private slots:
+    void testEveryChunkBoundary();
+    void testScalarsAndEmpty();
+    void testMalformed();
+    void testParserOnWorker();
+
+private:
+    static QByteArray sample();
+};
+
+QByteArray JsonRowStreamTest::sample() {
+    // brackets, braces and quotes inside strings must not count as structure
+    return QByteArray(R"( [ {"id":"1","title":"a ] b","body":"say \"hi\" {x}"},)"
+                      R"({"id":"2","nested":{"list":[1,2,{"k":"v\\"}]}} , {"id":"3","u":"é"} ] )");
+}
+
+void JsonRowStreamTest::testEveryChunkBoundary() {
+    const QByteArray data = sample();
+    const QJsonArray expected = QJsonDocument::fromJson(data).array();
+    QCOMPARE(expected.size(), 3);
+    for (int cut = 0; cut <= data.size(); ++cut) {
+        JsonArraySplitter splitter;
+        QVector<QByteArray> elements;
+        splitter.feed(data.left(cut), elements);
+        splitter.feed(data.mid(cut), elements);
+        QVERIFY2(splitter.isComplete(), qPrintable(QString("cut at %1").arg(cut)));
+        QCOMPARE(elements.size(), 3);
+        for (int i = 0; i < 3; ++i) QCOMPARE(QJsonDocument::fromJson(elements[i]).object(), expected.at(i).toObject());
+    }
+    // one byte at a time
+    JsonArraySplitter splitter;
+    QVector<QByteArray> elements;
+    for (char c : data) splitter.feed(QByteArray(1, c), elements);
+    QVERIFY(splitter.isComplete());
+    QCOMPARE(elements.size(), 3);
+}
+
+void JsonRowStreamTest::testScalarsAndEmpty() {
+    JsonArraySplitter empty;
+    QVector<QByteArray> elements;
+    empty.feed("[ ]", elements);
+    QVERIFY(empty.isComplete());
+    QVERIFY(elements.isEmpty());
+
+    JsonArraySplitter scalars;
+    scalars.feed("[1, \"a,]\" ,true]", elements);
+    QVERIFY(scalars.isComplete());
+    QCOMPARE(elements, QVector<QByteArray>({"1", "\"a,]\"", "true"}));
+}
+
+void JsonRowStreamTest::testMalformed() {
+    QVector<QByteArray> elements;
+    JsonArraySplitter notArray;
+    notArray.feed("{\"message\":\"JWT expired\"}", elements);
+    QVERIFY(notArray.failed());
+
+    JsonArraySplitter truncated;
+    truncated.feed("[{\"id\":1},{\"id\"", elements);
+    QVERIFY(!truncated.failed());
+    QVERIFY(!truncated.isComplete());
+
+    JsonArraySplitter trailing;
+    trailing.feed("[] x", elements);
+    QVERIFY(trailing.failed());
+}
+
+void JsonRowStreamTest::testParserOnWorker() {
+    QByteArray data = "[";
+    for (int i = 0; i < 1000; ++i) data += QString("%1{\"id\":\"%2\",\"content\":\"%3\"}").arg(i ? "," : "").arg(i).arg(QString(100, 'x')).toUtf8();
+    data += "]";
+
+    auto *parser = new JsonRowParser;
+    parser->moveToThread(JsonRowParser::workerThread());
+    QVERIFY(JsonRowParser::workerThread() != QThread::currentThread());
+    int batches = 0;
+    int rows = 0;
+    bool done = false;
+    bool ok = false;
+    connect(parser, &JsonRowParser::rowsParsed, this, [&](const QJsonArray& batch){
+        QVERIFY(batch.size() <= JsonRowParser::kBatchRows);
+        QCOMPARE(batch.at(0).toObject().value("id").toString(), QString::number(rows));
+        ++batches;
+        rows += batch.size();
+    });
+    connect(parser, &JsonRowParser::finished, this, [&](bool success, int count){ done = true; ok = success && count == 1000; });
+    for (int from = 0; from < data.size(); from += 4096) {
+        const QByteArray chunk = data.mid(from, 4096);
+        QMetaObject::invokeMethod(parser, [parser, chunk](){ parser->feed(chunk); });
+    }
+    QMetaObject::invokeMethod(parser, [parser](){ parser->finish(); });
+    QTRY_VERIFY_WITH_TIMEOUT(done, 5000);
+    QVERIFY(ok);
+    QCOMPARE(rows, 1000);
+    QCOMPARE(batches, 5);
+}
+
+QTEST_MAIN(JsonRowStreamTest)
+#include "json_row_stream_test.moc"
@@ -0,0 +1,110 @@
+#include <QtTest>
+#include <QJsonArray>
+#include <QJsonObject>
+#include "../cpp/src/MetricsRegistry.h"
+
+class MetricsRegistryTest : public QObject {
+    Q_OBJECT
+private slots:
+    void init();
+    void testSameNameSameMetric();
+    void testBucketsAreLogSpaced();
+    void testPercentiles();
+    void testConcurrentUpdates();
+    void testJsonAndSources();
+    void testResetKeepsPointers();
+};
+
+void MetricsRegistryTest::init() {
+    MetricsRegistry::reset();
+}
+
+void MetricsRegistryTest::testSameNameSameMetric() {
+    MetricsRegistry::Counter* c = MetricsRegistry::counter("test.count");
+    QCOMPARE(MetricsRegistry::counter("test.count"), c);
+    c->add();
+    c->add(4);
+    QCOMPARE(c->value(), qint64(5));
+    MetricsRegistry::gauge("test.depth")->set(3);
+    QCOMPARE(MetricsRegistry::gauge("test.depth")->value(), 3.0);
+}
+
+void MetricsRegistryTest::testBucketsAreLogSpaced() {
+    using H = MetricsRegistry::Histogram;
+    QCOMPARE(H::bucketFor(0.0), 0);
+    QCOMPARE(H::bucketFor(-1.0), 0);
+    for (int i = 1; i < H::kBuckets; ++i) {
+        QVERIFY(qFuzzyCompare(H::upperBound(i) / H::upperBound(i - 1), std::exp2(0.25)));
+        // a value just above a bound lands in the next bucket
+        QCOMPARE(H::bucketFor(H::upperBound(i - 1) * 1.01), i);
+    }
+    QCOMPARE(H::bucketFor(1e12), H::kBuckets - 1);
+    // a minute still has a bucket of its own
+    QVERIFY(H::upperBound(H::kBuckets - 2) > 60000.0);
+}
+
+void MetricsRegistryTest::testPercentiles() {
+    MetricsRegistry::Histogram* h = MetricsRegistry::histogram("test.latency_ms");
+    for (int i = 1; i <= 1000; ++i) h->record(i / 10.0); // 0.1 .. 100 ms
+    const HistogramSnapshot s = h->snapshot();
+    QCOMPARE(s.count, qint64(1000));
+    QCOMPARE(s.min, 0.1);
+    QCOMPARE(s.max, 100.0);
+    QVERIFY(qAbs(s.mean() - 50.05) < 1e-6);
+    // within one bucket (19%) of the exact value, never below it
+    for (double p : {0.5, 0.9, 0.99}) {
+        const double exact = p * 100.0;
+        QVERIFY2(s.percentile(p) >= exact && s.percentile(p) <= exact * 1.19, qPrintable(QString::number(p)));
+    }
+    QCOMPARE(s.percentile(1.0), 100.0);
+    QCOMPARE(HistogramSnapshot().percentile(0.5), 0.0);
+}
+
+void MetricsRegistryTest::testConcurrentUpdates() {
+    MetricsRegistry::Counter* c = MetricsRegistry::counter("test.concurrent");
+    MetricsRegistry::Histogram* h = MetricsRegistry::histogram("test.concurrent_ms");
+    QVector<QThread*> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.append(QThread::create([c, h](){
+            for (int i = 0; i < 10000; ++i) { c->add(); h->record(1.0); }
+        }));
+        threads.last()->start();
+    }
+    for (QThread* t : threads) { QVERIFY(t->wait(10000)); delete t; }
+    QCOMPARE(c->value(), qint64(40000));
+    QCOMPARE(h->snapshot().count, qint64(40000));
+    QCOMPARE(h->snapshot().sum, 40000.0);
+}
+
+void MetricsRegistryTest::testJsonAndSources() {
+    MetricsRegistry::counter("test.json_count")->add(7);
+    MetricsRegistry::histogram("test.json_ms")->record(2.0);
+    auto *owner = new QObject;
+    MetricsRegistry::addSource("things", owner, [](){ return QJsonArray{QJsonObject{{"id", 1}}}; });
+    MetricsRegistry::addSource("things", owner, [](){ return QJsonArray{QJsonObject{{"id", 2}}}; });
+
+    QJsonObject o = MetricsRegistry::toJson();
+    QCOMPARE(o["counters"].toObject()["test.json_count"].toInt(), 7);
+    const QJsonObject h = o["histograms"].toObject()["test.json_ms"].toObject();
+    QCOMPARE(h["count"].toInt(), 1);
+    QCOMPARE(h["p50"].toDouble(), 2.0);
+    QCOMPARE(h["buckets"].toArray().size(), 1);
+    QCOMPARE(o["sections"].toObject()["things"].toArray().size(), 2);
+
+    delete owner;
+    o = MetricsRegistry::toJson();
+    QVERIFY(!o["sections"].toObject().contains("things"));
+}
+
+void MetricsRegistryTest::testResetKeepsPointers() {
+    MetricsRegistry::Histogram* h = MetricsRegistry::histogram("test.reset_ms");
+    h->record(5.0);
+    MetricsRegistry::reset();
+    QCOMPARE(h->snapshot().count, qint64(0));
+    h->record(0.5);
+    QCOMPARE(h->snapshot().min, 0.5);
+    QCOMPARE(h->snapshot().max, 0.5);
+}
+
+QTEST_MAIN(MetricsRegistryTest)
+#include "metrics_registry_test.moc"
@@ -0,0 +1,131 @@
+#include <QtTest>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include "../cpp/src/MockSupabaseServer.h"
+#include "../cpp/src/AuthManager.h"
+#include "../cpp/src/BookmarksManager.h"
+
+class MockSupabaseTest : public QObject {
+    Q_OBJECT
+private slots:
+    void initTestCase();
+    void testAuthAndRest();
+    void testFilters();
+    void testInjectedErrors();
+    void testBookmarkSync();
+
+private:
+    QNetworkReply* send(const QByteArray& method, const QString& path, const QByteArray& body = QByteArray(), bool representation = false);
+    QByteArray waitBody(QNetworkReply* r, int* status);
+
+    MockSupabaseServer m_server;
+    QNetworkAccessManager m_net;
+    QString m_token;
+};
+
+void MockSupabaseTest::initTestCase() {
+    QStandardPaths::setTestModeEnabled(true);
+    const QDir dataDir(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation));
+    for (const QString &f : dataDir.entryList({"flow.db*"}, QDir::Files)) QFile::remove(dataDir.filePath(f));
+    QFile::remove(dataDir.filePath("auth.json"));
+    QVERIFY(m_server.listen());
+}
+
+QNetworkReply* MockSupabaseTest::send(const QByteArray& method, const QString& path, const QByteArray& body, bool representation) {
+    QNetworkRequest req(QUrl(m_server.url() + path));
+    req.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
+    req.setRawHeader("apikey", m_server.anonKey().toUtf8());
+    if (!m_token.isEmpty()) req.setRawHeader("Authorization", "Bearer " + m_token.toUtf8());
+    if (representation) req.setRawHeader("Prefer", "return=representation");
+    return m_net.sendCustomRequest(req, method, body);
+}
+
+QByteArray MockSupabaseTest::waitBody(QNetworkReply* r, int* status) {
+    QSignalSpy spy(r, &QNetworkReply::finished);
+    if (!r->isFinished()) spy.wait(5000);
+    *status = r->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    const QByteArray body = r->readAll();
+    r->deleteLater();
+    return body;
+}
+
+void MockSupabaseTest::testAuthAndRest() {
+    int status = 0;
+    // REST needs a token from the auth endpoint
+    waitBody(send("GET", "/rest/v1/bookmarks"), &status);
+    QCOMPARE(status, 401);
+    const QJsonObject tokens = QJsonDocument::fromJson(waitBody(send("POST", "/auth/v1/token?grant_type=password", R"({"email":"a@b.c","password":"x"})"), &status)).object();
+    QCOMPARE(status, 200);
+    m_token = tokens.value("access_token").toString();
+    QVERIFY(!m_token.isEmpty());
+    QCOMPARE(tokens.value("user").toObject().value("id").toString(), m_server.userId());
+
+    const QJsonArray created = QJsonDocument::fromJson(waitBody(send("POST", "/rest/v1/bookmarks", R"({"title":"A","url":"https://a"})", true), &status)).array();
+    QCOMPARE(status, 201);
+    QCOMPARE(created.size(), 1);
+    const QString id = created.at(0).toObject().value("id").toString();
+    QVERIFY(!id.isEmpty());
+
+    waitBody(send("PATCH", "/rest/v1/bookmarks?id=eq." + id, R"({"title":"B"})"), &status);
+    QCOMPARE(status, 204);
+    QCOMPARE(m_server.rows("bookmarks").at(0).toObject().value("title").toString(), QString("B"));
+    waitBody(send("DELETE", "/rest/v1/bookmarks?id=eq." + id), &status);
+    QCOMPARE(status, 204);
+    QCOMPARE(m_server.rowCount("bookmarks"), 0);
+}
+
+void MockSupabaseTest::testFilters() {
+    m_server.seedRows("todos", 10);
+    int status = 0;
+    QJsonArray rows = QJsonDocument::fromJson(waitBody(send("GET", "/rest/v1/todos?user_id=eq." + m_server.userId() + "&completed=eq.true"), &status)).array();
+    QCOMPARE(status, 200);
+    QCOMPARE(rows.size(), 4); // 0, 3, 6, 9
+    rows = QJsonDocument::fromJson(waitBody(send("GET", "/rest/v1/todos?order=title.desc&limit=3&offset=1"), &status)).array();
+    QCOMPARE(rows.size(), 3);
+    QCOMPARE(rows.at(0).toObject().value("title").toString(), QString("Seeded todos #8"));
+    // a batched insert is a single request
+    const qint64 before = m_server.stats().requests;
+    waitBody(send("POST", "/rest/v1/todos", R"([{"title":"x"},{"title":"y"}])"), &status);
+    QCOMPARE(status, 201);
+    QCOMPARE(m_server.rowCount("todos"), 12);
+    QCOMPARE(m_server.stats().requests, before + 1);
+}
+
+void MockSupabaseTest::testInjectedErrors() {
+    m_server.setErrorRate(1.0);
+    int status = 0;
+    waitBody(send("GET", "/rest/v1/notes"), &status);
+    QCOMPARE(status, 503);
+    QVERIFY(m_server.stats().injectedErrors >= 1);
+    m_server.setErrorRate(0.0);
+    waitBody(send("GET", "/rest/v1/notes"), &status);
+    QCOMPARE(status, 200);
+    QVERIFY(m_server.stats().bytesIn > 0);
+    QVERIFY(m_server.stats().bytesOut > 0);
+}
+
+void MockSupabaseTest::testBookmarkSync() {
+    AuthManager auth;
+    auth.setSupabaseConfig(m_server.url(), m_server.anonKey());
+    QSignalSpy signedIn(&auth, &AuthManager::signedIn);
+    auth.signIn("a@b.c", "x");
+    QVERIFY(signedIn.wait(5000));
+    BookmarksManager mgr;
+    mgr.setSupabaseConfig(m_server.url(), m_server.anonKey());
+    mgr.setAuthManager(&auth);
+
+    const int rowsBefore = m_server.rowCount("bookmarks");
+    mgr.addBookmark("Mock", "https://mock.example/", "");
+    QTRY_COMPARE_WITH_TIMEOUT(m_server.rowCount("bookmarks"), rowsBefore + 1, 5000);
+    QTRY_COMPARE_WITH_TIMEOUT(int(mgr.bookmarks().last().status), int(SyncStatus::Synced), 5000);
+    QVERIFY(!mgr.bookmarks().last().id.isEmpty());
+    // the add and the id from the server end up in one debounced write
+    mgr.flushSave();
+    QTRY_VERIFY(mgr.saveCount() >= 1);
+}
+
+QTEST_MAIN(MockSupabaseTest)
+#include "mock_supabase_test.moc"
@@ -0,0 +1,86 @@
+#include <QtTest>
+#include <QNetworkReply>
+#include "../cpp/src/MockSupabaseServer.h"
+#include "../cpp/src/NetworkClient.h"
+
+class NetworkClientTest : public QObject {
+    Q_OBJECT
+private slots:
+    void initTestCase();
+    void init();
+    void testInteractiveJumpsTheQueue();
+    void testDroppedWithContext();
+    void testStats();
+
+private:
+    void get(NetworkClient::Priority priority, QObject* context, std::function<void(QNetworkReply*)> done);
+
+    MockSupabaseServer m_server;
+    NetworkClient* m_client = nullptr;
+};
+
+void NetworkClientTest::initTestCase() {
+    QVERIFY(m_server.listen());
+    m_server.setLatency(20);
+    m_client = NetworkClient::instance();
+    QCOMPARE(NetworkClient::instance(), m_client); // one per process
+}
+
+void NetworkClientTest::init() {
+    QTRY_COMPARE(m_client->inFlight(), 0);
+    m_client->setMaxConcurrent(1);
+    m_client->resetStats();
+}
+
+void NetworkClientTest::get(NetworkClient::Priority priority, QObject* context, std::function<void(QNetworkReply*)> done) {
+    QNetworkRequest req(QUrl(m_server.url() + "/rest/v1/notes?select=id"));
+    req.setRawHeader("apikey", m_server.anonKey().toUtf8());
+    m_client->send(req, "GET", QByteArray(), priority, context, std::move(done));
+}
+
+void NetworkClientTest::testInteractiveJumpsTheQueue() {
+    QStringList order;
+    for (int i = 0; i < 4; ++i) get(NetworkClient::Background, this, [&order, i](QNetworkReply*){ order << QString("bulk%1").arg(i); });
+    get(NetworkClient::Interactive, this, [&order](QNetworkReply*){ order << "edit"; });
+    QCOMPARE(m_client->inFlight(), 1);
+    QCOMPARE(m_client->queued(), 4);
+    QTRY_COMPARE_WITH_TIMEOUT(order.size(), 5, 5000);
+    // the first bulk request was already on the wire; the edit goes right after it
+    QCOMPARE(order, QStringList({"bulk0", "edit", "bulk1", "bulk2", "bulk3"}));
+}
+
+void NetworkClientTest::testDroppedWithContext() {
+    int ran = 0;
+    get(NetworkClient::Background, this, [&ran](QNetworkReply*){ ++ran; });
+    auto *gone = new QObject;
+    get(NetworkClient::Background, gone, [&ran](QNetworkReply*){ ran += 100; });
+    get(NetworkClient::Background, this, [&ran](QNetworkReply*){ ++ran; });
+    delete gone;
+    QTRY_COMPARE_WITH_TIMEOUT(ran, 2, 5000);
+    QTest::qWait(50);
+    QCOMPARE(ran, 2);
+    QCOMPARE(m_client->stats().requests(), 2);
+    QCOMPARE(m_client->queued(), 0);
+}
+
+void NetworkClientTest::testStats() {
+    int done = 0;
+    for (int i = 0; i < 3; ++i) get(NetworkClient::Background, this, [&done](QNetworkReply* r){
+        QVERIFY(r->isFinished());
+        ++done;
+    });
+    QTRY_COMPARE_WITH_TIMEOUT(done, 3, 5000);
+    const NetworkStats st = m_client->stats();
+    QCOMPARE(st.sent[NetworkClient::Background], 3);
+    QCOMPARE(st.waited[NetworkClient::Background], 2);
+    // each waited for at least one 20 ms round trip
+    QVERIFY(st.maxQueueMs[NetworkClient::Background] >= 20);
+    QCOMPARE(st.peakInFlight, 1);
+    QCOMPARE(st.tlsRequests, 0); // plain http to the mock
+    const QJsonObject json = m_client->toJson();
+    QCOMPARE(json.value("requests").toInt(), 3);
+    QVERIFY(json.value("queue").toObject().contains("interactive"));
+}
+
+QTEST_MAIN(NetworkClientTest)
+#include "network_client_test.moc"
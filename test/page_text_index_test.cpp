@@ -0,0 +1,146 @@
+#include <QtTest>
+#include <QSqlQuery>
+#include "../cpp/src/PageTextIndex.h"
+#include "../cpp/src/StorageExecutor.h"
+
+class PageTextIndexTest : public QObject {
+    Q_OBJECT
+private slots:
+    void initTestCase();
+    void init();
+    void testFtsQuery();
+    void testSnippetHighlightsAndEscapes();
+    void testStoreAndSearch();
+    void testChangedTextReplacesOld();
+    void testLeastRecentlyVisitedEvicted();
+
+private:
+    QVector<PageTextHit> search(PageTextIndex& index, const QString& query);
+    static int pageCount();
+    static QString page(const QString& topic);
+};
+
+void PageTextIndexTest::initTestCase() {
+    QStandardPaths::setTestModeEnabled(true);
+    const QDir dataDir(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation));
+    for (const QString &f : dataDir.entryList({"flow.db*", "history.db*"}, QDir::Files)) QFile::remove(dataDir.filePath(f));
+    const bool fts5 = StorageExecutor::instance()->blockingRead<bool>([](Storage& s){
+        QSqlQuery q(s.history());
+        return q.exec("SELECT COUNT(*) FROM page_text_fts");
+    });
+    if (!fts5) QSKIP("SQLite was built without FTS5");
+}
+
+void PageTextIndexTest::init() {
+    StorageExecutor::instance()->blockingRead<bool>([](Storage& s){
+        QSqlQuery q(s.history());
+        // the contentless table is emptied with its own command
+        return q.exec("DELETE FROM page_text") && q.exec("INSERT INTO page_text_fts (page_text_fts) VALUES ('delete-all')");
+    });
+}
+
+QVector<PageTextHit> PageTextIndexTest::search(PageTextIndex& index, const QString& query) {
+    QVector<PageTextHit> out;
+    index.search(query, 20, this, [&out](const QVector<PageTextHit>& hits){ out = hits; });
+    StorageExecutor::instance()->waitForIdle();
+    return out;
+}
+
+int PageTextIndexTest::pageCount() {
+    return StorageExecutor::instance()->blockingRead<int>([](Storage& s){
+        QSqlQuery q(s.history());
+        return q.exec("SELECT COUNT(*) FROM page_text") && q.next() ? q.value(0).toInt() : -1;
+    });
+}
+
+// enough text that the page is worth reading, about one topic
+QString PageTextIndexTest::page(const QString& topic) {
+    QString text;
+    for (int i = 0; i < 20; ++i) text += QString("Paragraph %1 of an article about %2, with some filler words. ").arg(i).arg(topic);
+    return text;
+}
+
+void PageTextIndexTest::testFtsQuery() {
+    QCOMPARE(PageTextIndex::ftsQuery("rust borrow"), QString("\"rust\" \"borrow\"*"));
+    QCOMPARE(PageTextIndex::ftsQuery("Rust borrow "), QString("\"rust\" \"borrow\""));
+    // FTS5 syntax in the query is taken as plain words
+    QCOMPARE(PageTextIndex::ftsQuery("a\"b OR c*"), QString("\"a\" \"b\" \"or\" \"c\""));
+    QVERIFY(PageTextIndex::ftsQuery(" -- ").isEmpty());
+}
+
+void PageTextIndexTest::testSnippetHighlightsAndEscapes() {
+    const QString s = PageTextIndex::snippet("Use <vector> and Vectors wisely", {"vector"});
+    QCOMPARE(s, QString("Use &lt;<b>vector</b>&gt; and <b>Vectors</b> wisely"));
+
+    // a match deep in a long text is shown with context, cut at words
+    QString text;
+    for (int i = 0; i < 100; ++i) text += "filler ";
+    text += "needle ";
+    for (int i = 0; i < 100; ++i) text += "filler ";
+    const QString far = PageTextIndex::snippet(text, {"needle"}, 80);
+    QVERIFY(far.startsWith("… filler"));
+    QVERIFY(far.endsWith(" …"));
+    QVERIFY(far.contains("<b>needle</b>"));
+    QVERIFY(far.size() < 140);
+}
+
+void PageTextIndexTest::testStoreAndSearch() {
+    PageTextIndex index;
+    index.store("https://a.example/", "Borrow checker notes", page("the borrow checker"));
+    index.store("https://b.example/", "Gardening", page("tomato plants"));
+    StorageExecutor::instance()->waitForIdle();
+
+    const QVector<PageTextHit> hits = search(index, "borrow check");
+    QCOMPARE(hits.size(), 1);
+    QCOMPARE(hits[0].url, QString("https://a.example/"));
+    QCOMPARE(hits[0].title, QString("Borrow checker notes"));
+    QVERIFY(hits[0].snippet.contains("<b>borrow</b> <b>checker</b>"));
+    // diacritics and case fold away
+    QCOMPARE(search(index, "TOMATÖ").size(), 1);
+    QVERIFY(search(index, "spaceship").isEmpty());
+}
+
+void PageTextIndexTest::testChangedTextReplacesOld() {
+    PageTextIndex index;
+    index.store("https://a.example/", "News", page("elections"));
+    index.store("https://a.example/", "News", page("elections"));
+    StorageExecutor::instance()->waitForIdle();
+    QCOMPARE(pageCount(), 1);
+
+    index.store("https://a.example/", "News", page("weather"));
+    StorageExecutor::instance()->waitForIdle();
+    QCOMPARE(pageCount(), 1);
+    QVERIFY(search(index, "elections").isEmpty());
+    QCOMPARE(search(index, "weather").size(), 1);
+}
+
+void PageTextIndexTest::testLeastRecentlyVisitedEvicted() {
+    PageTextIndex index;
+    index.setBudget(PageTextIndex::kDefaultBudgetBytes, 3);
+    const QStringList topics = {"alpha", "bravo", "charlie"};
+    for (const QString &t : topics) {
+        index.store("https://" + t + ".example/", t, page(t));
+        StorageExecutor::instance()->waitForIdle();
+        QTest::qWait(2);
+    }
+    // visiting alpha again keeps it over bravo
+    index.store("https://alpha.example/", "alpha", page("alpha"));
+    StorageExecutor::instance()->waitForIdle();
+    QTest::qWait(2);
+    index.store("https://delta.example/", "delta", page("delta"));
+    StorageExecutor::instance()->waitForIdle();
+
+    QCOMPARE(pageCount(), 3);
+    QVERIFY(search(index, "bravo").isEmpty());
+    for (const QString &t : {"alpha", "charlie", "delta"}) QCOMPARE(search(index, t).size(), 1);
+
+    // a byte budget below one page leaves nothing
+    index.setBudget(1, 3);
+    index.store("https://echo.example/", "echo", page("echo"));
+    StorageExecutor::instance()->waitForIdle();
+    QCOMPARE(pageCount(), 0);
+    QVERIFY(search(index, "alpha").isEmpty());
+}
+
+QTEST_MAIN(PageTextIndexTest)
+#include "page_text_index_test.moc"
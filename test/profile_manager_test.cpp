@@ -0,0 +1,47 @@
+#include <QtTest>
+#include "../cpp/src/ProfileManager.h"
+
+class ProfileManagerTest : public QObject {
+    Q_OBJECT
+private slots:
+    void testConfigRoundTrip();
+    void testInvalidCacheTypeFallsBack();
+    void testCacheClassification();
+};
+
+void ProfileManagerTest::testConfigRoundTrip() {
+    ProfileConfig cfg;
+    cfg.httpCacheType = "memory";
+    cfg.httpCacheMaxBytes = 256LL * 1024 * 1024;
+    cfg.cachePath = "/tmp/flow-cache";
+    ProfileConfig back = ProfileManager::configFromJson(ProfileManager::configToJson(cfg));
+    QCOMPARE(back.httpCacheType, QString("memory"));
+    QCOMPARE(back.httpCacheMaxBytes, cfg.httpCacheMaxBytes);
+    QCOMPARE(back.cachePath, cfg.cachePath);
+}
+
+void ProfileManagerTest::testInvalidCacheTypeFallsBack() {
+    QJsonObject o;
+    o["http_cache_type"] = "floppy";
+    QCOMPARE(ProfileManager::configFromJson(o).httpCacheType, QString("disk"));
+}
+
+void ProfileManagerTest::testCacheClassification() {
+    CacheStats s;
+    QVariantList entries;
+    entries << QVariant(QVariantList{0, 5000, 12000});     // hit
+    entries << QVariant(QVariantList{300, 5000, 12000});   // revalidated (304)
+    entries << QVariant(QVariantList{5300, 5000, 12000});  // miss
+    entries << QVariant(QVariantList{0, 0, 0});            // opaque cross-origin
+    ProfileManager::accumulate(entries, s);
+    QCOMPARE(s.resources, qint64(4));
+    QCOMPARE(s.hits, qint64(1));
+    QCOMPARE(s.revalidated, qint64(1));
+    QCOMPARE(s.misses, qint64(1));
+    QCOMPARE(s.opaque, qint64(1));
+    QCOMPARE(s.bytesFromNetwork, qint64(5600));
+    QVERIFY(qAbs(s.hitRate() - 1.0 / 3.0) < 1e-9);
+}
+
+QTEST_MAIN(ProfileManagerTest)
+#include "profile_manager_test.moc"
@@ -0,0 +1,152 @@
+#include <QtTest>
+#include "../cpp/src/SearchIndex.h"
+
+namespace {
+SearchDocument doc(SearchSource source, const QString& key, const QString& title, const QString& text = QString(), int popularity = 0) {
+    SearchDocument d;
+    d.source = source;
+    d.key = key;
+    d.title = title;
+    d.text = text;
+    d.subtitle = text;
+    d.popularity = popularity;
+    return d;
+}
+
+QStringList keys(const QVector<SearchHit>& hits) {
+    QStringList out;
+    for (const SearchHit &h : hits) out << h.key;
+    return out;
+}
+}
+
+class SearchIndexTest : public QObject {
+    Q_OBJECT
+private slots:
+    void testTokenize();
+    void testAllWordsMustMatch();
+    void testPrefixWhileTyping();
+    void testPhrase();
+    void testFuzzy();
+    void testRanking();
+    void testSourceQuota();
+    void testIncrementalUpdates();
+    void testReplaceSource();
+    void testPurgeKeepsResults();
+};
+
+void SearchIndexTest::testTokenize() {
+    QCOMPARE(SearchIndex::tokenize("Hello, World! https://Qt.io/docs"),
+             QStringList({"hello", "world", "https", "qt", "io", "docs"}));
+    // accents are dropped, so "creme" finds "Crème"
+    QCOMPARE(SearchIndex::tokenize("Crème Brûlée"), QStringList({"creme", "brulee"}));
+    QVERIFY(SearchIndex::tokenize(" -- ").isEmpty());
+}
+
+void SearchIndexTest::testAllWordsMustMatch() {
+    SearchIndex index;
+    index.upsert(doc(SearchSource::History, "a", "Qt documentation", "https://doc.qt.io"));
+    index.upsert(doc(SearchSource::History, "b", "Qt blog", "https://qt.io/blog"));
+    QCOMPARE(keys(index.search("qt documentation ", 10)), QStringList({"a"}));
+    QCOMPARE(index.search("qt ", 10).size(), 2);
+    QVERIFY(index.search("qt missing ", 10).isEmpty());
+    // scheme noise is not indexed
+    QVERIFY(index.search("https ", 10).isEmpty());
+}
+
+void SearchIndexTest::testPrefixWhileTyping() {
+    SearchIndex index;
+    index.upsert(doc(SearchSource::Bookmark, "1", "Weather forecast"));
+    index.upsert(doc(SearchSource::Bookmark, "2", "Web search"));
+    QCOMPARE(index.search("wea", 10).size(), 1);
+    QCOMPARE(index.search("we", 10).size(), 2);
+    // a finished word is not a prefix
+    QVERIFY(index.search("wea ", 10).isEmpty());
+}
+
+void SearchIndexTest::testPhrase() {
+    SearchIndex index;
+    index.upsert(doc(SearchSource::Note, "n1", "Trip", "book the train to the coast"));
+    index.upsert(doc(SearchSource::Note, "n2", "Reading", "to the coast, then the train"));
+    QCOMPARE(keys(index.search("\"train to the coast\"", 10)), QStringList({"n1"}));
+    QCOMPARE(index.search("train coast", 10).size(), 2);
+}
+
+void SearchIndexTest::testFuzzy() {
+    SearchIndex index;
+    index.upsert(doc(SearchSource::Todo, "t1", "Renew passport"));
+    index.upsert(doc(SearchSource::Todo, "t2", "Pay rent"));
+    QCOMPARE(keys(index.search("pasport ", 10)), QStringList({"t1"}));  // deletion
+    QCOMPARE(keys(index.search("passprot ", 10)), QStringList({"t1"})); // swap
+    // short words must be exact
+    QVERIFY(index.search("pey ", 10).isEmpty());
+}
+
+void SearchIndexTest::testRanking() {
+    SearchIndex index;
+    index.upsert(doc(SearchSource::History, "https://a.example/recipes", "Dinner ideas", "https://a.example/recipes"));
+    index.upsert(doc(SearchSource::History, "https://b.example", "Recipes", "https://b.example"));
+    index.upsert(doc(SearchSource::History, "https://c.example", "Recipes", "https://c.example", 50));
+    const QVector<SearchHit> hits = index.search("recipes", 10);
+    QCOMPARE(hits.size(), 3);
+    // title matches first, the more visited of two alike first
+    QCOMPARE(keys(hits), QStringList({"https://c.example", "https://b.example", "https://a.example/recipes"}));
+    for (int i = 1; i < hits.size(); ++i) QVERIFY(hits[i - 1].score >= hits[i].score);
+}
+
+void SearchIndexTest::testSourceQuota() {
+    SearchIndex index;
+    for (int i = 0; i < 20; ++i) index.upsert(doc(SearchSource::History, QString::number(i), "garden page", QString(), 100));
+    index.upsert(doc(SearchSource::Note, "note", "garden plan"));
+    const QVector<SearchHit> hits = index.search("garden", 6);
+    QCOMPARE(hits.size(), 6);
+    // history outranks it, but the note still gets a place
+    QVERIFY(keys(hits).contains("note"));
+}
+
+void SearchIndexTest::testIncrementalUpdates() {
+    SearchIndex index;
+    QVERIFY(index.upsert(doc(SearchSource::Note, "n", "Shopping list", "milk eggs")));
+    QVERIFY(!index.upsert(doc(SearchSource::Note, "n", "Shopping list", "milk eggs")));
+    QVERIFY(index.upsert(doc(SearchSource::Note, "n", "Shopping list", "bread")));
+    QCOMPARE(index.size(), 1);
+    QVERIFY(index.search("milk", 10).isEmpty());
+    QCOMPARE(keys(index.search("bread", 10)), QStringList({"n"}));
+    // the same key in another source is another document
+    index.upsert(doc(SearchSource::Todo, "n", "Buy bread"));
+    QCOMPARE(index.search("bread", 10).size(), 2);
+    QVERIFY(index.remove(SearchSource::Note, "n"));
+    QVERIFY(!index.remove(SearchSource::Note, "n"));
+    QCOMPARE(index.search("bread", 10).first().source, SearchSource::Todo);
+    QCOMPARE(index.document(SearchSource::Todo, "n").title, QString("Buy bread"));
+    QVERIFY(index.document(SearchSource::Note, "n").key.isEmpty());
+}
+
+void SearchIndexTest::testReplaceSource() {
+    SearchIndex index;
+    index.replaceSource(SearchSource::Todo, {doc(SearchSource::Todo, "1", "one"), doc(SearchSource::Todo, "2", "two")});
+    index.upsert(doc(SearchSource::Bookmark, "1", "one bookmark"));
+    // one unchanged, one gone, one new; the bookmark is untouched
+    const int changed = index.replaceSource(SearchSource::Todo, {doc(SearchSource::Todo, "1", "one"), doc(SearchSource::Todo, "3", "three")});
+    QCOMPARE(changed, 2);
+    QCOMPARE(index.size(), 3);
+    QVERIFY(index.search("two", 10).isEmpty());
+    QCOMPARE(index.search("one", 10).size(), 2);
+}
+
+void SearchIndexTest::testPurgeKeepsResults() {
+    SearchIndex index;
+    for (int i = 0; i < 3000; ++i) index.upsert(doc(SearchSource::Todo, QString::number(i), QString("task %1").arg(i)));
+    // rewrite every one twice: enough tombstones to purge, and ids are reused
+    for (int round = 0; round < 2; ++round) {
+        for (int i = 0; i < 3000; ++i) index.upsert(doc(SearchSource::Todo, QString::number(i), QString("task %1 v%2").arg(i).arg(round)));
+    }
+    QCOMPARE(index.size(), 3000);
+    QCOMPARE(index.search("task ", 5000).size(), 3000);
+    QCOMPARE(keys(index.search("task 1234 ", 10)), QStringList({"1234"}));
+    QVERIFY(index.search("v0 ", 10).isEmpty());
+    QCOMPARE(index.search("v1 ", 5000).size(), 3000);
+}
+
+QTEST_MAIN(SearchIndexTest)
+#include "search_index_test.moc"
@@ -0,0 +1,56 @@
+#include <QtTest>
+#include "../cpp/src/SpeculationEngine.h"
+
+class SpeculationEngineTest : public QObject {
+    Q_OBJECT
+private slots:
+    void testOmniboxConfidence();
+    void testThresholdAndDuplicates();
+    void testRateLimit();
+    void testHitAccounting();
+};
+
+void SpeculationEngineTest::testOmniboxConfidence() {
+    const QUrl gh("https://github.com/qt/qtwebengine");
+    QVERIFY(SpeculationEngine::omniboxConfidence("gi", gh) < 0.5);
+    QVERIFY(SpeculationEngine::omniboxConfidence("githu", gh) >= 0.5);
+    // typed host only: preconnect, but not sure enough to prefetch a deep link
+    QVERIFY(SpeculationEngine::omniboxConfidence("github.com", gh) < 0.85);
+    QVERIFY(SpeculationEngine::omniboxConfidence("https://www.github.com/qt", gh) >= 0.85);
+    QVERIFY(SpeculationEngine::omniboxConfidence("webengine", gh) < 0.5);
+}
+
+void SpeculationEngineTest::testThresholdAndDuplicates() {
+    SpeculationEngine eng(nullptr);
+    eng.hint(QUrl("https://a.example/"), 0.2, SpeculationEngine::Source::Omnibox);
+    QCOMPARE(eng.stats().belowThreshold, qint64(1));
+    eng.hint(QUrl("https://a.example/"), 0.7, SpeculationEngine::Source::Omnibox);
+    eng.hint(QUrl("https://a.example/other"), 0.7, SpeculationEngine::Source::BookmarkHover);
+    QCOMPARE(eng.stats().preconnects, qint64(1));
+    QCOMPARE(eng.stats().duplicates, qint64(1));
+    // a confident hint upgrades a warm origin to a prefetch
+    eng.hint(QUrl("https://a.example/page"), 0.95, SpeculationEngine::Source::Omnibox);
+    QCOMPARE(eng.stats().prefetches, qint64(1));
+}
+
+void SpeculationEngineTest::testRateLimit() {
+    SpeculationEngine eng(nullptr);
+    eng.setRateLimit(2, 60000);
+    for (int i = 0; i < 5; ++i) eng.hint(QUrl(QString("https://h%1.example/").arg(i)), 0.7, SpeculationEngine::Source::Omnibox);
+    QCOMPARE(eng.stats().preconnects, qint64(2));
+    QCOMPARE(eng.stats().rateLimited, qint64(3));
+}
+
+void SpeculationEngineTest::testHitAccounting() {
+    SpeculationEngine eng(nullptr);
+    eng.hint(QUrl("https://a.example/"), 0.7, SpeculationEngine::Source::Omnibox);
+    eng.recordNavigation(QUrl("https://a.example/news"));
+    eng.recordNavigation(QUrl("https://b.example/"));
+    QCOMPARE(eng.stats().navigations, qint64(2));
+    QCOMPARE(eng.stats().hits, qint64(1));
+    QCOMPARE(eng.stats().hitRate(), 0.5);
+    QCOMPARE(eng.stats().precision(), 1.0);
+}
+
+QTEST_MAIN(SpeculationEngineTest)
+#include "speculation_engine_test.moc"
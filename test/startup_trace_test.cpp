@@ -0,0 +1,51 @@
+#include <QtTest>
+#include <QJsonArray>
+#include "../cpp/src/StartupTrace.h"
+
+class StartupTraceTest : public QObject {
+    Q_OBJECT
+private slots:
+    void testPhasesAreOrderedAndKeptOnce();
+    void testWorkerMarksCarryTheirThread();
+    void testReportAndJson();
+};
+
+void StartupTraceTest::testPhasesAreOrderedAndKeptOnce() {
+    StartupTrace::start();
+    StartupTrace::mark("alpha");
+    QTest::qWait(5);
+    StartupTrace::mark("beta");
+    const double firstBeta = StartupTrace::phases().last().atMs;
+    StartupTrace::mark("beta");
+    const auto phases = StartupTrace::phases();
+    QCOMPARE(phases.first().name, QString("process start"));
+    QCOMPARE(phases.last().name, QString("beta"));
+    QCOMPARE(phases.last().atMs, firstBeta);
+    for (int i = 1; i < phases.size(); ++i) QVERIFY(phases[i].atMs >= phases[i - 1].atMs);
+    QVERIFY(phases.last().atMs - phases.at(phases.size() - 2).atMs >= 4.0);
+    QVERIFY(StartupTrace::reached("alpha"));
+    QVERIFY(!StartupTrace::reached("gamma"));
+    QCOMPARE(phases.last().thread, QString("main"));
+}
+
+void StartupTraceTest::testWorkerMarksCarryTheirThread() {
+    QThread* worker = QThread::create([](){ StartupTrace::mark("from worker"); });
+    worker->setObjectName("storage-io");
+    worker->start();
+    QVERIFY(worker->wait(5000));
+    delete worker;
+    QCOMPARE(StartupTrace::phases().last().name, QString("from worker"));
+    QCOMPARE(StartupTrace::phases().last().thread, QString("storage-io"));
+}
+
+void StartupTraceTest::testReportAndJson() {
+    const QString report = StartupTrace::report();
+    QVERIFY(report.contains("alpha"));
+    QVERIFY(report.contains("storage-io"));
+    const QJsonArray phases = StartupTrace::toJson()["phases"].toArray();
+    QCOMPARE(phases.size(), StartupTrace::phases().size());
+    QCOMPARE(phases.at(1).toObject()["phase"].toString(), QString("alpha"));
+}
+
+QTEST_MAIN(StartupTraceTest)
+#include "startup_trace_test.moc"
@@ -0,0 +1,136 @@
+#include <QtTest>
+#include <QElapsedTimer>
+#include "../cpp/src/StorageExecutor.h"
+#include "../cpp/src/NotesManager.h"
+#include "../cpp/src/WorkspaceManager.h"
+#include "../cpp/src/SessionManager.h"
+#include "../cpp/src/HistoryManager.h"
+
+// Times every event the GUI thread handles. Storage work that slipped back
+// onto this thread shows up as a handler slower than the disk is fast.
+class WatchdogApp : public QCoreApplication {
+public:
+    using QCoreApplication::QCoreApplication;
+
+    bool notify(QObject* receiver, QEvent* event) override {
+        if (QThread::currentThread() != thread()) return QCoreApplication::notify(receiver, event);
+        // the receiver may be gone afterwards
+        const char* cls = receiver->metaObject()->className();
+        const int type = int(event->type());
+        QElapsedTimer t;
+        t.start();
+        const bool handled = QCoreApplication::notify(receiver, event);
+        const qint64 us = t.nsecsElapsed() / 1000;
+        if (us > worstUs) {
+            worstUs = us;
+            worst = QString("%1, event type %2").arg(cls).arg(type);
+        }
+        return handled;
+    }
+
+    qint64 worstUs = 0;
+    QString worst;
+};
+
+class StorageExecutorTest : public QObject {
+    Q_OBJECT
+private slots:
+    void initTestCase();
+    void testJobsRunInOrderOffThread();
+    void testCallbacksFollowContext();
+    void testGuiThreadNeverWaitsForDisk();
+
+private:
+    static constexpr int kSlowDiskMs = 30;
+    static constexpr qint64 kBudgetUs = 4000;
+    static WatchdogApp* app() { return static_cast<WatchdogApp*>(QCoreApplication::instance()); }
+};
+
+void StorageExecutorTest::initTestCase() {
+    QStandardPaths::setTestModeEnabled(true);
+    const QDir dataDir(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation));
+    for (const QString &f : dataDir.entryList({"flow.db*", "history.db*"}, QDir::Files)) QFile::remove(dataDir.filePath(f));
+    StorageExecutor::instance()->waitForIdle();
+}
+
+void StorageExecutorTest::testJobsRunInOrderOffThread() {
+    StorageExecutor* executor = StorageExecutor::instance();
+    QVector<int> order;
+    for (int i = 0; i < 5; ++i) {
+        executor->read<bool>(this, [executor](Storage&){ return QThread::currentThread() == executor->ioThread(); },
+                             [&order, i](bool offThread){ if (offThread) order << i; });
+    }
+    QTRY_COMPARE(order, QVector<int>({0, 1, 2, 3, 4}));
+}
+
+void StorageExecutorTest::testCallbacksFollowContext() {
+    StorageExecutor* executor = StorageExecutor::instance();
+    int ran = 0;
+    auto *gone = new QObject;
+    executor->read<int>(gone, [](Storage&){ return 1; }, [&ran](int v){ ran += 100 * v; });
+    executor->write(gone, [](Storage& s){ return s.setValue("watchdog", "x"); }, [&ran](bool){ ran += 100; });
+    executor->read<int>(this, [](Storage& s){ return s.value("watchdog").size(); }, [&ran](int v){ ran += v; });
+    delete gone;
+    executor->waitForIdle();
+    // the write itself still happened
+    QCOMPARE(ran, 1);
+}
+
+void StorageExecutorTest::testGuiThreadNeverWaitsForDisk() {
+    StorageExecutor* executor = StorageExecutor::instance();
+    // a profile on a slow network share: every storage job takes 30 ms
+    executor->setSimulatedLatency(kSlowDiskMs);
+    NotesManager notes;
+    WorkspaceManager workspaces;
+    SessionManager session;
+    HistoryManager history;
+    app()->worstUs = 0;
+
+    qint64 worstCallUs = 0;
+    QString worstCall;
+    auto timed = [&](const char* what, const std::function<void()>& fn){
+        QElapsedTimer t;
+        t.start();
+        fn();
+        const qint64 us = t.nsecsElapsed() / 1000;
+        if (us > worstCallUs) { worstCallUs = us; worstCall = what; }
+    };
+
+    // everything below is asked for before the stored state has even arrived
+    for (int i = 0; i < 100; ++i) timed("addNote", [&](){ notes.addNote(QString("Note %1").arg(i), "body"); });
+    timed("createWorkspace", [&](){ workspaces.createWorkspace("Slow disk"); });
+    timed("saveSession", [&](){ session.saveSession({"https://a.example", "https://b.example"}, 1); });
+    timed("addVisit", [&](){ history.addVisit("https://a.example", "A"); });
+    QVERIFY(!notes.isLoaded());
+
+    QTRY_VERIFY_WITH_TIMEOUT(notes.isLoaded() && workspaces.isLoaded(), 5000);
+    QCOMPARE(notes.count(), 100);
+    QCOMPARE(workspaces.workspaces().size(), 1);
+    timed("editNote", [&](){ notes.editNote(10, "Edited", "new body"); });
+    timed("removeNoteWithUndo", [&](){ notes.removeNoteWithUndo(0); });
+    timed("undoLastRemove", [&](){ notes.undoLastRemove(); });
+    timed("flushSave", [&](){ notes.flushSave(); });
+    timed("setTabsForWorkspace", [&](){ workspaces.setTabsForWorkspace(0, {"https://c.example"}); });
+    timed("switchToWorkspace", [&](){ workspaces.switchToWorkspace(0); });
+
+    QStringList urls;
+    HistoryManager::Results found;
+    bool searched = false;
+    timed("loadSession", [&](){ session.loadSession(this, [&](const QStringList& u, int){ urls = u; }); });
+    timed("search", [&](){ history.search("a.example", 10, this, [&](const HistoryManager::Results& r){ found = r; searched = true; }); });
+    QTRY_VERIFY_WITH_TIMEOUT(searched && !urls.isEmpty() && notes.saveCount() >= 1, 5000);
+    QCOMPARE(urls, QStringList({"https://a.example", "https://b.example"}));
+    QCOMPARE(found.size(), 1);
+
+    executor->setSimulatedLatency(0);
+    QVERIFY2(worstCallUs < kBudgetUs, qPrintable(QString("%1 took %2 us").arg(worstCall).arg(worstCallUs)));
+    QVERIFY2(app()->worstUs < kBudgetUs, qPrintable(QString("%1 took %2 us").arg(app()->worst).arg(app()->worstUs)));
+}
+
+int main(int argc, char** argv) {
+    WatchdogApp app(argc, argv);
+    StorageExecutorTest test;
+    return QTest::qExec(&test, argc, argv);
+}
+
+#include "storage_executor_test.moc"
@@ -0,0 +1,209 @@
+#include <QtTest>
+#include <QSqlQuery>
+#include <QTemporaryDir>
+#include "../cpp/src/StorageExecutor.h"
+#include "../cpp/src/NotesManager.h"
+#include "../cpp/src/WorkspaceManager.h"
+#include "../cpp/src/SessionManager.h"
+
+class StorageTest : public QObject {
+    Q_OBJECT
+private slots:
+    void initTestCase();
+    void testImportsLegacyJson();
+    void testOnlyChangedRowsAreWritten();
+    void testTransactionSpansStores();
+    void testOrderSurvivesUndo();
+    void testBackup();
+
+private:
+    static void writeJson(const QString& name, const QJsonDocument& doc);
+    static int totalChanges();
+    static int commitCount();
+    static QString noteTitleInDb(const QString& title);
+    static int countInDb(const QString& sql);
+
+    QDir m_dataDir;
+};
+
+void StorageTest::writeJson(const QString& name, const QJsonDocument& doc) {
+    QFile f(QDir(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation)).filePath(name));
+    QVERIFY(f.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    f.write(doc.toJson());
+}
+
+// the DB side is only reachable from the storage thread
+int StorageTest::totalChanges() {
+    return countInDb("SELECT total_changes()");
+}
+
+int StorageTest::commitCount() {
+    return StorageExecutor::instance()->blockingRead<int>([](Storage& s){ return s.commitCount(); });
+}
+
+int StorageTest::countInDb(const QString& sql) {
+    return StorageExecutor::instance()->blockingRead<int>([sql](Storage& s){
+        QSqlQuery q(s.database());
+        if (!q.exec(sql) || !q.next()) return -1;
+        return q.value(0).toInt();
+    });
+}
+
+QString StorageTest::noteTitleInDb(const QString& title) {
+    return StorageExecutor::instance()->blockingRead<QString>([title](Storage& s){
+        QSqlQuery q(s.database());
+        q.prepare("SELECT json_extract(data, '$.title') FROM notes WHERE json_extract(data, '$.title') = ?");
+        q.addBindValue(title);
+        if (!q.exec() || !q.next()) return QString();
+        return q.value(0).toString();
+    });
+}
+
+void StorageTest::initTestCase() {
+    QStandardPaths::setTestModeEnabled(true);
+    m_dataDir = QDir(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation));
+    QDir().mkpath(m_dataDir.path());
+    for (const QString &f : m_dataDir.entryList({"flow.db*", "*.imported"}, QDir::Files)) QFile::remove(m_dataDir.filePath(f));
+
+    // what the JSON-file managers left behind
+    QJsonObject synced{{"id", "r1"}, {"title", "Synced"}, {"content", "a"}, {"workspace", "Work"}, {"local_id", "l1"}, {"status", 0}};
+    QJsonObject dirty{{"id", ""}, {"title", "Dirty"}, {"content", "b"}, {"workspace", ""}, {"status", 2}};
+    writeJson("notes.json", QJsonDocument(QJsonArray{synced, dirty}));
+    writeJson("sync_state.json", QJsonDocument(QJsonObject{{"notes", QJsonObject{{"user_id", "u1"}, {"updated_at", "2026-01-01"}}}}));
+    QJsonObject ws{{"name", "Work"}, {"type", "window"}, {"tabs", QJsonArray{"https://a.example"}},
+                   {"groups", QJsonArray{QJsonObject{{"name", "G"}, {"color", "#ff0000"}}}}};
+    writeJson("workspaces.json", QJsonDocument(QJsonObject{{"workspaces", QJsonArray{ws}}, {"current", 0}}));
+    writeJson("session.json", QJsonDocument(QJsonObject{{"tabs", QJsonArray{"https://x.example", "https://y.example"}}, {"active", 1}}));
+
+    StorageExecutor* executor = StorageExecutor::instance();
+    QVERIFY(executor->blockingRead<bool>([](Storage& s){ return s.isOpen(); }));
+    QCOMPARE(executor->blockingRead<int>([](Storage& s){ return s.schemaVersion(); }), Storage::latestSchemaVersion());
+    const QString mode = executor->blockingRead<QString>([](Storage& s){
+        QSqlQuery q(s.database());
+        return q.exec("PRAGMA journal_mode") && q.next() ? q.value(0).toString() : QString();
+    });
+    QCOMPARE(mode.toLower(), QString("wal"));
+}
+
+void StorageTest::testImportsLegacyJson() {
+    for (const QString &f : {"notes.json", "sync_state.json", "workspaces.json", "session.json"}) {
+        QVERIFY2(!m_dataDir.exists(f), qPrintable(f));
+        QVERIFY2(m_dataDir.exists(f + ".imported"), qPrintable(f));
+    }
+    NotesManager notes;
+    QTRY_VERIFY(notes.isLoaded());
+    QCOMPARE(notes.count(), 2);
+    QCOMPARE(notes.notes().at(0).title, QString("Synced"));
+    QCOMPARE(notes.notes().at(1).title, QString("Dirty"));
+    // the unsynced note had no queue entry yet and gets one
+    QCOMPARE(notes.pendingCount(), 1);
+    QCOMPARE(notes.queuedOperations(), 1);
+    StorageExecutor* executor = StorageExecutor::instance();
+    QCOMPARE(executor->blockingRead<QString>([](Storage& s){ return s.syncCursor("notes", "u1"); }), QString("2026-01-01"));
+    QVERIFY(executor->blockingRead<QString>([](Storage& s){ return s.syncCursor("notes", "someone-else"); }).isEmpty());
+
+    WorkspaceManager workspaces;
+    QTRY_VERIFY(workspaces.isLoaded());
+    QCOMPARE(workspaces.workspaces().size(), 1);
+    QCOMPARE(workspaces.currentIndex(), 0);
+    QCOMPARE(workspaces.workspaces().at(0).tabs, QStringList({"https://a.example"}));
+    QCOMPARE(workspaces.groupsFor(0).at(0).color, QColor("#ff0000"));
+
+    SessionManager session;
+    QStringList urls;
+    int active = -1;
+    session.loadSession(this, [&](const QStringList& u, int a){ urls = u; active = a; });
+    QTRY_COMPARE(active, 1);
+    QCOMPARE(urls, QStringList({"https://x.example", "https://y.example"}));
+}
+
+void StorageTest::testOnlyChangedRowsAreWritten() {
+    NotesManager notes;
+    QTRY_VERIFY(notes.isLoaded());
+    for (int i = 0; i < 50; ++i) notes.addNote(QString("Bulk %1").arg(i), "body");
+    const int commitsBefore = commitCount();
+    notes.flushSave();
+    // fifty inserts, one transaction
+    QCOMPARE(commitCount(), commitsBefore + 1);
+    QCOMPARE(noteTitleInDb("Bulk 49"), QString("Bulk 49"));
+    QCOMPARE(notes.saveCount(), 0);
+    StorageExecutor::instance()->waitForIdle();
+    QCOMPARE(notes.saveCount(), 1);
+
+    const int before = totalChanges();
+    notes.editNote(10, "Edited", "new body");
+    notes.flushSave();
+    // the edited row and the op queue, nothing else
+    QCOMPARE(totalChanges() - before, 2);
+    QCOMPARE(noteTitleInDb("Edited"), QString("Edited"));
+}
+
+void StorageTest::testTransactionSpansStores() {
+    StorageExecutor* executor = StorageExecutor::instance();
+    WorkspaceManager workspaces;
+    NotesManager notes;
+    QTRY_VERIFY(workspaces.isLoaded() && notes.isLoaded());
+    const int index = notes.count() - 1;
+    const bool ok = executor->batch([&](){
+        // move the last note into a new workspace, then give up
+        const int ws = workspaces.createWorkspace("Moved");
+        NoteItem n = notes.notes().at(index);
+        n.workspace = "Moved";
+        notes.update(index, n);
+        notes.flushSave();
+        return ws < 0;
+    });
+    QVERIFY(!ok);
+    executor->waitForIdle();
+    WorkspaceManager reloaded;
+    QTRY_VERIFY(reloaded.isLoaded());
+    QCOMPARE(reloaded.workspaces().size(), 1);
+    const QString moved = "SELECT COUNT(*) FROM notes WHERE json_extract(data, '$.workspace') = 'Moved'";
+    QCOMPARE(countInDb(moved), 0);
+
+    // the dropped note is unsaved again and goes out with the next save
+    QVERIFY(executor->batch([&](){ notes.flushSave(); return true; }));
+    executor->waitForIdle();
+    QCOMPARE(countInDb(moved), 1);
+}
+
+void StorageTest::testOrderSurvivesUndo() {
+    QStringList expected;
+    {
+        NotesManager notes;
+        QTRY_VERIFY(notes.isLoaded());
+        notes.removeWithUndo(1);
+        notes.flushSave();
+        notes.undoLastRemove();
+        notes.removeWithUndo(0);
+        notes.undoLastRemove();
+        for (const NoteItem &n : notes.notes()) expected << n.title;
+    }
+    NotesManager reloaded;
+    QTRY_VERIFY(reloaded.isLoaded());
+    QStringList titles;
+    for (const NoteItem &n : reloaded.notes()) titles << n.title;
+    QCOMPARE(titles, expected);
+    QCOMPARE(titles.at(1), QString("Dirty"));
+}
+
+void StorageTest::testBackup() {
+    QTemporaryDir dir;
+    const QString path = dir.filePath("backup.db");
+    QVERIFY(StorageExecutor::instance()->blockingRead<bool>([path](Storage& s){ return s.backup(path); }));
+    NotesManager notes;
+    QTRY_VERIFY(notes.isLoaded());
+    {
+        QSqlDatabase copy = QSqlDatabase::addDatabase("QSQLITE", "backup_check");
+        copy.setDatabaseName(path);
+        QVERIFY(copy.open());
+        QSqlQuery q(copy);
+        QVERIFY(q.exec("SELECT COUNT(*) FROM notes") && q.next());
+        QCOMPARE(q.value(0).toInt(), notes.count());
+        copy.close();
+    }
+    QSqlDatabase::removeDatabase("backup_check");
+}
+
+QTEST_MAIN(StorageTest)
+#include "storage_test.moc"
@@ -0,0 +1,163 @@
+#include <QtTest>
+#include "../cpp/src/SyncOpQueue.h"
+
+class SyncOpQueueTest : public QObject {
+    Q_OBJECT
+private slots:
+    void testCollapsing();
+    void testFollowUpWhileInFlight();
+    void testCreateTimesOutThenDelete();
+    void testBackoff();
+    void testPersistence();
+    void testDirtyFields();
+};
+
+void SyncOpQueueTest::testCollapsing() {
+    SyncOpQueue q;
+    q.enqueueCreate("a");
+    q.enqueueUpdate("a", QString());
+    QCOMPARE(q.size(), 1);
+    QCOMPARE(q.find("a")->kind, SyncOp::Create);
+    // created and deleted before anything was sent: nothing to do
+    q.enqueueDelete("a", QString());
+    QVERIFY(q.isEmpty());
+
+    q.enqueueUpdate("b", "r1");
+    q.enqueueUpdate("b", "r1");
+    q.enqueueDelete("b", "r1");
+    QCOMPARE(q.size(), 1);
+    QCOMPARE(q.find("b")->kind, SyncOp::Delete);
+    QCOMPARE(q.deletedRemoteIds(), QStringList{"r1"});
+
+    // a remote row matching an unsent create turns it into an update of that row
+    q.enqueueCreate("c");
+    q.adopt("c", "r2");
+    QCOMPARE(q.find("c")->kind, SyncOp::Update);
+    QCOMPARE(q.find("c")->remoteId, QString("r2"));
+}
+
+void SyncOpQueueTest::testFollowUpWhileInFlight() {
+    SyncOpQueue q;
+    q.enqueueCreate("a");
+    QCOMPARE(q.takeDue(0).size(), 1);
+    QVERIFY(q.takeDue(0).isEmpty()); // already in flight
+    q.enqueueUpdate("a", QString());
+    QVERIFY(q.complete("a", SyncOp::Done, "r1", 0));
+    QCOMPARE(q.find("a")->kind, SyncOp::Update);
+    QCOMPARE(q.find("a")->remoteId, QString("r1"));
+
+    QCOMPARE(q.takeDue(0).size(), 1);
+    q.enqueueDelete("a", "r1");
+    QVERIFY(q.complete("a", SyncOp::Done, QString(), 0));
+    QCOMPARE(q.find("a")->kind, SyncOp::Delete);
+    q.takeDue(0);
+    QVERIFY(!q.complete("a", SyncOp::Done, QString(), 0));
+    QVERIFY(q.isEmpty());
+
+    // a conflict leaves nothing queued; the item waits for the user
+    q.enqueueUpdate("b", "r2");
+    q.takeDue(0);
+    QVERIFY(!q.complete("b", SyncOp::Conflict, QString(), 0));
+    QVERIFY(q.isEmpty());
+}
+
+// a POST that got no answer may have stored the row: the create is repeated
+// under the same id, and a delete after it is sent, not dropped
+void SyncOpQueueTest::testCreateTimesOutThenDelete() {
+    SyncOpQueue q;
+    q.enqueueCreate("a");
+    const QString id = q.find("a")->remoteId;
+    QVERIFY(!id.isEmpty());
+    q.takeDue(0);
+    QVERIFY(q.complete("a", SyncOp::Retry, QString(), 0));
+    QCOMPARE(q.find("a")->kind, SyncOp::Create);
+    QCOMPARE(q.find("a")->remoteId, id);
+    q.enqueueDelete("a", QString());
+    QCOMPARE(q.find("a")->kind, SyncOp::Delete);
+    QCOMPARE(q.deletedRemoteIds(), QStringList{id});
+
+    // deleted while the POST was out
+    q.enqueueCreate("b");
+    const QString idB = q.find("b")->remoteId;
+    q.clearBackoff();
+    QCOMPARE(q.takeDue(0).size(), 2);
+    q.enqueueDelete("b", QString());
+    QVERIFY(q.complete("b", SyncOp::Retry, QString(), 0));
+    QCOMPARE(q.find("b")->kind, SyncOp::Delete);
+    QCOMPARE(q.find("b")->remoteId, idB);
+
+    // or when shutdown cut the POST off
+    q.enqueueCreate("c");
+    const QString idC = q.find("c")->remoteId;
+    q.takeDue(0);
+    q.enqueueDelete("c", QString());
+    const SyncOpQueue restored = SyncOpQueue::fromJson(q.toJson());
+    QCOMPARE(restored.find("c")->kind, SyncOp::Delete);
+    QCOMPARE(restored.find("c")->remoteId, idC);
+}
+
+void SyncOpQueueTest::testBackoff() {
+    QCOMPARE(SyncOpQueue::backoffMs(1, 1.0), qint64(1000));
+    QCOMPARE(SyncOpQueue::backoffMs(3, 1.0), qint64(4000));
+    QCOMPARE(SyncOpQueue::backoffMs(30, 1.0), qint64(5 * 60 * 1000));
+    QCOMPARE(SyncOpQueue::backoffMs(2, 0.5), qint64(1000));
+
+    SyncOpQueue q;
+    q.enqueueUpdate("a", "r1");
+    q.takeDue(1000);
+    QVERIFY(q.complete("a", SyncOp::Retry, QString(), 1000));
+    QCOMPARE(q.find("a")->attempts, 1);
+    const qint64 due = q.nextDue();
+    QVERIFY(due >= 1500 && due < 2500);
+    QVERIFY(q.takeDue(1000).isEmpty());
+    QCOMPARE(q.takeDue(due).size(), 1);
+    QVERIFY(q.complete("a", SyncOp::Retry, QString(), due));
+    q.clearBackoff();
+    QCOMPARE(q.nextDue(), qint64(0));
+}
+
+void SyncOpQueueTest::testPersistence() {
+    SyncOpQueue q;
+    q.enqueueCreate("a");
+    q.enqueueUpdate("b", "r1");
+    q.enqueueUpdate("c", "r2");
+    q.takeDue(0);
+    q.enqueueDelete("c", "r2"); // queued behind the in-flight update
+
+    const SyncOpQueue restored = SyncOpQueue::fromJson(q.toJson());
+    QCOMPARE(restored.size(), 3);
+    QCOMPARE(restored.find("b")->kind, SyncOp::Update);
+    QCOMPARE(restored.find("c")->kind, SyncOp::Delete);
+    QVERIFY(!restored.find("a")->inFlight);
+    QCOMPARE(restored.find("a")->kind, SyncOp::Create);
+}
+
+void SyncOpQueueTest::testDirtyFields() {
+    SyncOpQueue q;
+    q.enqueueUpdate("a", "r1", {"title"});
+    q.enqueueUpdate("a", "r1", {"title", "content"});
+    QCOMPARE(q.find("a")->fields, QStringList({"title", "content"}));
+    // an edit of unknown extent sends the whole row
+    q.enqueueUpdate("a", "r1");
+    QVERIFY(q.find("a")->fields.isEmpty());
+
+    q.enqueueUpdate("b", "r2", {"title"});
+    QCOMPARE(q.takeDue(0).size(), 2);
+    q.enqueueUpdate("b", "r2", {"workspace"});
+    // the title is on the server; only what changed meanwhile goes next
+    QVERIFY(q.complete("b", SyncOp::Done, QString(), 0));
+    QCOMPARE(q.find("b")->fields, QStringList{"workspace"});
+
+    q.takeDue(0);
+    q.enqueueUpdate("b", "r2", {"content"});
+    // a failed send is repeated with the later change folded in
+    QVERIFY(q.complete("b", SyncOp::Retry, QString(), 0));
+    QCOMPARE(q.find("b")->fields, QStringList({"workspace", "content"}));
+
+    const SyncOpQueue restored = SyncOpQueue::fromJson(q.toJson());
+    QCOMPARE(restored.find("b")->fields, QStringList({"workspace", "content"}));
+    QVERIFY(restored.find("a")->fields.isEmpty());
+}
+
+QTEST_MAIN(SyncOpQueueTest)
+#include "sync_op_queue_test.moc"
@@ -0,0 +1,243 @@
+#include <QtTest>
+#include "../cpp/src/MockSupabaseServer.h"
+#include "../cpp/src/AuthManager.h"
+#include "../cpp/src/NotesManager.h"
+#include "../cpp/src/TodosManager.h"
+
+class SyncedCollectionTest : public QObject {
+    Q_OBJECT
+private slots:
+    void initTestCase();
+    void testBatchedPush();
+    void testEditsAndDeletesAreBatched();
+    void testDeltaPull();
+    void testTransientFailuresRetry();
+    void testOnlyChangedColumnsAreSent();
+    void testTiedTimestamps();
+    void testOwnPushIsNotAConflict();
+    void testFullListingOnlyWithoutUpdatedAt();
+
+private:
+    qint64 routeCount(const QString& route) const { return m_server.stats().byRoute.value(route); }
+
+    MockSupabaseServer m_server;
+    AuthManager* m_auth = nullptr;
+    NotesManager* m_mgr = nullptr;
+};
+
+void SyncedCollectionTest::initTestCase() {
+    QStandardPaths::setTestModeEnabled(true);
+    const QDir dataDir(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation));
+    for (const QString &f : dataDir.entryList({"flow.db*"}, QDir::Files)) QFile::remove(dataDir.filePath(f));
+    QFile::remove(dataDir.filePath("auth.json"));
+    QVERIFY(m_server.listen());
+    m_auth = new AuthManager(this);
+    m_auth->setSupabaseConfig(m_server.url(), m_server.anonKey());
+    m_mgr = new NotesManager(this);
+    m_mgr->setSupabaseConfig(m_server.url(), m_server.anonKey());
+    m_mgr->setAuthManager(m_auth);
+}
+
+void SyncedCollectionTest::testBatchedPush() {
+    // written while signed out, uploaded after the first pull
+    for (int i = 0; i < 120; ++i) m_mgr->addNote(QString("Note %1").arg(i), "body");
+    QCOMPARE(m_mgr->pendingCount(), 120);
+    m_auth->signIn("a@b.c", "x");
+    QTRY_COMPARE_WITH_TIMEOUT(m_mgr->pendingCount(), 0, 5000);
+    QCOMPARE(m_server.rowCount("notes"), 120);
+    QCOMPARE(routeCount("POST /rest/v1/notes"), 1);
+    QVERIFY(m_mgr->conflictIndices().isEmpty());
+    for (const auto &n : m_mgr->notes()) QVERIFY(!n.id.isEmpty());
+    // saves are coalesced, not one file rewrite per note
+    QTRY_VERIFY_WITH_TIMEOUT(m_mgr->saveCount() >= 1, 2000);
+    QVERIFY(m_mgr->saveCount() < 10);
+}
+
+void SyncedCollectionTest::testEditsAndDeletesAreBatched() {
+    const qint64 postsBefore = routeCount("POST /rest/v1/notes");
+    qint64 patchesBefore = routeCount("PATCH /rest/v1/notes");
+    for (int i = 0; i < 10; ++i) m_mgr->editNote(i, "Edited", "new body");
+    QTRY_COMPARE_WITH_TIMEOUT(m_mgr->pendingCount(), 0, 5000);
+    // the first edit goes out alone, the other nine wait for it and share one PATCH
+    QVERIFY(routeCount("PATCH /rest/v1/notes") - patchesBefore <= 2);
+
+    // different values cannot share a PATCH body; partial rows are never upserted
+    patchesBefore = routeCount("PATCH /rest/v1/notes");
+    for (int i = 0; i < 10; ++i) m_mgr->editNote(i, QString("Edited %1").arg(i), "new body");
+    QTRY_COMPARE_WITH_TIMEOUT(m_mgr->pendingCount(), 0, 5000);
+    QCOMPARE(routeCount("PATCH /rest/v1/notes") - patchesBefore, 10);
+    QCOMPARE(routeCount("POST /rest/v1/notes"), postsBefore);
+    QVERIFY(m_mgr->conflictIndices().isEmpty());
+    QCOMPARE(m_server.rowCount("notes"), 120);
+    int edited = 0;
+    for (const QJsonValue &v : m_server.rows("notes")) if (v.toObject().value("title").toString().startsWith("Edited ")) ++edited;
+    QCOMPARE(edited, 10);
+
+    for (int i = 0; i < 5; ++i) m_mgr->removeNote(0);
+    QCOMPARE(m_mgr->notes().size(), 115);
+    QTRY_COMPARE_WITH_TIMEOUT(m_server.rowCount("notes"), 115, 5000);
+    QVERIFY(routeCount("DELETE /rest/v1/notes") <= 2);
+}
+
+void SyncedCollectionTest::testDeltaPull() {
+    // the first pull had no cursor yet; this one lists everything once and sets it
+    m_mgr->syncFromSupabase();
+    QTRY_VERIFY_WITH_TIMEOUT(m_server.stats().byRoute.value("GET /rest/v1/notes") >= 2, 5000);
+    QTest::qWait(50);
+    QCOMPARE(m_mgr->notes().size(), 115);
+
+    QTest::qWait(5); // a newer updated_at than the cursor
+    m_server.seedRows("notes", 3);
+    const qint64 bytesBefore = m_server.stats().bytesOut;
+    m_mgr->syncFromSupabase();
+    QTRY_COMPARE_WITH_TIMEOUT(m_mgr->notes().size(), 118, 5000);
+    // only the three new rows travel, not all 118
+    QVERIFY(m_server.stats().bytesOut - bytesBefore < 2000);
+    QCOMPARE(m_mgr->pendingCount(), 0);
+}
+
+void SyncedCollectionTest::testTransientFailuresRetry() {
+    m_server.setErrorRate(1.0);
+    m_mgr->addNote("Offline-ish", "body");
+    m_mgr->removeNote(0);
+    QTRY_VERIFY_WITH_TIMEOUT(m_server.stats().injectedErrors >= 2, 5000);
+    // a 503 is retried later, not turned into a conflict
+    QVERIFY(m_mgr->conflictIndices().isEmpty());
+    QCOMPARE(m_mgr->pendingCount(), 1);
+    QCOMPARE(m_mgr->queuedOperations(), 2);
+
+    m_server.setErrorRate(0.0);
+    // first retry comes after 0.5-1.5 s of backoff
+    QTRY_COMPARE_WITH_TIMEOUT(m_mgr->queuedOperations(), 0, 10000);
+    QCOMPARE(m_mgr->pendingCount(), 0);
+    QCOMPARE(m_server.rowCount("notes"), 118);
+    QVERIFY(m_mgr->conflictIndices().isEmpty());
+}
+
+void SyncedCollectionTest::testOnlyChangedColumnsAreSent() {
+    const QString body = QString("Lorem ipsum dolor sit amet. ").repeated(800); // ~22 KB
+    m_mgr->editNote(0, "Long note", body);
+    QTRY_COMPARE_WITH_TIMEOUT(m_mgr->pendingCount(), 0, 5000);
+    // the large body went up gzip-encoded
+    QVERIFY(m_server.stats().gzipRequests >= 1);
+    QVERIFY(m_mgr->wireStats().compressed >= 1);
+
+    const qint64 bytesBefore = m_server.stats().bytesIn;
+    const qint64 patchesBefore = routeCount("PATCH /rest/v1/notes");
+    m_mgr->editNote(0, "Renamed", body);
+    QTRY_COMPARE_WITH_TIMEOUT(m_mgr->pendingCount(), 0, 5000);
+    // a title change is a PATCH of the title alone, not 22 KB of content again
+    QCOMPARE(routeCount("PATCH /rest/v1/notes") - patchesBefore, 1);
+    QVERIFY(m_server.stats().bytesIn - bytesBefore < 2000);
+    bool found = false;
+    for (const QJsonValue &v : m_server.rows("notes")) {
+        const QJsonObject row = v.toObject();
+        if (row.value("title").toString() != "Renamed") continue;
+        found = true;
+        QCOMPARE(row.value("content").toString(), body);
+    }
+    QVERIFY(found);
+    const SyncWireStats ws = m_mgr->wireStats();
+    QVERIFY(ws.savedBytes() > 20000);
+    QVERIFY(ws.payloadBytes < ws.fullRowBytes);
+}
+
+void SyncedCollectionTest::testTiedTimestamps() {
+    // rows of one transaction share updated_at: the ones written after a pull
+    // that already read some of them still arrive, across page boundaries too
+    m_server.setFixedTime("2099-01-01T00:00:00.000Z");
+    QSignalSpy finished(m_mgr, &SyncEngineBase::pullFinished);
+    const int before = m_mgr->notes().size();
+    m_server.seedRows("notes", 2);
+    m_mgr->syncFromSupabase();
+    QTRY_COMPARE_WITH_TIMEOUT(finished.size(), 1, 5000);
+    QCOMPARE(m_mgr->notes().size(), before + 2);
+    m_server.seedRows("notes", 1200);
+    m_mgr->syncFromSupabase();
+    QTRY_COMPARE_WITH_TIMEOUT(finished.size(), 2, 10000);
+    QCOMPARE(m_mgr->notes().size(), before + 1202);
+    QVERIFY(finished.at(1).at(0).toBool());
+    m_server.setFixedTime(QString());
+}
+
+void SyncedCollectionTest::testOwnPushIsNotAConflict() {
+    // after the cursor testTiedTimestamps left
+    m_server.setFixedTime("2099-01-02T00:00:00.000Z");
+    QSignalSpy finished(m_mgr, &SyncEngineBase::pullFinished);
+    m_mgr->syncFromSupabase();
+    QTRY_COMPARE_WITH_TIMEOUT(finished.size(), 1, 5000);
+    m_mgr->editNote(0, "Mine 1", "body");
+    QTRY_COMPARE_WITH_TIMEOUT(m_mgr->pendingCount(), 0, 5000);
+    const QString id = m_mgr->notes()[0].id;
+
+    // edited again and still queued when the next pull brings back the first edit
+    m_server.setErrorRate(1.0);
+    const qint64 errors = m_server.stats().injectedErrors;
+    m_mgr->editNote(0, "Mine 2", "body");
+    QTRY_VERIFY_WITH_TIMEOUT(m_server.stats().injectedErrors > errors, 5000);
+    m_server.setErrorRate(0.0);
+    m_mgr->syncFromSupabase();
+    QTRY_COMPARE_WITH_TIMEOUT(finished.size(), 2, 5000);
+    QVERIFY(m_mgr->conflictIndices().isEmpty());
+    QTRY_COMPARE_WITH_TIMEOUT(m_mgr->queuedOperations(), 0, 10000);
+    auto remoteTitle = [this, id]() {
+        for (const QJsonValue &v : m_server.rows("notes"))
+            if (v.toObject().value("id").toString() == id) return v.toObject().value("title").toString();
+        return QString();
+    };
+    QCOMPARE(remoteTitle(), QString("Mine 2"));
+
+    // someone else's edit is: both sides are kept and nothing is sent until a pick
+    m_server.setFixedTime("2099-01-03T00:00:00.000Z");
+    QVERIFY(m_server.editRow("notes", id, {{"title", "Theirs"}}));
+    m_server.setErrorRate(1.0);
+    const qint64 errors2 = m_server.stats().injectedErrors;
+    m_mgr->editNote(0, "Mine 3", "body");
+    QTRY_VERIFY_WITH_TIMEOUT(m_server.stats().injectedErrors > errors2, 5000);
+    m_server.setErrorRate(0.0);
+    m_mgr->syncFromSupabase();
+    QTRY_COMPARE_WITH_TIMEOUT(finished.size(), 3, 5000);
+    QCOMPARE(m_mgr->conflictIndices(), QList<int>{0});
+    QCOMPARE(m_mgr->notes()[0].title, QString("Mine 3"));
+    QCOMPARE(m_mgr->remoteVersion(0).title, QString("Theirs"));
+    QCOMPARE(m_mgr->queuedOperations(), 1);
+    QTest::qWait(2000); // past the backoff of the failed send
+    QCOMPARE(remoteTitle(), QString("Theirs"));
+
+    m_mgr->keepLocal(0);
+    QTRY_COMPARE_WITH_TIMEOUT(m_mgr->queuedOperations(), 0, 5000);
+    QCOMPARE(remoteTitle(), QString("Mine 3"));
+    QVERIFY(m_mgr->conflictIndices().isEmpty());
+    QVERIFY(m_mgr->remoteVersion(0).id.isEmpty());
+    m_server.setFixedTime(QString());
+}
+
+// a refused pull is a failed pull; only a table without updated_at turns
+// delta pulls off
+void SyncedCollectionTest::testFullListingOnlyWithoutUpdatedAt() {
+    QSignalSpy pulled(m_mgr, &SyncEngineBase::pullFinished);
+    m_server.failNextRequest(400, "22007", "invalid input syntax for type timestamp with time zone");
+    m_mgr->syncFromSupabase();
+    QTRY_COMPARE_WITH_TIMEOUT(pulled.count(), 1, 5000);
+    QCOMPARE(pulled[0][0].toBool(), false);
+    // the next pull still asks only for what changed since the cursor
+    const qint64 bytesBefore = m_server.stats().bytesOut;
+    m_mgr->syncFromSupabase();
+    QTRY_COMPARE_WITH_TIMEOUT(pulled.count(), 2, 5000);
+    QCOMPARE(pulled[1][0].toBool(), true);
+    QVERIFY(m_server.stats().bytesOut - bytesBefore < 2000);
+
+    m_server.dropUpdatedAt("todos");
+    m_server.seedRows("todos", 3);
+    TodosManager todos;
+    todos.setSupabaseConfig(m_server.url(), m_server.anonKey());
+    todos.setAuthManager(m_auth);
+    QSignalSpy todosPulled(&todos, &SyncEngineBase::pullFinished);
+    todos.syncFromSupabase();
+    QTRY_COMPARE_WITH_TIMEOUT(todosPulled.count(), 1, 5000);
+    QCOMPARE(todosPulled[0][0].toBool(), true);
+    QCOMPARE(todos.count(), 3);
+}
+
+QTEST_MAIN(SyncedCollectionTest)
+#include "synced_collection_test.moc"
@@ -0,0 +1,35 @@
+#include <QtTest>
+#include "../cpp/src/TabMetricsSampler.h"
+
+class TabMetricsTest : public QObject {
+    Q_OBJECT
+private slots:
+    void testParseStatm();
+    void testParseStatCommWithSpaces();
+    void testParseStatTruncated();
+};
+
+void TabMetricsTest::testParseStatm() {
+    qint64 rss = 0;
+    QVERIFY(TabMetricsSampler::parseStatm("52000 1500 800 10 0 20000 0\n", 4096, &rss));
+    QCOMPARE(rss, qint64(1500) * 4096);
+    QVERIFY(!TabMetricsSampler::parseStatm("", 4096, &rss));
+}
+
+void TabMetricsTest::testParseStatCommWithSpaces() {
+    // comm may contain spaces and parentheses; utime/stime are fields 14 and 15
+    QByteArray stat = "4242 (QtWebEngine (Render)) S 1 4242 4242 0 -1 4194560 100 0 0 0 731 129 0 0 20 0 12 0 5000 1000000 400\n";
+    quint64 utime = 0, stime = 0;
+    QVERIFY(TabMetricsSampler::parseStat(stat, &utime, &stime));
+    QCOMPARE(utime, quint64(731));
+    QCOMPARE(stime, quint64(129));
+}
+
+void TabMetricsTest::testParseStatTruncated() {
+    quint64 utime = 0, stime = 0;
+    QVERIFY(!TabMetricsSampler::parseStat("4242 (x) S 1 2 3", &utime, &stime));
+    QVERIFY(!TabMetricsSampler::parseStat("garbage", &utime, &stime));
+}
+
+QTEST_MAIN(TabMetricsTest)
+#include "tab_metrics_test.moc"
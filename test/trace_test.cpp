@@ -0,0 +1,127 @@
+#include <QtTest>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTemporaryDir>
+#include "../cpp/src/Trace.h"
+
+class TraceTest : public QObject {
+    Q_OBJECT
+private slots:
+    void init();
+    void testDisabledRecordsNothing();
+    void testScopeIsACompleteEvent();
+    void testThreadsGetTheirOwnTrack();
+    void testRingKeepsTheNewestEvents();
+    void testAsyncEventsShareAnId();
+    void testExportWritesChromeJson();
+
+private:
+    // events of the exported trace, metadata left out
+    static QJsonArray events();
+};
+
+QJsonArray TraceTest::events() {
+    QJsonArray out;
+    for (const QJsonValue &v : QJsonDocument::fromJson(Trace::toChromeJson())["traceEvents"].toArray())
+        if (v["ph"].toString() != "M") out.append(v);
+    return out;
+}
+
+void TraceTest::init() {
+    Trace::setEnabled(false);
+    Trace::clear();
+}
+
+void TraceTest::testDisabledRecordsNothing() {
+    {
+        FLOW_TRACE_SCOPE("off");
+        FLOW_TRACE_INSTANT("off");
+    }
+    QVERIFY(events().isEmpty());
+    QVERIFY(!Trace::detail("notes"));
+}
+
+void TraceTest::testScopeIsACompleteEvent() {
+    Trace::setEnabled(true);
+    {
+        FLOW_TRACE_SCOPE_DETAIL("work", "notes");
+        QThread::msleep(2);
+    }
+    const QJsonArray e = events();
+    QCOMPARE(e.size(), 1);
+    QCOMPARE(e[0]["name"].toString(), QString("work"));
+    QCOMPARE(e[0]["ph"].toString(), QString("X"));
+    QVERIFY(e[0]["dur"].toDouble() >= 1000.0);
+    QCOMPARE(e[0]["args"]["detail"].toString(), QString("notes"));
+}
+
+void TraceTest::testThreadsGetTheirOwnTrack() {
+    Trace::setEnabled(true);
+    FLOW_TRACE_INSTANT("on main");
+    QThread* worker = QThread::create([](){ FLOW_TRACE_INSTANT("on worker"); });
+    worker->setObjectName("storage-io");
+    worker->start();
+    QVERIFY(worker->wait(5000));
+    delete worker;
+
+    int mainTid = 0, workerTid = 0;
+    QHash<int, QString> names;
+    for (const QJsonValue &v : QJsonDocument::fromJson(Trace::toChromeJson())["traceEvents"].toArray()) {
+        if (v["ph"].toString() == "M") names.insert(v["tid"].toInt(), v["args"]["name"].toString());
+        else if (v["name"].toString() == "on main") mainTid = v["tid"].toInt();
+        else if (v["name"].toString() == "on worker") workerTid = v["tid"].toInt();
+    }
+    QVERIFY(mainTid && workerTid && mainTid != workerTid);
+    QCOMPARE(names.value(mainTid), QString("main"));
+    QCOMPARE(names.value(workerTid), QString("storage-io"));
+}
+
+void TraceTest::testRingKeepsTheNewestEvents() {
+    Trace::setEnabled(true);
+    const char* names[] = {"old", "new"};
+    for (int i = 0; i < Trace::kRingSize + 100; ++i) Trace::instant(names[i >= 100]);
+    const QJsonArray e = events();
+    QCOMPARE(e.size(), Trace::kRingSize);
+    for (const QJsonValue &v : e) QCOMPARE(v["name"].toString(), QString("new"));
+}
+
+void TraceTest::testAsyncEventsShareAnId() {
+    Trace::setEnabled(true);
+    const char* name = Trace::intern("GET /rest/v1/notes");
+    // the same text gives back the same pointer
+    QVERIFY(Trace::intern(QByteArray("GET /rest/v1/") + "notes") == name);
+    const std::uint64_t id = Trace::nextAsyncId();
+    QVERIFY(Trace::nextAsyncId() != id);
+    FLOW_TRACE_ASYNC_BEGIN(name, id);
+    FLOW_TRACE_ASYNC_STEP(name, id, "sent");
+    FLOW_TRACE_ASYNC_END(name, id);
+    const QJsonArray e = events();
+    QCOMPARE(e.size(), 3);
+    QCOMPARE(e[0]["ph"].toString(), QString("b"));
+    QCOMPARE(e[1]["ph"].toString(), QString("n"));
+    QCOMPARE(e[1]["args"]["step"].toString(), QString("sent"));
+    QCOMPARE(e[2]["ph"].toString(), QString("e"));
+    for (const QJsonValue &v : e) QCOMPARE(v["id"].toString(), e[0]["id"].toString());
+    QVERIFY(e[2]["ts"].toDouble() >= e[0]["ts"].toDouble());
+}
+
+void TraceTest::testExportWritesChromeJson() {
+    Trace::setEnabled(true);
+    { FLOW_TRACE_SCOPE("exported"); }
+    QTemporaryDir dir;
+    const QString path = dir.filePath("trace.json");
+    QVERIFY(Trace::exportChromeJson(path));
+    QFile f(path);
+    QVERIFY(f.open(QIODevice::ReadOnly));
+    QJsonParseError error;
+    const QJsonDocument doc = QJsonDocument::fromJson(f.readAll(), &error);
+    QCOMPARE(error.error, QJsonParseError::NoError);
+    QCOMPARE(doc["displayTimeUnit"].toString(), QString("ms"));
+    bool found = false;
+    for (const QJsonValue &v : doc["traceEvents"].toArray()) found = found || v["name"].toString() == "exported";
+    QVERIFY(found);
+}
+
+QTEST_MAIN(TraceTest)
+#include "trace_test.moc"